@@ -0,0 +1,286 @@
+/**
+ * @file    CcnClient.cpp
+ *
+ * @brief   Implementation file for the CcnClient class
+ *
+ * @author  Andrew Frost, Richard Millar
+ * @version 1.00
+ */
+
+// Header Files ===============================================================
+#include "CcnClient.h"
+#include <cerrno>
+#include <iostream>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// Class Implementation =======================================================
+/**
+ * @brief   Default constructor
+ * @details Constructs a client that is not connected yet
+ * @note    None
+ */
+CcnClient::CcnClient() : fd(-1), output(), input(), nextSequence(1)
+{
+
+}
+
+
+/**
+ * @brief   Destructor
+ * @note    None
+ */
+CcnClient::~CcnClient()
+{
+    close();
+}
+
+
+/**
+ * @brief       Connect to a server
+ *
+ * @param[in]   address     unix:path or tcp:port
+ *
+ * @note        Returns false if the address is not valid or nothing listens
+ */
+bool CcnClient::open(const std::string & address)
+{
+    NetAddress parsed;
+
+    if(!ParseNetAddress(address, parsed))
+    {
+        std::cout << "ERROR: Invalid server address " << address << ", expected unix:path or tcp:port." << std::endl;
+        return false;
+    }
+
+    fd = OpenConnection(parsed);
+
+    if(fd < 0)
+    {
+        std::cout << "ERROR: Could not connect to " << address << "." << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+
+/**
+ * @brief   Disconnect
+ * @details The server takes the client's vehicles off the network
+ * @note    None
+ */
+void CcnClient::close()
+{
+    if(fd >= 0)
+    {
+        ::close(fd);
+        fd = -1;
+    }
+
+    output.clear();
+    input.clear();
+}
+
+
+/**
+ * @brief       Ask for a route, joining the network if the vehicle is new
+ *
+ * @param[in]   id          vehicle ID, unique across all clients
+ * @param[in]   source      road the vehicle is on
+ * @param[in]   dest        road the vehicle is going to
+ * @param[in]   priority    JobPriority of the request
+ * @param[in]   deadline    seconds the request may wait, 0 for none
+ *
+ * @note        Returns the sequence number of the request
+ */
+unsigned int CcnClient::requestRoute(const std::string & id, const std::string & source, const std::string & dest,
+                                     int priority, double deadline)
+{
+    NetMessage request;
+
+    request.type = NET_ROUTE_REQUEST;
+    request.id = id;
+    request.from = source;
+    request.to = dest;
+    request.priority = priority;
+    request.deadline = deadline;
+
+    return send(request);
+}
+
+
+/**
+ * @brief       Ask to turn onto the next road
+ *
+ * @param[in]   id          vehicle ID
+ * @param[in]   currentRoad road the vehicle is on
+ * @param[in]   newRoad     road the vehicle wants to turn onto
+ *
+ * @note        Returns the sequence number of the request
+ */
+unsigned int CcnClient::changeRoad(const std::string & id, const std::string & currentRoad,
+                                   const std::string & newRoad)
+{
+    NetMessage request;
+
+    request.type = NET_ROAD_CHANGE;
+    request.id = id;
+    request.from = currentRoad;
+    request.to = newRoad;
+
+    return send(request);
+}
+
+
+/**
+ * @brief       Leave the network
+ *
+ * @param[in]   id          vehicle ID
+ * @param[in]   lastRoad    road the vehicle leaves from
+ *
+ * @note        Returns the sequence number of the request
+ */
+unsigned int CcnClient::leave(const std::string & id, const std::string & lastRoad)
+{
+    NetMessage request;
+
+    request.type = NET_LEAVE;
+    request.id = id;
+    request.from = lastRoad;
+
+    return send(request);
+}
+
+
+/**
+ * @brief   Write the buffered requests
+ * @note    Returns false if the connection failed
+ */
+bool CcnClient::flush()
+{
+    size_t written = 0;
+    ssize_t sent;
+
+    while(written < output.size())
+    {
+        sent = ::send(fd, output.data() + written, output.size() - written, MSG_NOSIGNAL);
+
+        if(sent < 0 && errno == EINTR)
+        {
+            continue;
+        }
+
+        if(sent <= 0)
+        {
+            return false;
+        }
+
+        written += (size_t)sent;
+    }
+
+    output.clear();
+
+    return true;
+}
+
+
+/**
+ * @brief       Wait for the next reply
+ * @details     Writes the buffered requests first. A route sent in several
+ *              frames is joined into one reply.
+ *
+ * @param[out]  reply       reply received
+ * @param[in]   timeoutMS   longest to wait, -1 for no limit
+ *
+ * @note        Returns 1 for a reply, 0 on timeout, -1 if the connection failed
+ */
+int CcnClient::receive(NetMessage & reply, int timeoutMS)
+{
+    char buffer[CLIENT_READ_SIZE];
+    std::list<std::pair<std::string, double> > parts;
+    pollfd ready;
+    ssize_t received;
+    size_t offset = 0;
+    int used;
+
+    if(fd < 0 || !flush())
+    {
+        return -1;
+    }
+
+    while(true)
+    {
+        used = DecodeMessage(input.data() + offset, input.size() - offset, reply);
+
+        if(used > 0)
+        {
+            offset += (size_t)used;
+
+            //the parts of a route are sent back to back, they are only taken
+            //off the input once the last one is there
+            if(reply.type == NET_ROUTE_RESPONSE && (reply.more || !parts.empty()))
+            {
+                parts.splice(parts.end(), reply.route);
+
+                if(reply.more)
+                {
+                    continue;
+                }
+
+                reply.route.swap(parts);
+            }
+
+            input.erase(0, offset);
+            return 1;
+        }
+
+        if(used < 0)
+        {
+            return -1;
+        }
+
+        offset = 0;
+        parts.clear();
+
+        ready.fd = fd;
+        ready.events = POLLIN;
+        ready.revents = 0;
+
+        if(poll(&ready, 1, timeoutMS) == 0)
+        {
+            return 0;
+        }
+
+        received = read(fd, buffer, sizeof(buffer));
+
+        if(received < 0 && errno == EINTR)
+        {
+            continue;
+        }
+
+        if(received <= 0)
+        {
+            return -1;
+        }
+
+        input.append(buffer, (size_t)received);
+    }
+}
+
+
+/**
+ * @brief       Buffer a request
+ *
+ * @param[in]   request     request to send, given the next sequence number
+ *
+ * @note        Returns the sequence number
+ */
+unsigned int CcnClient::send(NetMessage & request)
+{
+    request.sequence = nextSequence++;
+    EncodeMessage(request, output);
+
+    return request.sequence;
+}
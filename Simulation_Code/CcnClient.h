@@ -0,0 +1,55 @@
+/**
+ * @file    CcnClient.h
+ * @brief   Definition file for the CcnClient class
+ *
+ * @author  Andrew Frost, Richard Millar
+ * @version 1.00
+ */
+
+// Precompiler Directives =====================================================
+#ifndef CCNCLIENT_H
+#define CCNCLIENT_H
+
+// Header Files ===============================================================
+#include <string>
+#include "NetProtocol.h"
+
+#define CLIENT_READ_SIZE (1 << 16)
+
+// Class Definition ===========================================================
+/**
+ * @brief   Connection of a vehicle simulator to a Compute Node server.
+ * @details Requests are buffered and return their sequence number at once, so
+ *          many can be in flight; they are written together by flush() or the
+ *          next receive(). Replies are matched to requests by sequence number.
+ *          Used by one thread only.
+ *
+ * @class   CcnClient CcnClient.h "CcnClient.h"
+ */
+class CcnClient
+{
+public:
+    CcnClient();
+    ~CcnClient();
+
+    bool open(const std::string & address);
+    void close();
+
+    unsigned int requestRoute(const std::string & id, const std::string & source, const std::string & dest,
+                              int priority, double deadline);
+    unsigned int changeRoad(const std::string & id, const std::string & currentRoad, const std::string & newRoad);
+    unsigned int leave(const std::string & id, const std::string & lastRoad);
+
+    bool flush();
+    int receive(NetMessage & reply, int timeoutMS);
+
+private:
+    unsigned int send(NetMessage & request);
+
+    int fd;
+    std::string output; //requests not yet written
+    std::string input; //bytes read but not yet decoded
+    unsigned int nextSequence;
+};
+
+#endif
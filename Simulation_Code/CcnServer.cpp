@@ -0,0 +1,449 @@
+/**
+ * @file    CcnServer.cpp
+ *
+ * @brief   Implementation file for the CcnServer class
+ *
+ * @author  Andrew Frost, Richard Millar
+ * @version 1.00
+ */
+
+// Header Files ===============================================================
+#include "CcnServer.h"
+#include "CentralComputeNode.h"
+#include "Trace.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// Class Implementation =======================================================
+/**
+ * @brief       CcnServer constructor
+ *
+ * @param[in]   newCcn  Compute Node to serve
+ *
+ * @note        None
+ */
+CcnServer::CcnServer(CentralComputeNode & newCcn)
+    : ccn(newCcn), unixPath(), listenFd(-1), epollFd(-1), wakeFd(-1), connections(), fleet(newCcn),
+      accepted(0), requests(0), batches(0), largestBatch(0), routesSent(0)
+{
+    fleet.setWakeup([this]()
+    {
+        uint64_t signal = 1;
+
+        if(write(wakeFd, &signal, sizeof(signal)) < 0)
+        {
+            //the counter is already set, the loop wakes anyway
+        }
+    });
+}
+
+
+/**
+ * @brief   CcnServer destructor
+ * @note    None
+ */
+CcnServer::~CcnServer()
+{
+    close();
+}
+
+
+/**
+ * @brief       Start listening
+ *
+ * @param[in]   address     unix:path or tcp:port
+ *
+ * @note        Returns false if the address is not valid or cannot be used
+ */
+bool CcnServer::open(const std::string & address)
+{
+    NetAddress parsed;
+    epoll_event event;
+
+    if(!ParseNetAddress(address, parsed))
+    {
+        std::cout << "ERROR: Invalid server address " << address << ", expected unix:path or tcp:port." << std::endl;
+        return false;
+    }
+
+    listenFd = OpenListener(parsed);
+    epollFd = epoll_create1(0);
+    wakeFd = eventfd(0, EFD_NONBLOCK);
+
+    if(listenFd < 0 || epollFd < 0 || wakeFd < 0)
+    {
+        std::cout << "ERROR: Could not listen on " << address << "." << std::endl;
+        close();
+        return false;
+    }
+
+    if(parsed.transport == NET_UNIX)
+    {
+        unixPath = parsed.path;
+    }
+
+    event.events = EPOLLIN;
+    event.data.fd = listenFd;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &event);
+
+    event.events = EPOLLIN;
+    event.data.fd = wakeFd;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &event);
+
+    return true;
+}
+
+
+/**
+ * @brief       Serve clients
+ * @details     Each pass of the loop waits for events, reads every connection
+ *              that has data, handles all the requests read as one batch under
+ *              one lock of the Compute Node, then sends the routes that are
+ *              ready and the replies
+ *
+ * @param[in]   running     flag to show that the simulator is running
+ * @param[in]   seconds     time to serve for
+ *
+ * @note        Runs on its own thread
+ */
+void CcnServer::run(std::atomic_bool & running, double seconds)
+{
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now() +
+        std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(seconds));
+    epoll_event events[SERVER_MAX_EVENTS];
+    std::vector<Request> batch;
+    std::vector<int> closing;
+    std::unordered_map<int, std::unique_ptr<Connection> >::iterator connection;
+    NetMessage reply;
+    uint64_t signals;
+    int count, index;
+
+    TRACE_THREAD_NAME("server");
+
+    while(running && std::chrono::steady_clock::now() < end && epollFd >= 0)
+    {
+        count = epoll_wait(epollFd, events, SERVER_MAX_EVENTS, SERVER_POLL_MS);
+
+        batch.clear();
+        closing.clear();
+
+        for(index = 0; index < count; index++)
+        {
+            if(events[index].data.fd == listenFd)
+            {
+                acceptConnections();
+                continue;
+            }
+
+            if(events[index].data.fd == wakeFd)
+            {
+                while(read(wakeFd, &signals, sizeof(signals)) > 0)
+                {
+
+                }
+                continue;
+            }
+
+            connection = connections.find(events[index].data.fd);
+
+            if(connection == connections.end())
+            {
+                continue;
+            }
+
+            if((events[index].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) &&
+               !readConnection(*connection->second, batch))
+            {
+                closing.push_back(connection->first);
+            }
+            else if(events[index].events & EPOLLOUT)
+            {
+                flush(*connection->second);
+            }
+        }
+
+        if(!batch.empty() || !closing.empty())
+        {
+            TRACE_SCOPE("server", "batch");
+
+            ccn.getLock();
+            {
+                for(index = 0; index < (int)batch.size(); index++)
+                {
+                    if(fleet.handle(batch[index].connection, batch[index].message, reply))
+                    {
+                        EncodeMessage(reply, connections[batch[index].connection]->output);
+                    }
+                }
+
+                for(index = 0; index < (int)closing.size(); index++)
+                {
+                    closeConnection(closing[index]);
+                }
+            }
+            ccn.releaseLock();
+
+            requests += (long long)batch.size();
+            batches += batch.empty() ? 0 : 1;
+            largestBatch = std::max(largestBatch, (long long)batch.size());
+        }
+
+        sendRoutes();
+
+        for(connection = connections.begin(); connection != connections.end(); ++connection)
+        {
+            if(connection->second->output.size() > connection->second->written &&
+               !connection->second->watchingWrites)
+            {
+                flush(*connection->second);
+            }
+        }
+    }
+}
+
+
+/**
+ * @brief   Stop serving
+ * @details Takes the remote vehicles off the network and closes the sockets
+ * @note    Call once run() has returned
+ */
+void CcnServer::close()
+{
+    std::unordered_map<int, std::unique_ptr<Connection> >::iterator connection;
+
+    ccn.getLock();
+    {
+        fleet.dropAll();
+    }
+    ccn.releaseLock();
+
+    for(connection = connections.begin(); connection != connections.end(); ++connection)
+    {
+        ::close(connection->first);
+    }
+
+    connections.clear();
+
+    if(listenFd >= 0)
+    {
+        ::close(listenFd);
+        listenFd = -1;
+    }
+
+    if(epollFd >= 0)
+    {
+        ::close(epollFd);
+        epollFd = -1;
+    }
+
+    if(wakeFd >= 0)
+    {
+        ::close(wakeFd);
+        wakeFd = -1;
+    }
+
+    if(!unixPath.empty())
+    {
+        unlink(unixPath.c_str());
+        unixPath.clear();
+    }
+}
+
+
+/**
+ * @brief   Print how much the server handled
+ * @note    Call once run() has returned
+ */
+void CcnServer::printStatistics() const
+{
+    std::cout << "Server: " << accepted << " connections, " << requests << " requests in " << batches
+              << " batches, largest " << largestBatch << ", " << routesSent << " routes sent." << std::endl;
+}
+
+
+/**
+ * @brief   Accept every waiting connection
+ * @note    None
+ */
+void CcnServer::acceptConnections()
+{
+    epoll_event event;
+    int fd, enable = 1;
+
+    while((fd = accept4(listenFd, NULL, NULL, SOCK_NONBLOCK)) >= 0)
+    {
+        //fails harmlessly on a Unix socket
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+
+        std::unique_ptr<Connection> connection(new Connection());
+
+        connection->fd = fd;
+        connection->written = 0;
+        connection->watchingWrites = false;
+
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event);
+
+        connections[fd] = std::move(connection);
+        accepted++;
+    }
+}
+
+
+/**
+ * @brief       Read all a connection has sent
+ *
+ * @param[in]   connection  connection to read
+ * @param[out]  batch       requests read are appended
+ *
+ * @note        Returns false if the connection closed or sent a bad frame
+ */
+bool CcnServer::readConnection(Connection & connection, std::vector<Request> & batch)
+{
+    char buffer[SERVER_READ_SIZE];
+    size_t offset = 0;
+    ssize_t received;
+    int used;
+    bool open = true;
+
+    while(true)
+    {
+        received = read(connection.fd, buffer, sizeof(buffer));
+
+        if(received > 0)
+        {
+            connection.input.append(buffer, (size_t)received);
+        }
+        else
+        {
+            open = received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR);
+            break;
+        }
+    }
+
+    while(offset < connection.input.size())
+    {
+        batch.push_back(Request());
+        used = DecodeMessage(connection.input.data() + offset, connection.input.size() - offset,
+                             batch.back().message);
+
+        if(used <= 0)
+        {
+            batch.pop_back();
+            open = open && used == 0;
+            break;
+        }
+
+        batch.back().connection = connection.fd;
+        offset += (size_t)used;
+    }
+
+    connection.input.erase(0, offset);
+
+    return open;
+}
+
+
+/**
+ * @brief       Close a connection and take its vehicles off the network
+ *
+ * @param[in]   fd  socket of the connection
+ *
+ * @note        The caller holds the lock of the Compute Node
+ */
+void CcnServer::closeConnection(int fd)
+{
+    fleet.dropClient(fd);
+
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, NULL);
+    ::close(fd);
+    connections.erase(fd);
+}
+
+
+/**
+ * @brief   Queue the routes that are ready on their connections
+ * @note    None
+ */
+void CcnServer::sendRoutes()
+{
+    std::vector<RemoteFleet::RouteReady> routes;
+    std::unordered_map<int, std::unique_ptr<Connection> >::iterator connection;
+    NetMessage reply;
+    int index;
+
+    fleet.takeRoutes(routes);
+
+    reply.type = NET_ROUTE_RESPONSE;
+    reply.status = NET_OK;
+
+    for(index = 0; index < (int)routes.size(); index++)
+    {
+        connection = connections.find(routes[index].client);
+
+        //the vehicle's connection may have closed since
+        if(connection == connections.end())
+        {
+            continue;
+        }
+
+        reply.sequence = routes[index].sequence;
+        reply.route.swap(routes[index].route);
+        EncodeMessage(reply, connection->second->output);
+        routesSent++;
+    }
+}
+
+
+/**
+ * @brief       Write as much of a connection's replies as it takes
+ * @details     Whatever does not fit waits for epoll to report room
+ *
+ * @param[in]   connection  connection to write to
+ *
+ * @note        None
+ */
+void CcnServer::flush(Connection & connection)
+{
+    epoll_event event;
+    ssize_t sent;
+
+    while(connection.written < connection.output.size())
+    {
+        //a client that went away must not raise SIGPIPE
+        sent = send(connection.fd, connection.output.data() + connection.written,
+                    connection.output.size() - connection.written, MSG_NOSIGNAL);
+
+        if(sent <= 0)
+        {
+            break;
+        }
+
+        connection.written += (size_t)sent;
+    }
+
+    if(connection.written == connection.output.size())
+    {
+        connection.output.clear();
+        connection.written = 0;
+    }
+
+    if(connection.watchingWrites == connection.output.empty())
+    {
+        connection.watchingWrites = !connection.output.empty();
+
+        event.events = connection.watchingWrites ? (EPOLLIN | EPOLLOUT) : EPOLLIN;
+        event.data.fd = connection.fd;
+        epoll_ctl(epollFd, EPOLL_CTL_MOD, connection.fd, &event);
+    }
+}
@@ -0,0 +1,100 @@
+/**
+ * @file    CcnServer.h
+ * @brief   Definition file for the CcnServer class
+ *
+ * @author  Andrew Frost, Richard Millar
+ * @version 1.00
+ */
+
+// Precompiler Directives =====================================================
+#ifndef CCNSERVER_H
+#define CCNSERVER_H
+
+// Header Files ===============================================================
+#include <atomic>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "NetProtocol.h"
+#include "RemoteFleet.h"
+#include "VehicleServer.h"
+
+#define SERVER_MAX_EVENTS 64
+#define SERVER_POLL_MS 100
+#define SERVER_READ_SIZE (1 << 16)
+
+class CentralComputeNode;
+
+// Class Definition ===========================================================
+/**
+ * @brief   Serves the Compute Node to vehicles in other processes.
+ * @details One thread runs an epoll loop over the listening socket, the client
+ *          connections, and an eventfd the Compute Node thread signals when it
+ *          has routed a remote vehicle. Every request read in one pass of the
+ *          loop, from any connection, is handled as one batch under a single
+ *          lock of the Compute Node, and the replies go out as each connection
+ *          can take them. Clients pipeline: they send requests without waiting
+ *          and match the replies by sequence number. The remote vehicles are
+ *          kept by a RemoteFleet, with the socket of a connection as client.
+ *
+ * @class   CcnServer CcnServer.h "CcnServer.h"
+ */
+class CcnServer : public VehicleServer
+{
+public:
+    CcnServer(CentralComputeNode & newCcn);
+    ~CcnServer();
+
+    bool open(const std::string & address);
+    void run(std::atomic_bool & running, double seconds);
+    void close();
+
+    void printStatistics() const;
+
+private:
+    /**
+     * @brief   A client connection and its buffers.
+     */
+    struct Connection
+    {
+        int fd;
+        std::string input; //bytes read but not yet decoded
+        std::string output; //replies not yet written
+        size_t written; //bytes of output already written
+        bool watchingWrites; //the socket was full, epoll reports when it drains
+    };
+
+    /**
+     * @brief   A request read in this pass of the loop.
+     */
+    struct Request
+    {
+        int connection;
+        NetMessage message;
+    };
+
+    void acceptConnections();
+    bool readConnection(Connection & connection, std::vector<Request> & batch);
+    void closeConnection(int fd);
+    void sendRoutes();
+    void flush(Connection & connection);
+
+    CentralComputeNode & ccn;
+
+    std::string unixPath; //socket file to remove on close, if any
+    int listenFd;
+    int epollFd;
+    int wakeFd; //eventfd written when routes are ready
+
+    std::unordered_map<int, std::unique_ptr<Connection> > connections;
+    RemoteFleet fleet;
+
+    long long accepted;
+    long long requests;
+    long long batches;
+    long long largestBatch;
+    long long routesSent;
+};
+
+#endif
@@ -9,12 +9,20 @@
 
 // Header Files ===============================================================
 #include "CentralComputeNode.h"
+#include "RouteSearch.h"
+#include "Trace.h"
+#include <algorithm>
 #include <atomic>
+#include <chrono>
 
 #define _INFINITY 9999999
-
-template<typename Type>
-bool GetCheapestNode(std::unordered_set<Type> & set, std::map<Type, double> & fScore, Type & lowest);
+#define ALL_PAIRS_MAX_SUBNETS 4096
+#define TABLE_REFRESH_SLICE_MS 10
+#define ROUTE_CACHE_LIMIT 4096
+#define CUSTOMIZATION_SUBNETS_PER_MOVE 8 //by default one vehicle move tolerated per this many subnets
+#define ALTERNATIVE_MAX 8 //most routes offered per start and destination
+#define ALTERNATIVE_PENALTY 0.5 //cost added to a subnet for each alternative through it
+#define ALTERNATIVE_STRETCH 1.3 //most an alternative may cost, relative to the best route
 
 
 /**
@@ -24,11 +32,49 @@ bool GetCheapestNode(std::unordered_set<Type> & set, std::map<Type, double> & fS
  */
 CentralComputeNode::CentralComputeNode()
     : vehicles(), 
+    demandPending(0),
     subnetCapacity(), 
     vehiclesAtSubnet(), 
-    subnetAdjacencyMatrix(), 
     subnetToIndexTable(),
-    jobs()
+    indexToSubnetTable(),
+    roadGraph(),
+    nodeOrder(ORDER_RCM),
+    reverseGraph(),
+    landmarks(),
+    landmarkRoadCosts(),
+    closedRoads(),
+    graphVersion(0),
+    subnetOccupancy(),
+    capacityByIndex(),
+    roadChangeFailures(),
+    routingAlgorithm(ROUTE_ASTAR),
+    costModel(COST_LINEAR),
+    hierarchy(),
+    hierarchyMetric(),
+    hierarchyPath(),
+    occupancyVersion(0),
+    hierarchyVersion(0),
+    hierarchyGraphVersion(0),
+    customizationInterval(0),
+    distanceTable(),
+    tablePath(),
+    tableVersion(0),
+    tableGraphVersion(0),
+    tableRefreshRunning(false),
+    tableRefreshThread(),
+    jobs(),
+    strandedGraphVersion(0),
+    strandedOccupancyVersion(0),
+    alternativeCount(1),
+    alternatives(),
+    alternativePaths(),
+    alternativePenalty(),
+    alternativeDeliveries(0),
+    alternativeKey(0),
+    alternativeVersion(0),
+    routeCache(),
+    cachedRoutesByRoad(),
+    cachedRouteRoads()
 {
 
 }
@@ -40,7 +86,7 @@ CentralComputeNode::CentralComputeNode()
  */
 CentralComputeNode::~CentralComputeNode() 
 {
-   
+    stopTableRefresh();
 }
 
 
@@ -60,6 +106,11 @@ void CentralComputeNode::buildSubnetToIndexTable(std::vector<std::string> & subn
     {
         subnetToIndexTable[subnets[index]] = index;
     }
+
+    indexToSubnetTable = subnets;
+    subnetOccupancy.assign(subnets.size(), 0);
+    capacityByIndex.assign(subnets.size(), 0);
+    roadChangeFailures.assign(subnets.size(), 0);
 }
 
 /**
@@ -81,6 +132,20 @@ int CentralComputeNode::getMapIndex(const std::string & name)
 }
 
 
+/**
+ * @brief       Sets the numbering of the subnets
+ * @details     Selects how the next map is renumbered, see NodeOrder
+ * 
+ * @param[in]   order   numbering applied by setMap
+ * 
+ * @note        Reverse Cuthill-McKee by default
+ */
+void CentralComputeNode::setNodeOrder(NodeOrder order)
+{
+    nodeOrder = order;
+}
+
+
 /**
  * @brief       Assign new map to object
  * @details     Set a new city map within the object
@@ -91,487 +156,2157 @@ int CentralComputeNode::getMapIndex(const std::string & name)
  */
 void CentralComputeNode::setMap(std::vector<std::vector<double> > & map)
 {
-    subnetAdjacencyMatrix = map;
+    roadGraph.buildFromMatrix(map);
+    reorderNodes();
+    reverseGraph = roadGraph.reversed();
+
+    //tables built for the old map are no longer valid bounds
+    landmarks.clear();
+    landmarkRoadCosts.clear();
+    closedRoads.clear();
+    hierarchy.clear();
+    distanceTable.reset();
+    clearRouteCache();
+    alternatives.clear();
+    graphVersion++;
 }
 
 
 /**
- * @brief       Assign properties to submet
- * @details     Sets the subnet capacity specified by name
- * 
- * @param[in]   name        ID to be searched for
- * @param[in]   capacity    capacity of the subnet to assign
+ * @brief       Assign new map to object
+ * @details     Set a new city map from adjacency lists, for cities too large to
+ *              describe with an adjacency matrix
+ * @param[in]   graph   road graph using the indices of the subnetToIndexTable
  * 
  * @note        None
  */
-void CentralComputeNode::setSubnetProperties(std::string & name, int capacity)
+void CentralComputeNode::setMap(const RoadGraph & graph)
 {
-    subnetCapacity[name] = capacity;
+    roadGraph = graph;
+    reorderNodes();
+    reverseGraph = roadGraph.reversed();
+
+    landmarks.clear();
+    landmarkRoadCosts.clear();
+    closedRoads.clear();
+    hierarchy.clear();
+    distanceTable.reset();
+    clearRouteCache();
+    alternatives.clear();
+    graphVersion++;
 }
 
 
 /**
- * @brief       Adds a new job
- * @details     Appends a new job to the end of the queue
- * 
- * @param[in]   job     job to be appended
+ * @brief       Renumbers the subnets of the new map
+ * @details     Moves every subnet to its index in nodeOrder, in the road graph
+ *              and in every table kept by subnet index. Subnet IDs are kept, so
+ *              only code holding an index across setMap sees the change.
  * 
- * @note        None
+ * @note        Skipped when the index tables do not cover the graph
  */
-void CentralComputeNode::queueJob(Job & job)
+void CentralComputeNode::reorderNodes()
 {
-    jobs.push_back(job);
+    std::vector<int> newIndex, occupancy, capacities, failures;
+    std::vector<std::string> names;
+    int node, nodeCount = roadGraph.getNodeCount();
+
+    if (nodeOrder == ORDER_INPUT || (int)indexToSubnetTable.size() != nodeCount)
+    {
+        return;
+    }
+
+    TRACE_SCOPE("ccn", "reorderNodes");
+
+    ComputeNodeOrder(roadGraph, nodeOrder, newIndex);
+
+    roadGraph = roadGraph.renumbered(newIndex);
+
+    names.resize(nodeCount);
+    occupancy.resize(nodeCount);
+    capacities.resize(nodeCount);
+    failures.resize(nodeCount);
+
+    for (node = 0; node < nodeCount; node++)
+    {
+        names[newIndex[node]] = indexToSubnetTable[node];
+        occupancy[newIndex[node]] = subnetOccupancy[node];
+        capacities[newIndex[node]] = capacityByIndex[node];
+        failures[newIndex[node]] = roadChangeFailures[node];
+    }
+
+    indexToSubnetTable.swap(names);
+    subnetOccupancy.swap(occupancy);
+    capacityByIndex.swap(capacities);
+    roadChangeFailures.swap(failures);
+
+    for (node = 0; node < nodeCount; node++)
+    {
+        subnetToIndexTable[indexToSubnetTable[node]] = node;
+    }
 }
 
 
 /**
- * @brief       Computes route
- * @details     Computes the best route from start to end, and returns it
+ * @brief       Assign properties to submet
+ * @details     Sets the subnet capacity specified by name
  * 
- * @param[out]  route   route to be computed and returned
+ * @param[in]   name        ID to be searched for
+ * @param[in]   capacity    capacity of the subnet to assign
  * 
  * @note        None
  */
-bool CentralComputeNode::computeRoute(Route & route) 
+void CentralComputeNode::setSubnetProperties(std::string & name, int capacity)
 {
-    return aStar(route);
+    int index = getMapIndex(name);
+
+    subnetCapacity[name] = capacity;
+
+    if (index >= 0)
+    {
+        capacityByIndex[index] = capacity;
+    }
 }
 
 
 /**
- * @brief       Process waiting jobs for routes
- * @details     Processes all pending jobs in the queue, and if there are no vehicles
- *              present on the network, end the simulator.
- * 
- * @param[out]  running    boolean to determine whether the simulator is still
- *                          running.
- * @note        None
+ * @brief       Changes the travel time of a road
+ * @details     Updates the road in place in both graphs, without rebuilding
+ *              the map. A closed road keeps the new time for when it reopens.
+ *
+ * @param[in]   from        subnet the road starts at
+ * @param[in]   to          subnet the road ends at
+ * @param[in]   travelTime  new travel time in seconds
+ *
+ * @note        Returns false if there is no such road or the time is not
+ *              positive. The caller holds the lock of the Compute Node.
  */
-void CentralComputeNode::directTraffic(std::atomic_bool &running)
+bool CentralComputeNode::setRoadTime(const std::string & from, const std::string & to, double travelTime)
 {
-    std::list<Job>::iterator jobIter;
-    Job job;
-    Route route;
+    std::unordered_map<int, double>::iterator closed;
+    int edge, reverseEdge;
 
-    int counter = 0, minCapacity = _INFINITY;
-    
-    std::list<std::pair<std::string, double> >::iterator pathIter;
+    if (!(travelTime > 0) || travelTime >= SEARCH_INFINITY || !findRoad(from, to, edge, reverseEdge))
+    {
+        return false;
+    }
 
-    // If there are no more vehicles in the network
-    if (vehicles.empty())
+    closed = closedRoads.find(edge);
+
+    if (closed != closedRoads.end())
     {
-        running = false;
-        return;
+        closed->second = travelTime;
     }
-    // If there are no jobs to be run
-    if (jobs.empty())
+    else if (roadGraph.costs[edge] != travelTime)
     {
-        return;
+        changeRoadCost(edge, reverseEdge, travelTime);
     }
 
-    //fetch the first job
-    job = jobs.front();
+    return true;
+}
 
-    route.start = job.start;
-    route.dest = job.dest;
 
-    computeRoute(route);
+/**
+ * @brief       Closes a road
+ * @details     The road stays in the graph at a cost of SEARCH_INFINITY, which
+ *              no search relaxes, so new routes avoid it. Vehicles already
+ *              routed over it still drive it.
+ *
+ * @param[in]   from    subnet the road starts at
+ * @param[in]   to      subnet the road ends at
+ *
+ * @note        Returns false if there is no such road. The caller holds the
+ *              lock of the Compute Node.
+ */
+bool CentralComputeNode::closeRoad(const std::string & from, const std::string & to)
+{
+    int edge, reverseEdge;
 
-    if(route.route.empty())
+    if (!findRoad(from, to, edge, reverseEdge))
     {
-        return;
+        return false;
     }
 
-    //find the minimum capacity
-    for(pathIter = route.route.begin(); pathIter != route.route.end(); ++pathIter)
+    if (closedRoads.count(edge) == 0)
     {
-        if(subnetCapacity[pathIter->first] < minCapacity)
-        {
-            counter = (int)vehiclesAtSubnet[pathIter->first].size();
-            minCapacity = subnetCapacity[pathIter->first];
-        }
+        closedRoads[edge] = roadGraph.costs[edge];
+        changeRoadCost(edge, reverseEdge, SEARCH_INFINITY);
     }
 
-    //for each vehicle that can use the route, send it the route
+    return true;
+}
+
 
-    jobIter = jobs.begin();
+/**
+ * @brief       Reopens a closed road
+ * @details     Restores the travel time the road had when it was closed, or
+ *              the last one set while it was closed
+ *
+ * @param[in]   from    subnet the road starts at
+ * @param[in]   to      subnet the road ends at
+ *
+ * @note        Returns false if there is no such road, opening an open road
+ *              does nothing. The caller holds the lock of the Compute Node.
+ */
+bool CentralComputeNode::openRoad(const std::string & from, const std::string & to)
+{
+    std::unordered_map<int, double>::iterator closed;
+    double travelTime;
+    int edge, reverseEdge;
 
-    while (jobIter != jobs.end() && counter <= minCapacity)
+    if (!findRoad(from, to, edge, reverseEdge))
     {
-        job = *jobIter;
+        return false;
+    }
 
-        //if the vehicle can use this route
-        if (job.start == route.start && job.dest == route.dest)
-        {
-            if (vehicles[job.id] != NULL)
-            {
-                vehicles[job.id]->getLock();
-                {
-                    vehicles[job.id]->setRoute(route.route);
-                    counter++;
-                }
-                vehicles[job.id]->releaseLock();
+    closed = closedRoads.find(edge);
 
-                jobIter = jobs.erase(jobIter);
+    if (closed != closedRoads.end())
+    {
+        travelTime = closed->second;
+        closedRoads.erase(closed);
+        changeRoadCost(edge, reverseEdge, travelTime);
+    }
 
-                continue; // if we erased we don't need to increment iter
-            }
-        }
+    return true;
+}
+
+
+/**
+ * @brief       Changes the capacity of a subnet
+ * @details     Takes effect at once for road changes and the room of new
+ *              routes. The searches only have to catch up when the cost model
+ *              uses capacities.
+ *
+ * @param[in]   name        ID of the subnet
+ * @param[in]   capacity    vehicles that fit on the subnet
+ *
+ * @note        Returns false for an unknown subnet or a negative capacity.
+ *              The caller holds the lock of the Compute Node.
+ */
+bool CentralComputeNode::setSubnetCapacity(const std::string & name, int capacity)
+{
+    int index = getMapIndex(name);
 
-        ++jobIter;
+    if (index < 0 || capacity < 0)
+    {
+        return false;
     }
 
+    subnetCapacity[name] = capacity;
+    capacityByIndex[index] = capacity;
+
+    if (costModel == COST_BPR || costModel == COST_CAPACITY)
+    {
+        invalidateMetric();
+    }
 
+    return true;
 }
 
 
 /**
- * @brief       Add vehicle to network
- * @details     Appends vehicle to the vehicle map
- * 
- * @param[in]   vehicle     Vehicle to add to the network
- * 
- * @note        None
+ * @brief   Get the graph version
+ * @details Returns a counter bumped by every change to the map, the roads or,
+ *          under a cost model that uses them, the capacities. Work computed
+ *          from a snapshot of the graph is stale once the version moved on.
+ * @note    None
  */
-void CentralComputeNode::joinNetwork(Vehicle * vehicle)
+unsigned long long CentralComputeNode::getGraphVersion() const
 {
-    vehicles[vehicle->getID()] = vehicle;
-    vehiclesAtSubnet[vehicle->getSource()].emplace(vehicle->getID());
+    return graphVersion;
 }
 
 
 /**
- * @brief       Allow Vehicle to leave network
- * @details     Removes vehicle ID from network
+ * @brief       Adds a new job
+ * @details     Appends a new job to the end of the queue and to the bucket of
+ *              its start and destination, subject to admission control. When
+ *              the queue is full under ADMIT_STALE_ROUTE, the last route
+ *              computed for the same start and destination is returned instead.
  * 
- * @param[in]   id          ID of vehicle to remove
- * @param[in]   lastNode    last known node vehicle is at
+ * @param[in]   job         job to be appended
+ * @param[out]  staleRoute  cached route, filled when JOB_STALE is returned
  * 
  * @note        None
  */
-void CentralComputeNode::leaveNetwork(const std::string &id, const std::string &lastNode)
+AdmissionResult CentralComputeNode::queueJob(Job & job, Route & staleRoute)
 {
-    vehicles.erase(id);
-    vehiclesAtSubnet[lastNode].erase(id);
+    unsigned long long key = getJobKey(job.start, job.dest);
+    std::unordered_map<unsigned long long, std::list<std::pair<std::string, double> > >::iterator cached;
+    AdmissionResult result = jobs.push(job, key);
+
+    if (result != JOB_REJECTED || jobs.getPolicy() != ADMIT_STALE_ROUTE)
+    {
+        return result;
+    }
+
+    cached = routeCache.find(key);
+
+    if (cached == routeCache.end())
+    {
+        return JOB_REJECTED;
+    }
+
+    staleRoute.start = job.start;
+    staleRoute.dest = job.dest;
+    staleRoute.route = cached->second;
+
+    jobs.recordStaleRoute();
+
+    return JOB_STALE;
 }
 
 
 /**
- * @brief       Changes current road of vehicle
- * @details     Determines whether to allow Vehicle to change road, and if so, update
- *              vehicle location and count, else return false
+ * @brief       Computes route
+ * @details     Computes the best route from start to end, and returns it
  * 
- * @param[in]   id          vehicle ID
- * @param[in]   currentRoad road vehicle is currently on
- * @param[in]   newRoad     road vehicle is requesting to switch to
+ * @param[out]  route   route to be computed and returned
  * 
  * @note        None
  */
-bool CentralComputeNode::changeRoad(std::string & id, std::string & currentRoad, std::string & newRoad)
+bool CentralComputeNode::computeRoute(Route & route) 
 {
-    if (currentRoad == newRoad)
+    if (routingAlgorithm == ROUTE_HIERARCHY)
     {
-        return true;
+        return hierarchySearch(route);
     }
-    
-    if(vehiclesAtSubnet[newRoad].size() < (unsigned int)subnetCapacity[newRoad])
+
+    if (routingAlgorithm == ROUTE_BIDIRECTIONAL)
     {
-        vehiclesAtSubnet[newRoad].emplace(id);
-        vehiclesAtSubnet[currentRoad].erase(id);
+        return bidirectionalSearch(route);
+    }
 
-        return true;
+    if (routingAlgorithm == ROUTE_ALL_PAIRS)
+    {
+        return tableSearch(route);
     }
 
-    return false;
+    return aStar(route);
 }
 
 
 /**
- * @brief       A* Search Algorithm
- * @details     Computes a route based on the starting and end nodes using the A*
- *              Search algorithm
+ * @brief       Computes the cost from one subnet to every other
+ * @details     Runs a Dijkstra search over the congested costs that settles the
+ *              whole map, from the origin or, searching backward, to it
  * 
- * @param[out]  route   route to be computed and returned   
+ * @param[in]   origin      subnet the costs are measured from, or to
+ * @param[in]   backward    measure the cost of reaching the origin instead
+ * @param[out]  distances   cost by subnet index, SEARCH_INFINITY if unreachable
  * 
- * @note        None
+ * @note        The caller holds the lock of the Compute Node
  */
-bool CentralComputeNode::aStar(Route & route)
+bool CentralComputeNode::computeDistances(const std::string & origin, bool backward, std::vector<double> & distances)
 {
-    std::unordered_set<std::string> closedSet, openSet;
-
-    std::map<std::string, std::string> cameFrom;
+    TRACE_SCOPE("ccn", "computeDistances");
 
-    std::map<std::string, double> fScore, gScore;
+    int start = getMapIndex(origin);
 
-    std::map<std::string, int>::iterator subnetIter;
-
-    std::string current;
+    if (start < 0 || roadGraph.getNodeCount() == 0)
+    {
+        distances.assign(roadGraph.getNodeCount(), SEARCH_INFINITY);
+        return false;
+    }
 
-    std::vector<std::string> neighbors;
+    switch (costModel)
+    {
+    case COST_FREE_FLOW:
+        searchDistances(FreeFlowCost(), start, backward, distances);
+        break;
+    case COST_BPR:
+        searchDistances(BprCost(subnetOccupancy, capacityByIndex), start, backward, distances);
+        break;
+    case COST_CAPACITY:
+        searchDistances(CapacityCost(subnetOccupancy, capacityByIndex), start, backward, distances);
+        break;
+    default:
+        searchDistances(LinearCost(subnetOccupancy), start, backward, distances);
+        break;
+    }
 
-    int index;
+    return true;
+}
 
-    long long tentativeGScore;
-    
 
-    //initialize tables
-    for (subnetIter = subnetToIndexTable.begin(); subnetIter != subnetToIndexTable.end(); ++subnetIter)
+/**
+ * @brief       Computes the cost from one subnet to every other
+ * @details     Searches the road graph, or the reverse graph with the cost of
+ *              the road each reversed road stands for
+ * 
+ * @param[in]   cost        cost model of the roads
+ * @param[in]   start       index of the subnet the costs are measured from, or to
+ * @param[in]   backward    measure the cost of reaching start instead
+ * @param[out]  distances   cost by subnet index, SEARCH_INFINITY if unreachable
+ * 
+ * @note        None
+ */
+template<typename Cost>
+void CentralComputeNode::searchDistances(const Cost & cost, int start, bool backward, std::vector<double> & distances)
+{
+    if (backward)
     {
-        fScore[subnetIter->first] = _INFINITY;
-        gScore[subnetIter->first] = _INFINITY;
+        DijkstraSearch(reverseGraph, ReversedCost<Cost>(cost), getSearchContext(), start, distances);
     }
-
-    fScore[route.start] = 0;
+    else
+    {
+        DijkstraSearch(roadGraph, cost, getSearchContext(), start, distances);
+    }
+}
 
 
-    openSet.emplace(route.start);
+/**
+ * @brief       Process waiting jobs for routes
+ * @details     Processes all pending jobs in the queue, and if there are no vehicles
+ *              present on the network, end the simulator.
+ * 
+ * @param[out]  running    boolean to determine whether the simulator is still
+ *                          running.
+ * @note        None
+ */
+void CentralComputeNode::directTraffic(std::atomic_bool &running)
+{
+    Job job;
+    Route route;
 
-    gScore[route.start] = 0;    
+    unsigned long long key;
 
-    while(GetCheapestNode(openSet, fScore, current))
+    // If there are no more vehicles in the network, or coming
+    if (vehicles.empty() && demandPending == 0)
     {
+        running = false;
+        return;
+    }
+    //stranded jobs try again once the roads have changed, or under the
+    //capacity cost model the occupancy its costs depend on
+    if (jobs.getStrandedCount() > 0 && (graphVersion != strandedGraphVersion ||
+        (costModel == COST_CAPACITY && occupancyVersion != strandedOccupancyVersion)))
+    {
+        jobs.releaseStranded();
+    }
 
-        if(current == route.dest)
-        {
-            route = reconstructPath(cameFrom, current, route.start);
-
-            return true;
-        }
+    // If there are no jobs to be run
+    if (vehicles.empty() || jobs.isEmpty())
+    {
+        return;
+    }
 
-        openSet.erase(current);
+    TRACE_SCOPE("ccn", "directTraffic");
 
-        closedSet.emplace(current);
+    //fetch the job the scheduler wants served next
+    jobs.selectNext(job);
 
-        neighbors = expandNode(current);
+    route.start = job.start;
+    route.dest = job.dest;
 
-        for(index = 0; (unsigned)index < neighbors.size(); index++)
-        {
-            //if already evaluated
-            if(closedSet.count(neighbors[index]) > 0)
-            {
-                continue;
-            }
+    computeRoute(route);
 
-            //if not in open set
-            if(openSet.count(neighbors[index]) < 1)
-            {
-                openSet.emplace(neighbors[index]);
-            }
+    //a destination cut off by closed or full roads would hold up the jobs
+    //behind it, set the job aside until something changes
+    if(route.route.empty())
+    {
+        jobs.strand(job.id);
 
-            tentativeGScore = gScore[current] //get current gScore and add the cost to get to neighbor
-                + static_cast<double>((
-                    subnetAdjacencyMatrix //get distance to neighbor from current
-                    [
-                        subnetToIndexTable[current] //translate name to index
-                    ]
-                    [
-                        subnetToIndexTable[neighbors[index]] //translate name to index
-                    ])); 
-
-            if(tentativeGScore > gScore[neighbors[index]])
-            {
-                continue;
-            }
+        strandedGraphVersion = graphVersion;
+        strandedOccupancyVersion = occupancyVersion;
 
-            cameFrom[neighbors[index]] = current;
+        return;
+    }
 
-            gScore[neighbors[index]] = tentativeGScore;
+    key = getJobKey(route.start, route.dest);
 
-            fScore[neighbors[index]] = tentativeGScore 
-                + subnetAdjacencyMatrix //get distance to neighbor from current
-                [
-                    subnetToIndexTable[current] //translate name to index
-                ]
-                [
-                    subnetToIndexTable[neighbors[index]] //translate name to index
-                ] 
-                * (vehiclesAtSubnet[neighbors[index]].size() + vehiclesAtSubnet[current].size());
-        }
+    if (jobs.getPolicy() == ADMIT_STALE_ROUTE)
+    {
+        cacheRoute(key, route.route);
+    }
 
+    //with several vehicles waiting, spread them over the alternatives
+    if (alternativeCount > 1 && jobs.getWaitingCount(key) > 1)
+    {
+        spreadAlternatives(route, key, job.id);
+    }
+    else
+    {
+        //the picked job takes the route first, then the others that can use it
+        //in class order, only the bucket of this start and destination has to
+        //be visited
+        jobs.deliver(key, getRouteRoom(route), job.id, [this, &route](const Job & waiting)
+        {
+            return sendRoute(waiting.id, route.route);
+        });
     }
 
-    return false;
+    //a job its route had no room for waits behind the rest of its class, so
+    //one full road does not hold up the whole class until vehicles move
+    jobs.requeue(job.id);
 }
 
 
 /**
- * @brief       Constructs route between nodes
- * @details     Moves through the cameFrom list and builds a route between current and
- *              Start node
+ * @brief       Spreads the vehicles waiting for a route over its alternatives
+ * @details     Computes up to alternativeCount routes for the start and
+ *              destination and hands each a share of the waiting vehicles in
+ *              proportion to its room, the vehicles it can still take. Shares
+ *              are rounded down and what is left goes to the best routes
+ *              first, so a lone vehicle always gets the best route. The
+ *              picked job is served by the first route with a share.
  * 
- * @param[in]   cameFrom  List of nodes and their parents
- * @param[in]   current   Current node
- * @param[in]   start     Start node
+ * @param[in]   route   best route for the start and destination
+ * @param[in]   key     bucket of the route, see getJobKey
+ * @param[in]   picked  vehicle of the job selectNext picked
  * 
- * @note    None
+ * @note        The room of alternatives that share a subnet overlaps, like
+ *              the room of a single route it is an estimate
  */
-Route CentralComputeNode::reconstructPath
-(
-    std::map<std::string, std::string> & cameFrom,
-    std::string & current,
-    std::string & start
-)
+void CentralComputeNode::spreadAlternatives(const Route & route, unsigned long long key, const std::string & picked)
 {
-    Route route;
-    
-    double cost = 0;
-
-    route.dest = current;
+    TRACE_SCOPE("ccn", "spreadAlternatives");
 
-    route.start = start;
+    int rooms[ALTERNATIVE_MAX], shares[ALTERNATIVE_MAX];
+    std::string first = picked;
+    int index, count, waiting, totalRoom = 0, assigned = 0, served;
 
-    if (cameFrom[current] != start && !cameFrom[current].empty())
+    //a job blocked at the head of the queue is retried until the vehicles
+    //move, there is no need to search again before they do
+    if (alternatives.empty() || key != alternativeKey || occupancyVersion != alternativeVersion)
     {
-        cost = static_cast<double>((
-            subnetAdjacencyMatrix //get distance to neighbor from current
-            [
-                subnetToIndexTable[current] //translate name to index
-            ]
-            [
-                subnetToIndexTable[cameFrom[current]] //translate name to index
-            ])); 
+        computeAlternatives(route);
+
+        alternativeKey = key;
+        alternativeVersion = occupancyVersion;
     }
-    else
+
+    count = (int)alternatives.size();
+    waiting = jobs.getWaitingCount(key);
+
+    for (index = 0; index < count; index++)
     {
-        cost = 0;
+        rooms[index] = std::max(0, getRouteRoom(alternatives[index]));
+        totalRoom += rooms[index];
     }
 
-    route.route.push_front(std::pair<std::string, double>(current, cost));
+    for (index = 0; index < count; index++)
+    {
+        shares[index] = waiting >= totalRoom ? rooms[index]
+                                             : (int)((long long)waiting * rooms[index] / totalRoom);
+        assigned += shares[index];
+    }
+
+    for (index = 0; index < count && assigned < std::min(waiting, totalRoom); index++)
+    {
+        if (shares[index] < rooms[index])
+        {
+            shares[index]++;
+            assigned++;
+        }
+    }
 
-    while (current != start && !current.empty())
+    for (index = 0; index < count; index++)
     {
-        if (!cameFrom[current].empty())
+        if (shares[index] == 0)
         {
-            cost = static_cast<double>((
-                subnetAdjacencyMatrix //get distance to neighbor from current
-                [
-                    subnetToIndexTable[current] //translate name to index
-                ]
-                [
-                    subnetToIndexTable[cameFrom[current]] //translate name to index
-                ])); 
+            continue;
         }
-        else
+
+        const Route & alternative = alternatives[index];
+
+        served = jobs.deliver(key, shares[index], first, [this, &alternative](const Job & waiting)
+        {
+            return sendRoute(waiting.id, alternative.route);
+        });
+
+        first.clear();
+
+        if (index > 0)
         {
-            cost = 0;
+            alternativeDeliveries += served;
         }
+    }
+}
+
+
+/**
+ * @brief       Computes alternatives to a route
+ * @details     Penalty method: the subnets of every route found so far cost
+ *              more, and A* is run again under the penalized costs. A route
+ *              found twice is skipped, and the search stops at the first route
+ *              costing more than ALTERNATIVE_STRETCH times the best. Fills
+ *              alternatives with the best route first.
+ * 
+ * @param[in]   route   best route for its start and destination
+ * 
+ * @note        The alternatives are searched with A* on the road graph
+ *              whatever the routing algorithm, under the same cost model
+ */
+void CentralComputeNode::computeAlternatives(const Route & route)
+{
+    TRACE_SCOPE("ccn", "computeAlternatives");
+
+    std::list<std::pair<std::string, double> >::const_iterator pathIter;
+
+    int start = getMapIndex(route.start), dest = getMapIndex(route.dest);
 
-        current = cameFrom[current];        
+    alternatives.resize(1);
+    alternatives[0] = route;
 
+    alternativePaths.resize(1);
+    alternativePaths[0].clear();
 
-        route.route.push_front(std::pair<std::string, double>(current, cost));
+    for (pathIter = route.route.begin(); pathIter != route.route.end(); ++pathIter)
+    {
+        alternativePaths[0].push_back(getMapIndex(pathIter->first));
     }
 
-    return route;
+    switch (costModel)
+    {
+    case COST_FREE_FLOW:
+        searchAlternatives(FreeFlowCost(), start, dest);
+        break;
+    case COST_BPR:
+        searchAlternatives(BprCost(subnetOccupancy, capacityByIndex), start, dest);
+        break;
+    case COST_CAPACITY:
+        searchAlternatives(CapacityCost(subnetOccupancy, capacityByIndex), start, dest);
+        break;
+    default:
+        searchAlternatives(LinearCost(subnetOccupancy), start, dest);
+        break;
+    }
 }
 
 
 /**
- * @brief       Expands specified node
- * @details     Looks at all neighbors of the specified node
+ * @brief       Searches alternatives to the best route
+ * @details     See computeAlternatives
  * 
- * @param[in]   current current node to look at the neighbors for
+ * @param[in]   cost    cost model of the roads
+ * @param[in]   start   index of the start node
+ * @param[in]   dest    index of the destination node
  * 
  * @note        None
  */
-std::vector<std::string> CentralComputeNode::expandNode(std::string current)
+template<typename Cost>
+void CentralComputeNode::searchAlternatives(const Cost & cost, int start, int dest)
 {
-    std::map<std::string, int>::iterator iter;
-    std::vector<std::string> neighbors;
+    SearchContext & context = getSearchContext();
+
+    double limit = getPathCost(cost, alternativePaths[0]) * ALTERNATIVE_STRETCH;
+    int attempt, node, found;
+    unsigned int index;
 
-    int currentAddr = subnetToIndexTable[current];
+    alternativePenalty.assign(roadGraph.getNodeCount(), 0);
 
-    for (iter = subnetToIndexTable.begin(); iter != subnetToIndexTable.end(); ++iter)
-    {      
+    const PenaltyCost<Cost> penalized(cost, alternativePenalty, ALTERNATIVE_PENALTY);
 
-        
-        //same or not a neighbor
-        if (subnetAdjacencyMatrix[currentAddr][iter->second] <= 0)
+    //a repeated route raises the penalties further, so the next search differs
+    for (attempt = 0, found = 1; attempt < 2 * alternativeCount && found < alternativeCount; attempt++)
+    {
+        const std::vector<int> & last = alternativePaths.back();
+
+        for (index = 1; index < last.size(); index++)
+        {
+            alternativePenalty[last[index]]++;
+        }
+
+        if (!AStarSearch(roadGraph, penalized, landmarks, context, start, dest))
+        {
+            return;
+        }
+
+        alternativePaths.resize(alternativePaths.size() + 1);
+
+        std::vector<int> & path = alternativePaths.back();
+
+        for (node = dest; node >= 0; node = node == start ? -1 : context.getParent(node))
+        {
+            path.push_back(node);
+        }
+
+        std::reverse(path.begin(), path.end());
+
+        if (getPathCost(cost, path) > limit)
+        {
+            alternativePaths.pop_back();
+            return;
+        }
+
+        if (std::find(alternativePaths.begin(), alternativePaths.end() - 1, path) != alternativePaths.end() - 1)
         {
             continue;
         }
 
-        neighbors.push_back(iter->first);
+        alternatives.resize(alternatives.size() + 1);
+        buildRoute(path, alternatives.back());
+        found++;
+    }
+}
+
+
+/**
+ * @brief       Cost of a path
+ * 
+ * @param[in]   cost    cost model of the roads
+ * @param[in]   path    subnet indices from start to destination
+ * 
+ * @note        None
+ */
+template<typename Cost>
+double CentralComputeNode::getPathCost(const Cost & cost, const std::vector<int> & path) const
+{
+    double total = 0;
+    unsigned int index;
+
+    for (index = 0; index + 1 < path.size(); index++)
+    {
+        total += cost(path[index], path[index + 1], roadGraph.getCost(path[index], path[index + 1]));
     }
 
-    return neighbors;
+    return total;
 }
 
 
 /**
- * @brief   Default job constructor
- * @details Constructs a job object
- * @note    None
+ * @brief       Room left on a route
+ * @details     How many more vehicles the subnet of the route with the least
+ *              capacity can take, counting the vehicle that asked for it
+ * 
+ * @param[in]   route   route to measure
+ * 
+ * @note        None
  */
-Job::Job() : start(""), dest(""), id("")
+int CentralComputeNode::getRouteRoom(const Route & route)
 {
+    std::list<std::pair<std::string, double> >::const_iterator pathIter;
+
+    int counter = 0, minCapacity = _INFINITY;
+
+    //find the minimum capacity
+    for(pathIter = route.route.begin(); pathIter != route.route.end(); ++pathIter)
+    {
+        if(subnetCapacity[pathIter->first] < minCapacity)
+        {
+            counter = (int)vehiclesAtSubnet[pathIter->first].size();
+            minCapacity = subnetCapacity[pathIter->first];
+        }
+    }
 
+    return minCapacity - counter + 1;
 }
 
+
 /**
- * @brief   Default job desructor
- * @details Destroys job object
- * @note    None
+ * @brief       Sends a route to a waiting vehicle
+ * 
+ * @param[in]   id      ID of the vehicle
+ * @param[in]   route   route to send
+ * 
+ * @note        Returns false if the vehicle has left the network
  */
-Job::~Job() {}
+bool CentralComputeNode::sendRoute(const std::string & id, const std::list<std::pair<std::string, double> > & route)
+{
+    std::map<std::string, Vehicle*>::iterator vehicle = vehicles.find(id);
+
+    if (vehicle == vehicles.end() || vehicle->second == NULL)
+    {
+        return false;
+    }
+
+    vehicle->second->getLock();
+    {
+        vehicle->second->setRoute(route);
+    }
+    vehicle->second->releaseLock();
+
+    return true;
+}
 
 
 /**
- * @brief   Route default constructor
- * @details Initializes route object
- * @note    None
+ * @brief       Add vehicle to network
+ * @details     Appends vehicle to the vehicle map
+ * 
+ * @param[in]   vehicle     Vehicle to add to the network
+ * 
+ * @note        None
  */
-Route::Route() : start(""), dest(""), route()
+void CentralComputeNode::joinNetwork(Vehicle * vehicle)
 {
+    vehicles[vehicle->getID()] = vehicle;
 
+    if (vehiclesAtSubnet[vehicle->getSource()].emplace(vehicle->getID()).second)
+    {
+        adjustOccupancy(vehicle->getSource(), 1);
+    }
 }
 
 
 /**
- * @brief   Default route destructor
- * @details Destroys route object
- * @note    None
+ * @brief       Allow Vehicle to leave network
+ * @details     Removes vehicle ID from network
+ * 
+ * @param[in]   id          ID of vehicle to remove
+ * @param[in]   lastNode    last known node vehicle is at
+ * 
+ * @note        None
  */
-Route::~Route() {}
+void CentralComputeNode::leaveNetwork(const std::string &id, const std::string &lastNode)
+{
+    vehicles.erase(id);
+    jobs.cancel(id);
+
+    if (vehiclesAtSubnet[lastNode].erase(id) > 0)
+    {
+        adjustOccupancy(lastNode, -1);
+    }
+}
+
+
+/**
+ * @brief       Hold the network open for more vehicles
+ * @details     While demand is pending, directTraffic keeps running even when
+ *              no vehicle is on the network, as streamed or remote vehicles are
+ *              still to join. Each source of vehicles sets it pending once and
+ *              clears it once, the network stays open until all have cleared it.
+ * 
+ * @param[in]   pending     whether more vehicles will join from this source
+ * 
+ * @note        None
+ */
+void CentralComputeNode::setDemandPending(bool pending)
+{
+    demandPending += pending ? 1 : -1;
+}
 
 
 /**
- * @brief       Finds the cheapest node
- * @details     Scans the opened set to find the least f-score node.
+ * @brief       Changes current road of vehicle
+ * @details     Determines whether to allow Vehicle to change road, and if so, update
+ *              vehicle location and count, else return false
  * 
- * @param[in]   set     set to be scanned for node
- * @param[in]   fScore  map of node IDs and associated f-scores
- * @param[out]  lowest  Cheapest node found
+ * @param[in]   id          vehicle ID
+ * @param[in]   currentRoad road vehicle is currently on
+ * @param[in]   newRoad     road vehicle is requesting to switch to
+ * 
+ * @note        None
+ */
+bool CentralComputeNode::changeRoad(std::string & id, std::string & currentRoad, std::string & newRoad)
+{
+    TRACE_SCOPE("ccn", "changeRoad");
+
+    if (currentRoad == newRoad)
+    {
+        return true;
+    }
+    
+    if(vehiclesAtSubnet[newRoad].size() < (unsigned int)subnetCapacity[newRoad])
+    {
+        moveVehicle(id, currentRoad, newRoad);
+
+        return true;
+    }
+
+    refuseRoadChange(newRoad);
+
+    return false;
+}
+
+
+/**
+ * @brief       Moves a vehicle between roads
+ * @details     Updates the vehicle sets and occupancy without checking the
+ *              capacity, for road changes another authority has allowed
+ *
+ * @param[in]   id          vehicle ID
+ * @param[in]   currentRoad road the vehicle leaves
+ * @param[in]   newRoad     road the vehicle turns onto
  *
  * @note        None
  */
-template<typename Type>
-bool GetCheapestNode(std::unordered_set<Type> & set, std::map<Type, double> & fScore, Type & lowest)
+void CentralComputeNode::moveVehicle(const std::string & id, const std::string & currentRoad,
+                                     const std::string & newRoad)
 {
-    int lowestCost = _INFINITY;
+    if (vehiclesAtSubnet[newRoad].emplace(id).second)
+    {
+        adjustOccupancy(newRoad, 1);
+    }
+
+    if (vehiclesAtSubnet[currentRoad].erase(id) > 0)
+    {
+        adjustOccupancy(currentRoad, -1);
+    }
+}
 
-    typename std::unordered_set<Type>::iterator iter;
 
-    if(set.empty())
+/**
+ * @brief       Counts a refused road change
+ *
+ * @param[in]   newRoad     road the vehicle was refused, as it was full
+ *
+ * @note        None
+ */
+void CentralComputeNode::refuseRoadChange(const std::string & newRoad)
+{
+    int index = getMapIndex(newRoad);
+
+    if (index >= 0)
     {
-        return false;
+        roadChangeFailures[index]++;
     }
+}
+
 
-    for(iter = set.begin(); iter != set.end(); ++iter)
+/**
+ * @brief   Get the settled node count
+ * @details Returns how many subnets the last route query of the calling thread
+ *          settled
+ * @note    None
+ */
+int CentralComputeNode::getSettledNodeCount() const
+{
+    if (routingAlgorithm == ROUTE_HIERARCHY)
     {
-        if(fScore.count(*iter) == 0)
-        {
-            fScore[*iter] = _INFINITY;
-        }
+        return hierarchy.getScannedCount();
+    }
 
-        if(fScore[*iter] < lowestCost)
-        {
-            lowestCost = fScore[*iter];
+    if (routingAlgorithm == ROUTE_BIDIRECTIONAL)
+    {
+        return getSearchContext().getSettledCount() + getBackwardSearchContext().getSettledCount();
+    }
 
-            lowest = *iter;
-        }
+    //table lookups do not search
+    if (routingAlgorithm == ROUTE_ALL_PAIRS)
+    {
+        return 0;
     }
 
+    return getSearchContext().getSettledCount();
+}
+
+
+/**
+ * @brief       Builds the landmark tables
+ * @details     Selects landmarks on the free flow travel times of the current
+ *              map and precomputes their distance tables for the A* heuristic.
+ * 
+ * @param[in]   landmarkCount   number of landmarks to select
+ * @param[in]   strategy        landmark selection strategy
+ * @param[in]   threadCount     number of threads used for the tables
+ * 
+ * @note        None
+ */
+void CentralComputeNode::buildLandmarks(int landmarkCount, LandmarkStrategy strategy, int threadCount)
+{
+    landmarks.build(roadGraph, landmarkCount, strategy, threadCount);
+    landmarkRoadCosts = roadGraph.costs;
+}
+
+
+/**
+ * @brief       Saves the landmark tables
+ * @details     Writes the tables together with the checksum of the current map
+ * 
+ * @param[in]   fileName    file to write
+ * 
+ * @note        None
+ */
+bool CentralComputeNode::saveLandmarks(const std::string & fileName) const
+{
+    return landmarks.save(fileName, roadGraph.getChecksum());
+}
+
+
+/**
+ * @brief       Loads the landmark tables
+ * @details     Reads tables written by saveLandmarks(), files written for a
+ *              different map are rejected
+ * 
+ * @param[in]   fileName    file to read
+ * 
+ * @note        None
+ */
+bool CentralComputeNode::loadLandmarks(const std::string & fileName)
+{
+    if (!landmarks.load(fileName, roadGraph.getChecksum(), roadGraph.getNodeCount()))
+    {
+        return false;
+    }
+
+    landmarkRoadCosts = roadGraph.costs;
+
     return true;
+}
+
+
+/**
+ * @brief       Selects the route search
+ * @details     Sets the algorithm used by computeRoute
+ * 
+ * @param[in]   algorithm   search to use for new routes
+ * 
+ * @note        None
+ */
+void CentralComputeNode::setRoutingAlgorithm(RoutingAlgorithm algorithm)
+{
+    routingAlgorithm = algorithm;
+}
+
+
+/**
+ * @brief       Sets the cost model
+ * @details     Selects how every search costs a road, see CostModel
+ * 
+ * @param[in]   model   cost model to use
+ * 
+ * @note        A hierarchy is re-customized for the new model at once, the
+ *              distance table is recomputed on next use
+ */
+void CentralComputeNode::setCostModel(CostModel model)
+{
+    costModel = model;
+
+    if (hierarchy.isBuilt())
+    {
+        customizeHierarchy();
+    }
 
+    distanceTable.reset();
+    clearRouteCache();
+}
+
+
+/**
+ * @brief   Get the cost model
+ * @note    None
+ */
+CostModel CentralComputeNode::getCostModel() const
+{
+    return costModel;
 }
+
+
+/**
+ * @brief       Sets how many routes are offered per start and destination
+ * @details     With more than one, the vehicles waiting for the same start
+ *              and destination are spread over alternative routes, see
+ *              spreadAlternatives
+ * 
+ * @param[in]   count   routes offered, 1 sends every vehicle the best route
+ * 
+ * @note        Limited to ALTERNATIVE_MAX
+ */
+void CentralComputeNode::setAlternativeRoutes(int count)
+{
+    alternativeCount = std::max(1, std::min(count, ALTERNATIVE_MAX));
+}
+
+
+/**
+ * @brief   Get the number of vehicles sent on an alternative route
+ * @note    None
+ */
+long long CentralComputeNode::getAlternativeRouteCount() const
+{
+    return alternativeDeliveries;
+}
+
+
+/**
+ * @brief   Get the number of road changes refused, as the subnet was full
+ * @note    None
+ */
+long long CentralComputeNode::getRoadChangeFailureCount() const
+{
+    long long total = 0;
+    unsigned int index;
+
+    for (index = 0; index < roadChangeFailures.size(); index++)
+    {
+        total += roadChangeFailures[index];
+    }
+
+    return total;
+}
+
+
+/**
+ * @brief       Sets how stale the hierarchy metric may get
+ * @details     The hierarchy is re-customized before a query once this many
+ *              vehicles have changed subnets since the last customization.
+ *              Customizing costs about as much as searching the whole map, so
+ *              by default one move is tolerated per CUSTOMIZATION_SUBNETS_PER_MOVE
+ *              subnets and the cost is spread over the moves in between.
+ * 
+ * @param[in]   roadChanges     vehicle moves tolerated, 1 keeps it exact, 0
+ *                              scales it with the map
+ * 
+ * @note        A change to the roads re-customizes on the next query whatever
+ *              the interval
+ */
+void CentralComputeNode::setCustomizationInterval(int roadChanges)
+{
+    customizationInterval = roadChanges < 0 ? 0 : roadChanges;
+}
+
+
+/**
+ * @brief   Get the customization interval
+ * @details Returns the vehicle moves tolerated before the hierarchy is
+ *          re-customized, scaled with the map when none was set
+ * @note    None
+ */
+int CentralComputeNode::getCustomizationInterval() const
+{
+    if (customizationInterval > 0)
+    {
+        return customizationInterval;
+    }
+
+    return std::max(1, roadGraph.getNodeCount() / CUSTOMIZATION_SUBNETS_PER_MOVE);
+}
+
+
+/**
+ * @brief       Set the share of a priority class
+ * @details     TRANSIT and PRIVATE jobs are routed in proportion to their weights
+ *              while both are waiting
+ * 
+ * @param[in]   priority    class to change
+ * @param[in]   weight      relative share, at least 1
+ * 
+ * @note        None
+ */
+void CentralComputeNode::setPriorityWeight(JobPriority priority, int weight)
+{
+    jobs.setWeight(priority, weight);
+}
+
+
+/**
+ * @brief       Get the route latency of a priority class
+ * @details     Returns the time from queueing to delivery of the routes handed
+ *              out to jobs of the class so far
+ * 
+ * @param[in]   priority    class to report
+ * 
+ * @note        None
+ */
+const LatencyStats & CentralComputeNode::getLatencyStats(JobPriority priority) const
+{
+    return jobs.getLatencyStats(priority);
+}
+
+
+/**
+ * @brief       Set up admission control
+ * @details     Limits how many jobs may wait and sets what happens to jobs that
+ *              arrive while the queue is full
+ * 
+ * @param[in]   capacity    most queued jobs, 0 for no limit
+ * @param[in]   policy      reject, delay or answer with a stale route
+ * 
+ * @note        EMERGENCY jobs are always admitted
+ */
+void CentralComputeNode::setAdmissionControl(int capacity, AdmissionPolicy policy)
+{
+    jobs.setCapacity(capacity, policy);
+
+    if (policy != ADMIT_STALE_ROUTE)
+    {
+        clearRouteCache();
+    }
+}
+
+
+/**
+ * @brief   Get the queue depth
+ * @details Returns the number of jobs waiting for a route
+ * @note    None
+ */
+int CentralComputeNode::getQueueDepth() const
+{
+    return jobs.getSize();
+}
+
+
+/**
+ * @brief   Get the delayed job count
+ * @details Returns the number of jobs parked until the queue has room
+ * @note    None
+ */
+int CentralComputeNode::getDelayedJobCount() const
+{
+    return jobs.getDelayedCount();
+}
+
+
+/**
+ * @brief   Get the admission counters
+ * @details Returns how many jobs were queued, coalesced, delayed and shed
+ * @note    None
+ */
+const AdmissionStats & CentralComputeNode::getAdmissionStats() const
+{
+    return jobs.getAdmissionStats();
+}
+
+
+/**
+ * @brief       Writes the network to a checkpoint
+ * @details     Writes the checksum and size of the map the checkpoint belongs
+ *              to, and lists the vehicles on the network so the caller can
+ *              write them one at a time with saveVehicle
+ *
+ * @param[in]   writer      checkpoint to write to
+ * @param[out]  vehicleIds  vehicles on the network
+ *
+ * @note        The caller holds the lock of the Compute Node
+ */
+void CentralComputeNode::saveState(CheckpointWriter & writer, std::vector<std::string> & vehicleIds) const
+{
+    std::map<std::string, Vehicle*>::const_iterator vehicle;
+
+    writer.writeInt((long long)roadGraph.getChecksum());
+    writer.writeInt(roadGraph.getNodeCount());
+
+    vehicleIds.clear();
+
+    for (vehicle = vehicles.begin(); vehicle != vehicles.end(); ++vehicle)
+    {
+        vehicleIds.push_back(vehicle->first);
+    }
+}
+
+
+/**
+ * @brief       Writes one vehicle to a checkpoint
+ * @details     The vehicle is only tried for its lock, as vehicles take their
+ *              own lock before the lock of the Compute Node. Each vehicle
+ *              written is preceded by a 1.
+ *
+ * @param[in]   writer  checkpoint to write to
+ * @param[in]   id      vehicle to write
+ *
+ * @note        The caller holds the lock of the Compute Node. Returns 1 if the
+ *              vehicle was written, 0 if it has left the network and -1 if it
+ *              is busy and should be tried again after releasing the lock.
+ */
+int CentralComputeNode::saveVehicle(CheckpointWriter & writer, const std::string & id) const
+{
+    std::map<std::string, Vehicle*>::const_iterator vehicle = vehicles.find(id);
+
+    if (vehicle == vehicles.end() || vehicle->second == NULL)
+    {
+        return 0;
+    }
+
+    if (!vehicle->second->tryLock())
+    {
+        return -1;
+    }
+
+    writer.writeInt(1);
+    vehicle->second->save(writer);
+
+    vehicle->second->releaseLock();
+
+    return 1;
+}
+
+
+/**
+ * @brief       Writes the waiting jobs to a checkpoint
+ *
+ * @param[in]   writer  checkpoint to write to
+ *
+ * @note        The caller holds the lock of the Compute Node
+ */
+void CentralComputeNode::saveJobs(CheckpointWriter & writer) const
+{
+    jobs.save(writer);
+}
+
+
+/**
+ * @brief       Checks a checkpoint against the map
+ * @details     Reads what saveState wrote, apart from the vehicle list
+ *
+ * @param[in]   reader  checkpoint to read from
+ *
+ * @note        Returns false if the checkpoint was written for another map
+ */
+bool CentralComputeNode::restoreState(CheckpointReader & reader) const
+{
+    unsigned long long checksum = (unsigned long long)reader.readInt();
+    long long nodeCount = reader.readInt();
+
+    return reader.isGood() && checksum == roadGraph.getChecksum() && nodeCount == roadGraph.getNodeCount();
+}
+
+
+/**
+ * @brief       Reads the waiting jobs from a checkpoint
+ * @details     Queues the jobs again in their saved order with their original
+ *              wait, so deadlines and latencies carry on. Jobs of vehicles that
+ *              are not waiting for a route any more are dropped.
+ *
+ * @param[in]   reader  checkpoint to read from
+ * @param[in]   waiting vehicles restored without a route
+ *
+ * @note        Returns the number of jobs queued, or -1 if the checkpoint ended
+ *              early
+ */
+int CentralComputeNode::restoreJobs(CheckpointReader & reader, const std::unordered_set<std::string> & waiting)
+{
+    long long count = reader.readInt(), index;
+    int restored = 0;
+    Job job;
+
+    for (index = 0; index < count && reader.isGood(); index++)
+    {
+        job.load(reader);
+
+        if (waiting.count(job.id) > 0 && jobs.push(job, getJobKey(job.start, job.dest)) != JOB_REJECTED)
+        {
+            restored++;
+        }
+    }
+
+    return reader.isGood() ? restored : -1;
+}
+
+
+/**
+ * @brief       Get the subnets
+ * @details     Returns the name and capacity of every subnet by index
+ *
+ * @param[out]  names       subnet names
+ * @param[out]  capacities  subnet capacities
+ *
+ * @note        None
+ */
+void CentralComputeNode::getSubnets(std::vector<std::string> & names, std::vector<int> & capacities)
+{
+    int index;
+
+    names = indexToSubnetTable;
+    capacities.resize(names.size());
+
+    for (index = 0; index < (int)names.size(); index++)
+    {
+        capacities[index] = subnetCapacity[names[index]];
+    }
+}
+
+
+/**
+ * @brief   Get the road graph of the city
+ * @note    None
+ */
+const RoadGraph & CentralComputeNode::getRoadGraph() const
+{
+    return roadGraph;
+}
+
+
+/**
+ * @brief       Samples the state of the network
+ * @details     Copies the occupancy and road change failures of every subnet
+ *              and the queue length into sample. Both are kept by index, so
+ *              this is two flat copies however many vehicles there are.
+ *
+ * @param[out]  sample  state of the network, timeMS is left to the caller
+ *
+ * @note        The caller holds the lock of the Compute Node
+ */
+void CentralComputeNode::sampleOccupancy(OccupancySample & sample) const
+{
+    sample.queueLength = jobs.getSize();
+    sample.occupancy.assign(subnetOccupancy.begin(), subnetOccupancy.end());
+    sample.failures.assign(roadChangeFailures.begin(), roadChangeFailures.end());
+}
+
+
+/**
+ * @brief       A* Search Algorithm
+ * @details     Computes a route based on the starting and end nodes using the A*
+ *              Search algorithm, with the cost of a road given by the cost
+ *              model. The heuristic is the landmark lower bound on the free
+ *              flow travel time, which no cost model goes below, so it stays
+ *              admissible.
+ * 
+ * @param[out]  route   route to be computed and returned   
+ * 
+ * @note        Labels and the open list live in the per-thread SearchContext,
+ *              so no memory is allocated by the search itself once the context
+ *              has grown to the size of the graph.
+ */
+bool CentralComputeNode::aStar(Route & route)
+{
+    TRACE_SCOPE("ccn", "aStar");
+
+    SearchContext & context = getSearchContext();
+
+    int start, dest;
+
+    bool found;
+
+    start = getMapIndex(route.start);
+    dest = getMapIndex(route.dest);
+
+    if (start < 0 || dest < 0 || roadGraph.getNodeCount() == 0)
+    {
+        return false;
+    }
+
+    //the model is picked once per query, each search has its cost inlined
+    switch (costModel)
+    {
+    case COST_FREE_FLOW:
+        found = AStarSearch(roadGraph, FreeFlowCost(), landmarks, context, start, dest);
+        break;
+    case COST_BPR:
+        found = AStarSearch(roadGraph, BprCost(subnetOccupancy, capacityByIndex), landmarks, context, start, dest);
+        break;
+    case COST_CAPACITY:
+        found = AStarSearch(roadGraph, CapacityCost(subnetOccupancy, capacityByIndex), landmarks, context, start, dest);
+        break;
+    default:
+        found = AStarSearch(roadGraph, LinearCost(subnetOccupancy), landmarks, context, start, dest);
+        break;
+    }
+
+    if (found)
+    {
+        reconstructPath(context, dest, start, route);
+    }
+
+    return found;
+}
+
+
+/**
+ * @brief       Bidirectional Search Algorithm
+ * @details     Searches forward from the start and backward from the
+ *              destination until the two searches meet, see
+ *              BidirectionalSearch
+ * 
+ * @param[out]  route   route to be computed and returned   
+ * 
+ * @note        None
+ */
+bool CentralComputeNode::bidirectionalSearch(Route & route)
+{
+    TRACE_SCOPE("ccn", "bidirectionalSearch");
+
+    SearchContext & forward = getSearchContext();
+    SearchContext & backward = getBackwardSearchContext();
+
+    int start, dest, node, next, meet;
+
+    start = getMapIndex(route.start);
+    dest = getMapIndex(route.dest);
+
+    if (start < 0 || dest < 0 || roadGraph.getNodeCount() == 0)
+    {
+        return false;
+    }
+
+    switch (costModel)
+    {
+    case COST_FREE_FLOW:
+        meet = BidirectionalSearch(roadGraph, reverseGraph, FreeFlowCost(), landmarks,
+                                   forward, backward, start, dest);
+        break;
+    case COST_BPR:
+        meet = BidirectionalSearch(roadGraph, reverseGraph, BprCost(subnetOccupancy, capacityByIndex), landmarks,
+                                   forward, backward, start, dest);
+        break;
+    case COST_CAPACITY:
+        meet = BidirectionalSearch(roadGraph, reverseGraph, CapacityCost(subnetOccupancy, capacityByIndex), landmarks,
+                                   forward, backward, start, dest);
+        break;
+    default:
+        meet = BidirectionalSearch(roadGraph, reverseGraph, LinearCost(subnetOccupancy), landmarks,
+                                   forward, backward, start, dest);
+        break;
+    }
+
+    if (meet < 0)
+    {
+        return false;
+    }
+
+    reconstructPath(forward, meet, start, route);
+
+    //splice on the half found by the backward search, its parents lead to dest
+    for (node = meet; (next = backward.getParent(node)) >= 0; node = next)
+    {
+        route.route.back().second = roadGraph.getCost(node, next);
+        route.route.push_back(std::pair<std::string, double>(indexToSubnetTable[next], 0));
+    }
+
+    route.dest = indexToSubnetTable[dest];
+
+    return true;
+}
+
+
+/**
+ * @brief       Finds a road
+ * @details     Looks the road up among the roads leaving from, and its
+ *              reversed copy among the roads of reverseGraph leaving to
+ *
+ * @param[in]   from        subnet the road starts at
+ * @param[in]   to          subnet the road ends at
+ * @param[out]  edge        index of the road in roadGraph
+ * @param[out]  reverseEdge index of the road in reverseGraph
+ *
+ * @note        Returns false if there is no road from one to the other
+ */
+bool CentralComputeNode::findRoad(const std::string & from, const std::string & to, int & edge, int & reverseEdge)
+{
+    int start = getMapIndex(from), end = getMapIndex(to);
+
+    if (start < 0 || end < 0 || start >= roadGraph.getNodeCount() || end >= roadGraph.getNodeCount())
+    {
+        return false;
+    }
+
+    for (edge = roadGraph.offsets[start]; edge < roadGraph.offsets[start + 1]; edge++)
+    {
+        if (roadGraph.targets[edge] == end)
+        {
+            break;
+        }
+    }
+
+    for (reverseEdge = reverseGraph.offsets[end]; reverseEdge < reverseGraph.offsets[end + 1]; reverseEdge++)
+    {
+        if (reverseGraph.targets[reverseEdge] == start)
+        {
+            break;
+        }
+    }
+
+    return edge < roadGraph.offsets[start + 1] && reverseEdge < reverseGraph.offsets[end + 1];
+}
+
+
+/**
+ * @brief       Changes the cost of one road
+ * @details     Updates both graphs and drops only what the change makes wrong.
+ *              The landmark bounds stay valid while no road is cheaper than
+ *              when they were made, so they are only dropped when one is.
+ *              Only the cached routes over the road are visited and dropped,
+ *              found through cachedRoutesByRoad. The hierarchy
+ *              and the distance table catch up with the new graph version on
+ *              their next query.
+ *
+ * @param[in]   edge        index of the road in roadGraph
+ * @param[in]   reverseEdge index of the road in reverseGraph
+ * @param[in]   cost        new travel time, SEARCH_INFINITY when closed
+ *
+ * @note        None
+ */
+void CentralComputeNode::changeRoadCost(int edge, int reverseEdge, double cost)
+{
+    std::unordered_map<int, std::vector<unsigned long long> >::iterator overRoad;
+    std::vector<unsigned long long> keys;
+    unsigned int index;
+
+    roadGraph.costs[edge] = cost;
+    reverseGraph.costs[reverseEdge] = cost;
+
+    if (!landmarks.isEmpty() && edge < (int)landmarkRoadCosts.size() && cost < landmarkRoadCosts[edge])
+    {
+        landmarks.clear();
+        landmarkRoadCosts.clear();
+    }
+
+    overRoad = cachedRoutesByRoad.find(edge);
+
+    if (overRoad != cachedRoutesByRoad.end())
+    {
+        keys.swap(overRoad->second);
+
+        for (index = 0; index < keys.size(); index++)
+        {
+            uncacheRoute(keys[index]);
+        }
+    }
+
+    invalidateMetric();
+}
+
+
+/**
+ * @brief       Keeps a route for ADMIT_STALE_ROUTE
+ * @details     Replaces the cached route of the start and destination and files
+ *              its key under every road of the route, so a road update finds
+ *              the routes over it without scanning the cache
+ *
+ * @param[in]   key     start and destination, see getJobKey
+ * @param[in]   route   route to keep
+ *
+ * @note        The cache is cleared when full, it only has to cover recent
+ *              routes
+ */
+void CentralComputeNode::cacheRoute(unsigned long long key, const std::list<std::pair<std::string, double> > & route)
+{
+    unsigned int index;
+
+    if (routeCache.count(key) > 0)
+    {
+        uncacheRoute(key);
+    }
+    else if (routeCache.size() >= ROUTE_CACHE_LIMIT)
+    {
+        clearRouteCache();
+    }
+
+    routeCache[key] = route;
+
+    findRouteRoads(route, cachedRouteRoads);
+
+    for (index = 0; index < cachedRouteRoads.size(); index++)
+    {
+        cachedRoutesByRoad[cachedRouteRoads[index]].push_back(key);
+    }
+}
+
+
+/**
+ * @brief       Drops a cached route
+ * @details     Erases the route and its key from the roads it was filed under
+ *
+ * @param[in]   key     start and destination, see getJobKey
+ *
+ * @note        None
+ */
+void CentralComputeNode::uncacheRoute(unsigned long long key)
+{
+    std::unordered_map<unsigned long long, std::list<std::pair<std::string, double> > >::iterator cached;
+    std::unordered_map<int, std::vector<unsigned long long> >::iterator overRoad;
+    unsigned int index;
+
+    cached = routeCache.find(key);
+
+    if (cached == routeCache.end())
+    {
+        return;
+    }
+
+    findRouteRoads(cached->second, cachedRouteRoads);
+
+    for (index = 0; index < cachedRouteRoads.size(); index++)
+    {
+        overRoad = cachedRoutesByRoad.find(cachedRouteRoads[index]);
+
+        if (overRoad == cachedRoutesByRoad.end())
+        {
+            continue;
+        }
+
+        overRoad->second.erase(std::remove(overRoad->second.begin(), overRoad->second.end(), key),
+                               overRoad->second.end());
+
+        if (overRoad->second.empty())
+        {
+            cachedRoutesByRoad.erase(overRoad);
+        }
+    }
+
+    routeCache.erase(cached);
+}
+
+
+/**
+ * @brief   Drops every cached route
+ * @details Clears the cache and its index by road
+ * @note    None
+ */
+void CentralComputeNode::clearRouteCache()
+{
+    routeCache.clear();
+    cachedRoutesByRoad.clear();
+}
+
+
+/**
+ * @brief       Finds the roads of a route
+ * @details     Looks each step of the route up among the roads leaving the
+ *              subnet before it
+ *
+ * @param[in]   route   route of subnet names
+ * @param[out]  edges   index in roadGraph of every road of the route
+ *
+ * @note        Steps with no road between them are skipped
+ */
+void CentralComputeNode::findRouteRoads(const std::list<std::pair<std::string, double> > & route,
+                                        std::vector<int> & edges)
+{
+    std::list<std::pair<std::string, double> >::const_iterator step;
+    int from = -1, to, edge;
+
+    edges.clear();
+
+    for (step = route.begin(); step != route.end(); ++step)
+    {
+        to = getMapIndex(step->first);
+
+        if (from >= 0 && to >= 0 && from < roadGraph.getNodeCount())
+        {
+            for (edge = roadGraph.offsets[from]; edge < roadGraph.offsets[from + 1]; edge++)
+            {
+                if (roadGraph.targets[edge] == to)
+                {
+                    edges.push_back(edge);
+                    break;
+                }
+            }
+        }
+
+        from = to;
+    }
+}
+
+
+/**
+ * @brief   Marks the costs of the roads as changed
+ * @details Bumps the graph version, so the hierarchy is re-customized and the
+ *          distance table recomputed on their next query, and drops the
+ *          alternatives
+ * @note    None
+ */
+void CentralComputeNode::invalidateMetric()
+{
+    graphVersion++;
+    alternatives.clear();
+}
+
+
+/**
+ * @brief       Constructs route between nodes
+ * @details     Follows the parents stored in the search context from current
+ *              back to the start node and builds the route in place. Each
+ *              entry holds the time needed to reach the next entry.
+ * 
+ * @param[in]   context   search context holding the parents
+ * @param[in]   current   index of the last node of the route
+ * @param[in]   start     index of the start node
+ * @param[out]  route     route to be filled
+ * 
+ * @note    None
+ */
+void CentralComputeNode::reconstructPath
+(
+    const SearchContext & context,
+    int current,
+    int start,
+    Route & route
+)
+{
+    int parent;
+
+    route.start = indexToSubnetTable[start];
+    route.dest = indexToSubnetTable[current];
+
+    route.route.clear();
+
+    route.route.push_front(std::pair<std::string, double>(indexToSubnetTable[current], 0));
+
+    while (current != start && (parent = context.getParent(current)) >= 0)
+    {
+        route.route.push_front(std::pair<std::string, double>(indexToSubnetTable[parent], 
+            roadGraph.getCost(parent, current)));
+
+        current = parent;
+    }
+}
+
+
+/**
+ * @brief       Contraction hierarchy search
+ * @details     Builds the hierarchy on first use and re-customizes it when the
+ *              occupancy has drifted, then answers the route from it
+ * 
+ * @param[out]  route   route to be computed and returned
+ * 
+ * @note        None
+ */
+bool CentralComputeNode::hierarchySearch(Route & route)
+{
+    TRACE_SCOPE("ccn", "hierarchySearch");
+
+    int start, dest;
+    double cost;
+
+    start = getMapIndex(route.start);
+    dest = getMapIndex(route.dest);
+
+    if (start < 0 || dest < 0 || roadGraph.getNodeCount() == 0)
+    {
+        return false;
+    }
+
+    if (!hierarchy.isBuilt())
+    {
+        hierarchy.build(roadGraph);
+        customizeHierarchy();
+    }
+    else if (occupancyVersion - hierarchyVersion >= (unsigned)getCustomizationInterval()
+        || hierarchyGraphVersion != graphVersion)
+    {
+        customizeHierarchy();
+    }
+
+    if (!hierarchy.query(start, dest, hierarchyPath, cost))
+    {
+        return false;
+    }
+
+    buildRoute(hierarchyPath, route);
+
+    return true;
+}
+
+
+/**
+ * @brief       Customizes the hierarchy
+ * @details     Applies the current congested cost of every road
+ * 
+ * @note        None
+ */
+void CentralComputeNode::customizeHierarchy()
+{
+    TRACE_SCOPE("ccn", "customizeHierarchy");
+
+    computeRoadCosts(hierarchyMetric);
+
+    hierarchy.customize(hierarchyMetric);
+
+    hierarchyVersion = occupancyVersion;
+    hierarchyGraphVersion = graphVersion;
+}
+
+
+/**
+ * @brief       All pairs table search
+ * @details     Reads the route off the distance table, computing the table
+ *              first if there is none for the current map. Cities too large
+ *              for a table fall back to A*.
+ * 
+ * @param[out]  route   route to be computed and returned
+ * 
+ * @note        None
+ */
+bool CentralComputeNode::tableSearch(Route & route)
+{
+    TRACE_SCOPE("ccn", "tableSearch");
+
+    int start, dest;
+
+    start = getMapIndex(route.start);
+    dest = getMapIndex(route.dest);
+
+    if (start < 0 || dest < 0 || roadGraph.getNodeCount() == 0)
+    {
+        return false;
+    }
+
+    if (!distanceTable || distanceTable->getNodeCount() != roadGraph.getNodeCount()
+        || tableGraphVersion != graphVersion)
+    {
+        if (roadGraph.getNodeCount() > ALL_PAIRS_MAX_SUBNETS)
+        {
+            return aStar(route);
+        }
+
+        refreshTable();
+    }
+
+    if (!distanceTable->getPath(start, dest, tablePath))
+    {
+        return false;
+    }
+
+    buildRoute(tablePath, route);
+
+    return true;
+}
+
+
+/**
+ * @brief       Recomputes the distance table
+ * @details     Computes a new table for the current congested costs and
+ *              replaces the old one
+ * 
+ * @note        The caller holds the lock of the Compute Node
+ */
+void CentralComputeNode::refreshTable()
+{
+    TRACE_SCOPE("ccn", "refreshTable");
+
+    std::shared_ptr<DistanceTable> table = std::make_shared<DistanceTable>();
+    std::vector<double> costs;
+
+    computeRoadCosts(costs);
+
+    table->compute(roadGraph, costs, (int)std::thread::hardware_concurrency());
+
+    distanceTable = table;
+    tableVersion = occupancyVersion;
+    tableGraphVersion = graphVersion;
+}
+
+
+/**
+ * @brief       Starts the background table refresh
+ * @details     Launches a thread that recomputes the distance table every
+ *              period while the occupancy keeps changing. The new table is
+ *              computed without holding the lock and swapped in when done, so
+ *              routes keep being served from the old one in the meantime.
+ * 
+ * @param[in]   periodMS    time between refreshes in milliseconds
+ * 
+ * @note        None
+ */
+void CentralComputeNode::startTableRefresh(long long periodMS)
+{
+    stopTableRefresh();
+
+    tableRefreshRunning = true;
+    tableRefreshThread = std::thread(&CentralComputeNode::tableRefreshLoop, this, periodMS);
+}
+
+
+/**
+ * @brief   Stops the background table refresh
+ * @details Signals the refresh thread and waits for it to finish
+ * @note    None
+ */
+void CentralComputeNode::stopTableRefresh()
+{
+    tableRefreshRunning = false;
+
+    if (tableRefreshThread.joinable())
+    {
+        tableRefreshThread.join();
+    }
+}
+
+
+/**
+ * @brief       Background table refresh
+ * @details     Body of the refresh thread. Takes a snapshot of the road graph
+ *              and the congested costs under the lock, computes the table
+ *              outside of it and swaps it in.
+ * 
+ * @param[in]   periodMS    time between refreshes in milliseconds
+ * 
+ * @note        None
+ */
+void CentralComputeNode::tableRefreshLoop(long long periodMS)
+{
+    TRACE_THREAD_NAME("table refresh");
+
+    std::shared_ptr<DistanceTable> table;
+    RoadGraph graph;
+    std::vector<double> costs;
+    unsigned long long version, snapshotGraphVersion = 0;
+    long long waited;
+    bool stale;
+
+    while (tableRefreshRunning)
+    {
+        //sleep in short slices so stopping does not wait a whole period
+        for (waited = 0; waited < periodMS && tableRefreshRunning; waited += TABLE_REFRESH_SLICE_MS)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(TABLE_REFRESH_SLICE_MS));
+        }
+
+        getLock();
+        {
+            version = occupancyVersion;
+            snapshotGraphVersion = graphVersion;
+            stale = (!distanceTable || version != tableVersion || snapshotGraphVersion != tableGraphVersion)
+                && roadGraph.getNodeCount() > 0 && roadGraph.getNodeCount() <= ALL_PAIRS_MAX_SUBNETS;
+
+            if (stale)
+            {
+                graph = roadGraph;
+                computeRoadCosts(costs);
+            }
+        }
+        releaseLock();
+
+        if (!stale || !tableRefreshRunning)
+        {
+            continue;
+        }
+
+        table = std::make_shared<DistanceTable>();
+
+        {
+            TRACE_SCOPE("ccn", "refreshTable");
+
+            table->compute(graph, costs, (int)std::thread::hardware_concurrency());
+        }
+
+        getLock();
+        {
+            //the roads may have changed while computing
+            if (snapshotGraphVersion == graphVersion)
+            {
+                distanceTable = table;
+                tableVersion = version;
+                tableGraphVersion = snapshotGraphVersion;
+            }
+        }
+        releaseLock();
+    }
+}
+
+
+/**
+ * @brief       Builds a route from subnet indices
+ * @details     Each entry of the route holds the time needed to reach the next
+ *              entry, the same layout reconstructPath produces
+ * 
+ * @param[in]   path    subnet indices from start to destination
+ * @param[out]  route   route to be filled
+ * 
+ * @note        None
+ */
+void CentralComputeNode::buildRoute(const std::vector<int> & path, Route & route)
+{
+    unsigned int index;
+
+    route.start = indexToSubnetTable[path.front()];
+    route.dest = indexToSubnetTable[path.back()];
+
+    route.route.clear();
+
+    for (index = 0; index + 1 < path.size(); index++)
+    {
+        route.route.push_back(std::pair<std::string, double>(indexToSubnetTable[path[index]],
+            roadGraph.getCost(path[index], path[index + 1])));
+    }
+
+    route.route.push_back(std::pair<std::string, double>(indexToSubnetTable[path.back()], 0));
+}
+
+
+/**
+ * @brief       Key of a job bucket
+ * @details     Packs the map indices of a start and destination into the key of
+ *              their bucket in the job queue
+ * 
+ * @param[in]   start   subnet the route starts at
+ * @param[in]   dest    subnet the route ends at
+ * 
+ * @note        Subnets missing from the map share index -1, their jobs never
+ *              get a route
+ */
+unsigned long long CentralComputeNode::getJobKey(const std::string & start, const std::string & dest)
+{
+    return ((unsigned long long)(unsigned int)getMapIndex(start) << 32) | (unsigned int)getMapIndex(dest);
+}
+
+
+/**
+ * @brief       Congested cost of every road
+ * @details     Fills costs with the cost model of each road of the road graph,
+ *              in the order of roadGraph.targets
+ * 
+ * @param[out]  costs   cost of every road
+ * 
+ * @note        None
+ */
+void CentralComputeNode::computeRoadCosts(std::vector<double> & costs) const
+{
+    switch (costModel)
+    {
+    case COST_FREE_FLOW:
+        FillRoadCosts(roadGraph, FreeFlowCost(), costs);
+        break;
+    case COST_BPR:
+        FillRoadCosts(roadGraph, BprCost(subnetOccupancy, capacityByIndex), costs);
+        break;
+    case COST_CAPACITY:
+        FillRoadCosts(roadGraph, CapacityCost(subnetOccupancy, capacityByIndex), costs);
+        break;
+    default:
+        FillRoadCosts(roadGraph, LinearCost(subnetOccupancy), costs);
+        break;
+    }
+}
+
+
+/**
+ * @brief       Updates the occupancy of a subnet
+ * @details     Keeps subnetOccupancy in step with vehiclesAtSubnet
+ * 
+ * @param[in]   subnet  ID of the subnet
+ * @param[in]   delta   change in the number of vehicles
+ * 
+ * @note        None
+ */
+void CentralComputeNode::adjustOccupancy(const std::string & subnet, int delta)
+{
+    int index = getMapIndex(subnet);
+
+    if (index >= 0)
+    {
+        subnetOccupancy[index] += delta;
+        occupancyVersion++;
+    }
+}
+
+
+/**
+ * @brief   Get the search context
+ * @details Returns the search context of the calling thread, each thread that
+ *          computes routes reuses its own context between queries
+ * @note    None
+ */
+SearchContext & CentralComputeNode::getSearchContext()
+{
+    static thread_local SearchContext context;
+
+    return context;
+}
+
+
+/**
+ * @brief   Get the backward search context
+ * @details Returns the context of the calling thread for the half of a
+ *          bidirectional search that runs from the destination
+ * @note    None
+ */
+SearchContext & CentralComputeNode::getBackwardSearchContext()
+{
+    static thread_local SearchContext context;
+
+    return context;
+}
+
+
+/**
+ * @brief   Route default constructor
+ * @details Initializes route object
+ * @note    None
+ */
+Route::Route() : start(""), dest(""), route()
+{
+
+}
+
+
+/**
+ * @brief   Default route destructor
+ * @details Destroys route object
+ * @note    None
+ */
+Route::~Route() {}
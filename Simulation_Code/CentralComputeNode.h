@@ -11,18 +11,47 @@
 
 // Header Files ===============================================================
 #include <unordered_set>
+#include <unordered_map>
 #include <vector>
 #include <list>
 #include <map>
 #include <string>
 #include <atomic>
+#include <memory>
+#include <thread>
 #include "Vehicle.h"
 #include "ThreadSafeObject.h"
+#include "SearchContext.h"
+#include "RoadGraph.h"
+#include "NodeOrder.h"
+#include "CostModel.h"
+#include "Landmarks.h"
+#include "ContractionHierarchy.h"
+#include "DistanceTable.h"
+#include "JobQueue.h"
+#include "Checkpoint.h"
+#include "OccupancyLog.h"
+#include "RoadAuthority.h"
 
-struct Job;
 struct Route;
 class Vehicle;
 
+/**
+ * @brief   Search used by computeRoute.
+ * @details ASTAR searches the road graph directly with the landmark heuristic.
+ *          BIDIRECTIONAL searches from both ends at once and meets in the
+ *          middle. HIERARCHY answers from a customizable contraction hierarchy
+ *          that is re-customized as congestion changes. ALL_PAIRS reads routes
+ *          off a precomputed table of every pair of subnets.
+ */
+enum RoutingAlgorithm
+{
+    ROUTE_ASTAR,
+    ROUTE_BIDIRECTIONAL,
+    ROUTE_HIERARCHY,
+    ROUTE_ALL_PAIRS
+};
+
 // Class Definition ===========================================================
 /**
  * @brief   The centralized compute node for the entire network.
@@ -32,7 +61,7 @@ class Vehicle;
  * 
  * @class   CentralComputeNode  CentralComputeNode.h "CentralComputeNode.h"
  */
-class CentralComputeNode : public ThreadSafeObject
+class CentralComputeNode : public ThreadSafeObject, public RoadAuthority
 {
     
 public:
@@ -43,55 +72,177 @@ public:
 
     int getMapIndex(const std::string & name);
 
+    void setNodeOrder(NodeOrder order);
     void setMap(std::vector<std::vector<double> > & map);
+    void setMap(const RoadGraph & graph);
 
     void setSubnetProperties(std::string & name, int capacity/*, double speed*/);
+
+    bool setRoadTime(const std::string & from, const std::string & to, double travelTime);
+    bool closeRoad(const std::string & from, const std::string & to);
+    bool openRoad(const std::string & from, const std::string & to);
+    bool setSubnetCapacity(const std::string & name, int capacity);
+    unsigned long long getGraphVersion() const;
    
-    void queueJob(Job & job);
+    AdmissionResult queueJob(Job & job, Route & staleRoute);
 
     bool computeRoute(Route & route);
+    bool computeDistances(const std::string & origin, bool backward, std::vector<double> & distances);
 
     void directTraffic(std::atomic_bool &running);
 
     void joinNetwork(Vehicle* vehicle);
     void leaveNetwork(const std::string &id, const std::string &lastNode);
 
+    void setDemandPending(bool pending);
+
     bool changeRoad(std::string & id, std::string & currentRoad, std::string & newRoad);
+    void moveVehicle(const std::string & id, const std::string & currentRoad, const std::string & newRoad);
+    void refuseRoadChange(const std::string & newRoad);
+
+    int getSettledNodeCount() const;
+
+    void buildLandmarks(int landmarkCount, LandmarkStrategy strategy, int threadCount);
+    bool saveLandmarks(const std::string & fileName) const;
+    bool loadLandmarks(const std::string & fileName);
+
+    void setRoutingAlgorithm(RoutingAlgorithm algorithm);
+    void setCostModel(CostModel model);
+    CostModel getCostModel() const;
+
+    void setAlternativeRoutes(int count);
+    long long getAlternativeRouteCount() const;
+    long long getRoadChangeFailureCount() const;
+    void setCustomizationInterval(int roadChanges);
+    int getCustomizationInterval() const;
+
+    void setPriorityWeight(JobPriority priority, int weight);
+    const LatencyStats & getLatencyStats(JobPriority priority) const;
+
+    void setAdmissionControl(int capacity, AdmissionPolicy policy);
+    int getQueueDepth() const;
+    int getDelayedJobCount() const;
+    const AdmissionStats & getAdmissionStats() const;
+
+    void startTableRefresh(long long periodMS);
+    void stopTableRefresh();
+
+    void saveState(CheckpointWriter & writer, std::vector<std::string> & vehicleIds) const;
+    int saveVehicle(CheckpointWriter & writer, const std::string & id) const;
+    void saveJobs(CheckpointWriter & writer) const;
+
+    bool restoreState(CheckpointReader & reader) const;
+    int restoreJobs(CheckpointReader & reader, const std::unordered_set<std::string> & waiting);
+
+    void getSubnets(std::vector<std::string> & names, std::vector<int> & capacities);
+    const RoadGraph & getRoadGraph() const;
+    void sampleOccupancy(OccupancySample & sample) const;
 
 private:
 
     bool aStar(Route & route);
+    bool bidirectionalSearch(Route & route);
+
+    template<typename Cost>
+    void searchDistances(const Cost & cost, int start, bool backward, std::vector<double> & distances);
+
+    void spreadAlternatives(const Route & route, unsigned long long key, const std::string & picked);
+    void computeAlternatives(const Route & route);
+
+    template<typename Cost>
+    void searchAlternatives(const Cost & cost, int start, int dest);
+
+    template<typename Cost>
+    double getPathCost(const Cost & cost, const std::vector<int> & path) const;
+
+    int getRouteRoom(const Route & route);
+    bool sendRoute(const std::string & id, const std::list<std::pair<std::string, double> > & route);
 
-    Route reconstructPath(std::map<std::string, std::string> & cameFrom,
-                                       std::string & current, std::string & start);
+    void reorderNodes();
 
-    std::vector<std::string> expandNode(std::string current);
+    bool findRoad(const std::string & from, const std::string & to, int & edge, int & reverseEdge);
+    void changeRoadCost(int edge, int reverseEdge, double cost);
+    void invalidateMetric();
+
+    void cacheRoute(unsigned long long key, const std::list<std::pair<std::string, double> > & route);
+    void uncacheRoute(unsigned long long key);
+    void clearRouteCache();
+    void findRouteRoads(const std::list<std::pair<std::string, double> > & route, std::vector<int> & edges);
+
+    void reconstructPath(const SearchContext & context, int current, int start, Route & route);
+
+    bool hierarchySearch(Route & route);
+    void customizeHierarchy();
+
+    bool tableSearch(Route & route);
+    void refreshTable();
+    void tableRefreshLoop(long long periodMS);
+
+    void buildRoute(const std::vector<int> & path, Route & route);
+    void computeRoadCosts(std::vector<double> & costs) const;
+
+    void adjustOccupancy(const std::string & subnet, int delta);
+
+    unsigned long long getJobKey(const std::string & start, const std::string & dest);
+
+    static SearchContext & getSearchContext();
+    static SearchContext & getBackwardSearchContext();
 
     std::map<std::string, Vehicle*> vehicles; //maps the id of a vehicle to the actual vehicle
+    int demandPending; //sources of vehicles still to join, keep running while the network is empty
     std::map<std::string, int> subnetCapacity; // the number of cars that fit on a subnet
     std::map<std::string, std::unordered_set< std::string > > vehiclesAtSubnet; //a list of vehicles at each subnet
 
-    //this graph has the cost of a subnet in estimated time to travel between subnets
-    std::vector< std::vector< double > > subnetAdjacencyMatrix; //the graph that defines the city
     std::map<std::string, int> subnetToIndexTable;
+    std::vector<std::string> indexToSubnetTable;
 
-    std::list<Job> jobs; //the jobs that have to be processed
+    //this graph has the cost of a subnet in estimated time to travel between subnets
+    RoadGraph roadGraph; //the graph that defines the city, closed roads cost SEARCH_INFINITY
+    NodeOrder nodeOrder; //numbering of the subnets setMap applies
+    RoadGraph reverseGraph; //roadGraph with every road reversed
+    LandmarkTable landmarks; //lower bounds for the A* heuristic
+    std::vector<double> landmarkRoadCosts; //travel time of every road when the landmarks were made
+    std::unordered_map<int, double> closedRoads; //travel time to reopen at, by road index of roadGraph
+    unsigned long long graphVersion; //bumped on every change to the roads, or to a capacity the costs use
 
-};
+    std::vector<int> subnetOccupancy; //the size of vehiclesAtSubnet by subnet index
+    std::vector<int> capacityByIndex; //subnetCapacity by subnet index
+    std::vector<int> roadChangeFailures; //road changes refused by subnet index, as the subnet was full
 
+    RoutingAlgorithm routingAlgorithm;
+    CostModel costModel; //cost of a road for every search
+    ContractionHierarchy hierarchy;
+    std::vector<double> hierarchyMetric; //congested cost of every road of roadGraph
+    std::vector<int> hierarchyPath;
+    unsigned long long occupancyVersion; //bumped on every vehicle move
+    unsigned long long hierarchyVersion; //occupancy the hierarchy was customized for
+    unsigned long long hierarchyGraphVersion; //graph the hierarchy was customized for
+    int customizationInterval; //vehicle moves tolerated before re-customizing, 0 to scale with the map
+
+    std::shared_ptr<const DistanceTable> distanceTable;
+    std::vector<int> tablePath;
+    unsigned long long tableVersion; //occupancy the table was computed for
+    unsigned long long tableGraphVersion; //graph the table was computed for
+    std::atomic_bool tableRefreshRunning;
+    std::thread tableRefreshThread;
+
+    JobQueue jobs; //the jobs that have to be processed
+    unsigned long long strandedGraphVersion; //graph the stranded jobs found no route in
+    unsigned long long strandedOccupancyVersion; //occupancy the stranded jobs found no route in
+
+    int alternativeCount; //routes offered to the vehicles waiting for one start and destination
+    std::vector<Route> alternatives; //best route first, reused between jobs
+    std::vector<std::vector<int> > alternativePaths; //subnet indices of each alternative
+    std::vector<int> alternativePenalty; //alternatives through each subnet by subnet index
+    long long alternativeDeliveries; //vehicles sent on a route other than the best
+    unsigned long long alternativeKey; //start and destination of the alternatives
+    unsigned long long alternativeVersion; //occupancy the alternatives were computed for
+
+    //last route computed for each start and destination, kept for ADMIT_STALE_ROUTE
+    std::unordered_map<unsigned long long, std::list<std::pair<std::string, double> > > routeCache;
+    std::unordered_map<int, std::vector<unsigned long long> > cachedRoutesByRoad; //routeCache keys by road index of roadGraph
+    std::vector<int> cachedRouteRoads; //roads of one cached route, reused
 
-/**
- * @brief   Request structure passed to the Compute Node.
- * @details Object that is passed by Vehicles to the Compute Node to be processed.
- */
-struct Job
-{
-public:
-    Job();
-    ~Job();
-    std::string start;
-    std::string dest;
-    std::string id;
 };
 
 
@@ -0,0 +1,250 @@
+/**
+ * @file    Checkpoint.cpp
+ *
+ * @brief   Implementation file for the CheckpointWriter and CheckpointReader classes
+ *
+ * @author  Andrew Frost, Richard Millar
+ * @version 1.00
+ */
+
+// Header Files ===============================================================
+#include "Checkpoint.h"
+#include <cstdio>
+#include <cstring>
+
+#define CHECKPOINT_MAX_STRING (1 << 20)
+
+
+/**
+ * @brief   Default constructor
+ * @details Constructs a writer that is not open yet
+ * @note    None
+ */
+CheckpointWriter::CheckpointWriter() : file(), targetName(""), temporaryName("")
+{
+
+}
+
+/**
+ * @brief   Default destructor
+ * @details A checkpoint that was not closed is discarded
+ * @note    None
+ */
+CheckpointWriter::~CheckpointWriter()
+{
+    if (file.is_open())
+    {
+        file.close();
+        std::remove(temporaryName.c_str());
+    }
+}
+
+
+/**
+ * @brief       Starts a checkpoint
+ * @details     Opens the temporary file and writes the tag
+ *
+ * @param[in]   fileName    checkpoint file to write
+ *
+ * @note        None
+ */
+bool CheckpointWriter::open(const std::string & fileName)
+{
+    targetName = fileName;
+    temporaryName = fileName + ".tmp";
+
+    file.open(temporaryName.c_str(), std::ios::binary | std::ios::trunc);
+
+    if (!file.is_open())
+    {
+        return false;
+    }
+
+    file.write(CHECKPOINT_FILE_TAG, sizeof(CHECKPOINT_FILE_TAG) - 1);
+
+    return file.good();
+}
+
+
+/**
+ * @brief   Finishes a checkpoint
+ * @details Flushes the temporary file and renames it over the target
+ * @note    Returns false and keeps the previous checkpoint if anything failed
+ */
+bool CheckpointWriter::close()
+{
+    bool good;
+
+    if (!file.is_open())
+    {
+        return false;
+    }
+
+    file.flush();
+    good = file.good();
+    file.close();
+
+    if (!good || std::rename(temporaryName.c_str(), targetName.c_str()) != 0)
+    {
+        std::remove(temporaryName.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+
+/**
+ * @brief       Writes an integer
+ *
+ * @param[in]   value   value to write
+ *
+ * @note        None
+ */
+void CheckpointWriter::writeInt(long long value)
+{
+    file.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+
+/**
+ * @brief       Writes a floating point value
+ *
+ * @param[in]   value   value to write
+ *
+ * @note        None
+ */
+void CheckpointWriter::writeDouble(double value)
+{
+    file.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+
+/**
+ * @brief       Writes a string
+ * @details     Writes the length followed by the characters
+ *
+ * @param[in]   value   value to write
+ *
+ * @note        None
+ */
+void CheckpointWriter::writeString(const std::string & value)
+{
+    writeInt((long long)value.size());
+    file.write(value.data(), value.size());
+}
+
+
+/**
+ * @brief   Default constructor
+ * @details Constructs a reader that is not open yet
+ * @note    None
+ */
+CheckpointReader::CheckpointReader() : file()
+{
+
+}
+
+/**
+ * @brief   Default destructor
+ * @details Destroys a CheckpointReader object
+ * @note    None
+ */
+CheckpointReader::~CheckpointReader()
+{
+
+}
+
+
+/**
+ * @brief       Opens a checkpoint
+ * @details     Opens the file and checks its tag
+ *
+ * @param[in]   fileName    checkpoint file to read
+ *
+ * @note        Returns false if the file is missing or not a checkpoint
+ */
+bool CheckpointReader::open(const std::string & fileName)
+{
+    char tag[sizeof(CHECKPOINT_FILE_TAG) - 1];
+
+    file.open(fileName.c_str(), std::ios::binary);
+
+    if (!file.is_open())
+    {
+        return false;
+    }
+
+    file.read(tag, sizeof(tag));
+
+    return file.good() && std::memcmp(tag, CHECKPOINT_FILE_TAG, sizeof(tag)) == 0;
+}
+
+
+/**
+ * @brief   Reads an integer
+ * @details Returns 0 once the file has failed
+ * @note    None
+ */
+long long CheckpointReader::readInt()
+{
+    long long value = 0;
+
+    file.read(reinterpret_cast<char*>(&value), sizeof(value));
+
+    return file.good() ? value : 0;
+}
+
+
+/**
+ * @brief   Reads a floating point value
+ * @details Returns 0 once the file has failed
+ * @note    None
+ */
+double CheckpointReader::readDouble()
+{
+    double value = 0;
+
+    file.read(reinterpret_cast<char*>(&value), sizeof(value));
+
+    return file.good() ? value : 0;
+}
+
+
+/**
+ * @brief   Reads a string
+ * @details Returns an empty string once the file has failed, or if the stored
+ *          length is not plausible
+ * @note    None
+ */
+std::string CheckpointReader::readString()
+{
+    long long length = readInt();
+    std::string value;
+
+    if (length < 0 || length > CHECKPOINT_MAX_STRING)
+    {
+        file.setstate(std::ios::failbit);
+        return value;
+    }
+
+    value.resize((std::size_t)length);
+
+    if (length > 0)
+    {
+        file.read(&value[0], length);
+    }
+
+    return file.good() ? value : std::string();
+}
+
+
+/**
+ * @brief   Shows whether every read so far succeeded
+ * @details Returns false after a short file or a bad length
+ * @note    None
+ */
+bool CheckpointReader::isGood() const
+{
+    return file.good();
+}
@@ -0,0 +1,75 @@
+/**
+ * @file    Checkpoint.h
+ * @brief   Definition file for the CheckpointWriter and CheckpointReader classes
+ *
+ * @author  Andrew Frost, Richard Millar
+ * @version 1.00
+ */
+
+// Precompiler Directives =====================================================
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+// Header Files ===============================================================
+#include <fstream>
+#include <string>
+
+#define CHECKPOINT_FILE_TAG "SDNCKP01"
+
+// Class Definition ===========================================================
+/**
+ * @brief   Binary output of a simulation checkpoint.
+ * @details Values are written in native byte order, strings with their length
+ *          first. The file is written under a temporary name and renamed over
+ *          the target by close(), so a crash mid-write never leaves a truncated
+ *          checkpoint behind.
+ *
+ * @class   CheckpointWriter Checkpoint.h "Checkpoint.h"
+ */
+class CheckpointWriter
+{
+public:
+    CheckpointWriter();
+    ~CheckpointWriter();
+
+    bool open(const std::string & fileName);
+    bool close();
+
+    void writeInt(long long value);
+    void writeDouble(double value);
+    void writeString(const std::string & value);
+
+private:
+    std::ofstream file;
+    std::string targetName;
+    std::string temporaryName;
+};
+
+
+/**
+ * @brief   Binary input of a simulation checkpoint.
+ * @details Reads back what CheckpointWriter wrote. Once a read fails every later
+ *          read returns zero or empty, so callers only check isGood() at the
+ *          end of a section.
+ *
+ * @class   CheckpointReader Checkpoint.h "Checkpoint.h"
+ */
+class CheckpointReader
+{
+public:
+    CheckpointReader();
+    ~CheckpointReader();
+
+    bool open(const std::string & fileName);
+
+    long long readInt();
+    double readDouble();
+    std::string readString();
+
+    bool isGood() const;
+
+private:
+    std::ifstream file;
+};
+
+#endif
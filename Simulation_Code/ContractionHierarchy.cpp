@@ -0,0 +1,709 @@
+/**
+ * @file    ContractionHierarchy.cpp
+ *
+ * @brief   Implementation file for the ContractionHierarchy class
+ *
+ * @author  Andrew Frost, Richard Millar
+ * @version 1.00
+ */
+
+// Header Files ===============================================================
+#include "ContractionHierarchy.h"
+#include "SearchContext.h"
+#include <algorithm>
+
+#define DISSECTION_LEAF_SIZE 32
+
+
+/**
+ * @brief   Default constructor
+ * @details Constructs an empty hierarchy
+ * @note    None
+ */
+ContractionHierarchy::ContractionHierarchy()
+    : undirectedOffsets(),
+    undirectedTargets(),
+    mark(),
+    markStamp(0),
+    rank(),
+    nodeAt(),
+    arcOffsets(),
+    arcHeads(),
+    arcTails(),
+    treeParent(),
+    edgeArcs(),
+    edgeUpward(),
+    upWeights(),
+    downWeights(),
+    upLowArcs(),
+    upHighArcs(),
+    downLowArcs(),
+    downHighArcs(),
+    customized(false),
+    forwardDistances(),
+    backwardDistances(),
+    forwardArcs(),
+    backwardArcs(),
+    arcPath(),
+    scannedCount(0)
+{
+
+}
+
+/**
+ * @brief   Default destructor
+ * @details Destroys a ContractionHierarchy object
+ * @note    None
+ */
+ContractionHierarchy::~ContractionHierarchy()
+{
+
+}
+
+
+/**
+ * @brief       Builds the metric independent part of the hierarchy
+ * @details     Orders the subnets by nested dissection, then contracts them in
+ *              that order. The result must be customized before it can answer
+ *              queries.
+ *
+ * @param[in]   graph   graph of the city
+ *
+ * @note        Only the shape of the graph is used, the costs are ignored.
+ */
+void ContractionHierarchy::build(const RoadGraph & graph)
+{
+    int nodeCount = graph.getNodeCount();
+
+    clear();
+
+    computeOrder(graph);
+    contract(graph);
+
+    forwardDistances.assign(nodeCount, SEARCH_INFINITY);
+    backwardDistances.assign(nodeCount, SEARCH_INFINITY);
+    forwardArcs.assign(nodeCount, -1);
+    backwardArcs.assign(nodeCount, -1);
+
+    //the ordering scratch is not needed anymore
+    std::vector<int>().swap(undirectedOffsets);
+    std::vector<int>().swap(undirectedTargets);
+    std::vector<unsigned int>().swap(mark);
+}
+
+
+/**
+ * @brief   Removes the hierarchy
+ * @details Frees all arcs and weights
+ * @note    None
+ */
+void ContractionHierarchy::clear()
+{
+    rank.clear();
+    nodeAt.clear();
+    arcOffsets.clear();
+    arcHeads.clear();
+    arcTails.clear();
+    treeParent.clear();
+    edgeArcs.clear();
+    edgeUpward.clear();
+    upWeights.clear();
+    downWeights.clear();
+    upLowArcs.clear();
+    upHighArcs.clear();
+    downLowArcs.clear();
+    downHighArcs.clear();
+    customized = false;
+}
+
+
+/**
+ * @brief   Shows whether the hierarchy is built
+ * @details Returns true once build() has run
+ * @note    None
+ */
+bool ContractionHierarchy::isBuilt() const
+{
+    return !arcOffsets.empty();
+}
+
+
+/**
+ * @brief   Shows whether the hierarchy is customized
+ * @details Returns true once a metric has been applied
+ * @note    None
+ */
+bool ContractionHierarchy::isCustomized() const
+{
+    return customized;
+}
+
+
+/**
+ * @brief       Applies a metric to the hierarchy
+ * @details     Copies the cost of every road onto its arc, then processes the
+ *              subnets from lowest to highest rank. For each pair of upward
+ *              neighbors u, v of a subnet w the paths u-w-v and v-w-u may be
+ *              shorter than the arc between u and v. Arcs are final before they
+ *              are used because their lower triangles all have a lower middle.
+ *
+ * @param[in]   edgeCosts   cost of every road of the graph passed to build()
+ *
+ * @note        None
+ */
+void ContractionHierarchy::customize(const std::vector<double> & edgeCosts)
+{
+    int arcCount = getArcCount(), nodeCount = (int)nodeAt.size();
+    int edge, arc, node, low, high, lowHead, highHead, cross, end;
+    double candidate;
+
+    upWeights.assign(arcCount, SEARCH_INFINITY);
+    downWeights.assign(arcCount, SEARCH_INFINITY);
+    upLowArcs.assign(arcCount, -1);
+    upHighArcs.assign(arcCount, -1);
+    downLowArcs.assign(arcCount, -1);
+    downHighArcs.assign(arcCount, -1);
+
+    for (edge = 0; edge < (int)edgeArcs.size(); edge++)
+    {
+        arc = edgeArcs[edge];
+
+        if (arc < 0)
+        {
+            continue;
+        }
+
+        if (edgeUpward[edge])
+        {
+            upWeights[arc] = std::min(upWeights[arc], edgeCosts[edge]);
+        }
+        else
+        {
+            downWeights[arc] = std::min(downWeights[arc], edgeCosts[edge]);
+        }
+    }
+
+    for (node = 0; node < nodeCount; node++)
+    {
+        end = arcOffsets[node + 1];
+
+        for (low = arcOffsets[node]; low < end; low++)
+        {
+            lowHead = arcHeads[low];
+            cross = arcOffsets[lowHead];
+
+            for (high = low + 1; high < end; high++)
+            {
+                highHead = arcHeads[high];
+
+                //both lists are sorted, and the arc exists because the graph is chordal
+                while (arcHeads[cross] < highHead)
+                {
+                    cross++;
+                }
+
+                candidate = downWeights[low] + upWeights[high];
+
+                if (candidate < upWeights[cross])
+                {
+                    upWeights[cross] = candidate;
+                    upLowArcs[cross] = low;
+                    upHighArcs[cross] = high;
+                }
+
+                candidate = downWeights[high] + upWeights[low];
+
+                if (candidate < downWeights[cross])
+                {
+                    downWeights[cross] = candidate;
+                    downLowArcs[cross] = low;
+                    downHighArcs[cross] = high;
+                }
+            }
+        }
+    }
+
+    customized = true;
+}
+
+
+/**
+ * @brief       Computes a shortest path
+ * @details     Relaxes the upward arcs of every ancestor of the source in the
+ *              elimination tree, does the same backwards from the target, and
+ *              joins the two at the common ancestor with the smallest total.
+ *
+ * @param[in]   source  subnet index to start from
+ * @param[in]   target  subnet index to end at
+ * @param[out]  path    subnet indices of the path, source and target included
+ * @param[out]  cost    cost of the path under the current metric
+ *
+ * @note        None
+ */
+bool ContractionHierarchy::query(int source, int target, std::vector<int> & path, double & cost)
+{
+    int node, arc, head, meet = -1;
+    int start, end;
+    double best = SEARCH_INFINITY;
+
+    path.clear();
+    scannedCount = 0;
+
+    if (!customized)
+    {
+        return false;
+    }
+
+    start = rank[source];
+    end = rank[target];
+
+    for (node = start; node >= 0; node = treeParent[node])
+    {
+        forwardDistances[node] = backwardDistances[node] = SEARCH_INFINITY;
+        forwardArcs[node] = backwardArcs[node] = -1;
+    }
+    for (node = end; node >= 0; node = treeParent[node])
+    {
+        forwardDistances[node] = backwardDistances[node] = SEARCH_INFINITY;
+        forwardArcs[node] = backwardArcs[node] = -1;
+    }
+
+    forwardDistances[start] = 0;
+    backwardDistances[end] = 0;
+
+    //upward neighbors are always ancestors, so only the two tree paths change
+    for (node = start; node >= 0; node = treeParent[node])
+    {
+        scannedCount++;
+
+        if (forwardDistances[node] >= SEARCH_INFINITY)
+        {
+            continue;
+        }
+
+        for (arc = arcOffsets[node]; arc < arcOffsets[node + 1]; arc++)
+        {
+            head = arcHeads[arc];
+
+            if (forwardDistances[node] + upWeights[arc] < forwardDistances[head])
+            {
+                forwardDistances[head] = forwardDistances[node] + upWeights[arc];
+                forwardArcs[head] = arc;
+            }
+        }
+    }
+
+    for (node = end; node >= 0; node = treeParent[node])
+    {
+        scannedCount++;
+
+        if (backwardDistances[node] >= SEARCH_INFINITY)
+        {
+            continue;
+        }
+
+        for (arc = arcOffsets[node]; arc < arcOffsets[node + 1]; arc++)
+        {
+            head = arcHeads[arc];
+
+            if (backwardDistances[node] + downWeights[arc] < backwardDistances[head])
+            {
+                backwardDistances[head] = backwardDistances[node] + downWeights[arc];
+                backwardArcs[head] = arc;
+            }
+        }
+
+        if (forwardDistances[node] + backwardDistances[node] < best)
+        {
+            best = forwardDistances[node] + backwardDistances[node];
+            meet = node;
+        }
+    }
+
+    if (meet < 0 || best >= SEARCH_INFINITY)
+    {
+        return false;
+    }
+
+    cost = best;
+
+    //arcs from the source up to the meeting point
+    arcPath.clear();
+
+    for (node = meet; forwardArcs[node] >= 0; node = arcTails[forwardArcs[node]])
+    {
+        arcPath.push_back(forwardArcs[node]);
+    }
+
+    path.push_back(nodeAt[start]);
+
+    while (!arcPath.empty())
+    {
+        unpack(arcPath.back(), true, path);
+        arcPath.pop_back();
+    }
+
+    //and back down to the target
+    for (node = meet; backwardArcs[node] >= 0; node = arcTails[backwardArcs[node]])
+    {
+        unpack(backwardArcs[node], false, path);
+    }
+
+    return true;
+}
+
+
+/**
+ * @brief   Get the arc count
+ * @details Returns the number of arcs, original roads and shortcuts together
+ * @note    None
+ */
+int ContractionHierarchy::getArcCount() const
+{
+    return (int)arcHeads.size();
+}
+
+
+/**
+ * @brief   Get the scanned count
+ * @details Returns how many subnets the last query scanned
+ * @note    None
+ */
+int ContractionHierarchy::getScannedCount() const
+{
+    return scannedCount;
+}
+
+
+/**
+ * @brief       Computes the contraction order
+ * @details     Builds the undirected version of the graph and orders it by
+ *              nested dissection.
+ *
+ * @param[in]   graph   graph of the city
+ *
+ * @note        None
+ */
+void ContractionHierarchy::computeOrder(const RoadGraph & graph)
+{
+    std::vector<std::vector<int> > neighbors(graph.getNodeCount());
+    std::vector<int> nodes, order;
+    int node, edge, nodeCount = graph.getNodeCount();
+
+    for (node = 0; node < nodeCount; node++)
+    {
+        for (edge = graph.offsets[node]; edge < graph.offsets[node + 1]; edge++)
+        {
+            if (graph.targets[edge] != node)
+            {
+                neighbors[node].push_back(graph.targets[edge]);
+                neighbors[graph.targets[edge]].push_back(node);
+            }
+        }
+    }
+
+    undirectedOffsets.assign(1, 0);
+    undirectedTargets.clear();
+
+    for (node = 0; node < nodeCount; node++)
+    {
+        std::sort(neighbors[node].begin(), neighbors[node].end());
+        neighbors[node].erase(std::unique(neighbors[node].begin(), neighbors[node].end()), neighbors[node].end());
+
+        undirectedTargets.insert(undirectedTargets.end(), neighbors[node].begin(), neighbors[node].end());
+        undirectedOffsets.push_back((int)undirectedTargets.size());
+    }
+
+    mark.assign(nodeCount, 0);
+    markStamp = 0;
+
+    for (node = 0; node < nodeCount; node++)
+    {
+        nodes.push_back(node);
+    }
+
+    dissect(nodes, order);
+
+    rank.assign(nodeCount, 0);
+    nodeAt = order;
+
+    for (node = 0; node < nodeCount; node++)
+    {
+        rank[nodeAt[node]] = node;
+    }
+}
+
+
+/**
+ * @brief       Nested dissection of a set of subnets
+ * @details     Splits a connected set along the smallest balanced level of a
+ *              breadth first search from a peripheral subnet. Both halves are ordered first and
+ *              the separating level is ranked above them. Disconnected sets are
+ *              ordered one component at a time without a separator.
+ *
+ * @param[in]   nodes   subnets to order, reused as scratch
+ * @param[out]  order   subnets in increasing rank, the set is appended
+ *
+ * @note        None
+ */
+void ContractionHierarchy::dissect(std::vector<int> & nodes, std::vector<int> & order)
+{
+    std::vector<int> queue, levels, lower, upper, separator, rest;
+    unsigned int setStamp, visitStamp;
+    int index, edge, node, neighbor, level, passes, first, last, best;
+
+    if (nodes.size() <= DISSECTION_LEAF_SIZE)
+    {
+        order.insert(order.end(), nodes.begin(), nodes.end());
+        return;
+    }
+
+    //mark the set, then breadth first search from a peripheral subnet
+    setStamp = ++markStamp;
+
+    for (index = 0; index < (int)nodes.size(); index++)
+    {
+        mark[nodes[index]] = setStamp;
+    }
+
+    node = nodes[0];
+
+    for (passes = 0; passes < 2; passes++)
+    {
+        visitStamp = ++markStamp;
+
+        queue.assign(1, node);
+        levels.assign(1, 0);
+        mark[node] = visitStamp;
+
+        for (index = 0; index < (int)queue.size(); index++)
+        {
+            for (edge = undirectedOffsets[queue[index]]; edge < undirectedOffsets[queue[index] + 1]; edge++)
+            {
+                neighbor = undirectedTargets[edge];
+
+                if (mark[neighbor] == setStamp)
+                {
+                    mark[neighbor] = visitStamp;
+                    queue.push_back(neighbor);
+                    levels.push_back(levels[index] + 1);
+                }
+            }
+        }
+
+        node = queue.back();
+
+        //reset the visited subnets so the next pass sees the set again
+        for (index = 0; index < (int)queue.size(); index++)
+        {
+            mark[queue[index]] = setStamp;
+        }
+    }
+
+    if (queue.size() < nodes.size())
+    {
+        visitStamp = ++markStamp;
+
+        for (index = 0; index < (int)queue.size(); index++)
+        {
+            mark[queue[index]] = visitStamp;
+        }
+
+        for (index = 0; index < (int)nodes.size(); index++)
+        {
+            if (mark[nodes[index]] != visitStamp)
+            {
+                rest.push_back(nodes[index]);
+            }
+        }
+
+        nodes.clear();
+        dissect(queue, order);
+        dissect(rest, order);
+        return;
+    }
+
+    //the smallest level that leaves at least a third of the subnets on each
+    //side separates the rest, levels are contiguous in the queue
+    level = levels[queue.size() / 2];
+    best = (int)queue.size();
+
+    for (first = 0; first < (int)queue.size(); first = last)
+    {
+        for (last = first; last < (int)queue.size() && levels[last] == levels[first]; last++)
+        {
+        }
+
+        if (3 * first >= (int)queue.size() && 3 * ((int)queue.size() - last) >= (int)queue.size()
+            && last - first < best)
+        {
+            best = last - first;
+            level = levels[first];
+        }
+    }
+
+    for (index = 0; index < (int)queue.size(); index++)
+    {
+        if (levels[index] < level)
+        {
+            lower.push_back(queue[index]);
+        }
+        else if (levels[index] > level)
+        {
+            upper.push_back(queue[index]);
+        }
+        else
+        {
+            separator.push_back(queue[index]);
+        }
+    }
+
+    nodes.clear();
+    queue.clear();
+    levels.clear();
+
+    dissect(lower, order);
+    dissect(upper, order);
+
+    order.insert(order.end(), separator.begin(), separator.end());
+}
+
+
+/**
+ * @brief       Contracts the subnets in rank order
+ * @details     Runs the elimination game: the upward neighbors of each subnet
+ *              are joined into a clique, which is done by handing them to the
+ *              lowest of them. The resulting chordal graph holds every arc a
+ *              shortest path can need, whatever the metric.
+ *
+ * @param[in]   graph   graph of the city
+ *
+ * @note        None
+ */
+void ContractionHierarchy::contract(const RoadGraph & graph)
+{
+    std::vector<std::vector<int> > upward(nodeAt.size());
+    int node, edge, low, high, parent, nodeCount = (int)nodeAt.size();
+
+    for (node = 0; node < nodeCount; node++)
+    {
+        for (edge = undirectedOffsets[node]; edge < undirectedOffsets[node + 1]; edge++)
+        {
+            low = rank[node];
+            high = rank[undirectedTargets[edge]];
+
+            if (low < high)
+            {
+                upward[low].push_back(high);
+            }
+        }
+    }
+
+    treeParent.assign(nodeCount, -1);
+    arcOffsets.assign(1, 0);
+
+    for (node = 0; node < nodeCount; node++)
+    {
+        std::sort(upward[node].begin(), upward[node].end());
+        upward[node].erase(std::unique(upward[node].begin(), upward[node].end()), upward[node].end());
+
+        if (!upward[node].empty())
+        {
+            parent = upward[node][0];
+            treeParent[node] = parent;
+            upward[parent].insert(upward[parent].end(), upward[node].begin() + 1, upward[node].end());
+        }
+
+        arcHeads.insert(arcHeads.end(), upward[node].begin(), upward[node].end());
+        arcTails.insert(arcTails.end(), upward[node].size(), node);
+        arcOffsets.push_back((int)arcHeads.size());
+
+        std::vector<int>().swap(upward[node]);
+    }
+
+    edgeArcs.assign(graph.getEdgeCount(), -1);
+    edgeUpward.assign(graph.getEdgeCount(), 0);
+
+    for (node = 0; node < nodeCount; node++)
+    {
+        for (edge = graph.offsets[node]; edge < graph.offsets[node + 1]; edge++)
+        {
+            low = rank[node];
+            high = rank[graph.targets[edge]];
+
+            if (low < high)
+            {
+                edgeArcs[edge] = findArc(low, high);
+                edgeUpward[edge] = 1;
+            }
+            else if (high < low)
+            {
+                edgeArcs[edge] = findArc(high, low);
+                edgeUpward[edge] = 0;
+            }
+        }
+    }
+}
+
+
+/**
+ * @brief       Finds an arc
+ * @details     Returns the arc from tail to head, or -1 if there is none
+ *
+ * @param[in]   tail    rank of the lower end
+ * @param[in]   head    rank of the upper end
+ *
+ * @note        None
+ */
+int ContractionHierarchy::findArc(int tail, int head) const
+{
+    std::vector<int>::const_iterator first = arcHeads.begin() + arcOffsets[tail];
+    std::vector<int>::const_iterator last = arcHeads.begin() + arcOffsets[tail + 1];
+    std::vector<int>::const_iterator found = std::lower_bound(first, last, head);
+
+    if (found == last || *found != head)
+    {
+        return -1;
+    }
+
+    return (int)(found - arcHeads.begin());
+}
+
+
+/**
+ * @brief       Expands an arc into roads
+ * @details     Replaces a shortcut by the two arcs of the lower triangle that
+ *              produced its weight, until only original roads are left. The
+ *              subnets after the first end of the arc are appended to path.
+ *
+ * @param[in]   arc     arc to expand
+ * @param[in]   upward  true to walk tail to head, false for head to tail
+ * @param[out]  path    subnet indices, appended to
+ *
+ * @note        None
+ */
+void ContractionHierarchy::unpack(int arc, bool upward, std::vector<int> & path) const
+{
+    if (upward)
+    {
+        if (upLowArcs[arc] < 0)
+        {
+            path.push_back(nodeAt[arcHeads[arc]]);
+            return;
+        }
+
+        unpack(upLowArcs[arc], false, path);
+        unpack(upHighArcs[arc], true, path);
+    }
+    else
+    {
+        if (downLowArcs[arc] < 0)
+        {
+            path.push_back(nodeAt[arcTails[arc]]);
+            return;
+        }
+
+        unpack(downHighArcs[arc], false, path);
+        unpack(downLowArcs[arc], true, path);
+    }
+}
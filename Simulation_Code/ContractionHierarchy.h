@@ -0,0 +1,99 @@
+/**
+ * @file    ContractionHierarchy.h
+ * @brief   Definition file for the ContractionHierarchy class
+ *
+ * @author  Andrew Frost, Richard Millar
+ * @version 1.00
+ */
+
+// Precompiler Directives =====================================================
+#ifndef CONTRACTIONHIERARCHY_H
+#define CONTRACTIONHIERARCHY_H
+
+// Header Files ===============================================================
+#include <vector>
+#include "RoadGraph.h"
+
+// Class Definition ===========================================================
+/**
+ * @brief   Customizable contraction hierarchy of the city.
+ * @details Preprocessing is split in two. build() orders the subnets by nested
+ *          dissection and contracts them in that order, which only depends on
+ *          the shape of the graph. customize() then computes the weight of every
+ *          shortcut for a given set of road costs by relaxing lower triangles,
+ *          which is cheap enough to repeat whenever congestion changes.
+ *
+ *          Queries walk up the elimination tree from both ends, so they touch
+ *          only the ancestors of the start and the destination.
+ *
+ * @class   ContractionHierarchy ContractionHierarchy.h "ContractionHierarchy.h"
+ */
+class ContractionHierarchy
+{
+public:
+    ContractionHierarchy();
+    ~ContractionHierarchy();
+
+    void build(const RoadGraph & graph);
+    void clear();
+
+    bool isBuilt() const;
+    bool isCustomized() const;
+
+    void customize(const std::vector<double> & edgeCosts);
+
+    bool query(int source, int target, std::vector<int> & path, double & cost);
+
+    int getArcCount() const;
+    int getScannedCount() const;
+
+private:
+    void computeOrder(const RoadGraph & graph);
+    void dissect(std::vector<int> & nodes, std::vector<int> & order);
+    void contract(const RoadGraph & graph);
+
+    int findArc(int tail, int head) const;
+
+    void unpack(int arc, bool upward, std::vector<int> & path) const;
+
+    //undirected adjacency lists used while ordering
+    std::vector<int> undirectedOffsets;
+    std::vector<int> undirectedTargets;
+    std::vector<unsigned int> mark;
+    unsigned int markStamp;
+
+    std::vector<int> rank; //rank of each subnet index
+    std::vector<int> nodeAt; //subnet index of each rank
+
+    //upward arcs in rank space, sorted by head within each tail
+    std::vector<int> arcOffsets;
+    std::vector<int> arcHeads;
+    std::vector<int> arcTails;
+    std::vector<int> treeParent; //elimination tree, the lowest upward neighbor
+
+    //arc and direction of each road of the original graph
+    std::vector<int> edgeArcs;
+    std::vector<char> edgeUpward;
+
+    //customized metric, up is tail to head and down is head to tail
+    std::vector<double> upWeights;
+    std::vector<double> downWeights;
+
+    //lower triangle that produced each weight, -1 for an original road
+    std::vector<int> upLowArcs;
+    std::vector<int> upHighArcs;
+    std::vector<int> downLowArcs;
+    std::vector<int> downHighArcs;
+
+    bool customized;
+
+    //query scratch, only the ancestors of the last query are ever dirty
+    std::vector<double> forwardDistances;
+    std::vector<double> backwardDistances;
+    std::vector<int> forwardArcs;
+    std::vector<int> backwardArcs;
+    std::vector<int> arcPath;
+    int scannedCount;
+};
+
+#endif
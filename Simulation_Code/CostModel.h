@@ -0,0 +1,158 @@
+/**
+ * @file    CostModel.h
+ * @brief   Definition file for the road cost models of the route searches
+ *
+ * @author  Andrew Frost, Richard Millar
+ * @version 1.00
+ */
+
+// Precompiler Directives =====================================================
+#ifndef COSTMODEL_H
+#define COSTMODEL_H
+
+// Header Files ===============================================================
+#include <vector>
+#include "SearchContext.h"
+
+#define BPR_ALPHA 0.15 //delay of a road at capacity, as a share of its travel time
+
+/**
+ * @brief   Cost of a road used by the route searches.
+ * @details FREE_FLOW is the travel time alone. LINEAR adds the travel time
+ *          once for every vehicle at either end of the road. BPR is the Bureau
+ *          of Public Roads function travelTime * (1 + 0.15 * (v / c)^4) of the
+ *          occupancy v and capacity c of the subnet entered. CAPACITY is the
+ *          travel time, but a full subnet can't be entered at all.
+ *
+ *          Every model costs at least the travel time, so the landmark lower
+ *          bounds on free flow travel time stay admissible under all of them.
+ */
+enum CostModel
+{
+    COST_FREE_FLOW,
+    COST_LINEAR,
+    COST_BPR,
+    COST_CAPACITY
+};
+
+
+/**
+ * @brief   The travel time of the road.
+ * @details Each cost model is a policy with an inline call operator taking
+ *          the subnet indices at both ends of a road and its free flow travel
+ *          time. The searches are templates over the policy, so the cost is
+ *          inlined into their inner loop rather than called through a switch
+ *          or a pointer for every road.
+ */
+struct FreeFlowCost
+{
+    double operator()(int, int, double travelTime) const
+    {
+        return travelTime;
+    }
+};
+
+
+/**
+ * @brief   The travel time, plus the travel time again for every vehicle at
+ *          either end of the road.
+ */
+struct LinearCost
+{
+    explicit LinearCost(const std::vector<int> & newOccupancy) : occupancy(newOccupancy.data()) {}
+
+    double operator()(int from, int to, double travelTime) const
+    {
+        return travelTime + travelTime * (occupancy[to] + occupancy[from]);
+    }
+
+    const int* occupancy; //vehicles by subnet index
+};
+
+
+/**
+ * @brief   The BPR delay of the subnet entered.
+ * @details The delay grows with the fourth power of how full the subnet is,
+ *          so it barely changes a route until a subnet gets close to capacity.
+ */
+struct BprCost
+{
+    BprCost(const std::vector<int> & newOccupancy, const std::vector<int> & newCapacity)
+        : occupancy(newOccupancy.data()), capacity(newCapacity.data()) {}
+
+    double operator()(int, int to, double travelTime) const
+    {
+        double ratio = (double)occupancy[to] / (capacity[to] > 0 ? capacity[to] : 1);
+
+        ratio *= ratio;
+
+        return travelTime * (1 + BPR_ALPHA * ratio * ratio);
+    }
+
+    const int* occupancy; //vehicles by subnet index
+    const int* capacity; //capacity by subnet index
+};
+
+
+/**
+ * @brief   The travel time, or SEARCH_INFINITY to enter a full subnet.
+ * @details A search never relaxes a road of infinite cost, so the routes
+ *          only pass through subnets with room left.
+ */
+struct CapacityCost
+{
+    CapacityCost(const std::vector<int> & newOccupancy, const std::vector<int> & newCapacity)
+        : occupancy(newOccupancy.data()), capacity(newCapacity.data()) {}
+
+    double operator()(int, int to, double travelTime) const
+    {
+        return occupancy[to] < capacity[to] ? travelTime : SEARCH_INFINITY;
+    }
+
+    const int* occupancy; //vehicles by subnet index
+    const int* capacity; //capacity by subnet index
+};
+
+
+/**
+ * @brief   A cost model that makes subnets already in use dearer.
+ * @details Scales the cost of entering a subnet by 1 + factor for every time
+ *          it is on a route found before, so the next search is pushed onto
+ *          other subnets. The penalty never lowers a cost.
+ */
+template<typename Cost>
+struct PenaltyCost
+{
+    PenaltyCost(const Cost & newCost, const std::vector<int> & newPenalties, double newFactor)
+        : cost(newCost), penalties(newPenalties.data()), factor(newFactor) {}
+
+    double operator()(int from, int to, double travelTime) const
+    {
+        return cost(from, to, travelTime) * (1 + factor * penalties[to]);
+    }
+
+    Cost cost;
+    const int* penalties; //routes through each subnet by subnet index
+    double factor;
+};
+
+
+/**
+ * @brief   A cost model for the roads of a reversed graph.
+ * @details A road of the reversed graph from a to b is the road from b to a,
+ *          and costs what that road does.
+ */
+template<typename Cost>
+struct ReversedCost
+{
+    explicit ReversedCost(const Cost & newCost) : cost(newCost) {}
+
+    double operator()(int from, int to, double travelTime) const
+    {
+        return cost(to, from, travelTime);
+    }
+
+    Cost cost;
+};
+
+#endif
@@ -0,0 +1,309 @@
+/**
+ * @file    DistanceTable.cpp
+ *
+ * @brief   Implementation file for the DistanceTable class
+ *
+ * @author  Andrew Frost, Richard Millar
+ * @version 1.00
+ */
+
+// Header Files ===============================================================
+#include "DistanceTable.h"
+#include <algorithm>
+#include <thread>
+
+#define TABLE_TILE 64
+#define TABLE_INFINITY 1e30f
+
+template<typename Function>
+void ParallelFor(int count, int threadCount, Function work);
+
+
+/**
+ * @brief   Default constructor
+ * @details Constructs an empty table
+ * @note    None
+ */
+DistanceTable::DistanceTable() : nodeCount(0), stride(0), distances(), nextHops()
+{
+
+}
+
+/**
+ * @brief   Default destructor
+ * @details Destroys a DistanceTable object
+ * @note    None
+ */
+DistanceTable::~DistanceTable()
+{
+
+}
+
+
+/**
+ * @brief       Fills the table
+ * @details     Starts from the roads of the graph and runs one round of the
+ *              blocked Floyd-Warshall per tile column.
+ *
+ * @param[in]   graph       graph of the city
+ * @param[in]   edgeCosts   cost of every road of the graph
+ * @param[in]   threadCount number of worker threads
+ *
+ * @note        None
+ */
+void DistanceTable::compute(const RoadGraph & graph, const std::vector<double> & edgeCosts, int threadCount)
+{
+    int node, edge, block;
+    std::size_t cell;
+
+    nodeCount = graph.getNodeCount();
+    stride = ((nodeCount + TABLE_TILE - 1) / TABLE_TILE) * TABLE_TILE;
+
+    distances.assign((std::size_t)stride * stride, TABLE_INFINITY);
+    nextHops.assign((std::size_t)stride * stride, -1);
+
+    for (node = 0; node < nodeCount; node++)
+    {
+        cell = (std::size_t)node * stride + node;
+        distances[cell] = 0;
+        nextHops[cell] = node;
+
+        for (edge = graph.offsets[node]; edge < graph.offsets[node + 1]; edge++)
+        {
+            cell = (std::size_t)node * stride + graph.targets[edge];
+
+            if (graph.targets[edge] != node && (float)edgeCosts[edge] < distances[cell])
+            {
+                distances[cell] = (float)edgeCosts[edge];
+                nextHops[cell] = graph.targets[edge];
+            }
+        }
+    }
+
+    for (block = 0; block < stride / TABLE_TILE; block++)
+    {
+        runRound(block, std::max(1, threadCount));
+    }
+}
+
+
+/**
+ * @brief   Shows whether the table is empty
+ * @details Returns true until compute() has run
+ * @note    None
+ */
+bool DistanceTable::isEmpty() const
+{
+    return nodeCount == 0;
+}
+
+
+/**
+ * @brief   Get the node count
+ * @details Returns the number of subnets the table was computed for
+ * @note    None
+ */
+int DistanceTable::getNodeCount() const
+{
+    return nodeCount;
+}
+
+
+/**
+ * @brief       Get the cost between two subnets
+ * @details     Returns the cost of the cheapest route, or -1 if there is none
+ *
+ * @param[in]   source  subnet index to start from
+ * @param[in]   target  subnet index to end at
+ *
+ * @note        None
+ */
+double DistanceTable::getDistance(int source, int target) const
+{
+    float distance = distances[(std::size_t)source * stride + target];
+
+    if (distance >= TABLE_INFINITY)
+    {
+        return -1;
+    }
+
+    return distance;
+}
+
+
+/**
+ * @brief       Reads a route off the table
+ * @details     Follows the next hops from source until target is reached
+ *
+ * @param[in]   source  subnet index to start from
+ * @param[in]   target  subnet index to end at
+ * @param[out]  path    subnet indices of the route, both ends included
+ *
+ * @note        None
+ */
+bool DistanceTable::getPath(int source, int target, std::vector<int> & path) const
+{
+    int node = source;
+
+    path.clear();
+
+    if (distances[(std::size_t)source * stride + target] >= TABLE_INFINITY)
+    {
+        return false;
+    }
+
+    path.push_back(node);
+
+    while (node != target && (int)path.size() <= nodeCount)
+    {
+        node = nextHops[(std::size_t)node * stride + target];
+        path.push_back(node);
+    }
+
+    return node == target;
+}
+
+
+/**
+ * @brief       One round of the blocked Floyd-Warshall
+ * @details     Relaxes every tile through the subnets of one tile column. The
+ *              pivot tile goes first, then the tiles sharing its row or column,
+ *              which only depend on the pivot, then all remaining tiles, which
+ *              only depend on the second step.
+ *
+ * @param[in]   block       tile index of the pivot
+ * @param[in]   threadCount number of worker threads
+ *
+ * @note        None
+ */
+void DistanceTable::runRound(int block, int threadCount)
+{
+    const int tiles = stride / TABLE_TILE;
+
+    updateTile(block, block, block);
+
+    ParallelFor(tiles, threadCount, [this, block](int tile)
+    {
+        if (tile != block)
+        {
+            updateTile(block, tile, block);
+            updateTile(tile, block, block);
+        }
+    });
+
+    ParallelFor(tiles, threadCount, [this, block, tiles](int row)
+    {
+        int col;
+
+        if (row == block)
+        {
+            return;
+        }
+
+        for (col = 0; col < tiles; col++)
+        {
+            if (col != block)
+            {
+                updateTile(row, col, block);
+            }
+        }
+    });
+}
+
+
+/**
+ * @brief       Relaxes one tile
+ * @details     For every subnet k of the pivot tile, routes from the subnets of
+ *              the tile row to the subnets of the tile column may get cheaper by
+ *              passing through k. The inner loop is a branch free select over a
+ *              contiguous row, which the compiler turns into vector code.
+ *
+ * @param[in]   row     tile row to update
+ * @param[in]   col     tile column to update
+ * @param[in]   pivot   tile index of the subnets to route through
+ *
+ * @note        None
+ */
+void DistanceTable::updateTile(int row, int col, int pivot)
+{
+    const std::size_t rowStart = (std::size_t)row * TABLE_TILE * stride;
+    const std::size_t pivotStart = (std::size_t)pivot * TABLE_TILE * stride;
+
+    int k, i, j, hop, mask;
+    float through, candidate, current;
+    const float* pivotRow;
+    float* distanceRow;
+    int* hopRow;
+
+    for (k = 0; k < TABLE_TILE; k++)
+    {
+        pivotRow = &distances[pivotStart + (std::size_t)k * stride + col * TABLE_TILE];
+
+        for (i = 0; i < TABLE_TILE; i++)
+        {
+            through = distances[rowStart + (std::size_t)i * stride + pivot * TABLE_TILE + k];
+
+            if (through >= TABLE_INFINITY)
+            {
+                continue;
+            }
+
+            hop = nextHops[rowStart + (std::size_t)i * stride + pivot * TABLE_TILE + k];
+            distanceRow = &distances[rowStart + (std::size_t)i * stride + col * TABLE_TILE];
+            hopRow = &nextHops[rowStart + (std::size_t)i * stride + col * TABLE_TILE];
+
+            //the hop is blended with an all ones or all zeros mask, a plain
+            //select on it keeps the compiler from vectorizing the loop
+            for (j = 0; j < TABLE_TILE; j++)
+            {
+                candidate = through + pivotRow[j];
+                current = distanceRow[j];
+                mask = -(int)(candidate < current);
+                distanceRow[j] = candidate < current ? candidate : current;
+                hopRow[j] = (hop & mask) | (hopRow[j] & ~mask);
+            }
+        }
+    }
+}
+
+
+/**
+ * @brief       Runs work over a range of indices on several threads
+ * @details     Index i is handled by thread i modulo threadCount, the calling
+ *              thread takes part as thread 0.
+ *
+ * @param[in]   count       number of indices
+ * @param[in]   threadCount number of threads to use
+ * @param[in]   work        function called with every index
+ *
+ * @note        None
+ */
+template<typename Function>
+void ParallelFor(int count, int threadCount, Function work)
+{
+    std::vector<std::thread> workers;
+    int worker;
+
+    threadCount = std::min(threadCount, count);
+
+    for (worker = 1; worker < threadCount; worker++)
+    {
+        workers.push_back(std::thread([&work, count, threadCount, worker]()
+        {
+            for (int index = worker; index < count; index += threadCount)
+            {
+                work(index);
+            }
+        }));
+    }
+
+    for (int index = 0; index < count; index += std::max(1, threadCount))
+    {
+        work(index);
+    }
+
+    for (worker = 0; worker < (int)workers.size(); worker++)
+    {
+        workers[worker].join();
+    }
+}
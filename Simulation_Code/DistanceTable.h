@@ -0,0 +1,58 @@
+/**
+ * @file    DistanceTable.h
+ * @brief   Definition file for the DistanceTable class
+ *
+ * @author  Andrew Frost, Richard Millar
+ * @version 1.00
+ */
+
+// Precompiler Directives =====================================================
+#ifndef DISTANCETABLE_H
+#define DISTANCETABLE_H
+
+// Header Files ===============================================================
+#include <vector>
+#include "RoadGraph.h"
+
+// Class Definition ===========================================================
+/**
+ * @brief   All pairs shortest path table of the city.
+ * @details Holds the cost between every pair of subnets together with the
+ *          first subnet to visit on the way, so a route is read off the table
+ *          in time proportional to its length. The table is filled by a blocked
+ *          Floyd-Warshall: the matrices are split into square tiles that fit in
+ *          the L1 cache, the tile kernel is written so the compiler vectorizes
+ *          its inner loop, and the independent tiles of each round are shared
+ *          between worker threads.
+ *
+ * @class   DistanceTable DistanceTable.h "DistanceTable.h"
+ */
+class DistanceTable
+{
+public:
+    DistanceTable();
+    ~DistanceTable();
+
+    void compute(const RoadGraph & graph, const std::vector<double> & edgeCosts, int threadCount);
+
+    bool isEmpty() const;
+
+    int getNodeCount() const;
+
+    double getDistance(int source, int target) const;
+
+    bool getPath(int source, int target, std::vector<int> & path) const;
+
+private:
+    void runRound(int block, int threadCount);
+
+    void updateTile(int row, int col, int pivot);
+
+    int nodeCount;
+    int stride; //nodeCount rounded up to a whole number of tiles
+
+    std::vector<float> distances; //row major, stride x stride
+    std::vector<int> nextHops; //first subnet after the row on the way to the column
+};
+
+#endif
@@ -0,0 +1,824 @@
+/**
+ * @file    Federation.cpp
+ *
+ * @brief   Implementation file for the CcnFederation class
+ *
+ * @author  Andrew Frost, Richard Millar
+ * @version 1.00
+ */
+
+// Header Files ===============================================================
+#include "Federation.h"
+#include "Trace.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <list>
+
+/**
+ * @brief   A road of the boundary overlay before it is compressed.
+ */
+struct OverlayRoad
+{
+    int target;
+    double cost;
+};
+
+// Class Implementation =======================================================
+/**
+ * @brief   Default constructor
+ * @details Constructs a federation with no regions, see build()
+ * @note    None
+ */
+CcnFederation::CcnFederation()
+    : partition(), cityGraph(), names(), cityIndex(), localIndex(), boundaryIndex(), boundarySubnets(), regions(),
+      overlayMutex(), overlay(), exchanges(0), exchangeSeconds(0), exchangeRunning(false), exchangeThread(),
+      localRoutes(0), stitchedRoutes(0), failedRoutes(0)
+{
+
+}
+
+
+/**
+ * @brief   Destructor
+ * @note    None
+ */
+CcnFederation::~CcnFederation()
+{
+    stopExchange();
+}
+
+
+/**
+ * @brief       Split a city into regions, each with its own Compute Node
+ * @details     Partitions the city's road graph, gives each region the subnets
+ *              and roads inside it, finds the boundary subnets and makes the
+ *              first overlay
+ *
+ * @param[in]   city            Compute Node holding the whole city
+ * @param[in]   regionCount     number of regions
+ * @param[in]   algorithm       routing algorithm of every region
+ *
+ * @note        The caller holds the lock of the city, nothing may route on
+ *              the federation while it is built
+ */
+void CcnFederation::build(CentralComputeNode & city, int regionCount, RoutingAlgorithm algorithm)
+{
+    std::vector<std::vector<std::string> > regionNames;
+    std::vector<RoadGraph> regionGraphs;
+    std::vector<int> capacities;
+    int node, region, edge, target, index;
+
+    stopExchange();
+
+    city.getSubnets(names, capacities);
+    cityGraph = city.getRoadGraph();
+    partition.build(cityGraph, regionCount);
+
+    cityIndex.clear();
+    localIndex.assign(cityGraph.getNodeCount(), -1);
+    boundaryIndex.assign(cityGraph.getNodeCount(), -1);
+    boundarySubnets.clear();
+    regions.clear();
+    regions.resize(partition.getRegionCount());
+    regionNames.resize(partition.getRegionCount());
+    regionGraphs.resize(partition.getRegionCount());
+
+    for (node = 0; node < cityGraph.getNodeCount(); node++)
+    {
+        region = partition.getRegion(node);
+
+        cityIndex[names[node]] = node;
+        localIndex[node] = (int)regions[region].subnets.size();
+        regions[region].subnets.push_back(node);
+        regionNames[region].push_back(names[node]);
+
+        if (!partition.getGhostRegions(node).empty())
+        {
+            regions[region].boundary.push_back(localIndex[node]);
+            boundaryIndex[node] = (int)boundarySubnets.size();
+            boundarySubnets.push_back(node);
+        }
+    }
+
+    //each region keeps the roads with both ends inside it
+    for (region = 0; region < (int)regions.size(); region++)
+    {
+        RoadGraph & graph = regionGraphs[region];
+
+        graph.offsets.assign(1, 0);
+
+        for (index = 0; index < (int)regions[region].subnets.size(); index++)
+        {
+            node = regions[region].subnets[index];
+
+            for (edge = cityGraph.offsets[node]; edge < cityGraph.offsets[node + 1]; edge++)
+            {
+                target = cityGraph.targets[edge];
+
+                if (partition.getRegion(target) == region)
+                {
+                    graph.targets.push_back(localIndex[target]);
+                    graph.costs.push_back(cityGraph.costs[edge]);
+                }
+            }
+
+            graph.offsets.push_back((int)graph.targets.size());
+        }
+
+        regions[region].ccn.reset(new CentralComputeNode());
+        regions[region].ccn->buildSubnetToIndexTable(regionNames[region]);
+        //local indices follow the city, which is already renumbered
+        regions[region].ccn->setNodeOrder(ORDER_INPUT);
+
+        for (index = 0; index < (int)regionNames[region].size(); index++)
+        {
+            regions[region].ccn->setSubnetProperties(regionNames[region][index],
+                                                     capacities[regions[region].subnets[index]]);
+        }
+
+        regions[region].ccn->setMap(graph);
+        regions[region].ccn->setRoutingAlgorithm(algorithm);
+        regions[region].ccn->setCostModel(city.getCostModel());
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(overlayMutex);
+
+        overlay.reset();
+        exchanges = 0;
+        exchangeSeconds = 0;
+    }
+
+    localRoutes = 0;
+    stitchedRoutes = 0;
+    failedRoutes = 0;
+
+    exchangeSummaries();
+}
+
+
+/**
+ * @brief   Get the number of regions
+ * @note    None
+ */
+int CcnFederation::getRegionCount() const
+{
+    return (int)regions.size();
+}
+
+
+/**
+ * @brief   Get the number of boundary subnets
+ * @note    None
+ */
+int CcnFederation::getBoundaryCount() const
+{
+    return (int)boundarySubnets.size();
+}
+
+
+/**
+ * @brief   Get the number of roads of the current overlay
+ * @details Roads between regions and shortcuts across regions
+ * @note    None
+ */
+int CcnFederation::getOverlayRoadCount() const
+{
+    std::lock_guard<std::mutex> guard(overlayMutex);
+
+    return overlay ? overlay->getEdgeCount() : 0;
+}
+
+
+/**
+ * @brief       Get the Compute Node of a region
+ *
+ * @param[in]   region  index of the region
+ *
+ * @note        Take its lock before using it
+ */
+CentralComputeNode & CcnFederation::getRegion(int region)
+{
+    return *regions[region].ccn;
+}
+
+
+/**
+ * @brief       Computes a route across the federation
+ * @details     Measures the congested cost from the start to every subnet of
+ *              its region and from every subnet of the destination's region
+ *              to the destination, then searches the overlay between the two
+ *              boundaries. A route inside one region is computed by the region
+ *              unless leaving it is cheaper.
+ *
+ * @param[out]  route   route to be computed and returned
+ *
+ * @note        Safe to call from any number of threads
+ */
+bool CcnFederation::computeRoute(Route & route)
+{
+    TRACE_SCOPE("federation", "computeRoute");
+
+    std::unordered_map<std::string, int>::const_iterator startEntry = cityIndex.find(route.start);
+    std::unordered_map<std::string, int>::const_iterator destEntry = cityIndex.find(route.dest);
+    std::shared_ptr<const RoadGraph> snapshot;
+    std::vector<double> fromStart, toDest;
+    std::vector<int> overlayPath, path;
+    double localCost = SEARCH_INFINITY, overlayCost = SEARCH_INFINITY;
+    int start, dest, startRegion, destRegion, index;
+    bool success;
+
+    if (startEntry == cityIndex.end() || destEntry == cityIndex.end())
+    {
+        failedRoutes++;
+        return false;
+    }
+
+    start = startEntry->second;
+    dest = destEntry->second;
+    startRegion = partition.getRegion(start);
+    destRegion = partition.getRegion(dest);
+
+    {
+        std::lock_guard<std::mutex> guard(overlayMutex);
+
+        snapshot = overlay;
+    }
+
+    Region & first = regions[startRegion];
+    Region & last = regions[destRegion];
+
+    //a region no road leaves has only its own routes
+    if (startRegion == destRegion && (!snapshot || first.boundary.empty()))
+    {
+        first.ccn->getLock();
+        {
+            success = first.ccn->computeRoute(route);
+        }
+        first.ccn->releaseLock();
+
+        (success ? localRoutes : failedRoutes)++;
+        return success;
+    }
+
+    first.ccn->getLock();
+    {
+        first.ccn->computeDistances(route.start, false, fromStart);
+    }
+    first.ccn->releaseLock();
+
+    if (startRegion == destRegion)
+    {
+        localCost = fromStart[localIndex[dest]];
+    }
+
+    if (snapshot && !first.boundary.empty() && !last.boundary.empty())
+    {
+        last.ccn->getLock();
+        {
+            last.ccn->computeDistances(route.dest, true, toDest);
+        }
+        last.ccn->releaseLock();
+
+        searchOverlay(*snapshot, startRegion, destRegion, fromStart, toDest, overlayCost, overlayPath);
+    }
+
+    if (localCost >= SEARCH_INFINITY && overlayCost >= SEARCH_INFINITY)
+    {
+        failedRoutes++;
+        return false;
+    }
+
+    if (localCost <= overlayCost)
+    {
+        first.ccn->getLock();
+        {
+            success = first.ccn->computeRoute(route);
+        }
+        first.ccn->releaseLock();
+
+        (success ? localRoutes : failedRoutes)++;
+        return success;
+    }
+
+    //stitch the regions' routes between the boundary subnets of the overlay path
+    success = appendSegment(startRegion, start, boundarySubnets[overlayPath.front()], path);
+
+    for (index = 0; success && index + 1 < (int)overlayPath.size(); index++)
+    {
+        int from = boundarySubnets[overlayPath[index]], to = boundarySubnets[overlayPath[index + 1]];
+
+        if (partition.getRegion(from) == partition.getRegion(to))
+        {
+            success = appendSegment(partition.getRegion(from), from, to, path);
+        }
+        else
+        {
+            path.push_back(to);
+        }
+    }
+
+    success = success && appendSegment(destRegion, boundarySubnets[overlayPath.back()], dest, path);
+
+    if (!success)
+    {
+        failedRoutes++;
+        return false;
+    }
+
+    buildRoute(path, route);
+    stitchedRoutes++;
+
+    return true;
+}
+
+
+/**
+ * @brief       Add a vehicle to the region of its source
+ *
+ * @param[in]   vehicle     vehicle to add
+ *
+ * @note        Vehicles are routed by computeRoute, not by the job queues of
+ *              the regions
+ */
+void CcnFederation::joinNetwork(Vehicle * vehicle)
+{
+    std::unordered_map<std::string, int>::const_iterator entry = cityIndex.find(vehicle->getSource());
+
+    if (entry == cityIndex.end())
+    {
+        return;
+    }
+
+    CentralComputeNode & ccn = *regions[partition.getRegion(entry->second)].ccn;
+
+    ccn.getLock();
+    {
+        ccn.joinNetwork(vehicle);
+    }
+    ccn.releaseLock();
+}
+
+
+/**
+ * @brief       Take a vehicle off the region it was last in
+ *
+ * @param[in]   id          vehicle ID
+ * @param[in]   lastNode    subnet the vehicle leaves from
+ *
+ * @note        None
+ */
+void CcnFederation::leaveNetwork(const std::string & id, const std::string & lastNode)
+{
+    std::unordered_map<std::string, int>::const_iterator entry = cityIndex.find(lastNode);
+
+    if (entry == cityIndex.end())
+    {
+        return;
+    }
+
+    CentralComputeNode & ccn = *regions[partition.getRegion(entry->second)].ccn;
+
+    ccn.getLock();
+    {
+        ccn.leaveNetwork(id, lastNode);
+    }
+    ccn.releaseLock();
+}
+
+
+/**
+ * @brief       Turn a vehicle onto a road
+ * @details     The region of the new road decides. A vehicle crossing into
+ *              another region then leaves the region it came from.
+ *
+ * @param[in]   id          vehicle ID
+ * @param[in]   currentRoad road the vehicle is on
+ * @param[in]   newRoad     road the vehicle wants to turn onto
+ *
+ * @note        Returns false if the new road is full
+ */
+bool CcnFederation::changeRoad(std::string & id, std::string & currentRoad, std::string & newRoad)
+{
+    std::unordered_map<std::string, int>::const_iterator current = cityIndex.find(currentRoad);
+    std::unordered_map<std::string, int>::const_iterator next = cityIndex.find(newRoad);
+    int currentRegion, newRegion;
+    bool success;
+
+    if (current == cityIndex.end() || next == cityIndex.end())
+    {
+        return false;
+    }
+
+    currentRegion = partition.getRegion(current->second);
+    newRegion = partition.getRegion(next->second);
+
+    CentralComputeNode & deciding = *regions[newRegion].ccn;
+
+    deciding.getLock();
+    {
+        success = deciding.changeRoad(id, currentRoad, newRoad);
+    }
+    deciding.releaseLock();
+
+    if (success && currentRegion != newRegion)
+    {
+        leaveNetwork(id, currentRoad);
+    }
+
+    return success;
+}
+
+
+/**
+ * @brief   Exchange the occupancy summaries of the regions
+ * @details Each region measures the congested cost from each of its boundary
+ *          subnets to the others and reports the occupancy of its subnets. Roads between regions are costed from
+ *          the occupancy at both ends, the way a Compute Node costs a road.
+ *          The new overlay then replaces the old one.
+ * @note    None
+ */
+void CcnFederation::exchangeSummaries()
+{
+    TRACE_SCOPE("federation", "exchangeSummaries");
+
+    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+    std::vector<std::vector<OverlayRoad> > roads(boundarySubnets.size());
+    std::shared_ptr<RoadGraph> next = std::make_shared<RoadGraph>();
+    std::vector<int> occupancy(cityGraph.getNodeCount(), 0);
+    std::vector<double> distances;
+    OccupancySample sample;
+    OverlayRoad road;
+    int region, from, to, node, edge, index;
+
+    for (region = 0; region < (int)regions.size(); region++)
+    {
+        Region & current = regions[region];
+
+        current.ccn->getLock();
+        {
+            current.ccn->sampleOccupancy(sample);
+        }
+        current.ccn->releaseLock();
+
+        //the lock is taken per boundary subnet so routes are not held up for
+        //the whole summary
+        for (from = 0; from < (int)current.boundary.size(); from++)
+        {
+            current.ccn->getLock();
+            {
+                current.ccn->computeDistances(names[current.subnets[current.boundary[from]]], false, distances);
+            }
+            current.ccn->releaseLock();
+
+            for (to = 0; to < (int)current.boundary.size(); to++)
+            {
+                if (to != from && distances[current.boundary[to]] < SEARCH_INFINITY)
+                {
+                    road.target = boundaryIndex[current.subnets[current.boundary[to]]];
+                    road.cost = distances[current.boundary[to]];
+                    roads[boundaryIndex[current.subnets[current.boundary[from]]]].push_back(road);
+                }
+            }
+        }
+
+        for (index = 0; index < (int)current.subnets.size(); index++)
+        {
+            occupancy[current.subnets[index]] = sample.occupancy[index];
+        }
+    }
+
+    for (node = 0; node < (int)boundarySubnets.size(); node++)
+    {
+        from = boundarySubnets[node];
+
+        for (edge = cityGraph.offsets[from]; edge < cityGraph.offsets[from + 1]; edge++)
+        {
+            to = cityGraph.targets[edge];
+
+            if (partition.getRegion(to) != partition.getRegion(from))
+            {
+                road.target = boundaryIndex[to];
+                road.cost = cityGraph.costs[edge] + cityGraph.costs[edge] * (occupancy[from] + occupancy[to]);
+                roads[node].push_back(road);
+            }
+        }
+    }
+
+    next->offsets.assign(1, 0);
+
+    for (node = 0; node < (int)roads.size(); node++)
+    {
+        for (index = 0; index < (int)roads[node].size(); index++)
+        {
+            next->targets.push_back(roads[node][index].target);
+            next->costs.push_back(roads[node][index].cost);
+        }
+
+        next->offsets.push_back((int)next->targets.size());
+    }
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+
+    std::lock_guard<std::mutex> guard(overlayMutex);
+
+    overlay = next;
+    exchanges++;
+    exchangeSeconds += elapsed.count();
+}
+
+
+/**
+ * @brief       Starts the periodic exchange
+ * @details     Launches a thread that exchanges the occupancy summaries every
+ *              period
+ *
+ * @param[in]   periodMS    time between exchanges in milliseconds
+ *
+ * @note        None
+ */
+void CcnFederation::startExchange(long long periodMS)
+{
+    stopExchange();
+
+    exchangeRunning = true;
+    exchangeThread = std::thread(&CcnFederation::exchangeLoop, this, periodMS);
+}
+
+
+/**
+ * @brief   Stops the periodic exchange
+ * @details Signals the exchange thread and waits for it to finish
+ * @note    None
+ */
+void CcnFederation::stopExchange()
+{
+    exchangeRunning = false;
+
+    if (exchangeThread.joinable())
+    {
+        exchangeThread.join();
+    }
+}
+
+
+/**
+ * @brief   Get what the federation has done so far
+ * @note    None
+ */
+FederationStats CcnFederation::getStats() const
+{
+    FederationStats stats;
+
+    stats.localRoutes = localRoutes;
+    stats.stitchedRoutes = stitchedRoutes;
+    stats.failedRoutes = failedRoutes;
+
+    std::lock_guard<std::mutex> guard(overlayMutex);
+
+    stats.exchanges = exchanges;
+    stats.exchangeSeconds = exchangeSeconds;
+
+    return stats;
+}
+
+
+/**
+ * @brief   Print what the federation has done so far
+ * @note    None
+ */
+void CcnFederation::printStatistics() const
+{
+    FederationStats stats = getStats();
+
+    std::cout << "Federation: " << regions.size() << " regions, " << boundarySubnets.size() << " boundary subnets, "
+              << getOverlayRoadCount() << " overlay roads, " << stats.localRoutes << " local routes, "
+              << stats.stitchedRoutes << " stitched routes, " << stats.failedRoutes << " failed, "
+              << stats.exchanges << " exchanges averaging "
+              << (stats.exchanges > 0 ? stats.exchangeSeconds * 1000.0 / stats.exchanges : 0) << " ms." << std::endl;
+}
+
+
+/**
+ * @brief       Search the boundary overlay
+ * @details     A Dijkstra search that starts from every boundary subnet of the
+ *              start region at the cost of reaching it, and ends at the
+ *              boundary subnet of the destination region with the lowest cost
+ *              plus the cost from there to the destination
+ *
+ * @param[in]   overlayGraph    overlay to search
+ * @param[in]   startRegion     region of the start
+ * @param[in]   destRegion      region of the destination
+ * @param[in]   fromStart       cost from the start, by subnet of its region
+ * @param[in]   toDest          cost to the destination, by subnet of its region
+ * @param[out]  cost            cost of the best route through the overlay
+ * @param[out]  path            overlay nodes of the best route
+ *
+ * @note        Returns false if the overlay does not join the two regions
+ */
+bool CcnFederation::searchOverlay(const RoadGraph & overlayGraph, int startRegion, int destRegion,
+                                  const std::vector<double> & fromStart, const std::vector<double> & toDest,
+                                  double & cost, std::vector<int> & path)
+{
+    SearchContext & context = getOverlayContext();
+    const Region & first = regions[startRegion];
+    int node, neighbor, edge, index, meet = -1;
+    double key, tentativeGScore, total;
+
+    cost = SEARCH_INFINITY;
+    path.clear();
+
+    context.prepare(overlayGraph.getNodeCount());
+
+    for (index = 0; index < (int)first.boundary.size(); index++)
+    {
+        key = fromStart[first.boundary[index]];
+        node = boundaryIndex[first.subnets[first.boundary[index]]];
+
+        if (key < context.getGScore(node))
+        {
+            context.relax(node, key, -1);
+            context.push(node, key);
+        }
+    }
+
+    while (context.pop(node, key))
+    {
+        if (context.isSettled(node))
+        {
+            continue;
+        }
+
+        //every cost is at least the key, nothing left can do better
+        if (key >= cost)
+        {
+            break;
+        }
+
+        context.settle(node);
+
+        if (partition.getRegion(boundarySubnets[node]) == destRegion)
+        {
+            total = key + toDest[localIndex[boundarySubnets[node]]];
+
+            if (total < cost)
+            {
+                cost = total;
+                meet = node;
+            }
+        }
+
+        for (edge = overlayGraph.offsets[node]; edge < overlayGraph.offsets[node + 1]; edge++)
+        {
+            neighbor = overlayGraph.targets[edge];
+            tentativeGScore = key + overlayGraph.costs[edge];
+
+            if (!context.isSettled(neighbor) && tentativeGScore < context.getGScore(neighbor))
+            {
+                context.relax(neighbor, tentativeGScore, node);
+                context.push(neighbor, tentativeGScore);
+            }
+        }
+    }
+
+    if (meet < 0)
+    {
+        return false;
+    }
+
+    for (node = meet; node >= 0; node = context.getParent(node))
+    {
+        path.push_back(node);
+    }
+
+    std::reverse(path.begin(), path.end());
+
+    return true;
+}
+
+
+/**
+ * @brief       Append a region's route between two of its subnets to a path
+ *
+ * @param[in]   region  region both subnets are in
+ * @param[in]   from    city subnet the segment starts at, already the end of
+ *                      path unless path is empty
+ * @param[in]   to      city subnet the segment ends at
+ * @param[out]  path    city subnets of the route so far
+ *
+ * @note        Returns false if the region has no route
+ */
+bool CcnFederation::appendSegment(int region, int from, int to, std::vector<int> & path)
+{
+    std::list<std::pair<std::string, double> >::const_iterator step;
+    CentralComputeNode & ccn = *regions[region].ccn;
+    Route segment;
+    bool success = true;
+
+    if (path.empty())
+    {
+        path.push_back(from);
+    }
+
+    if (from == to)
+    {
+        return true;
+    }
+
+    segment.start = names[from];
+    segment.dest = names[to];
+
+    ccn.getLock();
+    {
+        success = ccn.computeRoute(segment);
+    }
+    ccn.releaseLock();
+
+    if (!success)
+    {
+        return false;
+    }
+
+    for (step = segment.route.begin(); step != segment.route.end(); ++step)
+    {
+        int node = cityIndex.find(step->first)->second;
+
+        if (node != path.back())
+        {
+            path.push_back(node);
+        }
+    }
+
+    return true;
+}
+
+
+/**
+ * @brief       Builds a route from city subnets
+ * @details     Each entry holds the free flow time to the next entry, the same
+ *              layout a Compute Node's routes have
+ *
+ * @param[in]   path    city subnets from start to destination
+ * @param[out]  route   route to be filled
+ *
+ * @note        None
+ */
+void CcnFederation::buildRoute(const std::vector<int> & path, Route & route) const
+{
+    unsigned int index;
+
+    route.route.clear();
+
+    for (index = 0; index + 1 < path.size(); index++)
+    {
+        route.route.push_back(std::pair<std::string, double>(names[path[index]],
+            cityGraph.getCost(path[index], path[index + 1])));
+    }
+
+    route.route.push_back(std::pair<std::string, double>(names[path.back()], 0));
+}
+
+
+/**
+ * @brief       Periodic exchange
+ * @details     Body of the exchange thread
+ *
+ * @param[in]   periodMS    time between exchanges in milliseconds
+ *
+ * @note        None
+ */
+void CcnFederation::exchangeLoop(long long periodMS)
+{
+    TRACE_THREAD_NAME("federation exchange");
+
+    long long waited;
+
+    while (exchangeRunning)
+    {
+        //sleep in short slices so stopping does not wait a whole period
+        for (waited = 0; waited < periodMS && exchangeRunning; waited += FEDERATION_SLICE_MS)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(FEDERATION_SLICE_MS));
+        }
+
+        if (exchangeRunning)
+        {
+            exchangeSummaries();
+        }
+    }
+}
+
+
+/**
+ * @brief   Get the overlay search context
+ * @details Returns the context of the calling thread for searching the
+ *          overlay, apart from the contexts the regions search with
+ * @note    None
+ */
+SearchContext & CcnFederation::getOverlayContext()
+{
+    static thread_local SearchContext context;
+
+    return context;
+}
@@ -0,0 +1,141 @@
+/**
+ * @file    Federation.h
+ * @brief   Definition file for the CcnFederation class
+ *
+ * @author  Andrew Frost, Richard Millar
+ * @version 1.00
+ */
+
+// Precompiler Directives =====================================================
+#ifndef FEDERATION_H
+#define FEDERATION_H
+
+// Header Files ===============================================================
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "CentralComputeNode.h"
+#include "Partition.h"
+#include "RoadAuthority.h"
+#include "RoadGraph.h"
+#include "SearchContext.h"
+
+#define FEDERATION_SLICE_MS 10
+
+class Vehicle;
+
+/**
+ * @brief   What a federation has done so far.
+ */
+struct FederationStats
+{
+    long long localRoutes; //answered by the region of the start alone
+    long long stitchedRoutes; //crossed the boundary overlay
+    long long failedRoutes;
+    long long exchanges;
+    double exchangeSeconds; //spent in all exchanges
+};
+
+
+// Class Definition ===========================================================
+/**
+ * @brief   Several Compute Nodes, each authoritative for one region of the
+ *          city, routing together.
+ * @details The city is split by a RoadPartition. Each region gets a Compute
+ *          Node of its own holding only its subnets and the roads between
+ *          them, behind its own lock, so routes in different regions are
+ *          computed in parallel. A boundary subnet has a road to or from
+ *          another region. The boundary overlay joins the boundary subnets
+ *          with the roads between regions and, inside each region, a shortcut
+ *          from every boundary subnet to every other carrying the congested
+ *          cost of the best path between them.
+ *
+ *          A route inside one region is computed by that region. A route
+ *          between regions, or one that is cheaper leaving its region, is
+ *          found on the overlay from the costs of reaching the start region's
+ *          boundary and of leaving for the destination, then stitched from
+ *          the regions' own routes for each shortcut. Only one region's lock
+ *          is held at a time.
+ *
+ *          The regions exchange occupancy summaries periodically: each
+ *          recomputes its shortcuts and reports the occupancy of its boundary
+ *          subnets for the roads between regions, and the new overlay is
+ *          swapped in whole, so routes in flight keep the overlay they
+ *          started with.
+ *
+ * @class   CcnFederation Federation.h "Federation.h"
+ */
+class CcnFederation : public RoadAuthority
+{
+public:
+    CcnFederation();
+    ~CcnFederation();
+
+    void build(CentralComputeNode & city, int regionCount, RoutingAlgorithm algorithm);
+
+    int getRegionCount() const;
+    int getBoundaryCount() const;
+    int getOverlayRoadCount() const;
+    CentralComputeNode & getRegion(int region);
+
+    bool computeRoute(Route & route);
+
+    void joinNetwork(Vehicle* vehicle);
+    void leaveNetwork(const std::string & id, const std::string & lastNode);
+    bool changeRoad(std::string & id, std::string & currentRoad, std::string & newRoad);
+
+    void exchangeSummaries();
+    void startExchange(long long periodMS);
+    void stopExchange();
+
+    FederationStats getStats() const;
+    void printStatistics() const;
+
+private:
+    /**
+     * @brief   A region and its Compute Node.
+     */
+    struct Region
+    {
+        std::unique_ptr<CentralComputeNode> ccn;
+        std::vector<int> subnets; //city subnet of each subnet of the region
+        std::vector<int> boundary; //subnets of the region on the boundary
+    };
+
+    bool searchOverlay(const RoadGraph & overlayGraph, int startRegion, int destRegion,
+                       const std::vector<double> & fromStart, const std::vector<double> & toDest,
+                       double & cost, std::vector<int> & path);
+    bool appendSegment(int region, int from, int to, std::vector<int> & path);
+    void buildRoute(const std::vector<int> & path, Route & route) const;
+
+    void exchangeLoop(long long periodMS);
+
+    static SearchContext & getOverlayContext();
+
+    RoadPartition partition;
+    RoadGraph cityGraph; //free flow travel times of the whole city
+    std::vector<std::string> names; //of the city subnets
+    std::unordered_map<std::string, int> cityIndex;
+    std::vector<int> localIndex; //index of each city subnet in its region
+    std::vector<int> boundaryIndex; //overlay node of each city subnet, -1 inside a region
+    std::vector<int> boundarySubnets; //city subnet of each overlay node
+    std::vector<Region> regions;
+
+    mutable std::mutex overlayMutex; //guards the overlay pointer and the exchange counts
+    std::shared_ptr<const RoadGraph> overlay; //over the boundary subnets, by overlay node
+    long long exchanges;
+    double exchangeSeconds;
+
+    std::atomic_bool exchangeRunning;
+    std::thread exchangeThread;
+
+    std::atomic<long long> localRoutes;
+    std::atomic<long long> stitchedRoutes;
+    std::atomic<long long> failedRoutes;
+};
+
+#endif
@@ -0,0 +1,137 @@
+/**
+ * @file    HandoffQueue.h
+ * @brief   Definition and implementation of the HandoffQueue class template
+ * @details A template, so the implementation lives in the header.
+ *
+ * @author  Andrew Frost, Richard Millar
+ * @version 1.00
+ */
+
+// Precompiler Directives =====================================================
+#ifndef HANDOFFQUEUE_H
+#define HANDOFFQUEUE_H
+
+// Header Files ===============================================================
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+#define HANDOFF_CACHE_LINE 64
+
+// Class Definition ===========================================================
+/**
+ * @brief   Bounded lock free queue between one producer and one consumer.
+ * @details A ring of a power of two size. Only the producer moves the tail and
+ *          only the consumer moves the head, each publishing with a release
+ *          store that the other side reads with an acquire load, so neither
+ *          side ever waits on a lock. The two indices sit on separate cache
+ *          lines so the threads do not share a line they both write.
+ *
+ * @class   HandoffQueue HandoffQueue.h "HandoffQueue.h"
+ */
+template <typename T>
+class HandoffQueue
+{
+public:
+    HandoffQueue(size_t minimumCapacity);
+    ~HandoffQueue();
+
+    bool push(const T & item);
+    bool pop(T & item);
+
+private:
+    std::vector<T> items;
+    size_t mask;
+
+    char paddingHead[HANDOFF_CACHE_LINE];
+    std::atomic<size_t> head; //next item to pop, written by the consumer
+    char paddingTail[HANDOFF_CACHE_LINE];
+    std::atomic<size_t> tail; //next slot to push to, written by the producer
+    char paddingEnd[HANDOFF_CACHE_LINE];
+};
+
+
+// Class Implementation =======================================================
+/**
+ * @brief       HandoffQueue constructor
+ *
+ * @param[in]   minimumCapacity     items the queue must hold, rounded up to a
+ *                                  power of two
+ *
+ * @note        None
+ */
+template <typename T>
+HandoffQueue<T>::HandoffQueue(size_t minimumCapacity)
+    : items(), mask(0), head(0), tail(0)
+{
+    size_t capacity = 1;
+
+    while (capacity < minimumCapacity)
+    {
+        capacity <<= 1;
+    }
+
+    items.resize(capacity);
+    mask = capacity - 1;
+}
+
+
+/**
+ * @brief   HandoffQueue destructor
+ * @note    None
+ */
+template <typename T>
+HandoffQueue<T>::~HandoffQueue()
+{
+
+}
+
+
+/**
+ * @brief       Add an item, called by the producer only
+ *
+ * @param[in]   item    item to add
+ *
+ * @note        Returns false if the queue is full
+ */
+template <typename T>
+bool HandoffQueue<T>::push(const T & item)
+{
+    size_t position = tail.load(std::memory_order_relaxed);
+
+    if (position - head.load(std::memory_order_acquire) > mask)
+    {
+        return false;
+    }
+
+    items[position & mask] = item;
+    tail.store(position + 1, std::memory_order_release);
+
+    return true;
+}
+
+
+/**
+ * @brief       Take the oldest item, called by the consumer only
+ *
+ * @param[out]  item    item taken
+ *
+ * @note        Returns false if the queue is empty
+ */
+template <typename T>
+bool HandoffQueue<T>::pop(T & item)
+{
+    size_t position = head.load(std::memory_order_relaxed);
+
+    if (position == tail.load(std::memory_order_acquire))
+    {
+        return false;
+    }
+
+    item = items[position & mask];
+    head.store(position + 1, std::memory_order_release);
+
+    return true;
+}
+
+#endif
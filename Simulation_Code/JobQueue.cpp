@@ -0,0 +1,907 @@
+/**
+ * @file    JobQueue.cpp
+ *
+ * @brief   Implementation file for the JobQueue class
+ *
+ * @author  Andrew Frost, Richard Millar
+ * @version 1.00
+ */
+
+// Header Files ===============================================================
+#include "JobQueue.h"
+#include <algorithm>
+#include <cmath>
+
+#define DEFAULT_TRANSIT_WEIGHT 4
+#define DEFAULT_PRIVATE_WEIGHT 1
+
+
+/**
+ * @brief   Default constructor
+ * @details Constructs an empty queue, transit is served four times as often as
+ *          private vehicles
+ * @note    None
+ */
+JobQueue::JobQueue()
+    : buckets(), pending(), delayedJobs(), strandedJobs(), capacity(0), policy(ADMIT_REJECT), admission()
+{
+    int priority;
+
+    for (priority = 0; priority < PRIORITY_COUNT; priority++)
+    {
+        weights[priority] = 1;
+        credits[priority] = 0;
+    }
+
+    weights[PRIORITY_TRANSIT] = DEFAULT_TRANSIT_WEIGHT;
+    weights[PRIORITY_PRIVATE] = DEFAULT_PRIVATE_WEIGHT;
+}
+
+/**
+ * @brief   Default destructor
+ * @details Destroys a JobQueue object
+ * @note    None
+ */
+JobQueue::~JobQueue()
+{
+
+}
+
+
+/**
+ * @brief       Adds a job
+ * @details     If the vehicle already has a job waiting, that job takes the new
+ *              start and destination and keeps its place, a stranded job goes
+ *              back in the queue to try the new destination. Otherwise the job is
+ *              stamped with the current time and appended to the queue of its
+ *              class and to its bucket, unless the queue is full.
+ *
+ * @param[in]   job     job to be appended
+ * @param[in]   key     bucket of the job's start and destination
+ *
+ * @note        A full queue delays or rejects the job depending on the policy,
+ *              EMERGENCY jobs are always queued
+ */
+AdmissionResult JobQueue::push(const Job & job, unsigned long long key)
+{
+    std::unordered_map<std::string, Pending>::iterator waiting = pending.find(job.id);
+    std::unordered_map<unsigned long long, Bucket>::iterator bucket;
+    Job stamped = job;
+
+    if (waiting != pending.end())
+    {
+        Pending & place = waiting->second;
+
+        admission.coalesced++;
+
+        if (place.stranded)
+        {
+            stamped = place.parked->first;
+            stamped.start = job.start;
+            stamped.dest = job.dest;
+
+            strandedJobs.erase(place.parked);
+            enqueue(stamped, key);
+
+            return JOB_COALESCED;
+        }
+
+        if (place.delayed)
+        {
+            place.parked->first.start = job.start;
+            place.parked->first.dest = job.dest;
+            place.parked->second = key;
+        }
+        else if (place.key != key)
+        {
+            //move the waiting job over to the bucket of its new route
+            bucket = buckets.find(place.key);
+            bucket->second.erase(place.entry);
+
+            if (bucket->second.empty())
+            {
+                buckets.erase(bucket);
+            }
+
+            place.job->start = job.start;
+            place.job->dest = job.dest;
+
+            place.entry = file(buckets[key], place.job);
+        }
+
+        place.key = key;
+
+        return JOB_COALESCED;
+    }
+
+    //restored jobs arrive with the time they were first queued
+    if (stamped.queuedTime == std::chrono::steady_clock::time_point())
+    {
+        stamped.queuedTime = std::chrono::steady_clock::now();
+    }
+
+    if (capacity > 0 && getSize() >= capacity && job.priority != PRIORITY_EMERGENCY)
+    {
+        if (policy == ADMIT_DELAY)
+        {
+            Pending & place = pending[job.id];
+
+            place.delayed = true;
+            place.stranded = false;
+            place.key = key;
+            place.parked = delayedJobs.insert(delayedJobs.end(), std::make_pair(stamped, key));
+
+            admission.delayed++;
+
+            return JOB_DELAYED;
+        }
+
+        admission.rejected++;
+
+        return JOB_REJECTED;
+    }
+
+    enqueue(stamped, key);
+
+    admission.queued++;
+
+    return JOB_QUEUED;
+}
+
+
+/**
+ * @brief       Drops the job of a vehicle
+ * @details     Removes the waiting, delayed or stranded job of the vehicle without
+ *              recording a latency, used when the vehicle leaves
+ *
+ * @param[in]   id      vehicle whose job to drop
+ *
+ * @note        Returns false if the vehicle had no job waiting
+ */
+bool JobQueue::cancel(const std::string & id)
+{
+    std::unordered_map<std::string, Pending>::iterator waiting = pending.find(id);
+    std::unordered_map<unsigned long long, Bucket>::iterator bucket;
+
+    if (waiting == pending.end())
+    {
+        return false;
+    }
+
+    if (waiting->second.delayed)
+    {
+        delayedJobs.erase(waiting->second.parked);
+    }
+    else if (waiting->second.stranded)
+    {
+        strandedJobs.erase(waiting->second.parked);
+    }
+    else
+    {
+        bucket = buckets.find(waiting->second.key);
+        bucket->second.erase(waiting->second.entry);
+
+        if (bucket->second.empty())
+        {
+            buckets.erase(bucket);
+        }
+
+        queues[waiting->second.job->priority].erase(waiting->second.job);
+    }
+
+    pending.erase(waiting);
+
+    admitDelayed();
+
+    return true;
+}
+
+
+/**
+ * @brief   Shows whether any job is waiting
+ * @details Returns true when every class queue is empty
+ * @note    None
+ */
+bool JobQueue::isEmpty() const
+{
+    return getSize() == 0;
+}
+
+
+/**
+ * @brief   Get the queue length
+ * @details Returns the number of waiting jobs of all classes
+ * @note    None
+ */
+int JobQueue::getSize() const
+{
+    int priority, size = 0;
+
+    for (priority = 0; priority < PRIORITY_COUNT; priority++)
+    {
+        size += (int)queues[priority].size();
+    }
+
+    return size;
+}
+
+
+/**
+ * @brief       Get the queue length of one class
+ * @details     Returns the number of waiting jobs of the class
+ *
+ * @param[in]   priority    class to count
+ *
+ * @note        None
+ */
+int JobQueue::getSize(JobPriority priority) const
+{
+    return (int)queues[priority].size();
+}
+
+
+/**
+ * @brief       Get the number of jobs waiting for one route
+ * @details     Returns the size of the bucket of a start and destination
+ *
+ * @param[in]   key     bucket of the route, see CentralComputeNode::getJobKey
+ *
+ * @note        Delayed jobs are not counted until they are queued
+ */
+int JobQueue::getWaitingCount(unsigned long long key) const
+{
+    std::unordered_map<unsigned long long, Bucket>::const_iterator bucket = buckets.find(key);
+
+    return bucket == buckets.end() ? 0 : (int)bucket->second.size();
+}
+
+
+/**
+ * @brief       Picks the next job to route
+ * @details     Returns the head of the EMERGENCY queue if there is one. Otherwise
+ *              the overdue head with the earliest deadline, and if none is
+ *              overdue the head of the class with the most round robin credit.
+ *              The job stays queued until a route is delivered to it.
+ *
+ * @param[out]  job     job to route
+ *
+ * @note        Returns false if no job is waiting
+ */
+bool JobQueue::selectNext(Job & job)
+{
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    std::chrono::steady_clock::time_point due, earliest;
+    int priority, chosen = -1, totalWeight = 0;
+
+    if (!queues[PRIORITY_EMERGENCY].empty())
+    {
+        job = queues[PRIORITY_EMERGENCY].front();
+        return true;
+    }
+
+    for (priority = PRIORITY_EMERGENCY + 1; priority < PRIORITY_COUNT; priority++)
+    {
+        const std::list<Job> & queue = queues[priority];
+
+        if (queue.empty() || queue.front().deadline <= 0)
+        {
+            continue;
+        }
+
+        due = queue.front().queuedTime + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                  std::chrono::duration<double>(queue.front().deadline));
+
+        if (due <= now && (chosen < 0 || due < earliest))
+        {
+            chosen = priority;
+            earliest = due;
+        }
+    }
+
+    if (chosen >= 0)
+    {
+        job = queues[chosen].front();
+        return true;
+    }
+
+    //smooth weighted round robin over the classes that have work
+    for (priority = PRIORITY_EMERGENCY + 1; priority < PRIORITY_COUNT; priority++)
+    {
+        if (queues[priority].empty())
+        {
+            continue;
+        }
+
+        credits[priority] += weights[priority];
+        totalWeight += weights[priority];
+
+        if (chosen < 0 || credits[priority] > credits[chosen])
+        {
+            chosen = priority;
+        }
+    }
+
+    if (chosen < 0)
+    {
+        return false;
+    }
+
+    credits[chosen] -= totalWeight;
+    job = queues[chosen].front();
+
+    return true;
+}
+
+
+/**
+ * @brief       Set the share of a class
+ * @details     Classes other than EMERGENCY are served in proportion to their
+ *              weights while they all have work
+ *
+ * @param[in]   priority    class to change
+ * @param[in]   weight      relative share, at least 1
+ *
+ * @note        None
+ */
+void JobQueue::setWeight(JobPriority priority, int weight)
+{
+    weights[priority] = weight < 1 ? 1 : weight;
+}
+
+
+/**
+ * @brief       Limit the queue length
+ * @details     Sets how many jobs may be queued and what happens to jobs that
+ *              arrive while that many are waiting
+ *
+ * @param[in]   newCapacity     most queued jobs, 0 for no limit
+ * @param[in]   newPolicy       what to do with jobs that do not fit
+ *
+ * @note        None
+ */
+void JobQueue::setCapacity(int newCapacity, AdmissionPolicy newPolicy)
+{
+    capacity = newCapacity < 0 ? 0 : newCapacity;
+    policy = newPolicy;
+
+    admitDelayed();
+}
+
+
+/**
+ * @brief   Get the admission policy
+ * @details Returns what happens to jobs that arrive while the queue is full
+ * @note    None
+ */
+AdmissionPolicy JobQueue::getPolicy() const
+{
+    return policy;
+}
+
+
+/**
+ * @brief   Get the delayed job count
+ * @details Returns the number of jobs parked until the queue has room
+ * @note    None
+ */
+int JobQueue::getDelayedCount() const
+{
+    return (int)delayedJobs.size();
+}
+
+
+/**
+ * @brief       Moves a job behind the others of its class
+ * @details     Puts the queued job of the vehicle at the back of its class queue
+ *              and of its class in its bucket, keeping the time it was queued
+ *
+ * @param[in]   id      vehicle whose job to move
+ *
+ * @note        Returns false if the vehicle has no queued job
+ */
+bool JobQueue::requeue(const std::string & id)
+{
+    std::unordered_map<std::string, Pending>::iterator waiting = pending.find(id);
+
+    if (waiting == pending.end() || waiting->second.delayed || waiting->second.stranded)
+    {
+        return false;
+    }
+
+    Pending & place = waiting->second;
+    std::list<Job> & queue = queues[place.job->priority];
+    Bucket & bucket = buckets[place.key];
+
+    queue.splice(queue.end(), queue, place.job);
+
+    bucket.erase(place.entry);
+    place.entry = file(bucket, place.job);
+
+    return true;
+}
+
+
+/**
+ * @brief       Sets a job aside
+ * @details     Takes the queued job of the vehicle out of its class queue and its
+ *              bucket, keeping the time it was queued, so the jobs behind it are
+ *              served while its destination cannot be reached
+ *
+ * @param[in]   id      vehicle whose job to set aside
+ *
+ * @note        Returns false if the vehicle has no queued job
+ */
+bool JobQueue::strand(const std::string & id)
+{
+    std::unordered_map<std::string, Pending>::iterator waiting = pending.find(id);
+    std::unordered_map<unsigned long long, Bucket>::iterator bucket;
+
+    if (waiting == pending.end() || waiting->second.delayed || waiting->second.stranded)
+    {
+        return false;
+    }
+
+    Pending & place = waiting->second;
+
+    bucket = buckets.find(place.key);
+    bucket->second.erase(place.entry);
+
+    if (bucket->second.empty())
+    {
+        buckets.erase(bucket);
+    }
+
+    place.stranded = true;
+    place.parked = strandedJobs.insert(strandedJobs.end(), std::make_pair(*place.job, place.key));
+
+    queues[place.job->priority].erase(place.job);
+
+    admission.stranded++;
+
+    admitDelayed();
+
+    return true;
+}
+
+
+/**
+ * @brief   Puts the stranded jobs back in the queue
+ * @details Called by the Compute Node when the roads have changed and the
+ *          destinations may be reached again. The jobs were admitted before,
+ *          so they go back whatever the capacity.
+ * @note    Returns the number of jobs put back
+ */
+int JobQueue::releaseStranded()
+{
+    int released = 0;
+
+    while (!strandedJobs.empty())
+    {
+        enqueue(strandedJobs.front().first, strandedJobs.front().second);
+        strandedJobs.pop_front();
+        released++;
+    }
+
+    return released;
+}
+
+
+/**
+ * @brief   Get the stranded job count
+ * @details Returns the number of jobs set aside for want of a route
+ * @note    None
+ */
+int JobQueue::getStrandedCount() const
+{
+    return (int)strandedJobs.size();
+}
+
+
+/**
+ * @brief   Counts a stale route
+ * @details Called by the Compute Node when a rejected job was answered with a
+ *          cached route instead
+ * @note    None
+ */
+void JobQueue::recordStaleRoute()
+{
+    admission.staleServed++;
+}
+
+
+/**
+ * @brief   Get the admission counters
+ * @details Returns how many jobs were queued, coalesced, delayed and shed
+ * @note    None
+ */
+const AdmissionStats & JobQueue::getAdmissionStats() const
+{
+    return admission;
+}
+
+
+/**
+ * @brief       Writes the waiting jobs
+ * @details     Writes the number of jobs followed by every queued job, class by
+ *              class in queue order, then the stranded and the delayed jobs.
+ *              Pushing them back in this order restores the queue, with the
+ *              stranded jobs queued to try again.
+ *
+ * @param[in]   writer  checkpoint to write to
+ *
+ * @note        None
+ */
+void JobQueue::save(CheckpointWriter & writer) const
+{
+    std::list<Job>::const_iterator job;
+    DelayedList::const_iterator parked;
+    int priority;
+
+    writer.writeInt(getSize() + getStrandedCount() + getDelayedCount());
+
+    for (priority = 0; priority < PRIORITY_COUNT; priority++)
+    {
+        for (job = queues[priority].begin(); job != queues[priority].end(); ++job)
+        {
+            job->save(writer);
+        }
+    }
+
+    for (parked = strandedJobs.begin(); parked != strandedJobs.end(); ++parked)
+    {
+        parked->first.save(writer);
+    }
+
+    for (parked = delayedJobs.begin(); parked != delayedJobs.end(); ++parked)
+    {
+        parked->first.save(writer);
+    }
+}
+
+
+/**
+ * @brief       Get the latency of a class
+ * @details     Returns the route delivery latencies recorded for the class
+ *
+ * @param[in]   priority    class to report
+ *
+ * @note        None
+ */
+const LatencyStats & JobQueue::getLatencyStats(JobPriority priority) const
+{
+    return latencies[priority];
+}
+
+
+/**
+ * @brief       Queues a job
+ * @details     Appends the job to the queue of its class and to its bucket and
+ *              remembers where the job of the vehicle is
+ *
+ * @param[in]   job     job to be appended, already stamped
+ * @param[in]   key     bucket of the job's start and destination
+ *
+ * @note        None
+ */
+void JobQueue::enqueue(const Job & job, unsigned long long key)
+{
+    std::list<Job> & queue = queues[job.priority];
+    Bucket & bucket = buckets[key];
+    Pending & place = pending[job.id];
+
+    place.delayed = false;
+    place.stranded = false;
+    place.key = key;
+    place.job = queue.insert(queue.end(), job);
+    place.entry = file(bucket, place.job);
+
+    if (getSize() > admission.maxDepth)
+    {
+        admission.maxDepth = getSize();
+    }
+}
+
+
+/**
+ * @brief       Files a job in its bucket
+ * @details     Inserts the job after the last job of its class or a higher one,
+ *              so the bucket stays in class order and in queue order within a
+ *              class
+ *
+ * @param[in]   bucket  bucket of the job's start and destination
+ * @param[in]   job     job within its class queue
+ *
+ * @note        Returns where the job was filed
+ */
+JobQueue::Bucket::iterator JobQueue::file(Bucket & bucket, std::list<Job>::iterator job)
+{
+    Bucket::iterator place = bucket.end(), before;
+
+    //jobs of lower classes are few and at the back
+    while (place != bucket.begin())
+    {
+        before = place;
+        --before;
+
+        if ((*before)->priority <= job->priority)
+        {
+            break;
+        }
+
+        place = before;
+    }
+
+    return bucket.insert(place, job);
+}
+
+
+/**
+ * @brief       Removes a served job
+ * @details     Records the job's latency and erases it from its class queue and
+ *              its bucket
+ *
+ * @param[in]   bucket  bucket holding the job
+ * @param[in]   entry   job within the bucket, moved to the next one
+ *
+ * @note        None
+ */
+void JobQueue::remove(Bucket & bucket, Bucket::iterator & entry)
+{
+    const Job & job = **entry;
+    std::chrono::duration<double> latency = std::chrono::steady_clock::now() - job.queuedTime;
+
+    latencies[job.priority].record(latency.count(), job.deadline > 0 && latency.count() > job.deadline);
+
+    pending.erase(job.id);
+
+    queues[job.priority].erase(*entry);
+    entry = bucket.erase(entry);
+}
+
+
+/**
+ * @brief   Queues delayed jobs
+ * @details Moves parked jobs into the queue, oldest first, while there is room.
+ *          They keep the time they first arrived, so their latency includes the
+ *          delay.
+ * @note    None
+ */
+void JobQueue::admitDelayed()
+{
+    while (!delayedJobs.empty() && (capacity == 0 || getSize() < capacity))
+    {
+        enqueue(delayedJobs.front().first, delayedJobs.front().second);
+        delayedJobs.pop_front();
+    }
+}
+
+
+/**
+ * @brief       Reads a priority class
+ * @details     Maps the name used in input and trip files to its priority class
+ *
+ * @param[in]   name        emergency, transit or private
+ * @param[out]  priority    class of the name
+ *
+ * @note        Returns false if the name is not a class
+ */
+bool ParseJobPriority(const std::string & name, JobPriority & priority)
+{
+    if (name == "emergency")
+    {
+        priority = PRIORITY_EMERGENCY;
+    }
+    else if (name == "transit")
+    {
+        priority = PRIORITY_TRANSIT;
+    }
+    else if (name == "private")
+    {
+        priority = PRIORITY_PRIVATE;
+    }
+    else
+    {
+        return false;
+    }
+
+    return true;
+}
+
+
+/**
+ * @brief   Default job constructor
+ * @details Constructs a job object
+ * @note    None
+ */
+Job::Job() : start(""), dest(""), id(""), priority(PRIORITY_PRIVATE), deadline(0), queuedTime()
+{
+
+}
+
+/**
+ * @brief   Default job desructor
+ * @details Destroys job object
+ * @note    None
+ */
+Job::~Job() {}
+
+
+/**
+ * @brief       Writes the job
+ * @details     The queue time is written as how long the job has waited
+ *
+ * @param[in]   writer  checkpoint to write to
+ *
+ * @note        None
+ */
+void Job::save(CheckpointWriter & writer) const
+{
+    std::chrono::duration<double> waited = std::chrono::steady_clock::now() - queuedTime;
+
+    writer.writeString(start);
+    writer.writeString(dest);
+    writer.writeString(id);
+    writer.writeInt(priority);
+    writer.writeDouble(deadline);
+    writer.writeDouble(waited.count());
+}
+
+
+/**
+ * @brief       Reads the job
+ * @details     Backdates the queue time by how long the job had waited, so its
+ *              latency and deadline carry over
+ *
+ * @param[in]   reader  checkpoint to read from
+ *
+ * @note        None
+ */
+void Job::load(CheckpointReader & reader)
+{
+    long long readPriority;
+
+    start = reader.readString();
+    dest = reader.readString();
+    id = reader.readString();
+    readPriority = reader.readInt();
+    deadline = reader.readDouble();
+
+    priority = (readPriority >= 0 && readPriority < PRIORITY_COUNT) ? (JobPriority)readPriority : PRIORITY_PRIVATE;
+    queuedTime = std::chrono::steady_clock::now() - std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                     std::chrono::duration<double>(reader.readDouble()));
+}
+
+
+/**
+ * @brief   Default constructor
+ * @details Constructs zeroed counters
+ * @note    None
+ */
+AdmissionStats::AdmissionStats()
+    : queued(0), coalesced(0), delayed(0), rejected(0), staleServed(0), stranded(0), maxDepth(0)
+{
+
+}
+
+/**
+ * @brief   Default destructor
+ * @details Destroys an AdmissionStats object
+ * @note    None
+ */
+AdmissionStats::~AdmissionStats()
+{
+
+}
+
+
+/**
+ * @brief   Default constructor
+ * @details Constructs empty statistics
+ * @note    None
+ */
+LatencyStats::LatencyStats() : count(0), missed(0), total(0), maximum(0)
+{
+    int bucket;
+
+    for (bucket = 0; bucket < LATENCY_BUCKETS; bucket++)
+    {
+        buckets[bucket] = 0;
+    }
+}
+
+/**
+ * @brief   Default destructor
+ * @details Destroys a LatencyStats object
+ * @note    None
+ */
+LatencyStats::~LatencyStats()
+{
+
+}
+
+
+/**
+ * @brief       Records one delivery
+ * @details     Adds the latency to the totals and to its bucket. Bucket 0 holds
+ *              latencies below a microsecond, then each power of two 2^e has
+ *              LATENCY_SUB_BUCKETS buckets of equal width from 2^e up to 2^(e+1)
+ *              microseconds.
+ *
+ * @param[in]   seconds         time from queueing to delivery
+ * @param[in]   missedDeadline  whether the job was delivered late
+ *
+ * @note        None
+ */
+void LatencyStats::record(double seconds, bool missedDeadline)
+{
+    double micro = seconds * 1e6, mantissa;
+    int bucket = 0, exponent;
+
+    if (micro >= 1.0)
+    {
+        //micro is mantissa * 2^exponent with the mantissa in [0.5, 1)
+        mantissa = std::frexp(micro, &exponent);
+        bucket = 1 + (exponent - 1) * LATENCY_SUB_BUCKETS + (int)((mantissa * 2.0 - 1.0) * LATENCY_SUB_BUCKETS);
+        bucket = std::min(bucket, LATENCY_BUCKETS - 1);
+    }
+
+    buckets[bucket]++;
+    count++;
+    total += seconds;
+
+    if (seconds > maximum)
+    {
+        maximum = seconds;
+    }
+
+    if (missedDeadline)
+    {
+        missed++;
+    }
+}
+
+
+/**
+ * @brief   Get the mean latency
+ * @details Returns the average latency in seconds, 0 if nothing was recorded
+ * @note    None
+ */
+double LatencyStats::getMean() const
+{
+    return count > 0 ? total / count : 0;
+}
+
+
+/**
+ * @brief       Get a latency percentile
+ * @details     Returns the upper end in seconds of the bucket that holds the
+ *              given fraction of deliveries, capped at the largest latency seen
+ *
+ * @param[in]   fraction    percentile as a fraction, 0.99 for p99
+ *
+ * @note        None
+ */
+double LatencyStats::getPercentile(double fraction) const
+{
+    long long seen = 0;
+    int bucket;
+
+    for (bucket = 0; bucket < LATENCY_BUCKETS; bucket++)
+    {
+        seen += buckets[bucket];
+
+        if (seen > 0 && seen >= fraction * count)
+        {
+            if (bucket == 0)
+            {
+                return std::min(1e-6, maximum);
+            }
+
+            //upper end of the bucket's part of its power of two
+            return std::min(std::ldexp(1.0 + (double)((bucket - 1) % LATENCY_SUB_BUCKETS + 1) / LATENCY_SUB_BUCKETS,
+                                       (bucket - 1) / LATENCY_SUB_BUCKETS) * 1e-6, maximum);
+        }
+    }
+
+    return maximum;
+}
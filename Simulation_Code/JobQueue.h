@@ -0,0 +1,303 @@
+/**
+ * @file    JobQueue.h
+ * @brief   Definition file for the JobQueue class
+ *
+ * @author  Andrew Frost, Richard Millar
+ * @version 1.00
+ */
+
+// Precompiler Directives =====================================================
+#ifndef JOBQUEUE_H
+#define JOBQUEUE_H
+
+// Header Files ===============================================================
+#include <chrono>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include "Checkpoint.h"
+
+#define LATENCY_OCTAVES 40 //powers of two of microseconds covered
+#define LATENCY_SUB_BUCKETS 8 //buckets each power of two is split into
+#define LATENCY_BUCKETS (1 + LATENCY_OCTAVES * LATENCY_SUB_BUCKETS)
+
+/**
+ * @brief   Priority class of a route request.
+ * @details EMERGENCY jobs are always served first. TRANSIT and PRIVATE share the
+ *          remaining service by weight.
+ */
+enum JobPriority
+{
+    PRIORITY_EMERGENCY,
+    PRIORITY_TRANSIT,
+    PRIORITY_PRIVATE,
+    PRIORITY_COUNT
+};
+
+
+bool ParseJobPriority(const std::string & name, JobPriority & priority);
+
+
+/**
+ * @brief   What happens to new jobs while the queue is full.
+ * @details REJECT turns them away so the vehicle asks again later. DELAY parks
+ *          them outside the queue until there is room. STALE_ROUTE answers them
+ *          with the last route computed for the same start and destination,
+ *          and rejects them if there is none.
+ */
+enum AdmissionPolicy
+{
+    ADMIT_REJECT,
+    ADMIT_DELAY,
+    ADMIT_STALE_ROUTE
+};
+
+
+/**
+ * @brief   Outcome of handing a job to the Compute Node.
+ */
+enum AdmissionResult
+{
+    JOB_QUEUED,
+    JOB_COALESCED, //the vehicle already had a job waiting, it was updated
+    JOB_DELAYED,
+    JOB_REJECTED,
+    JOB_STALE //answered with a cached route
+};
+
+
+/**
+ * @brief   Request structure passed to the Compute Node.
+ * @details Object that is passed by Vehicles to the Compute Node to be processed.
+ */
+struct Job
+{
+public:
+    Job();
+    ~Job();
+
+    void save(CheckpointWriter & writer) const;
+    void load(CheckpointReader & reader);
+
+    std::string start;
+    std::string dest;
+    std::string id;
+
+    JobPriority priority;
+    double deadline; //seconds after queueing the route is due, 0 for none
+    std::chrono::steady_clock::time_point queuedTime;
+};
+
+
+/**
+ * @brief   Route delivery latency of one priority class.
+ * @details Latencies are counted in buckets of microseconds, each power of two
+ *          split into LATENCY_SUB_BUCKETS equal parts, so percentiles are
+ *          reported as the upper end of their bucket, within an eighth of a
+ *          power of two.
+ */
+struct LatencyStats
+{
+public:
+    LatencyStats();
+    ~LatencyStats();
+
+    void record(double seconds, bool missedDeadline);
+
+    double getMean() const;
+    double getPercentile(double fraction) const;
+
+    long long count;
+    long long missed; //jobs delivered after their deadline
+    double total;
+    double maximum;
+    long long buckets[LATENCY_BUCKETS];
+};
+
+
+/**
+ * @brief   Admission counters of the job queue.
+ */
+struct AdmissionStats
+{
+public:
+    AdmissionStats();
+    ~AdmissionStats();
+
+    long long queued;
+    long long coalesced;
+    long long delayed;
+    long long rejected; //turned away because the queue was full
+    long long staleServed; //rejected jobs answered with a cached route
+    long long stranded; //set aside because their destination could not be reached
+    int maxDepth; //longest the queue has been
+};
+
+
+// Class Definition ===========================================================
+/**
+ * @brief   Pending route requests of the Compute Node.
+ * @details Keeps one FIFO queue per priority class. selectNext serves the
+ *          EMERGENCY queue strictly first; among the other classes a head whose
+ *          deadline has passed goes next, and otherwise the classes are picked
+ *          by smooth weighted round robin. Every job is also filed in a bucket
+ *          by its start and destination, so one computed route is handed to all
+ *          vehicles waiting for it without scanning the queues. Buckets are kept
+ *          in class order, EMERGENCY first, and in queue order within a class.
+ *
+ *          Each vehicle has at most one job waiting: asking again updates the
+ *          waiting job in place. With a capacity set, jobs other than EMERGENCY
+ *          that arrive while the queue is full are shed by the admission policy.
+ *          A job with no route to its destination is stranded outside the queue
+ *          until the Compute Node releases it, so it does not hold up its class.
+ *
+ * @class   JobQueue JobQueue.h "JobQueue.h"
+ */
+class JobQueue
+{
+public:
+    JobQueue();
+    ~JobQueue();
+
+    AdmissionResult push(const Job & job, unsigned long long key);
+
+    bool cancel(const std::string & id);
+
+    bool isEmpty() const;
+
+    int getSize() const;
+    int getSize(JobPriority priority) const;
+    int getWaitingCount(unsigned long long key) const;
+
+    bool selectNext(Job & job);
+
+    template<typename Function>
+    int deliver(unsigned long long key, int limit, const std::string & first, Function send);
+
+    void setWeight(JobPriority priority, int weight);
+
+    void setCapacity(int newCapacity, AdmissionPolicy newPolicy);
+    AdmissionPolicy getPolicy() const;
+
+    int getDelayedCount() const;
+
+    bool requeue(const std::string & id);
+    bool strand(const std::string & id);
+    int releaseStranded();
+    int getStrandedCount() const;
+
+    void recordStaleRoute();
+    const AdmissionStats & getAdmissionStats() const;
+
+    const LatencyStats & getLatencyStats(JobPriority priority) const;
+
+    void save(CheckpointWriter & writer) const;
+
+private:
+    typedef std::list<std::list<Job>::iterator> Bucket;
+    typedef std::list<std::pair<Job, unsigned long long> > DelayedList;
+
+    /**
+     * @brief   Where the job of one vehicle is waiting.
+     */
+    struct Pending
+    {
+        bool delayed;
+        bool stranded;
+        unsigned long long key;
+        std::list<Job>::iterator job; //when queued
+        Bucket::iterator entry; //when queued
+        DelayedList::iterator parked; //when delayed or stranded
+    };
+
+    void enqueue(const Job & job, unsigned long long key);
+    Bucket::iterator file(Bucket & bucket, std::list<Job>::iterator job);
+    void remove(Bucket & bucket, Bucket::iterator & entry);
+    void admitDelayed();
+
+    std::list<Job> queues[PRIORITY_COUNT];
+    std::unordered_map<unsigned long long, Bucket> buckets; //jobs by start and destination, in class order
+
+    int weights[PRIORITY_COUNT];
+    int credits[PRIORITY_COUNT]; //smooth weighted round robin state
+
+    LatencyStats latencies[PRIORITY_COUNT];
+
+    std::unordered_map<std::string, Pending> pending; //waiting job of each vehicle
+    DelayedList delayedJobs; //jobs parked by ADMIT_DELAY, oldest first
+    DelayedList strandedJobs; //jobs with no route, oldest first
+
+    int capacity; //most queued jobs, 0 for no limit
+    AdmissionPolicy policy;
+    AdmissionStats admission;
+};
+
+
+// Template Implementation ====================================================
+/**
+ * @brief       Hands a route to the jobs waiting for it
+ * @details     Serves the job of vehicle first if it waits in the bucket, then
+ *              visits the other jobs of the start and destination in class
+ *              order and calls send on each. Jobs for which send returns true
+ *              are removed and their latency is recorded, until limit jobs were
+ *              served.
+ *
+ * @param[in]   key     bucket of the route, see CentralComputeNode::getJobKey
+ * @param[in]   limit   most jobs to serve
+ * @param[in]   first   vehicle of the job selectNext picked, "" for none
+ * @param[in]   send    called with each job, returns true if it was served
+ *
+ * @note        Returns the number of jobs served. Serving the picked job first
+ *              keeps a small room from going to an older job of a lower class.
+ */
+template<typename Function>
+int JobQueue::deliver(unsigned long long key, int limit, const std::string & first, Function send)
+{
+    std::unordered_map<unsigned long long, Bucket>::iterator bucket = buckets.find(key);
+    std::unordered_map<std::string, Pending>::iterator picked = pending.find(first);
+    Bucket::iterator entry;
+    int served = 0;
+
+    if (bucket == buckets.end())
+    {
+        return 0;
+    }
+
+    if (limit > 0 && picked != pending.end() && !picked->second.delayed && !picked->second.stranded &&
+        picked->second.key == key)
+    {
+        entry = picked->second.entry;
+
+        if (send(**entry))
+        {
+            remove(bucket->second, entry);
+            served++;
+        }
+    }
+
+    entry = bucket->second.begin();
+
+    while (entry != bucket->second.end() && served < limit)
+    {
+        if (send(**entry))
+        {
+            remove(bucket->second, entry);
+            served++;
+
+            continue; // if we erased we don't need to increment iter
+        }
+
+        ++entry;
+    }
+
+    if (bucket->second.empty())
+    {
+        buckets.erase(bucket);
+    }
+
+    admitDelayed();
+
+    return served;
+}
+
+#endif
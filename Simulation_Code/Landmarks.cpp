@@ -0,0 +1,599 @@
+/**
+ * @file    Landmarks.cpp
+ *
+ * @brief   Implementation file for the LandmarkTable class
+ *
+ * @author  Andrew Frost, Richard Millar
+ * @version 1.00
+ */
+
+// Header Files ===============================================================
+#include "Landmarks.h"
+#include "SearchContext.h"
+#include <algorithm>
+#include <fstream>
+#include <functional>
+#include <queue>
+#include <random>
+#include <thread>
+#include <cstring>
+
+#define LANDMARK_FILE_TAG "SDNALT01"
+#define LANDMARK_SEED 400
+
+typedef std::pair<double, int> QueueEntry;
+
+void ComputeDistances(const RoadGraph & graph, int source, std::vector<double> & distances,
+                      std::vector<int> * parents, std::vector<int> * order);
+
+
+/**
+ * @brief   Default constructor
+ * @details Constructs an empty table, lowerBound() returns 0 until built
+ * @note    None
+ */
+LandmarkTable::LandmarkTable() : landmarks(), fromLandmark(), toLandmark(), nodeCount(0)
+{
+
+}
+
+/**
+ * @brief   Default destructor
+ * @details Destroys a LandmarkTable object
+ * @note    None
+ */
+LandmarkTable::~LandmarkTable()
+{
+
+}
+
+
+/**
+ * @brief       Builds the landmark tables
+ * @details     Selects the landmarks with the given strategy, then computes the
+ *              distance tables with one worker thread per group of landmarks.
+ *
+ * @param[in]   graph           graph of free flow travel times
+ * @param[in]   landmarkCount   number of landmarks to select
+ * @param[in]   strategy        selection strategy
+ * @param[in]   threadCount     number of worker threads for the tables
+ *
+ * @note        None
+ */
+void LandmarkTable::build(const RoadGraph & graph, int landmarkCount, LandmarkStrategy strategy, int threadCount)
+{
+    clear();
+
+    nodeCount = graph.getNodeCount();
+    landmarkCount = std::min(landmarkCount, nodeCount);
+
+    if (landmarkCount <= 0)
+    {
+        return;
+    }
+
+    if (strategy == LANDMARKS_AVOID)
+    {
+        selectAvoid(graph, landmarkCount);
+    }
+    else
+    {
+        selectFarthest(graph, landmarkCount);
+    }
+
+    computeTables(graph, std::max(1, threadCount));
+}
+
+
+/**
+ * @brief   Removes all landmarks
+ * @details Empties the tables
+ * @note    None
+ */
+void LandmarkTable::clear()
+{
+    landmarks.clear();
+    fromLandmark.clear();
+    toLandmark.clear();
+    nodeCount = 0;
+}
+
+
+/**
+ * @brief   Shows whether the table is empty
+ * @details Returns true when no landmarks were built or loaded
+ * @note    None
+ */
+bool LandmarkTable::isEmpty() const
+{
+    return landmarks.empty();
+}
+
+
+/**
+ * @brief   Get the landmark count
+ * @details Returns the number of landmarks in the table
+ * @note    None
+ */
+int LandmarkTable::getLandmarkCount() const
+{
+    return (int)landmarks.size();
+}
+
+
+/**
+ * @brief   Get the landmarks
+ * @details Returns the subnet index of each landmark
+ * @note    None
+ */
+const std::vector<int> & LandmarkTable::getLandmarks() const
+{
+    return landmarks;
+}
+
+
+/**
+ * @brief       Lower bound on the travel time between two subnets
+ * @details     For every landmark L, d(L,t) - d(L,v) and d(v,L) - d(t,L) are
+ *              both at most d(v,t). The largest of these is returned.
+ *
+ * @param[in]   node    subnet index the bound starts at
+ * @param[in]   target  subnet index the bound ends at
+ *
+ * @note        Returns SEARCH_INFINITY when the tables prove the target can
+ *              not be reached from node, and 0 when the table is empty.
+ */
+double LandmarkTable::lowerBound(int node, int target) const
+{
+    const int count = (int)landmarks.size();
+    const double* nodeFrom = &fromLandmark[0] + (std::size_t)node * count;
+    const double* targetFrom = &fromLandmark[0] + (std::size_t)target * count;
+    const double* nodeTo = &toLandmark[0] + (std::size_t)node * count;
+    const double* targetTo = &toLandmark[0] + (std::size_t)target * count;
+
+    double bound = 0;
+    int index;
+
+    for (index = 0; index < count; index++)
+    {
+        if (nodeFrom[index] < SEARCH_INFINITY)
+        {
+            //the landmark reaches node but not target, so node can't either
+            if (targetFrom[index] >= SEARCH_INFINITY)
+            {
+                return SEARCH_INFINITY;
+            }
+
+            bound = std::max(bound, targetFrom[index] - nodeFrom[index]);
+        }
+
+        if (targetTo[index] < SEARCH_INFINITY)
+        {
+            //target reaches the landmark but node does not, so node can't reach target
+            if (nodeTo[index] >= SEARCH_INFINITY)
+            {
+                return SEARCH_INFINITY;
+            }
+
+            bound = std::max(bound, nodeTo[index] - targetTo[index]);
+        }
+    }
+
+    return bound;
+}
+
+
+/**
+ * @brief       Writes the tables to a file
+ * @details     The file starts with a tag and the checksum of the graph the
+ *              tables were built for, followed by the landmarks and both
+ *              distance tables.
+ *
+ * @param[in]   fileName    file to write
+ * @param[in]   checksum    checksum of the graph
+ *
+ * @note        None
+ */
+bool LandmarkTable::save(const std::string & fileName, unsigned long long checksum) const
+{
+    std::ofstream outputFile(fileName.c_str(), std::ios::binary);
+    int count = (int)landmarks.size();
+
+    if (!outputFile.is_open() || landmarks.empty())
+    {
+        return false;
+    }
+
+    outputFile.write(LANDMARK_FILE_TAG, sizeof(LANDMARK_FILE_TAG) - 1);
+    outputFile.write(reinterpret_cast<const char*>(&checksum), sizeof(checksum));
+    outputFile.write(reinterpret_cast<const char*>(&nodeCount), sizeof(nodeCount));
+    outputFile.write(reinterpret_cast<const char*>(&count), sizeof(count));
+    outputFile.write(reinterpret_cast<const char*>(&landmarks[0]), sizeof(int) * count);
+    outputFile.write(reinterpret_cast<const char*>(&fromLandmark[0]), sizeof(double) * fromLandmark.size());
+    outputFile.write(reinterpret_cast<const char*>(&toLandmark[0]), sizeof(double) * toLandmark.size());
+
+    return outputFile.good();
+}
+
+
+/**
+ * @brief       Reads the tables from a file
+ * @details     Fails without changing the table when the file is missing or was
+ *              written for a different graph.
+ *
+ * @param[in]   fileName        file to read
+ * @param[in]   checksum        checksum of the current graph
+ * @param[in]   expectedNodes   number of subnets in the current graph
+ *
+ * @note        None
+ */
+bool LandmarkTable::load(const std::string & fileName, unsigned long long checksum, int expectedNodes)
+{
+    std::ifstream inputFile(fileName.c_str(), std::ios::binary);
+    char tag[sizeof(LANDMARK_FILE_TAG) - 1];
+    unsigned long long fileChecksum;
+    int fileNodes, count;
+
+    std::vector<int> fileLandmarks;
+    std::vector<double> fileFrom, fileTo;
+
+    if (!inputFile.is_open())
+    {
+        return false;
+    }
+
+    inputFile.read(tag, sizeof(tag));
+    inputFile.read(reinterpret_cast<char*>(&fileChecksum), sizeof(fileChecksum));
+    inputFile.read(reinterpret_cast<char*>(&fileNodes), sizeof(fileNodes));
+    inputFile.read(reinterpret_cast<char*>(&count), sizeof(count));
+
+    if (!inputFile.good() || std::memcmp(tag, LANDMARK_FILE_TAG, sizeof(tag)) != 0
+        || fileChecksum != checksum || fileNodes != expectedNodes || count <= 0 || count > fileNodes)
+    {
+        return false;
+    }
+
+    fileLandmarks.resize(count);
+    fileFrom.resize((std::size_t)fileNodes * count);
+    fileTo.resize((std::size_t)fileNodes * count);
+
+    inputFile.read(reinterpret_cast<char*>(&fileLandmarks[0]), sizeof(int) * count);
+    inputFile.read(reinterpret_cast<char*>(&fileFrom[0]), sizeof(double) * fileFrom.size());
+    inputFile.read(reinterpret_cast<char*>(&fileTo[0]), sizeof(double) * fileTo.size());
+
+    if (!inputFile.good())
+    {
+        return false;
+    }
+
+    landmarks.swap(fileLandmarks);
+    fromLandmark.swap(fileFrom);
+    toLandmark.swap(fileTo);
+    nodeCount = fileNodes;
+
+    return true;
+}
+
+
+/**
+ * @brief       Farthest landmark selection
+ * @details     Starts from the subnet farthest from subnet 0, then repeatedly
+ *              adds the subnet whose distance to the closest landmark is the
+ *              largest. Subnets no landmark reaches are picked first.
+ *
+ * @param[in]   graph           graph to select from
+ * @param[in]   landmarkCount   number of landmarks to select
+ *
+ * @note        None
+ */
+void LandmarkTable::selectFarthest(const RoadGraph & graph, int landmarkCount)
+{
+    std::vector<double> closest(nodeCount, SEARCH_INFINITY), distances;
+    std::vector<bool> chosen(nodeCount, false);
+    int node, best;
+
+    ComputeDistances(graph, 0, closest, NULL, NULL);
+
+    while ((int)landmarks.size() < landmarkCount)
+    {
+        best = -1;
+
+        for (node = 0; node < nodeCount; node++)
+        {
+            if (!chosen[node] && (best < 0 || closest[node] > closest[best]))
+            {
+                best = node;
+            }
+        }
+
+        landmarks.push_back(best);
+        chosen[best] = true;
+
+        if (landmarks.size() == 1)
+        {
+            std::fill(closest.begin(), closest.end(), SEARCH_INFINITY);
+        }
+
+        ComputeDistances(graph, best, distances, NULL, NULL);
+
+        for (node = 0; node < nodeCount; node++)
+        {
+            closest[node] = std::min(closest[node], distances[node]);
+        }
+    }
+}
+
+
+/**
+ * @brief       Avoid landmark selection
+ * @details     Grows a shortest path tree from a random root and weighs every
+ *              subnet by how much the current landmarks underestimate its
+ *              distance from the root. Subtrees that already hold a landmark
+ *              weigh nothing. The new landmark is the leaf reached by walking
+ *              from the heaviest subnet into its heaviest child.
+ *
+ * @param[in]   graph           graph to select from
+ * @param[in]   landmarkCount   number of landmarks to select
+ *
+ * @note        The bounds used while selecting only look at distances from
+ *              landmarks, which is enough to rank the candidates.
+ */
+void LandmarkTable::selectAvoid(const RoadGraph & graph, int landmarkCount)
+{
+    std::mt19937 generator(LANDMARK_SEED);
+    std::uniform_int_distribution<int> pickRoot(0, nodeCount - 1);
+
+    std::vector<std::vector<double> > selected;
+    std::vector<double> distances;
+    std::vector<int> parents, order, childOffsets, children, fill;
+    std::vector<double> size;
+    std::vector<bool> covered, chosen(nodeCount, false);
+
+    int root, node, best, child, index, landmark;
+    double bound;
+
+    while ((int)landmarks.size() < landmarkCount)
+    {
+        root = pickRoot(generator);
+
+        ComputeDistances(graph, root, distances, &parents, &order);
+
+        size.assign(nodeCount, 0);
+        covered.assign(nodeCount, false);
+
+        //children of each node in the tree, as compressed lists
+        childOffsets.assign(nodeCount + 1, 0);
+
+        for (index = 0; index < (int)order.size(); index++)
+        {
+            if (parents[order[index]] >= 0)
+            {
+                childOffsets[parents[order[index]] + 1]++;
+            }
+        }
+
+        for (node = 0; node < nodeCount; node++)
+        {
+            childOffsets[node + 1] += childOffsets[node];
+        }
+
+        children.resize(childOffsets[nodeCount]);
+        fill.assign(childOffsets.begin(), childOffsets.end() - 1);
+
+        for (index = 0; index < (int)order.size(); index++)
+        {
+            if (parents[order[index]] >= 0)
+            {
+                children[fill[parents[order[index]]]++] = order[index];
+            }
+        }
+
+        //weigh the subtrees bottom up
+        for (index = (int)order.size() - 1; index >= 0; index--)
+        {
+            node = order[index];
+
+            if (chosen[node])
+            {
+                covered[node] = true;
+            }
+
+            if (!covered[node])
+            {
+                bound = 0;
+
+                for (landmark = 0; landmark < (int)selected.size(); landmark++)
+                {
+                    if (selected[landmark][node] < SEARCH_INFINITY && selected[landmark][root] < SEARCH_INFINITY)
+                    {
+                        bound = std::max(bound, selected[landmark][node] - selected[landmark][root]);
+                    }
+                }
+
+                size[node] += distances[node] - bound;
+            }
+            else
+            {
+                size[node] = 0;
+            }
+
+            if (parents[node] >= 0)
+            {
+                if (covered[node])
+                {
+                    covered[parents[node]] = true;
+                }
+
+                size[parents[node]] += size[node];
+            }
+        }
+
+        best = -1;
+
+        for (index = 0; index < (int)order.size(); index++)
+        {
+            if (!covered[order[index]] && (best < 0 || size[order[index]] > size[best]))
+            {
+                best = order[index];
+            }
+        }
+
+        //every reachable subnet is covered, fall back to any unused subnet
+        if (best < 0)
+        {
+            for (node = 0; node < nodeCount && chosen[node]; node++)
+            {
+            }
+
+            best = node;
+        }
+        else
+        {
+            while (childOffsets[best] < childOffsets[best + 1])
+            {
+                child = children[childOffsets[best]];
+
+                for (index = childOffsets[best] + 1; index < childOffsets[best + 1]; index++)
+                {
+                    if (size[children[index]] > size[child])
+                    {
+                        child = children[index];
+                    }
+                }
+
+                best = child;
+            }
+        }
+
+        landmarks.push_back(best);
+        chosen[best] = true;
+
+        selected.push_back(std::vector<double>());
+        ComputeDistances(graph, best, selected.back(), NULL, NULL);
+    }
+}
+
+
+/**
+ * @brief       Computes the distance tables
+ * @details     Each worker thread runs a forward and a backward Dijkstra search
+ *              from its share of the landmarks and writes its columns of the
+ *              node major tables.
+ *
+ * @param[in]   graph           graph of free flow travel times
+ * @param[in]   threadCount     number of worker threads
+ *
+ * @note        None
+ */
+void LandmarkTable::computeTables(const RoadGraph & graph, int threadCount)
+{
+    const RoadGraph reverse = graph.reversed();
+    const int count = (int)landmarks.size();
+
+    std::vector<std::thread> workers;
+    int worker;
+
+    fromLandmark.assign((std::size_t)nodeCount * count, SEARCH_INFINITY);
+    toLandmark.assign((std::size_t)nodeCount * count, SEARCH_INFINITY);
+
+    threadCount = std::min(threadCount, count);
+
+    for (worker = 0; worker < threadCount; worker++)
+    {
+        workers.push_back(std::thread([this, &graph, &reverse, count, threadCount, worker]()
+        {
+            std::vector<double> distances;
+            int landmark, node;
+
+            for (landmark = worker; landmark < count; landmark += threadCount)
+            {
+                ComputeDistances(graph, landmarks[landmark], distances, NULL, NULL);
+
+                for (node = 0; node < nodeCount; node++)
+                {
+                    fromLandmark[(std::size_t)node * count + landmark] = distances[node];
+                }
+
+                ComputeDistances(reverse, landmarks[landmark], distances, NULL, NULL);
+
+                for (node = 0; node < nodeCount; node++)
+                {
+                    toLandmark[(std::size_t)node * count + landmark] = distances[node];
+                }
+            }
+        }));
+    }
+
+    for (worker = 0; worker < threadCount; worker++)
+    {
+        workers[worker].join();
+    }
+}
+
+
+/**
+ * @brief       Single source shortest paths
+ * @details     Runs Dijkstra's algorithm from source over the whole graph.
+ *
+ * @param[in]   graph       graph to search
+ * @param[in]   source      subnet index to start from
+ * @param[out]  distances   travel time to every subnet, SEARCH_INFINITY if unreachable
+ * @param[out]  parents     optional shortest path tree, -1 for the root and unreached
+ * @param[out]  order       optional list of reached subnets in settle order
+ *
+ * @note        None
+ */
+void ComputeDistances(const RoadGraph & graph, int source, std::vector<double> & distances,
+                      std::vector<int> * parents, std::vector<int> * order)
+{
+    std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<QueueEntry> > open;
+    QueueEntry entry;
+    int edge, neighbor;
+
+    distances.assign(graph.getNodeCount(), SEARCH_INFINITY);
+
+    if (parents != NULL)
+    {
+        parents->assign(graph.getNodeCount(), -1);
+    }
+    if (order != NULL)
+    {
+        order->clear();
+    }
+
+    distances[source] = 0;
+    open.push(QueueEntry(0, source));
+
+    while (!open.empty())
+    {
+        entry = open.top();
+        open.pop();
+
+        if (entry.first > distances[entry.second])
+        {
+            continue;
+        }
+
+        if (order != NULL)
+        {
+            order->push_back(entry.second);
+        }
+
+        for (edge = graph.offsets[entry.second]; edge < graph.offsets[entry.second + 1]; edge++)
+        {
+            neighbor = graph.targets[edge];
+
+            if (entry.first + graph.costs[edge] < distances[neighbor])
+            {
+                distances[neighbor] = entry.first + graph.costs[edge];
+
+                if (parents != NULL)
+                {
+                    (*parents)[neighbor] = entry.second;
+                }
+
+                open.push(QueueEntry(distances[neighbor], neighbor));
+            }
+        }
+    }
+}
@@ -0,0 +1,76 @@
+/**
+ * @file    Landmarks.h
+ * @brief   Definition file for the LandmarkTable class
+ *
+ * @author  Andrew Frost, Richard Millar
+ * @version 1.00
+ */
+
+// Precompiler Directives =====================================================
+#ifndef LANDMARKS_H
+#define LANDMARKS_H
+
+// Header Files ===============================================================
+#include <string>
+#include <vector>
+#include "RoadGraph.h"
+
+/**
+ * @brief   How landmarks are picked from the graph.
+ * @details FARTHEST repeatedly picks the subnet farthest from the landmarks
+ *          chosen so far. AVOID grows a shortest path tree from a random root
+ *          and picks a leaf in the region the current landmarks cover worst.
+ */
+enum LandmarkStrategy
+{
+    LANDMARKS_FARTHEST,
+    LANDMARKS_AVOID
+};
+
+// Class Definition ===========================================================
+/**
+ * @brief   Landmark distance tables for the ALT heuristic.
+ * @details Holds the free flow travel time from every landmark to every subnet
+ *          and from every subnet to every landmark. By the triangle inequality
+ *          these give a lower bound on the travel time between any two subnets,
+ *          which the Compute Node uses as its A* heuristic.
+ *
+ * @class   LandmarkTable Landmarks.h "Landmarks.h"
+ */
+class LandmarkTable
+{
+public:
+    LandmarkTable();
+    ~LandmarkTable();
+
+    void build(const RoadGraph & graph, int landmarkCount, LandmarkStrategy strategy, int threadCount);
+
+    void clear();
+
+    bool isEmpty() const;
+
+    int getLandmarkCount() const;
+
+    const std::vector<int> & getLandmarks() const;
+
+    double lowerBound(int node, int target) const;
+
+    bool save(const std::string & fileName, unsigned long long checksum) const;
+    bool load(const std::string & fileName, unsigned long long checksum, int expectedNodes);
+
+private:
+    void selectFarthest(const RoadGraph & graph, int landmarkCount);
+    void selectAvoid(const RoadGraph & graph, int landmarkCount);
+
+    void computeTables(const RoadGraph & graph, int threadCount);
+
+    std::vector<int> landmarks;
+
+    //both tables are stored node major, entry node * landmarks.size() + l
+    std::vector<double> fromLandmark; //travel time from landmark l to the node
+    std::vector<double> toLandmark; //travel time from the node to landmark l
+
+    int nodeCount;
+};
+
+#endif
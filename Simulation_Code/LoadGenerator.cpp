@@ -0,0 +1,607 @@
+/**
+ * @file    LoadGenerator.cpp
+ *
+ * @brief   Vehicle simulator and load generator for the Compute Node server
+ * @details Drives simulated vehicles against an SDN serving the Compute Node,
+ *          see the serve input keyword. Each connection runs on its own thread
+ *          and keeps every one of its vehicles busy: a vehicle asks for a route
+ *          between two random subnets, turns onto each road of the route and
+ *          leaves, then starts a new trip, so up to one request per vehicle is
+ *          in flight on a connection. With a speedup each vehicle also drives
+ *          the roads, waiting the road's travel time divided by the speedup
+ *          before it turns; without one the vehicles go as fast as the server
+ *          answers. Reports the request rate and the latency of each kind of
+ *          request. An shm:name address drives the shared memory transport
+ *          instead of a socket.
+ *
+ *          CcnLoad input-file address [connections] [vehicles] [seconds] [speedup]
+ *
+ * @author  Andrew Frost, Richard Millar
+ * @version 1.00
+ */
+
+// Header Files ===============================================================
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <cstdlib>
+#include <chrono>
+#include <thread>
+#include <random>
+#include <vector>
+#include <string>
+#include <list>
+#include <unordered_map>
+#include <algorithm>
+#include "CcnClient.h"
+#include "ShmClient.h"
+
+#define LOAD_RETRY_MS 10
+#define LOAD_DRAIN_MS 2000
+#define LOAD_ROUTE_TIMEOUT_MS 1000
+
+/**
+ * @brief   A simulated vehicle of a connection.
+ */
+struct SimVehicle
+{
+    std::string id;
+    std::string road; //road the vehicle is on
+    std::string dest;
+    std::list<std::pair<std::string, double> > route; //roads still to turn onto
+    int trip;
+    bool waiting; //a request of the vehicle is in flight
+    unsigned int sequence; //of the request in flight
+    std::chrono::steady_clock::time_point sentAt;
+    std::chrono::steady_clock::time_point readyAt; //when it sends its next request
+    NetMessageType next; //request it sends next
+};
+
+
+/**
+ * @brief   A reply as the load generator uses it, from either transport.
+ */
+struct LoadReply
+{
+    int type;
+    int status;
+    unsigned int sequence;
+    std::list<std::pair<std::string, double> > route;
+};
+
+
+/**
+ * @brief   What one connection measured.
+ */
+struct LoadResult
+{
+    std::vector<double> latencies[3]; //seconds, by route, road change and leave
+    long long refused;
+    long long invalid;
+    long long timedOut; //routes given up on
+    long long trips;
+    bool failed;
+};
+
+// Function Prototypes ========================================================
+bool ReadSubnets(const char* fileName, std::vector<std::string> & subnets);
+void RunConnection(const std::string & address, const std::vector<std::string> & subnets, int connection,
+                   int vehicleCount, double seconds, double speedup, LoadResult & result);
+template <class Client>
+void DriveVehicles(Client & client, const std::vector<std::string> & subnets, int connection,
+                   int vehicleCount, double seconds, double speedup, LoadResult & result);
+int ReceiveReply(CcnClient & client, LoadReply & reply, int timeoutMS);
+int ReceiveReply(ShmClient & client, LoadReply & reply, int timeoutMS);
+void StartTrip(SimVehicle & vehicle, const std::vector<std::string> & subnets, std::mt19937 & random,
+               int connection, int index);
+void PrintLatencies(const char* name, std::vector<double> & latencies);
+
+
+// Main Function ==============================================================
+int main(int argc, char * argv[])
+{
+    std::vector<std::string> subnets;
+    std::vector<LoadResult> results;
+    std::vector<std::thread> threads;
+    std::vector<double> latencies[3];
+    const char* names[3] = {"route", "road change", "leave"};
+
+    int connections = 4, vehicles = 64;
+    double seconds = 10, speedup = 0;
+    long long requests = 0, refused = 0, invalid = 0, timedOut = 0, trips = 0;
+    int index, kind, failed = -1;
+
+    if (argc < 3)
+    {
+        std::cout << "Usage: CcnLoad input-file address [connections] [vehicles] [seconds] [speedup]" << std::endl;
+        return -1;
+    }
+
+    if (argc > 3)
+    {
+        connections = std::max(1, std::atoi(argv[3]));
+    }
+
+    if (argc > 4)
+    {
+        vehicles = std::max(1, std::atoi(argv[4]));
+    }
+
+    if (argc > 5)
+    {
+        seconds = std::atof(argv[5]);
+    }
+
+    if (argc > 6)
+    {
+        speedup = std::atof(argv[6]);
+    }
+
+    if (!ReadSubnets(argv[1], subnets) || subnets.size() < 2)
+    {
+        std::cout << "Error: could not read the subnets of " << argv[1] << ". Terminating early." << std::endl;
+        return -1;
+    }
+
+    std::cout << "Driving " << connections << " x " << vehicles << " vehicles at " << argv[2] << " for "
+              << seconds << " s";
+
+    if (speedup > 0)
+    {
+        std::cout << ", " << speedup << " times real time";
+    }
+
+    std::cout << "." << std::endl;
+
+    results.resize(connections);
+
+    for (index = 0; index < connections; index++)
+    {
+        threads.push_back(std::thread(RunConnection, std::string(argv[2]), std::cref(subnets), index, vehicles,
+                                      seconds, speedup, std::ref(results[index])));
+    }
+
+    for (index = 0; index < connections; index++)
+    {
+        threads[index].join();
+
+        if (results[index].failed && failed < 0)
+        {
+            failed = index;
+        }
+    }
+
+    if (failed >= 0)
+    {
+        std::cout << "Error: connection " << failed << " failed. Terminating early." << std::endl;
+        return -1;
+    }
+
+    for (index = 0; index < connections; index++)
+    {
+        for (kind = 0; kind < 3; kind++)
+        {
+            latencies[kind].insert(latencies[kind].end(), results[index].latencies[kind].begin(),
+                                   results[index].latencies[kind].end());
+            requests += (long long)results[index].latencies[kind].size();
+        }
+
+        refused += results[index].refused;
+        invalid += results[index].invalid;
+        timedOut += results[index].timedOut;
+        trips += results[index].trips;
+    }
+
+    std::cout << std::fixed << std::setprecision(0) << requests << " requests, " << requests / seconds
+              << " per second, " << trips << " trips, " << refused << " refused, " << timedOut
+              << " routes timed out, " << invalid << " invalid." << std::endl;
+
+    for (kind = 0; kind < 3; kind++)
+    {
+        PrintLatencies(names[kind], latencies[kind]);
+    }
+
+    return 0;
+}
+
+// Functions ==================================================================
+/**
+ * @brief       Read the subnet names of an input file
+ *
+ * @param[in]   fileName    SDN input file
+ * @param[out]  subnets     names of its intersections
+ */
+bool ReadSubnets(const char* fileName, std::vector<std::string> & subnets)
+{
+    std::ifstream inputFile(fileName);
+    std::string line, command, name;
+
+    if (!inputFile.is_open())
+    {
+        return false;
+    }
+
+    while (std::getline(inputFile, line))
+    {
+        std::istringstream arguments(line);
+
+        if (arguments >> command >> name && command == "intersect")
+        {
+            subnets.push_back(name);
+        }
+    }
+
+    return true;
+}
+
+
+/**
+ * @brief       Drive the vehicles of one connection
+ *
+ * @param[in]   address         server address
+ * @param[in]   subnets         subnets to pick trips from
+ * @param[in]   connection      index of the connection, part of vehicle IDs
+ * @param[in]   vehicleCount    vehicles on the connection
+ * @param[in]   seconds         time to drive for
+ * @param[in]   speedup         simulated time per real time, 0 to not wait
+ * @param[out]  result          latencies and counts
+ */
+void RunConnection(const std::string & address, const std::vector<std::string> & subnets, int connection,
+                   int vehicleCount, double seconds, double speedup, LoadResult & result)
+{
+    result.refused = 0;
+    result.invalid = 0;
+    result.timedOut = 0;
+    result.trips = 0;
+
+    if (address.compare(0, 4, "shm:") == 0)
+    {
+        ShmClient client;
+
+        result.failed = !client.open(address);
+
+        if (!result.failed)
+        {
+            DriveVehicles(client, subnets, connection, vehicleCount, seconds, speedup, result);
+        }
+    }
+    else
+    {
+        CcnClient client;
+
+        result.failed = !client.open(address);
+
+        if (!result.failed)
+        {
+            DriveVehicles(client, subnets, connection, vehicleCount, seconds, speedup, result);
+        }
+    }
+}
+
+
+/**
+ * @brief       Drive the vehicles of a connection
+ *
+ * @param[in]   client          open client of either transport
+ * @param[in]   subnets         subnets to pick trips from
+ * @param[in]   connection      index of the connection, part of vehicle IDs
+ * @param[in]   vehicleCount    vehicles on the connection
+ * @param[in]   seconds         time to drive for
+ * @param[in]   speedup         simulated time per real time, 0 to not wait
+ * @param[out]  result          latencies and counts
+ */
+template <class Client>
+void DriveVehicles(Client & client, const std::vector<std::string> & subnets, int connection,
+                   int vehicleCount, double seconds, double speedup, LoadResult & result)
+{
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    std::chrono::steady_clock::time_point end = now +
+        std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(seconds));
+    std::chrono::steady_clock::time_point earliest;
+    std::unordered_map<unsigned int, std::pair<int, std::chrono::steady_clock::time_point> > inFlight;
+    std::unordered_map<unsigned int, std::pair<int, std::chrono::steady_clock::time_point> >::iterator request;
+    std::vector<SimVehicle> vehicles(vehicleCount);
+    std::mt19937 random(1000 + connection);
+    LoadReply reply;
+    unsigned int sequence;
+    int index, received, kind, timeoutMS;
+
+    for (index = 0; index < vehicleCount; index++)
+    {
+        vehicles[index].trip = 0;
+        StartTrip(vehicles[index], subnets, random, connection, index);
+    }
+
+    while (true)
+    {
+        now = std::chrono::steady_clock::now();
+        earliest = end;
+
+        //send the requests of the vehicles that are ready
+        for (index = 0; index < vehicleCount && now < end; index++)
+        {
+            SimVehicle & vehicle = vehicles[index];
+
+            //the CCN holds routes back while a road on them is full, a vehicle
+            //waiting too long gives up and leaves so it frees its own road
+            if (vehicle.waiting && vehicle.next == NET_ROUTE_REQUEST &&
+                now - vehicle.sentAt > std::chrono::milliseconds(LOAD_ROUTE_TIMEOUT_MS))
+            {
+                inFlight.erase(vehicle.sequence);
+                result.timedOut++;
+                vehicle.waiting = false;
+                vehicle.route.clear();
+                vehicle.next = NET_LEAVE;
+            }
+
+            if (vehicle.waiting)
+            {
+                if (vehicle.next == NET_ROUTE_REQUEST)
+                {
+                    earliest = std::min(earliest, vehicle.sentAt + std::chrono::milliseconds(LOAD_ROUTE_TIMEOUT_MS));
+                }
+
+                continue;
+            }
+
+            if (vehicle.readyAt > now)
+            {
+                earliest = std::min(earliest, vehicle.readyAt);
+                continue;
+            }
+
+            if (vehicle.next == NET_ROUTE_REQUEST)
+            {
+                sequence = client.requestRoute(vehicle.id, vehicle.road, vehicle.dest, 2, 0);
+            }
+            else if (vehicle.next == NET_ROAD_CHANGE)
+            {
+                sequence = client.changeRoad(vehicle.id, vehicle.road, vehicle.route.front().first);
+            }
+            else
+            {
+                sequence = client.leave(vehicle.id, vehicle.road);
+            }
+
+            if (sequence == 0)
+            {
+                //the request could not be sent, the server has gone
+                result.failed = true;
+                return;
+            }
+
+            vehicle.waiting = true;
+            vehicle.sequence = sequence;
+            vehicle.sentAt = now;
+            inFlight[sequence] = std::make_pair(index, now);
+        }
+
+        //let the last replies come in, but not wait forever on a lost route
+        if (now >= end)
+        {
+            earliest = end + std::chrono::milliseconds(LOAD_DRAIN_MS);
+
+            if (inFlight.empty() || now >= earliest)
+            {
+                break;
+            }
+        }
+
+        timeoutMS = (int)std::chrono::duration_cast<std::chrono::milliseconds>(earliest - now).count();
+        received = ReceiveReply(client, reply, std::max(0, timeoutMS));
+
+        if (received < 0)
+        {
+            //the server may stop serving while the last replies are awaited
+            result.failed = now < end;
+            return;
+        }
+
+        if (received == 0)
+        {
+            continue;
+        }
+
+        now = std::chrono::steady_clock::now();
+        request = inFlight.find(reply.sequence);
+
+        if (request == inFlight.end())
+        {
+            continue;
+        }
+
+        index = request->second.first;
+        SimVehicle & vehicle = vehicles[index];
+
+        kind = reply.type == NET_ROUTE_RESPONSE ? 0 : (reply.type == NET_ROAD_CHANGE_ACK ? 1 : 2);
+        result.latencies[kind].push_back(std::chrono::duration<double>(now - request->second.second).count());
+        inFlight.erase(request);
+
+        vehicle.waiting = false;
+        vehicle.readyAt = now;
+
+        if (reply.status == NET_INVALID)
+        {
+            result.invalid++;
+            StartTrip(vehicle, subnets, random, connection, index);
+            continue;
+        }
+
+        if (reply.type == NET_ROUTE_RESPONSE)
+        {
+            if (reply.status == NET_REFUSED)
+            {
+                //turned away by admission control, ask again shortly
+                result.refused++;
+                vehicle.readyAt = now + std::chrono::milliseconds(LOAD_RETRY_MS);
+                continue;
+            }
+
+            vehicle.route.swap(reply.route);
+        }
+        else if (reply.type == NET_ROAD_CHANGE_ACK)
+        {
+            if (reply.status == NET_REFUSED)
+            {
+                //the road is full, ask for a new route from here
+                result.refused++;
+                vehicle.next = NET_ROUTE_REQUEST;
+                vehicle.readyAt = now + std::chrono::milliseconds(LOAD_RETRY_MS);
+                continue;
+            }
+
+            vehicle.road = vehicle.route.front().first;
+        }
+        else
+        {
+            result.trips++;
+            StartTrip(vehicle, subnets, random, connection, index);
+            continue;
+        }
+
+        //drive along the route to the next road to turn onto
+        while (!vehicle.route.empty() && vehicle.route.front().first == vehicle.road)
+        {
+            if (speedup > 0)
+            {
+                vehicle.readyAt += std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                    std::chrono::duration<double>(vehicle.route.front().second / speedup));
+            }
+
+            vehicle.route.pop_front();
+        }
+
+        vehicle.next = vehicle.route.empty() ? NET_LEAVE : NET_ROAD_CHANGE;
+    }
+}
+
+
+/**
+ * @brief       Wait for the next reply on a socket
+ *
+ * @param[in]   client      connected client
+ * @param[out]  reply       reply received
+ * @param[in]   timeoutMS   longest to wait
+ *
+ * @note        Returns 1 for a reply, 0 on timeout, -1 if the connection failed
+ */
+int ReceiveReply(CcnClient & client, LoadReply & reply, int timeoutMS)
+{
+    NetMessage message;
+    int received = client.receive(message, timeoutMS);
+
+    if (received > 0)
+    {
+        reply.type = message.type;
+        reply.status = message.status;
+        reply.sequence = message.sequence;
+        reply.route.swap(message.route);
+    }
+
+    return received;
+}
+
+
+/**
+ * @brief       Wait for the next reply in shared memory
+ * @details     The route is read in place from the client's ring and its
+ *              subnets from the shared names table, nothing is decoded. A long
+ *              route is gathered from the replies it was split over.
+ *
+ * @param[in]   client      connected client
+ * @param[out]  reply       reply received
+ * @param[in]   timeoutMS   longest to wait
+ *
+ * @note        Returns 1 for a reply, 0 on timeout, -1 if the server has gone
+ */
+int ReceiveReply(ShmClient & client, LoadReply & reply, int timeoutMS)
+{
+    const ShmResponse* response;
+    int received = client.receive(response, timeoutMS);
+    unsigned int step;
+
+    bool more = received > 0;
+
+    if (received > 0)
+    {
+        reply.type = response->type;
+        reply.status = response->status;
+        reply.sequence = response->sequence;
+        reply.route.clear();
+    }
+
+    //the parts of a route are published together, the rest is already there
+    while (more)
+    {
+        for (step = 0; step < response->count; step++)
+        {
+            reply.route.push_back(std::make_pair(std::string(client.subnetName(response->route[step].subnet)),
+                                                 response->route[step].cost));
+        }
+
+        more = response->more != 0;
+        client.release();
+
+        if (more && client.receive(response, timeoutMS) <= 0)
+        {
+            return -1;
+        }
+    }
+
+    return received;
+}
+
+
+/**
+ * @brief       Start a new trip between two random subnets
+ *
+ * @param[out]  vehicle     vehicle to start
+ * @param[in]   subnets     subnets to pick from
+ * @param[in]   random      random numbers of the connection
+ * @param[in]   connection  index of the connection
+ * @param[in]   index       index of the vehicle on the connection
+ */
+void StartTrip(SimVehicle & vehicle, const std::vector<std::string> & subnets, std::mt19937 & random,
+               int connection, int index)
+{
+    std::uniform_int_distribution<int> pick(0, (int)subnets.size() - 1);
+    int source = pick(random), dest;
+
+    do
+    {
+        dest = pick(random);
+    } while (dest == source);
+
+    //each trip is a new vehicle, so the server never sees a stale one
+    vehicle.id = "load" + std::to_string(connection) + "-" + std::to_string(index) + "-" +
+                 std::to_string(vehicle.trip++);
+    vehicle.road = subnets[source];
+    vehicle.dest = subnets[dest];
+    vehicle.route.clear();
+    vehicle.waiting = false;
+    vehicle.next = NET_ROUTE_REQUEST;
+}
+
+
+/**
+ * @brief       Print the latency percentiles of one kind of request
+ *
+ * @param[in]   name        kind of request
+ * @param[in]   latencies   latencies in seconds, sorted here
+ */
+void PrintLatencies(const char* name, std::vector<double> & latencies)
+{
+    if (latencies.empty())
+    {
+        return;
+    }
+
+    std::sort(latencies.begin(), latencies.end());
+
+    std::cout << std::fixed << std::setprecision(1) << "  " << name << ": " << latencies.size() << ", p50 "
+              << latencies[latencies.size() / 2] * 1e6 << " us, p99 "
+              << latencies[(size_t)(latencies.size() * 0.99)] * 1e6 << " us, p99.9 "
+              << latencies[(size_t)(latencies.size() * 0.999)] * 1e6 << " us, max "
+              << latencies.back() * 1e6 << " us" << std::endl;
+}
@@ -0,0 +1,523 @@
+/**
+ * @file    NetProtocol.cpp
+ *
+ * @brief   Implementation file for the messages between a remote vehicle and
+ *          the Compute Node server
+ *
+ * @author  Andrew Frost, Richard Millar
+ * @version 1.00
+ */
+
+// Header Files ===============================================================
+#include "NetProtocol.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+void AppendBytes(std::string & output, const void* value, size_t size);
+void AppendString(std::string & output, const std::string & value);
+bool TakeBytes(const char* & data, const char* end, void* value, size_t size);
+bool TakeString(const char* & data, const char* end, std::string & value);
+void EncodeRoute(const NetMessage & message, std::string & output);
+
+
+/**
+ * @brief   Default constructor
+ * @note    None
+ */
+NetMessage::NetMessage() : type(NET_ROUTE_REQUEST), sequence(0), id(), from(), to(), priority(0), deadline(0),
+                           status(NET_OK), more(false), route()
+{
+
+}
+
+
+/**
+ * @brief   Destructor
+ * @note    None
+ */
+NetMessage::~NetMessage()
+{
+
+}
+
+
+/**
+ * @brief       Append a message to a buffer
+ * @details     A frame is the length of the rest of the frame, the kind, the
+ *              sequence number, then the fields of the kind. Numbers are in
+ *              native byte order, as both ends run on the same machine, and
+ *              strings have a two byte length first.
+ *
+ * @param[in]   message     message to encode
+ * @param[out]  output      buffer the frame is appended to
+ *
+ * @note        A route response may take several frames, see EncodeRoute
+ */
+void EncodeMessage(const NetMessage & message, std::string & output)
+{
+    size_t start = output.size();
+    uint32_t length = 0;
+    uint8_t value;
+
+    if(message.type == NET_ROUTE_RESPONSE)
+    {
+        EncodeRoute(message, output);
+        return;
+    }
+
+    AppendBytes(output, &length, sizeof(length));
+
+    value = (uint8_t)message.type;
+    AppendBytes(output, &value, sizeof(value));
+    AppendBytes(output, &message.sequence, sizeof(uint32_t));
+
+    switch(message.type)
+    {
+        case NET_ROUTE_REQUEST:
+            AppendString(output, message.id);
+            AppendString(output, message.from);
+            AppendString(output, message.to);
+            value = (uint8_t)message.priority;
+            AppendBytes(output, &value, sizeof(value));
+            AppendBytes(output, &message.deadline, sizeof(double));
+            break;
+
+        case NET_ROAD_CHANGE:
+            AppendString(output, message.id);
+            AppendString(output, message.from);
+            AppendString(output, message.to);
+            break;
+
+        case NET_LEAVE:
+            AppendString(output, message.id);
+            AppendString(output, message.from);
+            break;
+
+        case NET_ROAD_CHANGE_ACK:
+        case NET_LEAVE_ACK:
+            value = (uint8_t)message.status;
+            AppendBytes(output, &value, sizeof(value));
+            break;
+
+        default:
+            break;
+    }
+
+    length = (uint32_t)(output.size() - start - sizeof(length));
+    std::memcpy(&output[start], &length, sizeof(length));
+}
+
+
+/**
+ * @brief       Append a route response to a buffer
+ * @details     Fills each frame with as many steps of the route as fit in
+ *              NET_MAX_FRAME and marks every frame but the last as having more
+ *              to follow. The client joins the parts back into one route.
+ *
+ * @param[in]   message     route response to encode
+ * @param[out]  output      buffer the frames are appended to
+ *
+ * @note        A step that fits in no frame turns the reply into NET_REFUSED,
+ *              the peer would drop the connection over a larger frame
+ */
+void EncodeRoute(const NetMessage & message, std::string & output)
+{
+    std::list<std::pair<std::string, double> >::const_iterator node = message.route.begin();
+    size_t origin = output.size(), start, moreAt, countAt;
+    uint32_t length, count;
+    uint8_t value;
+    NetMessage refused;
+
+    do
+    {
+        start = output.size();
+        length = 0;
+        AppendBytes(output, &length, sizeof(length));
+
+        value = (uint8_t)NET_ROUTE_RESPONSE;
+        AppendBytes(output, &value, sizeof(value));
+        AppendBytes(output, &message.sequence, sizeof(uint32_t));
+        value = (uint8_t)message.status;
+        AppendBytes(output, &value, sizeof(value));
+
+        moreAt = output.size();
+        value = 0;
+        AppendBytes(output, &value, sizeof(value));
+
+        countAt = output.size();
+        count = 0;
+        AppendBytes(output, &count, sizeof(count));
+
+        while(node != message.route.end() && output.size() - start - sizeof(length) + sizeof(uint16_t) +
+              node->first.size() + sizeof(double) <= NET_MAX_FRAME)
+        {
+            AppendString(output, node->first);
+            AppendBytes(output, &node->second, sizeof(double));
+            count++;
+            ++node;
+        }
+
+        if(count == 0 && node != message.route.end())
+        {
+            output.resize(origin);
+
+            refused.sequence = message.sequence;
+            refused.status = NET_REFUSED;
+            EncodeRoute(refused, output);
+
+            return;
+        }
+
+        value = node != message.route.end() ? 1 : 0;
+        std::memcpy(&output[moreAt], &value, sizeof(value));
+        std::memcpy(&output[countAt], &count, sizeof(count));
+
+        length = (uint32_t)(output.size() - start - sizeof(length));
+        std::memcpy(&output[start], &length, sizeof(length));
+    } while(node != message.route.end());
+}
+
+
+/**
+ * @brief       Read a message from the front of a buffer
+ *
+ * @param[in]   data        bytes received so far
+ * @param[in]   size        number of bytes
+ * @param[out]  message     message read
+ *
+ * @note        Returns the size of the frame read, 0 if the frame is not all
+ *              there yet, or -1 if it is not a valid frame
+ */
+int DecodeMessage(const char* data, size_t size, NetMessage & message)
+{
+    const char* end;
+    uint32_t length, count, index;
+    uint8_t value;
+    double time;
+    std::string node;
+
+    if(size < sizeof(length))
+    {
+        return 0;
+    }
+
+    std::memcpy(&length, data, sizeof(length));
+
+    if(length > NET_MAX_FRAME)
+    {
+        return -1;
+    }
+
+    if(size < sizeof(length) + length)
+    {
+        return 0;
+    }
+
+    end = data + sizeof(length) + length;
+    data += sizeof(length);
+
+    if(!TakeBytes(data, end, &value, sizeof(value)) || !TakeBytes(data, end, &message.sequence, sizeof(uint32_t)))
+    {
+        return -1;
+    }
+
+    message.type = (NetMessageType)value;
+    message.more = false;
+    message.route.clear();
+
+    switch(message.type)
+    {
+        case NET_ROUTE_REQUEST:
+            if(!TakeString(data, end, message.id) || !TakeString(data, end, message.from) ||
+               !TakeString(data, end, message.to) || !TakeBytes(data, end, &value, sizeof(value)) ||
+               !TakeBytes(data, end, &message.deadline, sizeof(double)))
+            {
+                return -1;
+            }
+
+            message.priority = value;
+            break;
+
+        case NET_ROUTE_RESPONSE:
+            if(!TakeBytes(data, end, &value, sizeof(value)))
+            {
+                return -1;
+            }
+
+            message.status = value;
+
+            if(!TakeBytes(data, end, &value, sizeof(value)) || !TakeBytes(data, end, &count, sizeof(count)))
+            {
+                return -1;
+            }
+
+            message.more = value != 0;
+
+            for(index = 0; index < count; index++)
+            {
+                if(!TakeString(data, end, node) || !TakeBytes(data, end, &time, sizeof(time)))
+                {
+                    return -1;
+                }
+
+                message.route.push_back(std::make_pair(node, time));
+            }
+            break;
+
+        case NET_ROAD_CHANGE:
+            if(!TakeString(data, end, message.id) || !TakeString(data, end, message.from) ||
+               !TakeString(data, end, message.to))
+            {
+                return -1;
+            }
+            break;
+
+        case NET_LEAVE:
+            if(!TakeString(data, end, message.id) || !TakeString(data, end, message.from))
+            {
+                return -1;
+            }
+            break;
+
+        case NET_ROAD_CHANGE_ACK:
+        case NET_LEAVE_ACK:
+            if(!TakeBytes(data, end, &value, sizeof(value)))
+            {
+                return -1;
+            }
+
+            message.status = value;
+            break;
+
+        default:
+            return -1;
+    }
+
+    return data == end ? (int)(sizeof(length) + length) : -1;
+}
+
+
+/**
+ * @brief       Parse a server address
+ * @details     unix:path names a Unix domain socket, tcp:port a port on the
+ *              loopback interface
+ *
+ * @param[in]   text        address to parse
+ * @param[out]  address     parsed address
+ *
+ * @note        Returns false if the address is neither
+ */
+bool ParseNetAddress(const std::string & text, NetAddress & address)
+{
+    if(text.compare(0, 5, "unix:") == 0 && text.size() > 5)
+    {
+        address.transport = NET_UNIX;
+        address.path = text.substr(5);
+        address.port = 0;
+
+        return address.path.size() < sizeof(((sockaddr_un*)0)->sun_path);
+    }
+
+    if(text.compare(0, 4, "tcp:") == 0 && text.size() > 4)
+    {
+        address.transport = NET_TCP;
+        address.path.clear();
+        address.port = std::atoi(text.c_str() + 4);
+
+        return address.port > 0 && address.port < 65536;
+    }
+
+    return false;
+}
+
+
+/**
+ * @brief       Open a non blocking socket listening on an address
+ * @details     A Unix socket file left by an earlier run is replaced
+ *
+ * @param[in]   address     address to listen on
+ *
+ * @note        Returns -1 on failure
+ */
+int OpenListener(const NetAddress & address)
+{
+    sockaddr_un local;
+    sockaddr_in loopback;
+    int socketFd, enable = 1, result;
+
+    socketFd = socket(address.transport == NET_UNIX ? AF_UNIX : AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+
+    if(socketFd < 0)
+    {
+        return -1;
+    }
+
+    if(address.transport == NET_UNIX)
+    {
+        std::memset(&local, 0, sizeof(local));
+        local.sun_family = AF_UNIX;
+        std::strncpy(local.sun_path, address.path.c_str(), sizeof(local.sun_path) - 1);
+        unlink(address.path.c_str());
+
+        result = bind(socketFd, (sockaddr*)&local, sizeof(local));
+    }
+    else
+    {
+        setsockopt(socketFd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+
+        std::memset(&loopback, 0, sizeof(loopback));
+        loopback.sin_family = AF_INET;
+        loopback.sin_port = htons((uint16_t)address.port);
+        loopback.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+        result = bind(socketFd, (sockaddr*)&loopback, sizeof(loopback));
+    }
+
+    if(result < 0 || listen(socketFd, NET_LISTEN_BACKLOG) < 0)
+    {
+        close(socketFd);
+        return -1;
+    }
+
+    return socketFd;
+}
+
+
+/**
+ * @brief       Open a blocking connection to a server
+ * @details     Small frames go out at once, TCP does not hold them back
+ *
+ * @param[in]   address     address of the server
+ *
+ * @note        Returns -1 on failure
+ */
+int OpenConnection(const NetAddress & address)
+{
+    sockaddr_un local;
+    sockaddr_in loopback;
+    int socketFd, enable = 1, result;
+
+    socketFd = socket(address.transport == NET_UNIX ? AF_UNIX : AF_INET, SOCK_STREAM, 0);
+
+    if(socketFd < 0)
+    {
+        return -1;
+    }
+
+    if(address.transport == NET_UNIX)
+    {
+        std::memset(&local, 0, sizeof(local));
+        local.sun_family = AF_UNIX;
+        std::strncpy(local.sun_path, address.path.c_str(), sizeof(local.sun_path) - 1);
+
+        result = connect(socketFd, (sockaddr*)&local, sizeof(local));
+    }
+    else
+    {
+        std::memset(&loopback, 0, sizeof(loopback));
+        loopback.sin_family = AF_INET;
+        loopback.sin_port = htons((uint16_t)address.port);
+        loopback.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+        result = connect(socketFd, (sockaddr*)&loopback, sizeof(loopback));
+
+        if(result == 0)
+        {
+            setsockopt(socketFd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+        }
+    }
+
+    if(result < 0)
+    {
+        close(socketFd);
+        return -1;
+    }
+
+    return socketFd;
+}
+
+
+/**
+ * @brief       Append raw bytes to a buffer
+ *
+ * @param[out]  output  buffer to append to
+ * @param[in]   value   bytes to append
+ * @param[in]   size    number of bytes
+ */
+void AppendBytes(std::string & output, const void* value, size_t size)
+{
+    output.append((const char*)value, size);
+}
+
+
+/**
+ * @brief       Append a string, its length first
+ *
+ * @param[out]  output  buffer to append to
+ * @param[in]   value   string to append, cut to 65535 bytes
+ */
+void AppendString(std::string & output, const std::string & value)
+{
+    uint16_t length = (uint16_t)std::min<size_t>(value.size(), 0xFFFF);
+
+    AppendBytes(output, &length, sizeof(length));
+    output.append(value, 0, length);
+}
+
+
+/**
+ * @brief       Take raw bytes from the front of a frame
+ *
+ * @param[in]   data    front of the frame, moved past the bytes taken
+ * @param[in]   end     end of the frame
+ * @param[out]  value   bytes taken
+ * @param[in]   size    number of bytes
+ *
+ * @note        Returns false if the frame is too short
+ */
+bool TakeBytes(const char* & data, const char* end, void* value, size_t size)
+{
+    if((size_t)(end - data) < size)
+    {
+        return false;
+    }
+
+    std::memcpy(value, data, size);
+    data += size;
+
+    return true;
+}
+
+
+/**
+ * @brief       Take a string from the front of a frame
+ *
+ * @param[in]   data    front of the frame, moved past the string
+ * @param[in]   end     end of the frame
+ * @param[out]  value   string taken
+ *
+ * @note        Returns false if the frame is too short
+ */
+bool TakeString(const char* & data, const char* end, std::string & value)
+{
+    uint16_t length;
+
+    if(!TakeBytes(data, end, &length, sizeof(length)) || (size_t)(end - data) < length)
+    {
+        return false;
+    }
+
+    value.assign(data, length);
+    data += length;
+
+    return true;
+}
@@ -0,0 +1,106 @@
+/**
+ * @file    NetProtocol.h
+ * @brief   Definition file for the messages between a remote vehicle and the
+ *          Compute Node server
+ *
+ * @author  Andrew Frost, Richard Millar
+ * @version 1.00
+ */
+
+// Precompiler Directives =====================================================
+#ifndef NETPROTOCOL_H
+#define NETPROTOCOL_H
+
+// Header Files ===============================================================
+#include <cstddef>
+#include <list>
+#include <string>
+
+#define NET_MAX_FRAME (1 << 16)
+#define NET_LISTEN_BACKLOG 128
+
+/**
+ * @brief   Kind of a message.
+ * @details Each request has a reply of its own kind carrying the same
+ *          sequence number, so a client can send many requests before reading
+ *          the replies. Route responses come when the Compute Node has routed
+ *          the vehicle, so they may overtake the replies to later requests.
+ */
+enum NetMessageType
+{
+    NET_ROUTE_REQUEST = 1,  //vehicle id, source, dest, priority and deadline
+    NET_ROUTE_RESPONSE,     //status, whether more follows, and the route or a part of it
+    NET_ROAD_CHANGE,        //vehicle id, current road and new road
+    NET_ROAD_CHANGE_ACK,    //status, NET_OK if the vehicle may turn
+    NET_LEAVE,              //vehicle id and the road it leaves from
+    NET_LEAVE_ACK           //status
+};
+
+
+/**
+ * @brief   Status carried by a reply.
+ */
+enum NetStatus
+{
+    NET_OK,
+    NET_REFUSED,    //road change refused, or route request turned away
+    NET_INVALID     //the request did not make sense, e.g. an unknown vehicle
+};
+
+
+/**
+ * @brief   One message of the protocol, any kind.
+ * @details Only the fields of its kind are sent. A route that does not fit
+ *          in one frame is sent as several route responses with the same
+ *          sequence, each but the last marked more.
+ */
+struct NetMessage
+{
+public:
+    NetMessage();
+    ~NetMessage();
+
+    NetMessageType type;
+    unsigned int sequence; //chosen by the client, copied into the reply
+
+    std::string id;
+    std::string from; //source of a route request, current road, or last road
+    std::string to; //dest of a route request, or new road
+    int priority;
+    double deadline;
+
+    int status;
+    bool more; //the route goes on in the next frame
+    std::list<std::pair<std::string, double> > route;
+};
+
+
+/**
+ * @brief   Transport of a server or client address.
+ */
+enum NetTransport
+{
+    NET_UNIX,   //unix:path, a Unix domain socket
+    NET_TCP     //tcp:port, TCP on the loopback interface
+};
+
+
+/**
+ * @brief   Parsed server address.
+ */
+struct NetAddress
+{
+    NetTransport transport;
+    std::string path;
+    int port;
+};
+
+
+void EncodeMessage(const NetMessage & message, std::string & output);
+int DecodeMessage(const char* data, size_t size, NetMessage & message);
+
+bool ParseNetAddress(const std::string & text, NetAddress & address);
+int OpenListener(const NetAddress & address);
+int OpenConnection(const NetAddress & address);
+
+#endif
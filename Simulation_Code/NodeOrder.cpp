@@ -0,0 +1,253 @@
+/**
+ * @file    NodeOrder.cpp
+ *
+ * @brief   Implementation file for the renumbering of the road graph
+ *
+ * @author  Andrew Frost, Richard Millar
+ * @version 1.00
+ */
+
+// Header Files ===============================================================
+#include "NodeOrder.h"
+#include <algorithm>
+
+#define PERIPHERAL_ROUNDS 4 //most searches spent looking for the edge of a component
+
+// Function Prototypes ========================================================
+static int VisitLevels(const RoadGraph & graph, const RoadGraph & reverse, const std::vector<int> & degree,
+                       int start, int & depth, std::vector<int> & visited);
+static int FindPeripheralNode(const RoadGraph & graph, const RoadGraph & reverse, const std::vector<int> & degree,
+                              int root, std::vector<int> & visited);
+
+
+/**
+ * @brief       Computes a new numbering of the subnets
+ * @details     Numbers every connected component in turn, breadth first from
+ *              its first subnet for BFS, or for RCM from a subnet at the edge
+ *              of the component with the neighbors of each subnet taken fewest
+ *              roads first and the whole order reversed at the end.
+ *
+ * @param[in]   graph       road graph in its current numbering
+ * @param[in]   order       numbering to compute
+ * @param[out]  newIndex    new index of every subnet, by current index
+ *
+ * @note        ORDER_INPUT keeps every subnet where it is
+ */
+void ComputeNodeOrder(const RoadGraph & graph, NodeOrder order, std::vector<int> & newIndex)
+{
+    const int nodeCount = graph.getNodeCount();
+
+    RoadGraph reverse;
+    std::vector<int> degree, roots, sequence, neighbors, visited;
+    int root, head, current, edge, position;
+
+    newIndex.resize(nodeCount);
+
+    if (order == ORDER_INPUT)
+    {
+        for (current = 0; current < nodeCount; current++)
+        {
+            newIndex[current] = current;
+        }
+
+        return;
+    }
+
+    reverse = graph.reversed();
+
+    degree.assign(nodeCount, 0);
+    roots.resize(nodeCount);
+
+    for (current = 0; current < nodeCount; current++)
+    {
+        degree[current] = graph.offsets[current + 1] - graph.offsets[current]
+                        + reverse.offsets[current + 1] - reverse.offsets[current];
+        roots[current] = current;
+    }
+
+    //RCM starts each component from a subnet with few roads
+    if (order == ORDER_RCM)
+    {
+        std::stable_sort(roots.begin(), roots.end(), [&degree](int left, int right)
+        {
+            return degree[left] < degree[right];
+        });
+    }
+
+    visited.assign(nodeCount, 0);
+    sequence.reserve(nodeCount);
+
+    //the numbering marks the subnets it has placed with 2, the searches for
+    //the edge of a component use 1 and clear it again
+    for (position = 0; position < nodeCount; position++)
+    {
+        root = roots[position];
+
+        if (visited[root] == 2)
+        {
+            continue;
+        }
+
+        if (order == ORDER_RCM)
+        {
+            root = FindPeripheralNode(graph, reverse, degree, root, visited);
+        }
+
+        head = (int)sequence.size();
+        sequence.push_back(root);
+        visited[root] = 2;
+
+        while (head < (int)sequence.size())
+        {
+            current = sequence[head++];
+            neighbors.clear();
+
+            for (edge = graph.offsets[current]; edge < graph.offsets[current + 1]; edge++)
+            {
+                if (visited[graph.targets[edge]] != 2)
+                {
+                    visited[graph.targets[edge]] = 2;
+                    neighbors.push_back(graph.targets[edge]);
+                }
+            }
+
+            for (edge = reverse.offsets[current]; edge < reverse.offsets[current + 1]; edge++)
+            {
+                if (visited[reverse.targets[edge]] != 2)
+                {
+                    visited[reverse.targets[edge]] = 2;
+                    neighbors.push_back(reverse.targets[edge]);
+                }
+            }
+
+            if (order == ORDER_RCM)
+            {
+                std::stable_sort(neighbors.begin(), neighbors.end(), [&degree](int left, int right)
+                {
+                    return degree[left] < degree[right];
+                });
+            }
+
+            sequence.insert(sequence.end(), neighbors.begin(), neighbors.end());
+        }
+    }
+
+    if (order == ORDER_RCM)
+    {
+        std::reverse(sequence.begin(), sequence.end());
+    }
+
+    for (position = 0; position < nodeCount; position++)
+    {
+        newIndex[sequence[position]] = position;
+    }
+}
+
+
+/**
+ * @brief       Breadth first levels of a component
+ * @details     Searches breadth first from start, marking the subnets reached
+ *              with 1 in visited and clearing the marks again at the end
+ *
+ * @param[in]   graph   road graph
+ * @param[in]   reverse graph with every road reversed
+ * @param[in]   degree  roads in and out of every subnet
+ * @param[in]   start   subnet to search from
+ * @param[out]  depth   level of the subnets reached last
+ * @param[out]  visited marks of the subnets, 0 where not yet numbered
+ *
+ * @note        Returns the subnet with the fewest roads on the deepest level
+ */
+static int VisitLevels(const RoadGraph & graph, const RoadGraph & reverse, const std::vector<int> & degree,
+                       int start, int & depth, std::vector<int> & visited)
+{
+    std::vector<int> queue(1, start), level(1, 0);
+    unsigned int head;
+    int current, edge, neighbor, candidate;
+
+    visited[start] = 1;
+
+    for (head = 0; head < queue.size(); head++)
+    {
+        current = queue[head];
+
+        for (edge = graph.offsets[current]; edge < graph.offsets[current + 1]; edge++)
+        {
+            neighbor = graph.targets[edge];
+
+            if (visited[neighbor] == 0)
+            {
+                visited[neighbor] = 1;
+                queue.push_back(neighbor);
+                level.push_back(level[head] + 1);
+            }
+        }
+
+        for (edge = reverse.offsets[current]; edge < reverse.offsets[current + 1]; edge++)
+        {
+            neighbor = reverse.targets[edge];
+
+            if (visited[neighbor] == 0)
+            {
+                visited[neighbor] = 1;
+                queue.push_back(neighbor);
+                level.push_back(level[head] + 1);
+            }
+        }
+    }
+
+    depth = level.back();
+    candidate = queue.back();
+
+    //the deepest level is at the end of the queue
+    for (head = queue.size(); head > 0 && level[head - 1] == depth; head--)
+    {
+        if (degree[queue[head - 1]] < degree[candidate])
+        {
+            candidate = queue[head - 1];
+        }
+    }
+
+    for (head = 0; head < queue.size(); head++)
+    {
+        visited[queue[head]] = 0;
+    }
+
+    return candidate;
+}
+
+
+/**
+ * @brief       Finds a subnet at the edge of a component
+ * @details     Moves to the subnet with the fewest roads on the deepest
+ *              breadth first level for as long as that makes the component
+ *              deeper, the pseudo-peripheral node of George and Liu
+ *
+ * @param[in]   graph   road graph
+ * @param[in]   reverse graph with every road reversed
+ * @param[in]   degree  roads in and out of every subnet
+ * @param[in]   root    subnet of the component to start from
+ * @param[out]  visited marks of the subnets, 0 where not yet numbered
+ *
+ * @note        None
+ */
+static int FindPeripheralNode(const RoadGraph & graph, const RoadGraph & reverse, const std::vector<int> & degree,
+                              int root, std::vector<int> & visited)
+{
+    int depth = -1, nextDepth, round, candidate;
+
+    for (round = 0; round < PERIPHERAL_ROUNDS; round++)
+    {
+        candidate = VisitLevels(graph, reverse, degree, root, nextDepth, visited);
+
+        if (nextDepth <= depth)
+        {
+            break;
+        }
+
+        depth = nextDepth;
+        root = candidate;
+    }
+
+    return root;
+}
@@ -0,0 +1,37 @@
+/**
+ * @file    NodeOrder.h
+ * @brief   Definition file for the renumbering of the road graph
+ *
+ * @author  Andrew Frost, Richard Millar
+ * @version 1.00
+ */
+
+// Precompiler Directives =====================================================
+#ifndef NODEORDER_H
+#define NODEORDER_H
+
+// Header Files ===============================================================
+#include <vector>
+#include "RoadGraph.h"
+
+/**
+ * @brief   Order the subnets of the road graph are numbered in.
+ * @details INPUT keeps the order of the input file. BFS numbers the subnets in
+ *          breadth first order, so the neighbors of a subnet get indices close
+ *          to its own and a search touches nearby memory. RCM is reverse
+ *          Cuthill-McKee: a breadth first order from a subnet at the edge of
+ *          the city that visits the neighbors with the fewest roads first, then
+ *          reversed, which keeps the spread of indices across a road smaller
+ *          still. Roads are treated as two way for both.
+ */
+enum NodeOrder
+{
+    ORDER_INPUT,
+    ORDER_BFS,
+    ORDER_RCM
+};
+
+// Function Prototypes ========================================================
+void ComputeNodeOrder(const RoadGraph & graph, NodeOrder order, std::vector<int> & newIndex);
+
+#endif
@@ -0,0 +1,642 @@
+/**
+ * @file    OccupancyLog.cpp
+ *
+ * @brief   Implementation file for the OccupancyWriter and OccupancyReader classes
+ *
+ * @author  Andrew Frost, Richard Millar
+ * @version 1.00
+ */
+
+// Header Files ===============================================================
+#include "OccupancyLog.h"
+#include <algorithm>
+#include <cstring>
+
+#define OCCUPANCY_MAX_SUBNETS (1 << 24)
+#define OCCUPANCY_MAX_BLOCK_BYTES (1 << 30)
+
+
+// Encoding Helpers ===========================================================
+/**
+ * @brief       Appends an unsigned varint
+ * @details     Seven bits per byte, low bits first, the top bit marks that
+ *              another byte follows
+ *
+ * @param[out]  out     buffer to append to
+ * @param[in]   value   value to append
+ */
+static void PutVarint(std::vector<unsigned char> & out, unsigned long long value)
+{
+    while (value >= 0x80)
+    {
+        out.push_back((unsigned char)(value | 0x80));
+        value >>= 7;
+    }
+
+    out.push_back((unsigned char)value);
+}
+
+
+/**
+ * @brief       Reads an unsigned varint from a buffer
+ *
+ * @param[in]   data    next byte to read, advanced past the varint
+ * @param[in]   end     end of the buffer
+ * @param[out]  value   value read
+ *
+ * @note        Returns false if the buffer ends inside the varint
+ */
+static bool GetVarint(const unsigned char * & data, const unsigned char * end, unsigned long long & value)
+{
+    int shift = 0;
+
+    value = 0;
+
+    while (data < end && shift < 64)
+    {
+        value |= (unsigned long long)(*data & 0x7f) << shift;
+
+        if ((*data++ & 0x80) == 0)
+        {
+            return true;
+        }
+
+        shift += 7;
+    }
+
+    return false;
+}
+
+
+/**
+ * @brief       Reads an unsigned varint from a file
+ *
+ * @param[in]   file    file to read from
+ * @param[out]  value   value read
+ *
+ * @note        Returns false if the file ends inside the varint
+ */
+static bool ReadVarint(std::istream & file, unsigned long long & value)
+{
+    int shift = 0, byte;
+
+    value = 0;
+
+    while (shift < 64 && (byte = file.get()) != EOF)
+    {
+        value |= (unsigned long long)(byte & 0x7f) << shift;
+
+        if ((byte & 0x80) == 0)
+        {
+            return true;
+        }
+
+        shift += 7;
+    }
+
+    return false;
+}
+
+
+/**
+ * @brief   Maps a signed value to an unsigned one, small magnitudes first
+ */
+static unsigned long long ZigZag(long long value)
+{
+    return ((unsigned long long)value << 1) ^ (unsigned long long)(value >> 63);
+}
+
+
+/**
+ * @brief   Reverses ZigZag
+ */
+static long long UnZigZag(unsigned long long value)
+{
+    return (long long)(value >> 1) ^ -(long long)(value & 1);
+}
+
+
+/**
+ * @brief       Appends one column of a block
+ * @details     Each value is written as its change from the value before. A run
+ *              of unchanged values is written as its length, so the column is a
+ *              sequence of (run, change) pairs, with a final run when the column
+ *              ends unchanged.
+ *
+ * @param[out]  out         buffer to append to
+ * @param[in]   values      values of the column
+ * @param[in]   count       number of values
+ * @param[in]   previous    value before the first of the column
+ */
+template<typename Value>
+static void PutColumn(std::vector<unsigned char> & out, const Value * values, int count, Value previous)
+{
+    long long run = 0;
+    int index;
+
+    for (index = 0; index < count; index++)
+    {
+        if (values[index] == previous)
+        {
+            run++;
+            continue;
+        }
+
+        PutVarint(out, run);
+        PutVarint(out, ZigZag((long long)values[index] - (long long)previous));
+
+        previous = values[index];
+        run = 0;
+    }
+
+    if (run > 0)
+    {
+        PutVarint(out, run);
+    }
+}
+
+
+/**
+ * @brief       Reads one column of a block
+ *
+ * @param[in]   data        next byte to read, advanced past the column
+ * @param[in]   end         end of the buffer
+ * @param[out]  values      values of the column
+ * @param[in]   count       number of values
+ * @param[in]   previous    value before the first of the column
+ *
+ * @note        Returns false if the column is malformed
+ */
+template<typename Value>
+static bool GetColumn(const unsigned char * & data, const unsigned char * end, Value * values, int count, Value previous)
+{
+    unsigned long long run, change;
+    int index = 0;
+
+    while (index < count)
+    {
+        if (!GetVarint(data, end, run) || run > (unsigned long long)(count - index))
+        {
+            return false;
+        }
+
+        for (; run > 0; run--)
+        {
+            values[index++] = previous;
+        }
+
+        if (index < count)
+        {
+            if (!GetVarint(data, end, change))
+            {
+                return false;
+            }
+
+            previous = (Value)((long long)previous + UnZigZag(change));
+            values[index++] = previous;
+        }
+    }
+
+    return true;
+}
+
+
+/**
+ * @brief   Default constructor
+ * @details Constructs an empty sample
+ * @note    None
+ */
+OccupancySample::OccupancySample() : timeMS(0), queueLength(0), occupancy(), failures()
+{
+
+}
+
+/**
+ * @brief   Default destructor
+ * @details Destroys an OccupancySample object
+ * @note    None
+ */
+OccupancySample::~OccupancySample()
+{
+
+}
+
+
+/**
+ * @brief   Default constructor
+ * @details Constructs a writer that is not open yet
+ * @note    None
+ */
+OccupancyWriter::OccupancyWriter()
+    : file(), subnetCount(0), blockSize(0), times(), queueLengths(), occupancy(), failures(),
+    lastTime(0), lastQueueLength(0), lastOccupancy(), lastFailures(), buffer(), samples(0), bytes(0)
+{
+
+}
+
+/**
+ * @brief   Default destructor
+ * @details Writes the samples still held and closes the file
+ * @note    None
+ */
+OccupancyWriter::~OccupancyWriter()
+{
+    close();
+}
+
+
+/**
+ * @brief       Starts an occupancy file
+ * @details     Writes the tag followed by the name and capacity of every subnet
+ *
+ * @param[in]   fileName    file to write
+ * @param[in]   names       subnet names by index
+ * @param[in]   capacities  subnet capacities by index
+ *
+ * @note        Returns false if the file could not be created
+ */
+bool OccupancyWriter::open(const std::string & fileName, const std::vector<std::string> & names,
+                           const std::vector<int> & capacities)
+{
+    int index;
+
+    file.open(fileName.c_str(), std::ios::binary | std::ios::trunc);
+
+    if (!file.is_open())
+    {
+        return false;
+    }
+
+    subnetCount = (int)names.size();
+    blockSize = 0;
+
+    times.assign(OCCUPANCY_BLOCK_SAMPLES, 0);
+    queueLengths.assign(OCCUPANCY_BLOCK_SAMPLES, 0);
+    occupancy.assign((size_t)subnetCount * OCCUPANCY_BLOCK_SAMPLES, 0);
+    failures.assign((size_t)subnetCount * OCCUPANCY_BLOCK_SAMPLES, 0);
+
+    lastTime = 0;
+    lastQueueLength = 0;
+    lastOccupancy.assign(subnetCount, 0);
+    lastFailures.assign(subnetCount, 0);
+
+    buffer.assign(OCCUPANCY_FILE_TAG, OCCUPANCY_FILE_TAG + sizeof(OCCUPANCY_FILE_TAG) - 1);
+    PutVarint(buffer, subnetCount);
+
+    for (index = 0; index < subnetCount; index++)
+    {
+        PutVarint(buffer, names[index].size());
+        buffer.insert(buffer.end(), names[index].begin(), names[index].end());
+        PutVarint(buffer, ZigZag(index < (int)capacities.size() ? capacities[index] : 0));
+    }
+
+    file.write(reinterpret_cast<const char*>(&buffer[0]), buffer.size());
+
+    samples = 0;
+    bytes = (long long)buffer.size();
+
+    return file.good();
+}
+
+
+/**
+ * @brief   Finishes the occupancy file
+ * @details Writes the last, partial block and closes the file
+ * @note    Returns false if anything could not be written
+ */
+bool OccupancyWriter::close()
+{
+    bool good;
+
+    if (!file.is_open())
+    {
+        return false;
+    }
+
+    if (blockSize > 0)
+    {
+        writeBlock();
+    }
+
+    file.flush();
+    good = file.good();
+    file.close();
+
+    return good;
+}
+
+
+/**
+ * @brief       Adds a sample
+ * @details     Files the sample into the columns of the current block, and
+ *              writes the block once it is full
+ *
+ * @param[in]   sample  state of the network to add
+ *
+ * @note        Subnets missing from the sample are recorded as zero
+ */
+void OccupancyWriter::append(const OccupancySample & sample)
+{
+    int subnet, occupancyCount, failureCount;
+
+    if (!file.is_open())
+    {
+        return;
+    }
+
+    occupancyCount = std::min(subnetCount, (int)sample.occupancy.size());
+    failureCount = std::min(subnetCount, (int)sample.failures.size());
+
+    times[blockSize] = sample.timeMS;
+    queueLengths[blockSize] = sample.queueLength;
+
+    for (subnet = 0; subnet < subnetCount; subnet++)
+    {
+        occupancy[(size_t)subnet * OCCUPANCY_BLOCK_SAMPLES + blockSize] = subnet < occupancyCount ? sample.occupancy[subnet] : 0;
+        failures[(size_t)subnet * OCCUPANCY_BLOCK_SAMPLES + blockSize] = subnet < failureCount ? sample.failures[subnet] : 0;
+    }
+
+    blockSize++;
+    samples++;
+
+    if (blockSize == OCCUPANCY_BLOCK_SAMPLES)
+    {
+        writeBlock();
+    }
+}
+
+
+/**
+ * @brief   Get the sample count
+ * @details Returns the number of samples appended
+ * @note    None
+ */
+long long OccupancyWriter::getSampleCount() const
+{
+    return samples;
+}
+
+
+/**
+ * @brief   Get the byte count
+ * @details Returns the size of the file written so far
+ * @note    Samples of the current block are not counted until it is written
+ */
+long long OccupancyWriter::getByteCount() const
+{
+    return bytes;
+}
+
+
+/**
+ * @brief   Writes the current block
+ * @details Writes the sample count and encoded size, followed by every column
+ * @note    None
+ */
+void OccupancyWriter::writeBlock()
+{
+    std::vector<unsigned char> header;
+    int subnet;
+
+    buffer.clear();
+
+    PutColumn(buffer, &times[0], blockSize, lastTime);
+    PutColumn(buffer, &queueLengths[0], blockSize, lastQueueLength);
+
+    for (subnet = 0; subnet < subnetCount; subnet++)
+    {
+        PutColumn(buffer, &occupancy[(size_t)subnet * OCCUPANCY_BLOCK_SAMPLES], blockSize, lastOccupancy[subnet]);
+        lastOccupancy[subnet] = occupancy[(size_t)subnet * OCCUPANCY_BLOCK_SAMPLES + blockSize - 1];
+    }
+
+    for (subnet = 0; subnet < subnetCount; subnet++)
+    {
+        PutColumn(buffer, &failures[(size_t)subnet * OCCUPANCY_BLOCK_SAMPLES], blockSize, lastFailures[subnet]);
+        lastFailures[subnet] = failures[(size_t)subnet * OCCUPANCY_BLOCK_SAMPLES + blockSize - 1];
+    }
+
+    lastTime = times[blockSize - 1];
+    lastQueueLength = queueLengths[blockSize - 1];
+
+    PutVarint(header, blockSize);
+    PutVarint(header, buffer.size());
+
+    file.write(reinterpret_cast<const char*>(&header[0]), header.size());
+    file.write(reinterpret_cast<const char*>(&buffer[0]), buffer.size());
+
+    bytes += (long long)(header.size() + buffer.size());
+    blockSize = 0;
+}
+
+
+/**
+ * @brief   Default constructor
+ * @details Constructs a reader that is not open yet
+ * @note    None
+ */
+OccupancyReader::OccupancyReader()
+    : file(), names(), capacities(), subnetCount(0), blockSize(0), position(0), times(), queueLengths(),
+    occupancy(), failures(), lastTime(0), lastQueueLength(0), lastOccupancy(), lastFailures(), buffer()
+{
+
+}
+
+/**
+ * @brief   Default destructor
+ * @details Destroys an OccupancyReader object
+ * @note    None
+ */
+OccupancyReader::~OccupancyReader()
+{
+
+}
+
+
+/**
+ * @brief       Opens an occupancy file
+ * @details     Checks the tag and reads the subnets
+ *
+ * @param[in]   fileName    file to read
+ *
+ * @note        Returns false if the file is missing or not an occupancy file
+ */
+bool OccupancyReader::open(const std::string & fileName)
+{
+    char tag[sizeof(OCCUPANCY_FILE_TAG) - 1];
+    unsigned long long count, length, capacity;
+    int index;
+
+    file.open(fileName.c_str(), std::ios::binary);
+
+    if (!file.is_open())
+    {
+        return false;
+    }
+
+    file.read(tag, sizeof(tag));
+
+    if (!file.good() || std::memcmp(tag, OCCUPANCY_FILE_TAG, sizeof(tag)) != 0 ||
+        !ReadVarint(file, count) || count > OCCUPANCY_MAX_SUBNETS)
+    {
+        return false;
+    }
+
+    subnetCount = (int)count;
+    names.resize(subnetCount);
+    capacities.resize(subnetCount);
+
+    for (index = 0; index < subnetCount; index++)
+    {
+        if (!ReadVarint(file, length) || length > 4096)
+        {
+            return false;
+        }
+
+        names[index].resize((size_t)length);
+
+        if (length > 0)
+        {
+            file.read(&names[index][0], length);
+        }
+
+        if (!ReadVarint(file, capacity))
+        {
+            return false;
+        }
+
+        capacities[index] = (int)UnZigZag(capacity);
+    }
+
+    times.assign(OCCUPANCY_BLOCK_SAMPLES, 0);
+    queueLengths.assign(OCCUPANCY_BLOCK_SAMPLES, 0);
+    occupancy.assign((size_t)subnetCount * OCCUPANCY_BLOCK_SAMPLES, 0);
+    failures.assign((size_t)subnetCount * OCCUPANCY_BLOCK_SAMPLES, 0);
+    lastOccupancy.assign(subnetCount, 0);
+    lastFailures.assign(subnetCount, 0);
+
+    lastTime = 0;
+    lastQueueLength = 0;
+    blockSize = 0;
+    position = 0;
+
+    return file.good();
+}
+
+
+/**
+ * @brief   Get the subnet names
+ * @details Returns the names of the subnets by index
+ * @note    None
+ */
+const std::vector<std::string> & OccupancyReader::getSubnetNames() const
+{
+    return names;
+}
+
+
+/**
+ * @brief   Get the subnet capacities
+ * @details Returns the capacities of the subnets by index
+ * @note    None
+ */
+const std::vector<int> & OccupancyReader::getCapacities() const
+{
+    return capacities;
+}
+
+
+/**
+ * @brief       Reads the next sample
+ *
+ * @param[out]  sample  state of the network
+ *
+ * @note        Returns false at the end of the file or if it is malformed
+ */
+bool OccupancyReader::next(OccupancySample & sample)
+{
+    int subnet;
+
+    if (position >= blockSize && !readBlock())
+    {
+        return false;
+    }
+
+    sample.timeMS = times[position];
+    sample.queueLength = queueLengths[position];
+    sample.occupancy.resize(subnetCount);
+    sample.failures.resize(subnetCount);
+
+    for (subnet = 0; subnet < subnetCount; subnet++)
+    {
+        sample.occupancy[subnet] = occupancy[(size_t)subnet * OCCUPANCY_BLOCK_SAMPLES + position];
+        sample.failures[subnet] = failures[(size_t)subnet * OCCUPANCY_BLOCK_SAMPLES + position];
+    }
+
+    position++;
+
+    return true;
+}
+
+
+/**
+ * @brief   Reads the next block
+ * @details Decodes every column of the block
+ * @note    Returns false at the end of the file or if the block is malformed
+ */
+bool OccupancyReader::readBlock()
+{
+    unsigned long long count, length;
+    const unsigned char * data, * end;
+    int subnet;
+
+    if (!ReadVarint(file, count) || count == 0 || count > OCCUPANCY_BLOCK_SAMPLES ||
+        !ReadVarint(file, length) || length == 0 || length > OCCUPANCY_MAX_BLOCK_BYTES)
+    {
+        return false;
+    }
+
+    buffer.resize((size_t)length);
+    file.read(reinterpret_cast<char*>(&buffer[0]), length);
+
+    if (!file.good())
+    {
+        return false;
+    }
+
+    blockSize = (int)count;
+    position = 0;
+
+    data = &buffer[0];
+    end = data + buffer.size();
+
+    if (!GetColumn(data, end, &times[0], blockSize, lastTime) ||
+        !GetColumn(data, end, &queueLengths[0], blockSize, lastQueueLength))
+    {
+        return false;
+    }
+
+    for (subnet = 0; subnet < subnetCount; subnet++)
+    {
+        if (!GetColumn(data, end, &occupancy[(size_t)subnet * OCCUPANCY_BLOCK_SAMPLES], blockSize, lastOccupancy[subnet]))
+        {
+            return false;
+        }
+
+        lastOccupancy[subnet] = occupancy[(size_t)subnet * OCCUPANCY_BLOCK_SAMPLES + blockSize - 1];
+    }
+
+    for (subnet = 0; subnet < subnetCount; subnet++)
+    {
+        if (!GetColumn(data, end, &failures[(size_t)subnet * OCCUPANCY_BLOCK_SAMPLES], blockSize, lastFailures[subnet]))
+        {
+            return false;
+        }
+
+        lastFailures[subnet] = failures[(size_t)subnet * OCCUPANCY_BLOCK_SAMPLES + blockSize - 1];
+    }
+
+    lastTime = times[blockSize - 1];
+    lastQueueLength = queueLengths[blockSize - 1];
+
+    return data == end;
+}
@@ -0,0 +1,133 @@
+/**
+ * @file    OccupancyLog.h
+ * @brief   Definition file for the OccupancyWriter and OccupancyReader classes
+ *
+ * @author  Andrew Frost, Richard Millar
+ * @version 1.00
+ */
+
+// Precompiler Directives =====================================================
+#ifndef OCCUPANCYLOG_H
+#define OCCUPANCYLOG_H
+
+// Header Files ===============================================================
+#include <fstream>
+#include <string>
+#include <vector>
+
+#define OCCUPANCY_FILE_TAG "SDNOCC01"
+#define OCCUPANCY_BLOCK_SAMPLES 16
+
+/**
+ * @brief   State of the network at one point in time.
+ * @details occupancy and failures are indexed like the subnetToIndexTable of the
+ *          Compute Node. failures counts the road changes refused because the
+ *          subnet was full, since the start of the run.
+ */
+struct OccupancySample
+{
+public:
+    OccupancySample();
+    ~OccupancySample();
+
+    long long timeMS; //since the start of the run
+    int queueLength;
+    std::vector<int> occupancy;
+    std::vector<int> failures;
+};
+
+
+// Class Definition ===========================================================
+/**
+ * @brief   Columnar writer of occupancy samples.
+ * @details Samples are collected into blocks of OCCUPANCY_BLOCK_SAMPLES. A block
+ *          is written column by column: the times, the queue lengths, then the
+ *          occupancy of each subnet and the failures of each subnet over the
+ *          samples of the block. Each column holds the change from the sample
+ *          before as a zigzag varint, and runs of unchanged values as a single
+ *          count, so a subnet that did not change during a block costs one byte.
+ *
+ * @class   OccupancyWriter OccupancyLog.h "OccupancyLog.h"
+ */
+class OccupancyWriter
+{
+public:
+    OccupancyWriter();
+    ~OccupancyWriter();
+
+    bool open(const std::string & fileName, const std::vector<std::string> & names,
+              const std::vector<int> & capacities);
+    bool close();
+
+    void append(const OccupancySample & sample);
+
+    long long getSampleCount() const;
+    long long getByteCount() const;
+
+private:
+    void writeBlock();
+
+    std::ofstream file;
+    int subnetCount;
+    int blockSize; //samples in the current block
+
+    //the current block, each subnet's column is OCCUPANCY_BLOCK_SAMPLES long
+    std::vector<long long> times;
+    std::vector<int> queueLengths;
+    std::vector<int> occupancy;
+    std::vector<int> failures;
+
+    //last sample written, the first delta of a block is taken from it
+    long long lastTime;
+    int lastQueueLength;
+    std::vector<int> lastOccupancy;
+    std::vector<int> lastFailures;
+
+    std::vector<unsigned char> buffer; //encoded block
+    long long samples;
+    long long bytes;
+};
+
+
+/**
+ * @brief   Reads back the samples written by OccupancyWriter.
+ *
+ * @class   OccupancyReader OccupancyLog.h "OccupancyLog.h"
+ */
+class OccupancyReader
+{
+public:
+    OccupancyReader();
+    ~OccupancyReader();
+
+    bool open(const std::string & fileName);
+
+    const std::vector<std::string> & getSubnetNames() const;
+    const std::vector<int> & getCapacities() const;
+
+    bool next(OccupancySample & sample);
+
+private:
+    bool readBlock();
+
+    std::ifstream file;
+    std::vector<std::string> names;
+    std::vector<int> capacities;
+    int subnetCount;
+    int blockSize; //samples in the current block
+    int position; //next sample of the current block
+
+    std::vector<long long> times;
+    std::vector<int> queueLengths;
+    std::vector<int> occupancy;
+    std::vector<int> failures;
+
+    long long lastTime;
+    int lastQueueLength;
+    std::vector<int> lastOccupancy;
+    std::vector<int> lastFailures;
+
+    std::vector<unsigned char> buffer;
+};
+
+#endif
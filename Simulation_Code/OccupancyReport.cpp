@@ -0,0 +1,223 @@
+/**
+ * @file    OccupancyReport.cpp
+ *
+ * @brief   Reader for the occupancy samples written by the simulator
+ * @details Prints an occupancy file as CSV, one row per subnet and sample, or
+ *          as a text summary with the busiest subnets and their load over the
+ *          run.
+ *
+ * @author  Andrew Frost, Richard Millar
+ * @version 1.00
+ */
+
+// Header Files ===============================================================
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+#include <algorithm>
+#include <vector>
+#include <string>
+#include "OccupancyLog.h"
+
+#define SUMMARY_COLUMNS 60
+
+// Function Prototypes ========================================================
+bool PrintCSV(const std::string & fileName);
+bool PrintSummary(const std::string & fileName, int rows);
+
+
+// Main Function ==============================================================
+int main(int argc, char * argv[])
+{
+    std::string mode = "summary";
+    int rows = 20;
+
+    if (argc > 2)
+    {
+        mode = argv[2];
+    }
+    if (argc > 3)
+    {
+        rows = std::atoi(argv[3]);
+    }
+
+    if (argc < 2 || (mode != "csv" && mode != "summary") || rows < 1)
+    {
+        std::cout << "Usage: OccupancyReport occupancy-file [csv|summary] [rows]" << std::endl;
+        return -1;
+    }
+
+    if (!(mode == "csv" ? PrintCSV(argv[1]) : PrintSummary(argv[1], rows)))
+    {
+        std::cout << "Error: could not read occupancy file " << argv[1] << "." << std::endl;
+        return -1;
+    }
+
+    return 0;
+}
+
+
+// Functions ==================================================================
+/**
+ * @brief       Print the samples as CSV
+ * @details     One row per sample and subnet, failures are counted from the
+ *              start of the run
+ *
+ * @param[in]   fileName    occupancy file to read
+ */
+bool PrintCSV(const std::string & fileName)
+{
+    OccupancyReader reader;
+    OccupancySample sample;
+    int subnet;
+
+    if (!reader.open(fileName))
+    {
+        return false;
+    }
+
+    const std::vector<std::string> & names = reader.getSubnetNames();
+
+    std::cout << "time_ms,queue_length,subnet,occupancy,road_change_failures" << "\n";
+
+    while (reader.next(sample))
+    {
+        for (subnet = 0; subnet < (int)names.size(); subnet++)
+        {
+            std::cout << sample.timeMS << "," << sample.queueLength << "," << names[subnet] << ","
+                      << sample.occupancy[subnet] << "," << sample.failures[subnet] << "\n";
+        }
+    }
+
+    std::cout.flush();
+
+    return true;
+}
+
+
+/**
+ * @brief       Print a text summary of the samples
+ * @details     Reports the queue length over the run, and for the subnets with
+ *              the highest mean load (occupancy over capacity) their peak and
+ *              failures with a strip of their load over time, from ' ' for an
+ *              empty subnet to '@' for a full one
+ *
+ * @param[in]   fileName    occupancy file to read
+ * @param[in]   rows        number of subnets to list
+ */
+bool PrintSummary(const std::string & fileName, int rows)
+{
+    const char shades[] = " .:-=+*#%@";
+    const int shadeCount = (int)sizeof(shades) - 2;
+
+    OccupancyReader reader;
+    OccupancySample sample;
+    std::vector<double> meanLoad;
+    std::vector<int> peak, order;
+    long long sampleCount = 0, firstTime = 0, lastTime = 0, queueTotal = 0;
+    int queuePeak = 0, subnet, column, subnetCount;
+
+    //first pass for the length of the run, so the strips can be binned
+    if (!reader.open(fileName))
+    {
+        return false;
+    }
+
+    while (reader.next(sample))
+    {
+        if (sampleCount == 0)
+        {
+            firstTime = sample.timeMS;
+        }
+
+        lastTime = sample.timeMS;
+        sampleCount++;
+    }
+
+    const std::vector<std::string> names = reader.getSubnetNames();
+    const std::vector<int> capacities = reader.getCapacities();
+
+    subnetCount = (int)names.size();
+
+    std::cout << "Subnets: " << subnetCount << std::endl;
+    std::cout << "Samples: " << sampleCount << " over " << (lastTime - firstTime) / 1000.0 << " s" << std::endl;
+
+    if (sampleCount == 0)
+    {
+        return true;
+    }
+
+    int columns = (int)std::min<long long>(SUMMARY_COLUMNS, sampleCount);
+    std::vector<double> strips((size_t)subnetCount * columns, 0);
+    std::vector<int> binSamples(columns, 0);
+
+    meanLoad.assign(subnetCount, 0);
+    peak.assign(subnetCount, 0);
+
+    OccupancyReader second;
+    long long index = 0;
+
+    if (!second.open(fileName))
+    {
+        return false;
+    }
+
+    while (second.next(sample))
+    {
+        column = (int)(index * columns / sampleCount);
+        binSamples[column]++;
+        index++;
+
+        queueTotal += sample.queueLength;
+        queuePeak = std::max(queuePeak, sample.queueLength);
+
+        for (subnet = 0; subnet < subnetCount; subnet++)
+        {
+            double load = capacities[subnet] > 0 ? (double)sample.occupancy[subnet] / capacities[subnet] : 0;
+
+            meanLoad[subnet] += load;
+            peak[subnet] = std::max(peak[subnet], sample.occupancy[subnet]);
+            strips[(size_t)subnet * columns + column] += load;
+        }
+    }
+
+    std::cout << "Queue length: mean " << (double)queueTotal / sampleCount << ", max " << queuePeak << std::endl;
+
+    for (subnet = 0; subnet < subnetCount; subnet++)
+    {
+        meanLoad[subnet] /= sampleCount;
+        order.push_back(subnet);
+    }
+
+    rows = std::min(rows, subnetCount);
+
+    std::partial_sort(order.begin(), order.begin() + rows, order.end(), [&meanLoad](int left, int right)
+    {
+        return meanLoad[left] > meanLoad[right];
+    });
+
+    std::cout << std::left << std::setw(24) << "subnet" << std::right << std::setw(9) << "capacity"
+              << std::setw(9) << "mean" << std::setw(6) << "peak" << std::setw(10) << "failures"
+              << "  load over time" << std::endl;
+
+    for (index = 0; index < rows; index++)
+    {
+        std::string strip;
+
+        subnet = order[index];
+
+        for (column = 0; column < columns; column++)
+        {
+            double load = binSamples[column] > 0 ? strips[(size_t)subnet * columns + column] / binSamples[column] : 0;
+
+            strip += shades[std::max(0, std::min(shadeCount, (int)(load * shadeCount + 0.5)))];
+        }
+
+        std::cout << std::left << std::setw(24) << names[subnet] << std::right << std::setw(9) << capacities[subnet]
+                  << std::setw(9) << std::fixed << std::setprecision(2) << meanLoad[subnet] * capacities[subnet]
+                  << std::setw(6) << peak[subnet] << std::setw(10) << sample.failures[subnet]
+                  << "  |" << strip << "|" << std::endl;
+    }
+
+    return true;
+}
@@ -0,0 +1,278 @@
+/**
+ * @file    Partition.cpp
+ *
+ * @brief   Implementation file for the RoadPartition class
+ *
+ * @author  Andrew Frost, Richard Millar
+ * @version 1.00
+ */
+
+// Header Files ===============================================================
+#include "Partition.h"
+#include <algorithm>
+#include <climits>
+#include <deque>
+
+void UndirectedNeighbors(const RoadGraph & graph, std::vector<std::vector<int> > & neighbors);
+
+
+/**
+ * @brief   Default constructor
+ * @details Constructs an empty partition
+ * @note    None
+ */
+RoadPartition::RoadPartition() : regions(), sizes(), ghostRegions(), cutEdges(0)
+{
+
+}
+
+
+/**
+ * @brief   Destructor
+ * @note    None
+ */
+RoadPartition::~RoadPartition()
+{
+
+}
+
+
+/**
+ * @brief       Split the graph into regions
+ * @details     Seeds are picked farthest first: each new seed is the subnet the
+ *              most hops from the seeds so far, and a subnet no seed reaches
+ *              counts as farthest, so every part of a disconnected city gets a
+ *              seed while there are seeds left. Regions then grow one subnet
+ *              at a time, the smallest region taking the next subnet on its
+ *              frontier. Subnets no region reaches join the smallest region.
+ *
+ * @param[in]   graph           graph to split
+ * @param[in]   regionCount     number of regions, at most one per subnet
+ *
+ * @note        None
+ */
+void RoadPartition::build(const RoadGraph & graph, int regionCount)
+{
+    std::vector<std::vector<int> > neighbors;
+    std::vector<std::deque<int> > frontiers;
+    std::vector<int> hops, seeds;
+    std::deque<int> queue;
+    int nodeCount = graph.getNodeCount();
+    int node, region, smallest, farthest, index, edge;
+
+    regionCount = std::max(1, std::min(regionCount, nodeCount));
+
+    regions.assign(nodeCount, -1);
+    sizes.assign(regionCount, 0);
+    ghostRegions.assign(nodeCount, std::vector<int>());
+    cutEdges = 0;
+
+    if (nodeCount == 0)
+    {
+        sizes.clear();
+        return;
+    }
+
+    UndirectedNeighbors(graph, neighbors);
+
+    //farthest first seeds, by hops from the seeds picked so far
+    hops.assign(nodeCount, INT_MAX);
+    farthest = 0;
+
+    while ((int)seeds.size() < regionCount)
+    {
+        seeds.push_back(farthest);
+        hops[farthest] = 0;
+        queue.push_back(farthest);
+
+        while (!queue.empty())
+        {
+            node = queue.front();
+            queue.pop_front();
+
+            for (index = 0; index < (int)neighbors[node].size(); index++)
+            {
+                if (hops[neighbors[node][index]] > hops[node] + 1)
+                {
+                    hops[neighbors[node][index]] = hops[node] + 1;
+                    queue.push_back(neighbors[node][index]);
+                }
+            }
+        }
+
+        for (node = 0; node < nodeCount; node++)
+        {
+            if (hops[node] > hops[farthest])
+            {
+                farthest = node;
+            }
+        }
+    }
+
+    //grow the regions, the smallest one with a frontier goes next
+    frontiers.resize(regionCount);
+
+    for (region = 0; region < regionCount; region++)
+    {
+        regions[seeds[region]] = region;
+        sizes[region] = 1;
+        frontiers[region].assign(neighbors[seeds[region]].begin(), neighbors[seeds[region]].end());
+    }
+
+    while (true)
+    {
+        smallest = -1;
+
+        for (region = 0; region < regionCount; region++)
+        {
+            //drop subnets another region took in the meantime
+            while (!frontiers[region].empty() && regions[frontiers[region].front()] >= 0)
+            {
+                frontiers[region].pop_front();
+            }
+
+            if (!frontiers[region].empty() && (smallest < 0 || sizes[region] < sizes[smallest]))
+            {
+                smallest = region;
+            }
+        }
+
+        if (smallest < 0)
+        {
+            break;
+        }
+
+        node = frontiers[smallest].front();
+        frontiers[smallest].pop_front();
+
+        regions[node] = smallest;
+        sizes[smallest]++;
+
+        for (index = 0; index < (int)neighbors[node].size(); index++)
+        {
+            if (regions[neighbors[node][index]] < 0)
+            {
+                frontiers[smallest].push_back(neighbors[node][index]);
+            }
+        }
+    }
+
+    for (node = 0; node < nodeCount; node++)
+    {
+        if (regions[node] < 0)
+        {
+            region = (int)(std::min_element(sizes.begin(), sizes.end()) - sizes.begin());
+            regions[node] = region;
+            sizes[region]++;
+        }
+    }
+
+    //regions that border each subnet, and the roads that cross between regions
+    for (node = 0; node < nodeCount; node++)
+    {
+        for (index = 0; index < (int)neighbors[node].size(); index++)
+        {
+            region = regions[neighbors[node][index]];
+
+            if (region != regions[node] &&
+                std::find(ghostRegions[node].begin(), ghostRegions[node].end(), region) == ghostRegions[node].end())
+            {
+                ghostRegions[node].push_back(region);
+            }
+        }
+
+        for (edge = graph.offsets[node]; edge < graph.offsets[node + 1]; edge++)
+        {
+            if (regions[graph.targets[edge]] != regions[node])
+            {
+                cutEdges++;
+            }
+        }
+    }
+}
+
+
+/**
+ * @brief   Get the number of regions
+ * @note    None
+ */
+int RoadPartition::getRegionCount() const
+{
+    return (int)sizes.size();
+}
+
+
+/**
+ * @brief       Get the region of a subnet
+ *
+ * @param[in]   node    index of the subnet
+ *
+ * @note        None
+ */
+int RoadPartition::getRegion(int node) const
+{
+    return regions[node];
+}
+
+
+/**
+ * @brief       Get the number of subnets in a region
+ *
+ * @param[in]   region  region to count
+ *
+ * @note        None
+ */
+int RoadPartition::getRegionSize(int region) const
+{
+    return sizes[region];
+}
+
+
+/**
+ * @brief       Get the other regions next to a subnet
+ * @details     Empty unless the subnet is on the boundary of its region
+ *
+ * @param[in]   node    index of the subnet
+ *
+ * @note        None
+ */
+const std::vector<int> & RoadPartition::getGhostRegions(int node) const
+{
+    return ghostRegions[node];
+}
+
+
+/**
+ * @brief   Get the number of roads between regions
+ * @note    None
+ */
+int RoadPartition::getCutEdgeCount() const
+{
+    return cutEdges;
+}
+
+
+/**
+ * @brief       Lists the neighbors of each node in both directions
+ *
+ * @param[in]   graph       graph to read
+ * @param[out]  neighbors   nodes joined to each node by a road either way
+ */
+void UndirectedNeighbors(const RoadGraph & graph, std::vector<std::vector<int> > & neighbors)
+{
+    int node, edge;
+
+    neighbors.assign(graph.getNodeCount(), std::vector<int>());
+
+    for (node = 0; node < graph.getNodeCount(); node++)
+    {
+        for (edge = graph.offsets[node]; edge < graph.offsets[node + 1]; edge++)
+        {
+            if (graph.targets[edge] != node)
+            {
+                neighbors[node].push_back(graph.targets[edge]);
+                neighbors[graph.targets[edge]].push_back(node);
+            }
+        }
+    }
+}
@@ -0,0 +1,50 @@
+/**
+ * @file    Partition.h
+ * @brief   Definition file for the RoadPartition class
+ *
+ * @author  Andrew Frost, Richard Millar
+ * @version 1.00
+ */
+
+// Precompiler Directives =====================================================
+#ifndef PARTITION_H
+#define PARTITION_H
+
+// Header Files ===============================================================
+#include <vector>
+#include "RoadGraph.h"
+
+// Class Definition ===========================================================
+/**
+ * @brief   Split of the city into connected regions of about equal size.
+ * @details Regions are grown by breadth first search from seeds that are far
+ *          apart, one subnet at a time to whichever region is smallest, so
+ *          each region is compact and the roads between regions are few.
+ *          Roads are treated as two way while partitioning. A boundary subnet
+ *          has a road to or from another region; those regions keep a ghost
+ *          copy of its occupancy.
+ *
+ * @class   RoadPartition Partition.h "Partition.h"
+ */
+class RoadPartition
+{
+public:
+    RoadPartition();
+    ~RoadPartition();
+
+    void build(const RoadGraph & graph, int regionCount);
+
+    int getRegionCount() const;
+    int getRegion(int node) const;
+    int getRegionSize(int region) const;
+    const std::vector<int> & getGhostRegions(int node) const;
+    int getCutEdgeCount() const;
+
+private:
+    std::vector<int> regions; //region of each subnet
+    std::vector<int> sizes; //subnets in each region
+    std::vector<std::vector<int> > ghostRegions; //other regions next to each subnet
+    int cutEdges; //roads between regions
+};
+
+#endif
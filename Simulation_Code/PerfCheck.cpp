@@ -0,0 +1,585 @@
+/**
+ * @file    PerfCheck.cpp
+ *
+ * @brief   Performance regression gate for the simulator
+ * @details Runs the simulator over a fixed set of generated grid cities as
+ *          seeded, deterministic runs, reads the metrics each run writes, and
+ *          compares the best of a few runs with a stored baseline. Fails when
+ *          the route throughput drops, or the route latency or peak memory
+ *          grows, by more than a threshold. The simulated length and route
+ *          count of a seeded run never change between runs of the same build,
+ *          so a difference there is reported as a changed outcome.
+ *
+ * @author  Andrew Frost, Richard Millar
+ * @version 1.00
+ */
+
+// Header Files ===============================================================
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <random>
+#include <vector>
+#include <string>
+#include <map>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+#define PERF_DIRECTORY "perf_check"
+#define PERF_SIMULATOR "./SDN"
+#define PERF_REPEATS 3 //runs of each scenario, the best is kept
+#define PERF_THRESHOLD_PERCENT 20.0
+#define PERF_CAPACITY 12 //vehicles an intersection of a scenario city holds
+
+/**
+ * @brief   A generated run of the simulator.
+ */
+struct Scenario
+{
+    const char* name;
+    int width; //intersections along each side of the grid
+    int trips;
+    double rate; //trips per simulated second
+    unsigned int seed;
+    const char* router;
+};
+
+/**
+ * @brief   A metric of a run and whether a larger value is better.
+ */
+struct Metric
+{
+    const char* name;
+    bool higherIsBetter;
+};
+
+typedef std::map<std::string, double> Metrics;
+
+static const Scenario SCENARIOS[] =
+{
+    {"grid20-astar", 20, 6000, 4.0, 11, "astar"},
+    {"grid20-bidirectional", 20, 6000, 4.0, 11, "bidirectional"},
+    {"grid24-hierarchy", 24, 2500, 3.0, 17, "hierarchy"}
+};
+
+static const Metric COMPARED[] =
+{
+    {"routesPerSecond", true},
+    {"latencyP50Ms", false},
+    {"latencyP99Ms", false},
+    {"peakRssKB", false}
+};
+
+static const char* OUTCOME[] = {"simulatedSeconds", "routes"};
+
+// Function Prototypes ========================================================
+bool WriteScenario(const Scenario & scenario, const std::string & fileName, const std::string & metricsFile);
+bool RunScenario(const Scenario & scenario, Metrics & best);
+bool ReadMetrics(const std::string & fileName, Metrics & metrics);
+bool ReadBaseline(const std::string & fileName, std::map<std::string, Metrics> & baseline);
+bool WriteBaseline(const std::string & fileName, const std::vector<std::pair<std::string, Metrics> > & results);
+bool ParseJson(const std::string & text, std::vector<std::pair<std::string, Metrics> > & objects);
+
+
+// Main Function ==============================================================
+int main(int argc, char * argv[])
+{
+    std::vector<std::pair<std::string, Metrics> > results;
+    std::map<std::string, Metrics> baseline;
+    std::string mode = "check";
+    double threshold = PERF_THRESHOLD_PERCENT, change;
+    bool regressed = false, changed;
+    int scenario, metric, outcome;
+
+    if (argc > 2)
+    {
+        mode = argv[2];
+    }
+    if (argc > 3)
+    {
+        threshold = std::atof(argv[3]);
+    }
+
+    if (argc < 2 || (mode != "check" && mode != "record") || threshold <= 0)
+    {
+        std::cout << "Usage: PerfCheck baseline-file [check|record] [threshold-percent]" << std::endl;
+        return -1;
+    }
+
+    if (mode == "check" && !ReadBaseline(argv[1], baseline))
+    {
+        std::cout << "Error: could not read baseline " << argv[1] << ", record one with "
+                  << "PerfCheck " << argv[1] << " record." << std::endl;
+        return -1;
+    }
+
+    mkdir(PERF_DIRECTORY, 0755);
+
+    for (scenario = 0; scenario < (int)(sizeof(SCENARIOS) / sizeof(SCENARIOS[0])); scenario++)
+    {
+        Metrics best;
+
+        std::cout << "Running " << SCENARIOS[scenario].name << "..." << std::endl;
+
+        if (!RunScenario(SCENARIOS[scenario], best))
+        {
+            std::cout << "Error: scenario " << SCENARIOS[scenario].name << " did not run." << std::endl;
+            return -1;
+        }
+
+        results.push_back(std::make_pair(std::string(SCENARIOS[scenario].name), best));
+    }
+
+    if (mode == "record")
+    {
+        if (!WriteBaseline(argv[1], results))
+        {
+            std::cout << "Error: could not write baseline " << argv[1] << "." << std::endl;
+            return -1;
+        }
+
+        std::cout << "Baseline of " << results.size() << " scenarios written to " << argv[1] << "." << std::endl;
+        return 0;
+    }
+
+    std::cout << std::endl << std::left << std::setw(24) << "Scenario" << std::setw(18) << "Metric"
+              << std::right << std::setw(14) << "Baseline" << std::setw(14) << "Now"
+              << std::setw(10) << "Change" << std::endl;
+
+    for (scenario = 0; scenario < (int)results.size(); scenario++)
+    {
+        const std::string & name = results[scenario].first;
+        Metrics & now = results[scenario].second;
+
+        if (baseline.find(name) == baseline.end())
+        {
+            std::cout << std::left << std::setw(24) << name << "not in the baseline" << std::endl;
+            continue;
+        }
+
+        Metrics & before = baseline[name];
+
+        for (metric = 0; metric < (int)(sizeof(COMPARED) / sizeof(COMPARED[0])); metric++)
+        {
+            const Metric & compared = COMPARED[metric];
+
+            if (before.find(compared.name) == before.end() || before[compared.name] <= 0)
+            {
+                continue;
+            }
+
+            change = (now[compared.name] - before[compared.name]) * 100.0 / before[compared.name];
+
+            std::cout << std::left << std::setw(24) << name << std::setw(18) << compared.name << std::right
+                      << std::fixed << std::setprecision(3) << std::setw(14) << before[compared.name]
+                      << std::setw(14) << now[compared.name] << std::setprecision(1) << std::setw(9)
+                      << change << "%";
+
+            if ((compared.higherIsBetter && change < -threshold) || (!compared.higherIsBetter && change > threshold))
+            {
+                std::cout << "  REGRESSED";
+                regressed = true;
+            }
+
+            std::cout << std::endl;
+        }
+
+        changed = false;
+
+        for (outcome = 0; outcome < (int)(sizeof(OUTCOME) / sizeof(OUTCOME[0])); outcome++)
+        {
+            changed = changed || std::abs(now[OUTCOME[outcome]] - before[OUTCOME[outcome]]) > 1e-6;
+        }
+
+        if (changed)
+        {
+            std::cout << "Warning: the outcome of " << name << " changed (" << before["routes"] << " routes in "
+                      << before["simulatedSeconds"] << " s, now " << now["routes"] << " in "
+                      << now["simulatedSeconds"] << " s), record a new baseline if that is intended." << std::endl;
+        }
+    }
+
+    std::cout << std::endl << (regressed ? "Performance regressed" : "Performance within")
+              << " the " << std::setprecision(1) << threshold << "% threshold of " << argv[1] << "." << std::endl;
+
+    return regressed ? 1 : 0;
+}
+
+
+// Functions ==================================================================
+/**
+ * @brief       Write the input file of a scenario
+ * @details     A width x width grid city with roads of 10 to 60 seconds both
+ *              ways, generated trips between uniformly chosen intersections,
+ *              and a seed line so the run is stepped deterministically
+ *
+ * @param[in]   scenario        scenario to write
+ * @param[in]   fileName        input file to write
+ * @param[in]   metricsFile     file the run writes its metrics to
+ */
+bool WriteScenario(const Scenario & scenario, const std::string & fileName, const std::string & metricsFile)
+{
+    std::ofstream file(fileName.c_str());
+    std::mt19937 generator(scenario.width);
+    std::uniform_int_distribution<int> travelTime(10, 60);
+    std::vector<int> right(scenario.width * scenario.width), down(scenario.width * scenario.width);
+    int row, col, index;
+
+    if (!file.is_open())
+    {
+        return false;
+    }
+
+    file << "# generated by PerfCheck" << std::endl;
+    file << "seed " << scenario.seed << std::endl;
+    file << "generate " << scenario.rate << " " << scenario.trips << " " << scenario.seed << std::endl;
+    file << "metrics " << metricsFile << std::endl;
+
+    for (index = 0; index < (int)right.size(); index++)
+    {
+        right[index] = travelTime(generator);
+        down[index] = travelTime(generator);
+    }
+
+    for (row = 0; row < scenario.width; row++)
+    {
+        for (col = 0; col < scenario.width; col++)
+        {
+            index = row * scenario.width + col;
+
+            file << "intersect g" << row << "_" << col << " " << PERF_CAPACITY << std::endl;
+
+            if (row > 0)
+            {
+                file << "neighbor g" << row - 1 << "_" << col << " " << down[index - scenario.width] << std::endl;
+            }
+            if (row + 1 < scenario.width)
+            {
+                file << "neighbor g" << row + 1 << "_" << col << " " << down[index] << std::endl;
+            }
+            if (col > 0)
+            {
+                file << "neighbor g" << row << "_" << col - 1 << " " << right[index - 1] << std::endl;
+            }
+            if (col + 1 < scenario.width)
+            {
+                file << "neighbor g" << row << "_" << col + 1 << " " << right[index] << std::endl;
+            }
+        }
+    }
+
+    return file.good();
+}
+
+
+/**
+ * @brief       Run a scenario a few times
+ * @details     Runs the simulator with its console output discarded and keeps
+ *              the best of each metric over PERF_REPEATS runs, so a busy
+ *              machine during one run does not fail the check. The first run
+ *              also builds the landmarks the later ones load.
+ *
+ * @param[in]   scenario    scenario to run
+ * @param[out]  best        best metrics of the runs
+ */
+bool RunScenario(const Scenario & scenario, Metrics & best)
+{
+    std::string input = std::string(PERF_DIRECTORY) + "/" + scenario.name + ".txt";
+    std::string metricsFile = std::string(PERF_DIRECTORY) + "/" + scenario.name + ".json";
+    Metrics metrics;
+    Metrics::iterator value;
+    int repeat, metric, status, output;
+    pid_t child;
+
+    if (!WriteScenario(scenario, input, metricsFile))
+    {
+        return false;
+    }
+
+    for (repeat = 0; repeat < PERF_REPEATS; repeat++)
+    {
+        std::remove(metricsFile.c_str());
+
+        child = fork();
+
+        if (child < 0)
+        {
+            return false;
+        }
+
+        if (child == 0)
+        {
+            output = open("/dev/null", O_WRONLY);
+            dup2(output, STDOUT_FILENO);
+            execl(PERF_SIMULATOR, PERF_SIMULATOR, input.c_str(), scenario.router, (char*)NULL);
+            _exit(127);
+        }
+
+        if (waitpid(child, &status, 0) != child || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+        {
+            return false;
+        }
+
+        if (!ReadMetrics(metricsFile, metrics))
+        {
+            return false;
+        }
+
+        if (repeat == 0)
+        {
+            best = metrics;
+            continue;
+        }
+
+        for (metric = 0; metric < (int)(sizeof(COMPARED) / sizeof(COMPARED[0])); metric++)
+        {
+            value = best.find(COMPARED[metric].name);
+
+            if (value != best.end())
+            {
+                value->second = COMPARED[metric].higherIsBetter ? std::max(value->second, metrics[value->first])
+                                                                : std::min(value->second, metrics[value->first]);
+            }
+        }
+
+        best["wallSeconds"] = std::min(best["wallSeconds"], metrics["wallSeconds"]);
+    }
+
+    return true;
+}
+
+
+/**
+ * @brief       Read the metrics a run wrote
+ *
+ * @param[in]   fileName    metrics file written by the simulator
+ * @param[out]  metrics     values by name
+ */
+bool ReadMetrics(const std::string & fileName, Metrics & metrics)
+{
+    std::ifstream file(fileName.c_str());
+    std::stringstream text;
+    std::vector<std::pair<std::string, Metrics> > objects;
+
+    if (!file.is_open())
+    {
+        return false;
+    }
+
+    text << file.rdbuf();
+
+    if (!ParseJson(text.str(), objects) || objects.size() != 1)
+    {
+        return false;
+    }
+
+    metrics = objects[0].second;
+
+    return true;
+}
+
+
+/**
+ * @brief       Read a baseline
+ *
+ * @param[in]   fileName    baseline file written by WriteBaseline
+ * @param[out]  baseline    metrics by scenario name
+ */
+bool ReadBaseline(const std::string & fileName, std::map<std::string, Metrics> & baseline)
+{
+    std::ifstream file(fileName.c_str());
+    std::stringstream text;
+    std::vector<std::pair<std::string, Metrics> > objects;
+    int object;
+
+    if (!file.is_open())
+    {
+        return false;
+    }
+
+    text << file.rdbuf();
+
+    if (!ParseJson(text.str(), objects))
+    {
+        return false;
+    }
+
+    for (object = 0; object < (int)objects.size(); object++)
+    {
+        if (!objects[object].first.empty())
+        {
+            baseline[objects[object].first] = objects[object].second;
+        }
+    }
+
+    return !baseline.empty();
+}
+
+
+/**
+ * @brief       Write a baseline
+ * @details     A JSON object with an array of scenarios, each a flat object of
+ *              its name and metrics
+ *
+ * @param[in]   fileName    baseline file to write
+ * @param[in]   results     metrics of each scenario
+ */
+bool WriteBaseline(const std::string & fileName, const std::vector<std::pair<std::string, Metrics> > & results)
+{
+    std::ofstream file(fileName.c_str());
+    Metrics::const_iterator value;
+    int scenario;
+
+    if (!file.is_open())
+    {
+        return false;
+    }
+
+    file << std::fixed << std::setprecision(6) << "{" << std::endl << "    \"scenarios\": [" << std::endl;
+
+    for (scenario = 0; scenario < (int)results.size(); scenario++)
+    {
+        file << "        {" << std::endl << "            \"name\": \"" << results[scenario].first << "\"";
+
+        for (value = results[scenario].second.begin(); value != results[scenario].second.end(); ++value)
+        {
+            file << "," << std::endl << "            \"" << value->first << "\": " << value->second;
+        }
+
+        file << std::endl << "        }" << (scenario + 1 < (int)results.size() ? "," : "") << std::endl;
+    }
+
+    file << "    ]" << std::endl << "}" << std::endl;
+
+    return file.good();
+}
+
+
+/**
+ * @brief       Read the flat objects of a JSON document
+ * @details     Only what the simulator and WriteBaseline write: objects of
+ *              numbers and strings, possibly in an array of an outer object.
+ *              Each innermost object becomes its "name", if it has one, and
+ *              its numbers by key.
+ *
+ * @param[in]   text        JSON text
+ * @param[out]  objects     innermost objects in order
+ *
+ * @note        Returns false on text it does not understand
+ */
+bool ParseJson(const std::string & text, std::vector<std::pair<std::string, Metrics> > & objects)
+{
+    std::vector<std::pair<size_t, bool> > open; //each open object and whether one was opened inside it
+    std::string key, value;
+    size_t at = 0, end;
+    char* parsed;
+    double number;
+
+    while (at < text.size())
+    {
+        char next = text[at];
+
+        if (next == '{')
+        {
+            if (!open.empty())
+            {
+                open.back().second = true;
+            }
+
+            open.push_back(std::make_pair(objects.size(), false));
+            objects.push_back(std::make_pair(std::string(), Metrics()));
+            at++;
+        }
+        else if (next == '}')
+        {
+            if (open.empty())
+            {
+                return false;
+            }
+
+            //only the innermost objects are kept
+            if (open.back().second)
+            {
+                objects.erase(objects.begin() + open.back().first);
+            }
+
+            open.pop_back();
+            at++;
+        }
+        else if (next == '"')
+        {
+            end = text.find('"', at + 1);
+
+            if (end == std::string::npos || open.empty())
+            {
+                return false;
+            }
+
+            key = text.substr(at + 1, end - at - 1);
+            at = text.find_first_not_of(" \t\r\n", end + 1);
+
+            if (at == std::string::npos || text[at] != ':')
+            {
+                return false;
+            }
+
+            at = text.find_first_not_of(" \t\r\n", at + 1);
+
+            if (at == std::string::npos)
+            {
+                return false;
+            }
+
+            if (text[at] == '"')
+            {
+                end = text.find('"', at + 1);
+
+                if (end == std::string::npos)
+                {
+                    return false;
+                }
+
+                value = text.substr(at + 1, end - at - 1);
+                at = end + 1;
+
+                if (key == "name")
+                {
+                    objects[open.back().first].first = value;
+                }
+            }
+            else if (text[at] == '[' || text[at] == '{')
+            {
+                //the objects inside are read as they come
+                if (text[at] == '[')
+                {
+                    at++;
+                }
+            }
+            else
+            {
+                number = std::strtod(text.c_str() + at, &parsed);
+
+                if (parsed == text.c_str() + at)
+                {
+                    return false;
+                }
+
+                objects[open.back().first].second[key] = number;
+                at = parsed - text.c_str();
+            }
+        }
+        else
+        {
+            at++;
+        }
+    }
+
+    return open.empty();
+}
@@ -0,0 +1,593 @@
+/**
+ * @file    Region.cpp
+ *
+ * @brief   Implementation file for the AgentRegion class
+ *
+ * @author  Andrew Frost, Richard Millar
+ * @version 1.00
+ */
+
+// Header Files ===============================================================
+#include "Region.h"
+#include "CentralComputeNode.h"
+
+// Class Implementation =======================================================
+/**
+ * @brief   Default constructor
+ * @note    None
+ */
+SubnetTable::SubnetTable() : names(), capacities(), indices()
+{
+
+}
+
+
+/**
+ * @brief   Destructor
+ * @note    None
+ */
+SubnetTable::~SubnetTable()
+{
+
+}
+
+
+/**
+ * @brief       Fill the table
+ *
+ * @param[in]   newNames        subnet names by index
+ * @param[in]   newCapacities   subnet capacities by index
+ *
+ * @note        None
+ */
+void SubnetTable::build(const std::vector<std::string> & newNames, const std::vector<int> & newCapacities)
+{
+    int subnet;
+
+    names = newNames;
+    capacities = newCapacities;
+    indices.clear();
+
+    for(subnet = 0; subnet < (int)names.size(); subnet++)
+    {
+        indices[names[subnet]] = subnet;
+    }
+}
+
+
+/**
+ * @brief       Get the index of a subnet
+ *
+ * @param[in]   name    name of the subnet
+ *
+ * @note        Returns -1 for an unknown subnet
+ */
+int SubnetTable::find(const std::string & name) const
+{
+    std::unordered_map<std::string, int>::const_iterator subnet = indices.find(name);
+
+    return subnet == indices.end() ? -1 : subnet->second;
+}
+
+
+/**
+ * @brief       AgentRegion constructor
+ *
+ * @param[in]   newIndex        region of the partition this one runs
+ * @param[in]   newPartition    split of the city into regions
+ * @param[in]   newSubnets      names and capacities of the subnets
+ *
+ * @note        None
+ */
+AgentRegion::AgentRegion(int newIndex, const RoadPartition & newPartition, const SubnetTable & newSubnets)
+    : index(newIndex), partition(newPartition), subnets(newSubnets),
+      occupancy(newSubnets.names.size(), 0), inbox(), peers(), notify(),
+      backlog(newPartition.getRegionCount()), notifyPending(newPartition.getRegionCount(), false), mail(false),
+      currentAgent(NULL), decisions(), handoffSubnet(-1), moves(), refusals(),
+      handoffs(0), boundaryRefusals(0), ghostRefusals(0), syncs(0)
+{
+    int region;
+
+    for(region = 0; region < partition.getRegionCount(); region++)
+    {
+        inbox.push_back(std::unique_ptr<HandoffQueue<RegionMessage> >(
+            new HandoffQueue<RegionMessage>(REGION_QUEUE_CAPACITY)));
+    }
+}
+
+
+/**
+ * @brief   Destructor
+ * @note    None
+ */
+AgentRegion::~AgentRegion()
+{
+
+}
+
+
+/**
+ * @brief       Link the region to the others
+ *
+ * @param[in]   newPeers    every region by index, this one included
+ * @param[in]   newNotify   wakes the thread of a region that has been sent
+ *                          messages
+ *
+ * @note        None
+ */
+void AgentRegion::connect(const std::vector<AgentRegion*> & newPeers, const std::function<void(int)> & newNotify)
+{
+    peers = newPeers;
+    notify = newNotify;
+}
+
+
+/**
+ * @brief       Decide a road change
+ * @details     See the class description. A road change into another region
+ *              is not decided here: it returns false and takeHandoff() gives
+ *              the subnet, and the same road change is tried again once the
+ *              other region has decided.
+ *
+ * @param[in]   id          vehicle ID
+ * @param[in]   currentRoad road the vehicle is on, a subnet of this region
+ *                          unless the vehicle was just let in
+ * @param[in]   newRoad     road the vehicle wants to turn onto
+ *
+ * @note        Called by the region's own thread only
+ */
+bool AgentRegion::changeRoad(std::string & id, std::string & currentRoad, std::string & newRoad)
+{
+    std::unordered_map<VehicleAgent*, bool>::iterator decision = decisions.find(currentAgent);
+    int from = subnets.find(currentRoad);
+    int to = subnets.find(newRoad);
+    bool allowed;
+
+    handoffSubnet = -1;
+
+    //decided by the region of newRoad, which has already counted the vehicle in
+    if(decision != decisions.end())
+    {
+        allowed = decision->second;
+        decisions.erase(decision);
+
+        if(allowed)
+        {
+            release(from);
+            moves.push_back(RoadMove());
+            moves.back().id = id;
+            moves.back().from = currentRoad;
+            moves.back().to = newRoad;
+        }
+        else
+        {
+            refusals.push_back(newRoad);
+        }
+
+        return allowed;
+    }
+
+    if(from < 0 || to < 0)
+    {
+        refusals.push_back(newRoad);
+        return false;
+    }
+
+    if(currentRoad == newRoad)
+    {
+        return true;
+    }
+
+    if(partition.getRegion(to) != index)
+    {
+        //the ghost copy can only be behind by the vehicles still on their way
+        if(occupancy[to] >= subnets.capacities[to])
+        {
+            ghostRefusals++;
+            refusals.push_back(newRoad);
+            return false;
+        }
+
+        handoffSubnet = to;
+        return false;
+    }
+
+    if(occupancy[to] >= subnets.capacities[to])
+    {
+        refusals.push_back(newRoad);
+        return false;
+    }
+
+    occupancy[to]++;
+    publish(to);
+    release(from);
+
+    moves.push_back(RoadMove());
+    moves.back().id = id;
+    moves.back().from = currentRoad;
+    moves.back().to = newRoad;
+
+    return true;
+}
+
+
+/**
+ * @brief       Set the agent being resumed
+ * @details     Its road change may have been decided by another region
+ *
+ * @param[in]   agent   agent about to run
+ *
+ * @note        None
+ */
+void AgentRegion::setCurrentAgent(VehicleAgent* agent)
+{
+    currentAgent = agent;
+    handoffSubnet = -1;
+}
+
+
+/**
+ * @brief   Get the subnet the last road change has to ask another region for
+ * @details Returns -1 if the last road change was decided here
+ * @note    None
+ */
+int AgentRegion::takeHandoff()
+{
+    int subnet = handoffSubnet;
+
+    handoffSubnet = -1;
+
+    return subnet;
+}
+
+
+/**
+ * @brief       Count a vehicle joining the network
+ *
+ * @param[in]   subnet  subnet of this region the vehicle joins at
+ *
+ * @note        None
+ */
+void AgentRegion::join(const std::string & subnet)
+{
+    int joined = subnets.find(subnet);
+
+    if(joined >= 0)
+    {
+        occupancy[joined]++;
+        publish(joined);
+    }
+}
+
+
+/**
+ * @brief       Count a vehicle leaving the network
+ *
+ * @param[in]   subnet  subnet of this region the vehicle leaves from
+ *
+ * @note        None
+ */
+void AgentRegion::leave(const std::string & subnet)
+{
+    release(subnets.find(subnet));
+}
+
+
+/**
+ * @brief       Hand an agent to the region of the subnet it wants to enter
+ *
+ * @param[in]   agent   agent to hand over, no longer run by this region
+ * @param[in]   subnet  subnet of the other region
+ *
+ * @note        None
+ */
+void AgentRegion::handoff(VehicleAgent* agent, int subnet)
+{
+    RegionMessage message;
+
+    message.type = REGION_ENTER;
+    message.agent = agent;
+    message.subnet = subnet;
+    message.value = 0;
+
+    handoffs++;
+    send(partition.getRegion(subnet), message);
+}
+
+
+/**
+ * @brief   Check for and clear the flag set when messages are sent here
+ * @note    None
+ */
+bool AgentRegion::checkMail()
+{
+    return mail.exchange(false);
+}
+
+
+/**
+ * @brief       Handle the messages from the other regions
+ *
+ * @param[out]  adopted     agents that now run in this region are appended
+ *
+ * @note        Called by the region's own thread only
+ */
+void AgentRegion::receive(std::vector<VehicleAgent*> & adopted)
+{
+    RegionMessage message, reply;
+    int region;
+
+    mail = false;
+
+    for(region = 0; region < (int)inbox.size(); region++)
+    {
+        while(inbox[region]->pop(message))
+        {
+            switch(message.type)
+            {
+                case REGION_ENTER:
+                    if(occupancy[message.subnet] < subnets.capacities[message.subnet])
+                    {
+                        occupancy[message.subnet]++;
+                        publish(message.subnet);
+                        decisions[message.agent] = true;
+                        adopted.push_back(message.agent);
+                    }
+                    else
+                    {
+                        boundaryRefusals++;
+                        reply.type = REGION_RETURN;
+                        reply.agent = message.agent;
+                        reply.subnet = message.subnet;
+                        reply.value = 0;
+                        send(region, reply);
+                    }
+                    break;
+
+                case REGION_RETURN:
+                    decisions[message.agent] = false;
+                    adopted.push_back(message.agent);
+                    break;
+
+                case REGION_RELEASE:
+                    release(message.subnet);
+                    break;
+
+                case REGION_GHOST:
+                    occupancy[message.subnet] = message.value;
+                    break;
+            }
+        }
+    }
+}
+
+
+/**
+ * @brief   Send the messages waiting for room and wake the regions sent to
+ * @details Returns true if some messages still wait for room
+ * @note    Called without the lock of any scheduler shard
+ */
+bool AgentRegion::deliver()
+{
+    bool waiting = false;
+    int region;
+
+    for(region = 0; region < (int)backlog.size(); region++)
+    {
+        while(!backlog[region].empty() && peers[region]->inbox[index]->push(backlog[region].front()))
+        {
+            backlog[region].pop_front();
+            notifyPending[region] = true;
+        }
+
+        waiting = waiting || !backlog[region].empty();
+
+        if(notifyPending[region])
+        {
+            notifyPending[region] = false;
+            peers[region]->mail = true;
+            notify(region);
+        }
+    }
+
+    return waiting;
+}
+
+
+/**
+ * @brief   Get the number of road changes the Compute Node has yet to hear of
+ * @note    None
+ */
+int AgentRegion::getChangeCount() const
+{
+    return (int)(moves.size() + refusals.size());
+}
+
+
+/**
+ * @brief       Apply the batched road changes to the Compute Node
+ *
+ * @param[in]   ccn     Compute Node to update
+ *
+ * @note        The caller holds the lock of the Compute Node
+ */
+void AgentRegion::flush(CentralComputeNode & ccn)
+{
+    std::vector<RoadMove>::const_iterator move;
+    std::vector<std::string>::const_iterator refusal;
+
+    if(moves.empty() && refusals.empty())
+    {
+        return;
+    }
+
+    for(move = moves.begin(); move != moves.end(); ++move)
+    {
+        ccn.moveVehicle(move->id, move->from, move->to);
+    }
+
+    for(refusal = refusals.begin(); refusal != refusals.end(); ++refusal)
+    {
+        ccn.refuseRoadChange(*refusal);
+    }
+
+    moves.clear();
+    refusals.clear();
+    syncs++;
+}
+
+
+/**
+ * @brief       Take the agents still on their way between regions
+ *
+ * @param[out]  agents  agents in the messages to and from this region
+ *
+ * @note        Only once the scheduler threads have stopped
+ */
+void AgentRegion::takeAgents(std::vector<VehicleAgent*> & agents)
+{
+    RegionMessage message;
+    int region;
+
+    for(region = 0; region < (int)inbox.size(); region++)
+    {
+        while(inbox[region]->pop(message))
+        {
+            if(message.type == REGION_ENTER || message.type == REGION_RETURN)
+            {
+                agents.push_back(message.agent);
+            }
+        }
+
+        while(!backlog[region].empty())
+        {
+            if(backlog[region].front().type == REGION_ENTER || backlog[region].front().type == REGION_RETURN)
+            {
+                agents.push_back(backlog[region].front().agent);
+            }
+
+            backlog[region].pop_front();
+        }
+    }
+}
+
+
+/**
+ * @brief   Get the number of agents handed to other regions
+ * @note    None
+ */
+long long AgentRegion::getHandoffCount() const
+{
+    return handoffs;
+}
+
+
+/**
+ * @brief   Get the number of agents this region refused at its boundary
+ * @note    None
+ */
+long long AgentRegion::getBoundaryRefusalCount() const
+{
+    return boundaryRefusals;
+}
+
+
+/**
+ * @brief   Get the number of road changes refused on a ghost copy
+ * @note    None
+ */
+long long AgentRegion::getGhostRefusalCount() const
+{
+    return ghostRefusals;
+}
+
+
+/**
+ * @brief   Get the number of batches applied to the Compute Node
+ * @note    None
+ */
+long long AgentRegion::getSyncCount() const
+{
+    return syncs;
+}
+
+
+/**
+ * @brief       Queue a message for another region
+ * @details     Goes straight into the region's queue unless messages are
+ *              already waiting for room, so the order is kept
+ *
+ * @param[in]   region      region to send to
+ * @param[in]   message     message to send
+ *
+ * @note        Sent for real by deliver()
+ */
+void AgentRegion::send(int region, const RegionMessage & message)
+{
+    if(!backlog[region].empty() || !peers[region]->inbox[index]->push(message))
+    {
+        backlog[region].push_back(message);
+    }
+    else
+    {
+        notifyPending[region] = true;
+    }
+}
+
+
+/**
+ * @brief       Send the occupancy of a boundary subnet to the regions next to it
+ *
+ * @param[in]   subnet  subnet of this region that changed
+ *
+ * @note        None
+ */
+void AgentRegion::publish(int subnet)
+{
+    const std::vector<int> & ghosts = partition.getGhostRegions(subnet);
+    std::vector<int>::const_iterator region;
+    RegionMessage message;
+
+    message.type = REGION_GHOST;
+    message.agent = NULL;
+    message.subnet = subnet;
+    message.value = occupancy[subnet];
+
+    for(region = ghosts.begin(); region != ghosts.end(); ++region)
+    {
+        send(*region, message);
+    }
+}
+
+
+/**
+ * @brief       Count a vehicle off a subnet
+ * @details     Tells the region of the subnet if it is not this one
+ *
+ * @param[in]   subnet  subnet the vehicle left, or -1
+ *
+ * @note        None
+ */
+void AgentRegion::release(int subnet)
+{
+    RegionMessage message;
+
+    if(subnet < 0)
+    {
+        return;
+    }
+
+    if(partition.getRegion(subnet) == index)
+    {
+        occupancy[subnet]--;
+        publish(subnet);
+        return;
+    }
+
+    message.type = REGION_RELEASE;
+    message.agent = NULL;
+    message.subnet = subnet;
+    message.value = 0;
+
+    send(partition.getRegion(subnet), message);
+}
@@ -0,0 +1,168 @@
+/**
+ * @file    Region.h
+ * @brief   Definition file for the AgentRegion class
+ *
+ * @author  Andrew Frost, Richard Millar
+ * @version 1.00
+ */
+
+// Precompiler Directives =====================================================
+#ifndef REGION_H
+#define REGION_H
+
+// Header Files ===============================================================
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "RoadAuthority.h"
+#include "Partition.h"
+#include "HandoffQueue.h"
+
+#define REGION_QUEUE_CAPACITY 1024
+
+class CentralComputeNode;
+class VehicleAgent;
+
+/**
+ * @brief   Names and capacities of the subnets, shared by all regions.
+ */
+struct SubnetTable
+{
+public:
+    SubnetTable();
+    ~SubnetTable();
+
+    void build(const std::vector<std::string> & newNames, const std::vector<int> & newCapacities);
+    int find(const std::string & name) const;
+
+    std::vector<std::string> names;
+    std::vector<int> capacities;
+    std::unordered_map<std::string, int> indices;
+};
+
+
+/**
+ * @brief   What a message between regions asks for.
+ */
+enum RegionMessageType
+{
+    REGION_ENTER,   //agent wants to turn onto subnet, a subnet of the receiver
+    REGION_RETURN,  //agent was refused by the sender and goes back
+    REGION_RELEASE, //a vehicle left subnet, a subnet of the receiver
+    REGION_GHOST    //occupancy of subnet, a subnet of the sender, is now value
+};
+
+
+/**
+ * @brief   One message between regions.
+ */
+struct RegionMessage
+{
+    RegionMessageType type;
+    VehicleAgent* agent;
+    int subnet;
+    int value;
+};
+
+
+// Class Definition ===========================================================
+/**
+ * @brief   Occupancy and road change authority of one region of the city.
+ * @details Each region is run by one scheduler thread and only that thread
+ *          touches its state, so its road changes take no lock. It counts the
+ *          vehicles on its own subnets and keeps ghost copies of the occupancy
+ *          of the neighbouring regions' boundary subnets, which it is sent
+ *          whenever they change.
+ *
+ *          A vehicle turning onto a subnet of the same region is decided on
+ *          the spot. A vehicle turning into another region is refused at once
+ *          if the ghost copy shows the subnet full, otherwise its agent is
+ *          handed to the other region, which decides with its own count. An
+ *          accepted agent carries on in its new region and the old region is
+ *          told to release the subnet it left, a refused agent is sent back.
+ *          Regions talk through one lock free queue per ordered pair.
+ *
+ *          The Compute Node keeps routing on its own copy of the occupancy.
+ *          Each region batches the moves it allowed and applies them to the
+ *          Compute Node under one lock, instead of one lock per road change.
+ *
+ * @class   AgentRegion Region.h "Region.h"
+ */
+class AgentRegion : public RoadAuthority
+{
+public:
+    AgentRegion(int newIndex, const RoadPartition & newPartition, const SubnetTable & newSubnets);
+    ~AgentRegion();
+
+    void connect(const std::vector<AgentRegion*> & newPeers, const std::function<void(int)> & newNotify);
+
+    bool changeRoad(std::string & id, std::string & currentRoad, std::string & newRoad);
+
+    void setCurrentAgent(VehicleAgent* agent);
+    int takeHandoff();
+
+    void join(const std::string & subnet);
+    void leave(const std::string & subnet);
+    void handoff(VehicleAgent* agent, int subnet);
+
+    bool checkMail();
+    void receive(std::vector<VehicleAgent*> & adopted);
+    bool deliver();
+
+    int getChangeCount() const;
+    void flush(CentralComputeNode & ccn);
+
+    void takeAgents(std::vector<VehicleAgent*> & agents);
+
+    long long getHandoffCount() const;
+    long long getBoundaryRefusalCount() const;
+    long long getGhostRefusalCount() const;
+    long long getSyncCount() const;
+
+private:
+    /**
+     * @brief   A road change the Compute Node has yet to hear of.
+     */
+    struct RoadMove
+    {
+        std::string id;
+        std::string from;
+        std::string to;
+    };
+
+    void send(int region, const RegionMessage & message);
+    void publish(int subnet);
+    void release(int subnet);
+
+    int index;
+    const RoadPartition & partition;
+    const SubnetTable & subnets;
+
+    //own subnets are counted here, others hold ghost copies
+    std::vector<int> occupancy;
+
+    std::vector<std::unique_ptr<HandoffQueue<RegionMessage> > > inbox; //one per sending region
+    std::vector<AgentRegion*> peers;
+    std::function<void(int)> notify;
+    std::vector<std::deque<RegionMessage> > backlog; //by receiver, while its queue is full
+    std::vector<bool> notifyPending; //by receiver
+    std::atomic_bool mail; //a message was sent to this region
+
+    VehicleAgent* currentAgent; //agent being resumed
+    std::unordered_map<VehicleAgent*, bool> decisions; //entries decided by another region
+    int handoffSubnet; //subnet of another region the last road change asked for
+
+    std::vector<RoadMove> moves;
+    std::vector<std::string> refusals;
+
+    long long handoffs;
+    long long boundaryRefusals;
+    long long ghostRefusals;
+    long long syncs;
+};
+
+#endif
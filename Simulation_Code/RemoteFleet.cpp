@@ -0,0 +1,259 @@
+/**
+ * @file    RemoteFleet.cpp
+ *
+ * @brief   Implementation file for the RemoteFleet class
+ *
+ * @author  Andrew Frost, Richard Millar
+ * @version 1.00
+ */
+
+// Header Files ===============================================================
+#include "RemoteFleet.h"
+#include "CentralComputeNode.h"
+
+// Class Implementation =======================================================
+/**
+ * @brief       RemoteFleet constructor
+ *
+ * @param[in]   newCcn  Compute Node the vehicles drive on
+ *
+ * @note        None
+ */
+RemoteFleet::RemoteFleet(CentralComputeNode & newCcn)
+    : ccn(newCcn), remote(), clients(), readyMutex(), ready(), wakeup()
+{
+
+}
+
+
+/**
+ * @brief   RemoteFleet destructor
+ * @note    Call dropAll() first, the Compute Node may still point to the
+ *          stand ins
+ */
+RemoteFleet::~RemoteFleet()
+{
+
+}
+
+
+/**
+ * @brief       Set what is called when a route is queued
+ *
+ * @param[in]   newWakeup   wakes the server, called under the Compute Node's
+ *                          lock so it must not take it
+ *
+ * @note        None
+ */
+void RemoteFleet::setWakeup(const std::function<void()> & newWakeup)
+{
+    wakeup = newWakeup;
+}
+
+
+/**
+ * @brief       Handle one request
+ * @details     A route request joins the vehicle if it is new, and is answered
+ *              through takeRoutes() once the Compute Node has routed it,
+ *              unless it is turned away
+ *
+ * @param[in]   client      client the request came from
+ * @param[in]   request     request to handle
+ * @param[out]  reply       reply to send now
+ *
+ * @note        The caller holds the lock of the Compute Node. Returns false if
+ *              there is no reply to send now.
+ */
+bool RemoteFleet::handle(int client, NetMessage & request, NetMessage & reply)
+{
+    std::unordered_map<std::string, RemoteVehicle>::iterator vehicle = remote.find(request.id);
+    std::unique_ptr<Vehicle> standIn;
+    std::string id = request.id;
+    bool known = vehicle != remote.end() && vehicle->second.client == client;
+    bool success;
+
+    reply.sequence = request.sequence;
+    reply.route.clear();
+
+    switch(request.type)
+    {
+        case NET_ROUTE_REQUEST:
+        {
+            reply.type = NET_ROUTE_RESPONSE;
+
+            if(request.priority < 0 || request.priority >= PRIORITY_COUNT ||
+               ccn.getMapIndex(request.from) < 0 || ccn.getMapIndex(request.to) < 0 ||
+               (vehicle != remote.end() && !known))
+            {
+                reply.status = NET_INVALID;
+                return true;
+            }
+
+            //a new stand in each time, starting where the vehicle is now
+            standIn.reset(new Vehicle(request.id, request.from, request.to));
+            standIn->setPriority((JobPriority)request.priority, request.deadline);
+            standIn->setRouteListener([this, id]()
+            {
+                routeReady(id);
+            });
+
+            RemoteVehicle & entry = remote[request.id];
+
+            entry.client = client;
+            entry.sequence = request.sequence;
+            entry.road = request.from;
+
+            ccn.joinNetwork(standIn.get());
+            entry.vehicle = std::move(standIn);
+            clients[client].insert(request.id);
+
+            if(entry.vehicle->requestRoute(ccn))
+            {
+                //the route is sent when the Compute Node sets it
+                return false;
+            }
+
+            reply.status = NET_REFUSED;
+            return true;
+        }
+
+        case NET_ROAD_CHANGE:
+            reply.type = NET_ROAD_CHANGE_ACK;
+
+            if(!known)
+            {
+                reply.status = NET_INVALID;
+                return true;
+            }
+
+            success = ccn.changeRoad(request.id, request.from, request.to);
+            reply.status = success ? NET_OK : NET_REFUSED;
+
+            if(success)
+            {
+                vehicle->second.road = request.to;
+            }
+            return true;
+
+        case NET_LEAVE:
+            reply.type = NET_LEAVE_ACK;
+
+            if(!known)
+            {
+                reply.status = NET_INVALID;
+                return true;
+            }
+
+            ccn.leaveNetwork(request.id, request.from);
+            clients[client].erase(request.id);
+            remote.erase(vehicle);
+            reply.status = NET_OK;
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+
+/**
+ * @brief       Take the vehicles of a client off the network
+ *
+ * @param[in]   client  client that went away
+ *
+ * @note        The caller holds the lock of the Compute Node
+ */
+void RemoteFleet::dropClient(int client)
+{
+    std::unordered_map<int, std::unordered_set<std::string> >::iterator owned = clients.find(client);
+    std::unordered_set<std::string>::iterator id;
+    std::unordered_map<std::string, RemoteVehicle>::iterator vehicle;
+
+    if(owned == clients.end())
+    {
+        return;
+    }
+
+    for(id = owned->second.begin(); id != owned->second.end(); ++id)
+    {
+        vehicle = remote.find(*id);
+
+        if(vehicle != remote.end())
+        {
+            ccn.leaveNetwork(*id, vehicle->second.road);
+            remote.erase(vehicle);
+        }
+    }
+
+    clients.erase(owned);
+}
+
+
+/**
+ * @brief   Take every remote vehicle off the network
+ * @note    The caller holds the lock of the Compute Node, which only uses the
+ *          stand ins under it
+ */
+void RemoteFleet::dropAll()
+{
+    std::unordered_map<std::string, RemoteVehicle>::iterator vehicle;
+
+    for(vehicle = remote.begin(); vehicle != remote.end(); ++vehicle)
+    {
+        ccn.leaveNetwork(vehicle->first, vehicle->second.road);
+    }
+
+    remote.clear();
+    clients.clear();
+}
+
+
+/**
+ * @brief       Take the routes queued since the last call
+ *
+ * @param[out]  routes  routes to send, the vector is swapped in
+ *
+ * @note        A route may be for a client that has gone since
+ */
+void RemoteFleet::takeRoutes(std::vector<RouteReady> & routes)
+{
+    routes.clear();
+
+    std::lock_guard<std::mutex> guard(readyMutex);
+
+    routes.swap(ready);
+}
+
+
+/**
+ * @brief       Queue the route of a remote vehicle to be sent
+ * @details     The route listener of the stand ins
+ *
+ * @param[in]   id  vehicle that was routed
+ *
+ * @note        Called under the Compute Node's lock and the vehicle's lock, by
+ *              the Compute Node thread or by handle() for a stale route
+ */
+void RemoteFleet::routeReady(const std::string & id)
+{
+    std::unordered_map<std::string, RemoteVehicle>::iterator vehicle = remote.find(id);
+
+    if(vehicle == remote.end() || !vehicle->second.vehicle->hasRoute())
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(readyMutex);
+
+        ready.push_back(RouteReady());
+        ready.back().client = vehicle->second.client;
+        ready.back().sequence = vehicle->second.sequence;
+        ready.back().route = vehicle->second.vehicle->getRoute();
+    }
+
+    if(wakeup)
+    {
+        wakeup();
+    }
+}
@@ -0,0 +1,87 @@
+/**
+ * @file    RemoteFleet.h
+ * @brief   Definition file for the RemoteFleet class
+ *
+ * @author  Andrew Frost, Richard Millar
+ * @version 1.00
+ */
+
+// Precompiler Directives =====================================================
+#ifndef REMOTEFLEET_H
+#define REMOTEFLEET_H
+
+// Header Files ===============================================================
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "NetProtocol.h"
+#include "Vehicle.h"
+
+class CentralComputeNode;
+
+// Class Definition ===========================================================
+/**
+ * @brief   The vehicles of other processes on the Compute Node.
+ * @details Each remote vehicle is stood in for by a Vehicle the Compute Node
+ *          routes like any other, and whose route listener queues the route
+ *          for its client. Requests are the messages of NetProtocol.h whatever
+ *          the transport; a client is any number the server picks, such as a
+ *          socket. A client that goes away takes its vehicles off the network.
+ *
+ * @class   RemoteFleet RemoteFleet.h "RemoteFleet.h"
+ */
+class RemoteFleet
+{
+public:
+    /**
+     * @brief   A route set by the Compute Node, to be sent.
+     */
+    struct RouteReady
+    {
+        int client;
+        unsigned int sequence;
+        std::list<std::pair<std::string, double> > route;
+    };
+
+    RemoteFleet(CentralComputeNode & newCcn);
+    ~RemoteFleet();
+
+    void setWakeup(const std::function<void()> & newWakeup);
+
+    bool handle(int client, NetMessage & request, NetMessage & reply);
+    void dropClient(int client);
+    void dropAll();
+
+    void takeRoutes(std::vector<RouteReady> & routes);
+
+private:
+    /**
+     * @brief   A vehicle of a client on the network.
+     */
+    struct RemoteVehicle
+    {
+        std::unique_ptr<Vehicle> vehicle; //what the Compute Node routes
+        int client;
+        unsigned int sequence; //of the route request being answered
+        std::string road; //road the vehicle was last allowed onto
+    };
+
+    void routeReady(const std::string & id);
+
+    CentralComputeNode & ccn;
+
+    //guarded by the Compute Node's lock
+    std::unordered_map<std::string, RemoteVehicle> remote;
+    std::unordered_map<int, std::unordered_set<std::string> > clients; //vehicles of each client
+
+    std::mutex readyMutex; //taken last, after the Compute Node and vehicle locks
+    std::vector<RouteReady> ready;
+    std::function<void()> wakeup; //tells the server routes are ready
+};
+
+#endif
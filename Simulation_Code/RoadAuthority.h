@@ -0,0 +1,32 @@
+/**
+ * @file    RoadAuthority.h
+ * @brief   Definition file for the RoadAuthority interface
+ *
+ * @author  Andrew Frost, Richard Millar
+ * @version 1.00
+ */
+
+// Precompiler Directives =====================================================
+#ifndef ROADAUTHORITY_H
+#define ROADAUTHORITY_H
+
+// Header Files ===============================================================
+#include <string>
+
+// Class Definition ===========================================================
+/**
+ * @brief   Decides whether a vehicle may turn onto a subnet.
+ * @details The Compute Node decides for the whole city. When the city is split
+ *          into regions, each region decides for its own subnets.
+ *
+ * @class   RoadAuthority RoadAuthority.h "RoadAuthority.h"
+ */
+class RoadAuthority
+{
+public:
+    virtual ~RoadAuthority() {}
+
+    virtual bool changeRoad(std::string & id, std::string & currentRoad, std::string & newRoad) = 0;
+};
+
+#endif
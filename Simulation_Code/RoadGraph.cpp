@@ -0,0 +1,247 @@
+/**
+ * @file    RoadGraph.cpp
+ *
+ * @brief   Implementation file for the RoadGraph structure
+ *
+ * @author  Andrew Frost, Richard Millar
+ * @version 1.00
+ */
+
+// Header Files ===============================================================
+#include "RoadGraph.h"
+#include <algorithm>
+#include <cstring>
+
+#define FNV_OFFSET 14695981039346656037ULL
+#define FNV_PRIME 1099511628211ULL
+
+/**
+ * @brief   Default constructor
+ * @details Constructs an empty graph
+ * @note    None
+ */
+RoadGraph::RoadGraph() : offsets(1, 0), targets(), costs()
+{
+
+}
+
+/**
+ * @brief   Default destructor
+ * @details Destroys a RoadGraph object
+ * @note    None
+ */
+RoadGraph::~RoadGraph()
+{
+
+}
+
+
+/**
+ * @brief       Builds the adjacency lists from a matrix
+ * @details     Every positive entry of the matrix becomes a road, zero and
+ *              negative entries mean same subnet or not a neighbor.
+ *
+ * @param[in]   matrix  adjacency matrix of travel times
+ *
+ * @note        None
+ */
+void RoadGraph::buildFromMatrix(const std::vector<std::vector<double> > & matrix)
+{
+    unsigned int row, col;
+
+    offsets.assign(1, 0);
+    targets.clear();
+    costs.clear();
+
+    for (row = 0; row < matrix.size(); row++)
+    {
+        for (col = 0; col < matrix[row].size(); col++)
+        {
+            //same or not a neighbor
+            if (matrix[row][col] <= 0)
+            {
+                continue;
+            }
+
+            targets.push_back((int)col);
+            costs.push_back(matrix[row][col]);
+        }
+
+        offsets.push_back((int)targets.size());
+    }
+}
+
+
+/**
+ * @brief   Reverses every road
+ * @details Returns a graph where a road from a to b becomes a road from b to a,
+ *          used for searches that run backwards from a destination
+ * @note    None
+ */
+RoadGraph RoadGraph::reversed() const
+{
+    RoadGraph reverse;
+    std::vector<int> fill;
+    int node, edge, nodeCount = getNodeCount();
+
+    reverse.offsets.assign(nodeCount + 1, 0);
+    reverse.targets.resize(targets.size());
+    reverse.costs.resize(costs.size());
+
+    for (edge = 0; edge < getEdgeCount(); edge++)
+    {
+        reverse.offsets[targets[edge] + 1]++;
+    }
+
+    for (node = 0; node < nodeCount; node++)
+    {
+        reverse.offsets[node + 1] += reverse.offsets[node];
+    }
+
+    fill.assign(reverse.offsets.begin(), reverse.offsets.end() - 1);
+
+    for (node = 0; node < nodeCount; node++)
+    {
+        for (edge = offsets[node]; edge < offsets[node + 1]; edge++)
+        {
+            reverse.targets[fill[targets[edge]]] = node;
+            reverse.costs[fill[targets[edge]]] = costs[edge];
+            fill[targets[edge]]++;
+        }
+    }
+
+    return reverse;
+}
+
+
+/**
+ * @brief       Renumbers the subnets
+ * @details     Returns the same roads with subnet i moved to newIndex[i]. The
+ *              roads leaving each subnet are sorted by their new target, so a
+ *              search reads the labels of the neighbors in order.
+ *
+ * @param[in]   newIndex    new index of every subnet, a permutation
+ *
+ * @note        None
+ */
+RoadGraph RoadGraph::renumbered(const std::vector<int> & newIndex) const
+{
+    RoadGraph result;
+    std::vector<int> oldIndex(getNodeCount());
+    std::vector<std::pair<int, double> > roads;
+    int node, edge;
+    unsigned int road;
+
+    for (node = 0; node < getNodeCount(); node++)
+    {
+        oldIndex[newIndex[node]] = node;
+    }
+
+    result.targets.reserve(targets.size());
+    result.costs.reserve(costs.size());
+
+    for (node = 0; node < getNodeCount(); node++)
+    {
+        roads.clear();
+
+        for (edge = offsets[oldIndex[node]]; edge < offsets[oldIndex[node] + 1]; edge++)
+        {
+            roads.push_back(std::make_pair(newIndex[targets[edge]], costs[edge]));
+        }
+
+        //stable, so parallel roads keep their order
+        std::stable_sort(roads.begin(), roads.end(), [](const std::pair<int, double> & left,
+                                                         const std::pair<int, double> & right)
+        {
+            return left.first < right.first;
+        });
+
+        for (road = 0; road < roads.size(); road++)
+        {
+            result.targets.push_back(roads[road].first);
+            result.costs.push_back(roads[road].second);
+        }
+
+        result.offsets.push_back((int)result.targets.size());
+    }
+
+    return result;
+}
+
+
+/**
+ * @brief       Get the travel time of a road
+ * @details     Returns the cost of the cheapest road from one subnet to another,
+ *              or -1 if they are not neighbors
+ *
+ * @param[in]   from    subnet index the road starts at
+ * @param[in]   to      subnet index the road ends at
+ *
+ * @note        None
+ */
+double RoadGraph::getCost(int from, int to) const
+{
+    double cost = -1;
+    int edge;
+
+    for (edge = offsets[from]; edge < offsets[from + 1]; edge++)
+    {
+        if (targets[edge] == to && (cost < 0 || costs[edge] < cost))
+        {
+            cost = costs[edge];
+        }
+    }
+
+    return cost;
+}
+
+
+/**
+ * @brief   Get the node count
+ * @details Returns the number of subnets in the graph
+ * @note    None
+ */
+int RoadGraph::getNodeCount() const
+{
+    return (int)offsets.size() - 1;
+}
+
+
+/**
+ * @brief   Get the edge count
+ * @details Returns the number of roads in the graph
+ * @note    None
+ */
+int RoadGraph::getEdgeCount() const
+{
+    return (int)targets.size();
+}
+
+
+/**
+ * @brief   Get the checksum of the graph
+ * @details Returns an FNV-1a hash of the adjacency lists, used to tell whether
+ *          preprocessed data was built for this exact graph
+ * @note    None
+ */
+unsigned long long RoadGraph::getChecksum() const
+{
+    unsigned long long hash = FNV_OFFSET;
+    unsigned long long bits;
+    unsigned int index;
+
+    for (index = 0; index < offsets.size(); index++)
+    {
+        hash = (hash ^ (unsigned long long)offsets[index]) * FNV_PRIME;
+    }
+
+    for (index = 0; index < targets.size(); index++)
+    {
+        std::memcpy(&bits, &costs[index], sizeof(bits));
+
+        hash = (hash ^ (unsigned long long)targets[index]) * FNV_PRIME;
+        hash = (hash ^ bits) * FNV_PRIME;
+    }
+
+    return hash;
+}
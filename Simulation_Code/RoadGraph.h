@@ -0,0 +1,45 @@
+/**
+ * @file    RoadGraph.h
+ * @brief   Definition file for the RoadGraph structure
+ *
+ * @author  Andrew Frost, Richard Millar
+ * @version 1.00
+ */
+
+// Precompiler Directives =====================================================
+#ifndef ROADGRAPH_H
+#define ROADGRAPH_H
+
+// Header Files ===============================================================
+#include <vector>
+
+/**
+ * @brief   Compressed adjacency lists of the city.
+ * @details The roads leaving subnet i are targets[offsets[i]] to
+ *          targets[offsets[i + 1] - 1], with the travel time of each road in
+ *          costs. Built from the adjacency matrix handed to the Compute Node.
+ */
+struct RoadGraph
+{
+public:
+    RoadGraph();
+    ~RoadGraph();
+
+    void buildFromMatrix(const std::vector<std::vector<double> > & matrix);
+
+    RoadGraph reversed() const;
+    RoadGraph renumbered(const std::vector<int> & newIndex) const;
+
+    double getCost(int from, int to) const;
+
+    int getNodeCount() const;
+    int getEdgeCount() const;
+
+    unsigned long long getChecksum() const;
+
+    std::vector<int> offsets;
+    std::vector<int> targets;
+    std::vector<double> costs;
+};
+
+#endif
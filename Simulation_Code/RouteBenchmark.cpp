@@ -0,0 +1,868 @@
+/**
+ * @file    RouteBenchmark.cpp
+ *
+ * @brief   Routing benchmark for the CentralComputeNode
+ * @details Builds a square grid city, answers a fixed set of random route
+ *          queries and reports the query rate, settled nodes and the number of
+ *          heap allocations made per query. The federation router instead
+ *          splits the city into more and more regions and reports how the
+ *          route throughput and latency scale, and the assign router solves a
+ *          traffic assignment of a demand matrix over the grid.
+ *
+ * @author  Andrew Frost, Richard Millar
+ * @version 1.00
+ */
+
+// Header Files ===============================================================
+#include <iostream>
+#include <sstream>
+#include <cstdlib>
+#include <chrono>
+#include <atomic>
+#include <new>
+#include <random>
+#include <thread>
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <cmath>
+#include <algorithm>
+#include <iomanip>
+#include "CentralComputeNode.h"
+#include "Federation.h"
+#include "TrafficAssignment.h"
+
+#define OCCUPANCY_BENCH_SAMPLES 64
+#define FEDERATION_BENCH_MAX_REGIONS 16
+#define FEDERATION_BENCH_STRETCH_QUERIES 200
+#define FEDERATION_BENCH_EXCHANGE_MS 50
+#define ROAD_UPDATE_BENCH 10000
+#define ROUTE_CACHE_BENCH 2000 //vehicles routed to fill the stale route cache
+#define ASSIGN_BENCH_ITERATIONS 20
+#define ASSIGN_BENCH_GAP 0.0001
+#define ASSIGN_BENCH_CAPACITY 4 //capacity of every grid subnet
+
+// Allocation Counting ========================================================
+static std::atomic<long long> allocationCount(0);
+
+void* operator new(std::size_t size)
+{
+    void* memory;
+
+    allocationCount++;
+
+    memory = std::malloc(size == 0 ? 1 : size);
+
+    if (memory == NULL)
+    {
+        throw std::bad_alloc();
+    }
+
+    return memory;
+}
+
+void operator delete(void* memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
+
+// Function Prototypes ========================================================
+void BuildGridCity(CentralComputeNode & ccn, int width, bool shuffled);
+double MeanIndexGap(const RoadGraph & graph);
+std::string GridName(int row, int col);
+void BenchFederation(CentralComputeNode & ccn, const std::vector<std::pair<std::string, std::string> > & pairs,
+                     int threadCount);
+void BenchAssignment(CentralComputeNode & ccn, int width, long long pairCount, unsigned int seed, int threadCount);
+double RouteCost(const Route & route);
+
+
+// Main Function ==============================================================
+int main(int argc, char * argv[])
+{
+    CentralComputeNode ccn;
+    Route route;
+
+    int width = 40, queries = 2000, warmup = 50, landmarkCount = 0;
+    int threadCount = std::max(1, (int)std::thread::hardware_concurrency());
+    std::string router = "astar", costName = "linear", orderName = "rcm";
+    unsigned int seed = 400;
+
+    long long allocations, routeNodes = 0, settled = 0;
+    long long startAllocations;
+    int index, nodeCount;
+
+    std::vector<std::pair<std::string, std::string> > pairs;
+
+    if (argc > 1)
+    {
+        width = std::atoi(argv[1]);
+    }
+    if (argc > 2)
+    {
+        queries = std::atoi(argv[2]);
+    }
+    if (argc > 3)
+    {
+        seed = (unsigned)std::atoi(argv[3]);
+    }
+    if (argc > 4)
+    {
+        landmarkCount = std::atoi(argv[4]);
+    }
+    if (argc > 5)
+    {
+        router = argv[5];
+    }
+    if (argc > 6)
+    {
+        threadCount = std::atoi(argv[6]);
+    }
+    if (argc > 7)
+    {
+        costName = argv[7];
+    }
+    if (argc > 8)
+    {
+        orderName = argv[8];
+    }
+
+    if (width < 2 || queries < 1 || threadCount < 1 ||
+        (router != "astar" && router != "bidirectional" && router != "hierarchy" && router != "allpairs" &&
+         router != "federation" && router != "assign") ||
+        (costName != "free" && costName != "linear" && costName != "bpr" && costName != "capacity") ||
+        (orderName != "input" && orderName != "shuffled" && orderName != "bfs" && orderName != "rcm"))
+    {
+        std::cout << "Usage: RouteBench [grid width] [queries] [seed] [landmarks] "
+                  << "[astar|bidirectional|hierarchy|allpairs|federation|assign] [threads] "
+                  << "[free|linear|bpr|capacity] [input|shuffled|bfs|rcm]" << std::endl;
+        return -1;
+    }
+
+    //input keeps the grid numbered row by row, shuffled numbers it at random
+    //like an input file listing the intersections in any order, and bfs and
+    //rcm renumber the shuffled grid
+    if (orderName == "bfs")
+    {
+        ccn.setNodeOrder(ORDER_BFS);
+    }
+    else if (orderName == "input" || orderName == "shuffled")
+    {
+        ccn.setNodeOrder(ORDER_INPUT);
+    }
+
+    BuildGridCity(ccn, width, orderName != "input");
+    nodeCount = width * width;
+
+    std::cout << "Node order: " << orderName << ", mean index gap per road "
+              << MeanIndexGap(ccn.getRoadGraph()) << std::endl;
+
+    //queries is the number of origin and destination pairs of the demand
+    if (router == "assign")
+    {
+        BenchAssignment(ccn, width, queries, seed, threadCount);
+        return 0;
+    }
+
+    if (landmarkCount > 0)
+    {
+        std::chrono::time_point<std::chrono::steady_clock> buildStart = std::chrono::steady_clock::now();
+
+        ccn.buildLandmarks(landmarkCount, LANDMARKS_AVOID, (int)std::thread::hardware_concurrency());
+
+        std::chrono::duration<double> buildTime = std::chrono::steady_clock::now() - buildStart;
+
+        std::cout << "Landmarks: " << landmarkCount << " built in " << buildTime.count() << " s" << std::endl;
+    }
+
+    if (router == "hierarchy")
+    {
+        ccn.setRoutingAlgorithm(ROUTE_HIERARCHY);
+    }
+    else if (router == "bidirectional")
+    {
+        ccn.setRoutingAlgorithm(ROUTE_BIDIRECTIONAL);
+    }
+    else if (router == "allpairs")
+    {
+        ccn.setRoutingAlgorithm(ROUTE_ALL_PAIRS);
+    }
+
+    if (costName == "free")
+    {
+        ccn.setCostModel(COST_FREE_FLOW);
+    }
+    else if (costName == "bpr")
+    {
+        ccn.setCostModel(COST_BPR);
+    }
+    else if (costName == "capacity")
+    {
+        ccn.setCostModel(COST_CAPACITY);
+    }
+
+    std::mt19937 generator(seed);
+    std::uniform_int_distribution<int> pick(0, nodeCount - 1);
+
+    for (index = 0; index < queries + warmup; index++)
+    {
+        int from = pick(generator), to = pick(generator);
+
+        pairs.push_back(std::make_pair(GridName(from / width, from % width),
+                                       GridName(to / width, to % width)));
+    }
+
+    if (router == "federation")
+    {
+        BenchFederation(ccn, pairs, threadCount);
+        return 0;
+    }
+
+    //let the search context grow to the size of the graph, the first query
+    //also builds the hierarchy or the table when it is used
+    std::chrono::time_point<std::chrono::steady_clock> warmupStart = std::chrono::steady_clock::now();
+
+    for (index = 0; index < warmup; index++)
+    {
+        route.start = pairs[index].first;
+        route.dest = pairs[index].second;
+        ccn.computeRoute(route);
+    }
+
+    std::chrono::duration<double> warmupTime = std::chrono::steady_clock::now() - warmupStart;
+
+    std::cout << "Warmup (includes preprocessing): " << warmupTime.count() << " s" << std::endl;
+
+    startAllocations = allocationCount;
+    std::chrono::time_point<std::chrono::steady_clock> begin = std::chrono::steady_clock::now();
+
+    for (index = warmup; index < queries + warmup; index++)
+    {
+        route.start = pairs[index].first;
+        route.dest = pairs[index].second;
+        route.route.clear();
+
+        ccn.computeRoute(route);
+
+        routeNodes += (long long)route.route.size();
+        settled += ccn.getSettledNodeCount();
+    }
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+    allocations = allocationCount - startAllocations;
+
+    std::cout << "Grid: " << width << "x" << width << " (" << nodeCount << " subnets)" << std::endl;
+    std::cout << "Queries: " << queries << " (" << costName << " cost)" << std::endl;
+    std::cout << "Time per query: " << elapsed.count() * 1000.0 / queries << " ms" << std::endl;
+    std::cout << "Queries per second: " << queries / elapsed.count() << std::endl;
+    std::cout << "Settled nodes per query: " << (double)settled / queries << std::endl;
+    std::cout << "Settled nodes per second: " << settled / elapsed.count() << std::endl;
+    std::cout << "Allocations per query: " << (double)allocations / queries << std::endl;
+    std::cout << "Allocations per query excluding returned route: "
+              << (double)(allocations - routeNodes) / queries << std::endl;
+
+    if (router == "hierarchy")
+    {
+        //a vehicle joining changes the occupancy, so with an interval of one
+        //move the next query re-customizes
+        Vehicle car("bench", pairs[0].first, pairs[0].second);
+
+        ccn.setCustomizationInterval(1);
+        ccn.joinNetwork(&car);
+
+        begin = std::chrono::steady_clock::now();
+        route.start = pairs[0].first;
+        route.dest = pairs[0].second;
+        ccn.computeRoute(route);
+        elapsed = std::chrono::steady_clock::now() - begin;
+
+        std::cout << "Re-customization and query: " << elapsed.count() * 1000.0 << " ms" << std::endl;
+
+        ccn.leaveNetwork(car.getID(), car.getSource());
+        ccn.setCustomizationInterval(0);
+    }
+
+    //live road updates, each road is closed, slowed down, reopened and restored
+    const RoadGraph & graph = ccn.getRoadGraph();
+    std::mt19937 roadGenerator(seed);
+    std::vector<std::string> subnetNames;
+    std::vector<int> subnetCapacities;
+    std::string from, to;
+    double travelTime;
+    int edge, updates = 0;
+
+    ccn.getSubnets(subnetNames, subnetCapacities);
+
+    begin = std::chrono::steady_clock::now();
+
+    for (index = 0; index < ROAD_UPDATE_BENCH; index++)
+    {
+        int node = pick(roadGenerator);
+
+        edge = graph.offsets[node];
+        from = subnetNames[node];
+        to = subnetNames[graph.targets[edge]];
+        travelTime = graph.costs[edge];
+
+        ccn.closeRoad(from, to);
+        ccn.setRoadTime(from, to, travelTime * 2);
+        ccn.openRoad(from, to);
+        ccn.setRoadTime(from, to, travelTime);
+        updates += 4;
+    }
+
+    elapsed = std::chrono::steady_clock::now() - begin;
+
+    std::cout << "Road updates: " << elapsed.count() * 1000000.0 / updates << " us per update, graph version "
+              << ccn.getGraphVersion() << std::endl;
+
+    //the same updates with the stale route cache filled, each only visits the
+    //cached routes over its road
+    std::vector<Vehicle> cachedCars;
+    std::atomic_bool cacheRunning(true);
+    int cachedCount = std::min((int)pairs.size(), ROUTE_CACHE_BENCH);
+
+    ccn.setAdmissionControl(0, ADMIT_STALE_ROUTE);
+    cachedCars.reserve(cachedCount);
+
+    for (index = 0; index < cachedCount; index++)
+    {
+        cachedCars.push_back(Vehicle("cached" + std::to_string(index), pairs[index].first, pairs[index].second));
+        ccn.joinNetwork(&cachedCars.back());
+        cachedCars.back().requestRoute(ccn);
+    }
+
+    for (index = 0; index < cachedCount; index++)
+    {
+        ccn.directTraffic(cacheRunning);
+    }
+
+    updates = 0;
+    begin = std::chrono::steady_clock::now();
+
+    for (index = 0; index < ROAD_UPDATE_BENCH; index++)
+    {
+        int node = pick(roadGenerator);
+
+        edge = graph.offsets[node];
+        from = subnetNames[node];
+        to = subnetNames[graph.targets[edge]];
+        travelTime = graph.costs[edge];
+
+        ccn.setRoadTime(from, to, travelTime * 2);
+        ccn.setRoadTime(from, to, travelTime);
+        updates += 2;
+    }
+
+    elapsed = std::chrono::steady_clock::now() - begin;
+
+    std::cout << "Road updates after caching " << cachedCount << " routes: "
+              << elapsed.count() * 1000000.0 / updates << " us per update" << std::endl;
+
+    for (index = 0; index < cachedCount; index++)
+    {
+        ccn.leaveNetwork(cachedCars[index].getID(), cachedCars[index].getSource());
+    }
+
+    ccn.setAdmissionControl(0, ADMIT_REJECT);
+
+    //closing the first road of a route, the next query has to catch up and avoid it
+    route.start = pairs[0].first;
+    route.dest = pairs[0].second;
+    route.route.clear();
+    ccn.computeRoute(route);
+
+    if (route.route.size() > 1)
+    {
+        from = route.route.front().first;
+        to = (++route.route.begin())->first;
+
+        ccn.closeRoad(from, to);
+
+        begin = std::chrono::steady_clock::now();
+        route.route.clear();
+        ccn.computeRoute(route);
+        elapsed = std::chrono::steady_clock::now() - begin;
+
+        std::cout << "Query after a road closure: " << elapsed.count() * 1000.0 << " ms, closed road "
+                  << (route.route.size() > 1 && (++route.route.begin())->first == to ? "used" : "avoided")
+                  << std::endl;
+
+        ccn.openRoad(from, to);
+    }
+
+    //closing the roads into a corner cuts it off, a vehicle bound there must
+    //not hold up the vehicle queued behind it
+    if (width > 2)
+    {
+        Vehicle cutOff("cutoff", GridName(width - 1, width - 1), GridName(0, 0));
+        Vehicle behind("behind", GridName(width - 1, width - 1), GridName(1, 1));
+        std::atomic_bool running(true);
+
+        ccn.joinNetwork(&cutOff);
+        ccn.joinNetwork(&behind);
+
+        ccn.closeRoad(GridName(0, 1), GridName(0, 0));
+        ccn.closeRoad(GridName(1, 0), GridName(0, 0));
+
+        cutOff.requestRoute(ccn);
+        behind.requestRoute(ccn);
+
+        begin = std::chrono::steady_clock::now();
+        ccn.directTraffic(running);
+        ccn.directTraffic(running);
+        elapsed = std::chrono::steady_clock::now() - begin;
+
+        std::cout << "Cut off destination: " << elapsed.count() * 1000.0 << " ms for two passes, "
+                  << ccn.getAdmissionStats().stranded << " stranded, vehicle behind "
+                  << (behind.hasRoute() ? "routed" : "blocked");
+
+        ccn.openRoad(GridName(0, 1), GridName(0, 0));
+        ccn.directTraffic(running);
+
+        std::cout << ", " << (cutOff.hasRoute() ? "routed" : "still stranded") << " after reopening" << std::endl;
+
+        ccn.leaveNetwork(cutOff.getID(), cutOff.getSource());
+        ccn.leaveNetwork(behind.getID(), behind.getSource());
+        ccn.openRoad(GridName(1, 0), GridName(0, 0));
+    }
+
+    //cost of sampling the whole city, one vehicle joins between samples
+    OccupancyWriter occupancyWriter;
+    OccupancySample sample;
+    std::vector<std::string> names;
+    std::vector<int> capacities;
+    std::vector<Vehicle> cars;
+    std::chrono::duration<double> copyTime(0), encodeTime(0);
+
+    ccn.getSubnets(names, capacities);
+    cars.reserve(OCCUPANCY_BENCH_SAMPLES);
+
+    if (occupancyWriter.open("RouteBench.occ", names, capacities))
+    {
+        for (index = 0; index < OCCUPANCY_BENCH_SAMPLES; index++)
+        {
+            std::ostringstream id;
+            id << "sample" << index;
+
+            cars.push_back(Vehicle(id.str(), pairs[index % pairs.size()].first, pairs[index % pairs.size()].second));
+            ccn.joinNetwork(&cars.back());
+
+            begin = std::chrono::steady_clock::now();
+            ccn.sampleOccupancy(sample);
+            std::chrono::time_point<std::chrono::steady_clock> copied = std::chrono::steady_clock::now();
+            occupancyWriter.append(sample);
+
+            copyTime += copied - begin;
+            encodeTime += std::chrono::steady_clock::now() - copied;
+        }
+
+        occupancyWriter.close();
+        std::remove("RouteBench.occ");
+
+        std::cout << "Occupancy sample: " << copyTime.count() * 1000.0 / OCCUPANCY_BENCH_SAMPLES << " ms copy, "
+                  << encodeTime.count() * 1000.0 / OCCUPANCY_BENCH_SAMPLES << " ms encoding, "
+                  << (double)occupancyWriter.getByteCount() / OCCUPANCY_BENCH_SAMPLES << " bytes per sample" << std::endl;
+
+        for (index = 0; index < (int)cars.size(); index++)
+        {
+            ccn.leaveNetwork(cars[index].getID(), cars[index].getSource());
+        }
+    }
+
+    return 0;
+}
+
+
+// Functions ==================================================================
+/**
+ * @brief       Build a grid city
+ * @details     Creates width x width intersections, each connected to its four
+ *              neighbors with a travel time between 10 and 60 seconds. The
+ *              compute node renumbers them as set by its node order.
+ *
+ * @param[in]   ccn         compute node to load the city into
+ * @param[in]   width       number of intersections along each side
+ * @param[in]   shuffled    number the intersections at random instead of row
+ *                          by row
+ */
+void BuildGridCity(CentralComputeNode & ccn, int width, bool shuffled)
+{
+    std::vector<std::string> names, shuffledNames;
+    std::vector<int> newIndex;
+    RoadGraph graph;
+    std::mt19937 generator(width);
+    std::uniform_int_distribution<int> travelTime(10, 60);
+
+    int row, col, index, nodeCount = width * width;
+    std::vector<double> right(nodeCount, -1), down(nodeCount, -1);
+
+    for (index = 0; index < nodeCount; index++)
+    {
+        names.push_back(GridName(index / width, index % width));
+    }
+
+    for (row = 0; row < width; row++)
+    {
+        for (col = 0; col < width; col++)
+        {
+            index = row * width + col;
+
+            if (col + 1 < width)
+            {
+                right[index] = travelTime(generator);
+            }
+            if (row + 1 < width)
+            {
+                down[index] = travelTime(generator);
+            }
+        }
+    }
+
+    //every road is two way, with the same travel time in both directions
+    graph.offsets.assign(1, 0);
+
+    for (index = 0; index < nodeCount; index++)
+    {
+        row = index / width;
+        col = index % width;
+
+        if (row > 0)
+        {
+            graph.targets.push_back(index - width);
+            graph.costs.push_back(down[index - width]);
+        }
+        if (col > 0)
+        {
+            graph.targets.push_back(index - 1);
+            graph.costs.push_back(right[index - 1]);
+        }
+        if (col + 1 < width)
+        {
+            graph.targets.push_back(index + 1);
+            graph.costs.push_back(right[index]);
+        }
+        if (row + 1 < width)
+        {
+            graph.targets.push_back(index + width);
+            graph.costs.push_back(down[index]);
+        }
+
+        graph.offsets.push_back((int)graph.targets.size());
+    }
+
+    if (shuffled)
+    {
+        std::mt19937 shuffler(width);
+
+        for (index = 0; index < nodeCount; index++)
+        {
+            newIndex.push_back(index);
+        }
+
+        std::shuffle(newIndex.begin(), newIndex.end(), shuffler);
+
+        graph = graph.renumbered(newIndex);
+        shuffledNames.resize(nodeCount);
+
+        for (index = 0; index < nodeCount; index++)
+        {
+            shuffledNames[newIndex[index]] = names[index];
+        }
+
+        names.swap(shuffledNames);
+    }
+
+    ccn.buildSubnetToIndexTable(names);
+
+    for (index = 0; index < nodeCount; index++)
+    {
+        ccn.setSubnetProperties(names[index], ASSIGN_BENCH_CAPACITY);
+    }
+
+    ccn.setMap(graph);
+}
+
+
+/**
+ * @brief       Mean index gap of the roads
+ * @details     Average distance between the indices of the two ends of a road,
+ *              small when neighbors are stored close together
+ *
+ * @param[in]   graph   road graph
+ */
+double MeanIndexGap(const RoadGraph & graph)
+{
+    double total = 0;
+    int node, edge;
+
+    for (node = 0; node < graph.getNodeCount(); node++)
+    {
+        for (edge = graph.offsets[node]; edge < graph.offsets[node + 1]; edge++)
+        {
+            total += std::abs(graph.targets[edge] - node);
+        }
+    }
+
+    return graph.getEdgeCount() > 0 ? total / graph.getEdgeCount() : 0;
+}
+
+
+/**
+ * @brief       Name of a grid intersection
+ * @details     Returns the subnet ID of the intersection at row, col
+ *
+ * @param[in]   row     row of the intersection
+ * @param[in]   col     column of the intersection
+ */
+std::string GridName(int row, int col)
+{
+    std::stringstream name;
+
+    name << "g" << row << "_" << col;
+
+    return name.str();
+}
+
+
+/**
+ * @brief       Federation scaling benchmark
+ * @details     Splits the city into 1, 2, 4, ... regions. For each split it
+ *              checks the stitched routes against the single Compute Node,
+ *              then answers every query from a pool of threads while the
+ *              regions exchange their summaries in the background, and
+ *              reports the throughput and latency
+ *
+ * @param[in]   ccn             compute node holding the whole city
+ * @param[in]   pairs           start and destination of each query
+ * @param[in]   threadCount     threads asking for routes
+ */
+void BenchFederation(CentralComputeNode & ccn, const std::vector<std::pair<std::string, std::string> > & pairs,
+                     int threadCount)
+{
+    std::vector<std::vector<double> > latencies(threadCount);
+    std::vector<std::thread> threads;
+    std::vector<double> merged;
+    double stretch;
+    int regionCount, index, checked;
+
+    std::cout << "Federation: " << pairs.size() << " queries from " << threadCount << " threads, exchange every "
+              << FEDERATION_BENCH_EXCHANGE_MS << " ms" << std::endl;
+    std::cout << std::setw(8) << "Regions" << std::setw(10) << "Boundary" << std::setw(10) << "Overlay"
+              << std::setw(10) << "Build ms" << std::setw(13) << "Exchange ms" << std::setw(12) << "Queries/s"
+              << std::setw(10) << "p50 ms" << std::setw(10) << "p99 ms" << std::setw(10) << "Stitched"
+              << std::setw(10) << "Stretch" << std::endl;
+
+    for (regionCount = 1; regionCount <= FEDERATION_BENCH_MAX_REGIONS; regionCount *= 2)
+    {
+        CcnFederation federation;
+
+        std::chrono::time_point<std::chrono::steady_clock> buildStart = std::chrono::steady_clock::now();
+
+        federation.build(ccn, regionCount, ROUTE_ASTAR);
+
+        std::chrono::duration<double> buildTime = std::chrono::steady_clock::now() - buildStart;
+
+        //stitched routes should cost what the whole city's best route does
+        stretch = 0;
+        checked = 0;
+
+        for (index = 0; index < (int)pairs.size() && index < FEDERATION_BENCH_STRETCH_QUERIES; index++)
+        {
+            Route whole, stitched;
+
+            whole.start = stitched.start = pairs[index].first;
+            whole.dest = stitched.dest = pairs[index].second;
+
+            if (ccn.computeRoute(whole) && federation.computeRoute(stitched) && RouteCost(whole) > 0)
+            {
+                stretch += RouteCost(stitched) / RouteCost(whole);
+                checked++;
+            }
+        }
+
+        federation.startExchange(FEDERATION_BENCH_EXCHANGE_MS);
+        threads.clear();
+
+        std::chrono::time_point<std::chrono::steady_clock> begin = std::chrono::steady_clock::now();
+
+        for (index = 0; index < threadCount; index++)
+        {
+            threads.push_back(std::thread([&federation, &pairs, &latencies, index, threadCount]()
+            {
+                Route route;
+                int query;
+
+                latencies[index].clear();
+
+                for (query = index; query < (int)pairs.size(); query += threadCount)
+                {
+                    std::chrono::time_point<std::chrono::steady_clock> asked = std::chrono::steady_clock::now();
+
+                    route.start = pairs[query].first;
+                    route.dest = pairs[query].second;
+                    route.route.clear();
+
+                    federation.computeRoute(route);
+
+                    latencies[index].push_back(
+                        std::chrono::duration<double>(std::chrono::steady_clock::now() - asked).count());
+                }
+            }));
+        }
+
+        for (index = 0; index < threadCount; index++)
+        {
+            threads[index].join();
+        }
+
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+
+        federation.stopExchange();
+
+        merged.clear();
+
+        for (index = 0; index < threadCount; index++)
+        {
+            merged.insert(merged.end(), latencies[index].begin(), latencies[index].end());
+        }
+
+        std::sort(merged.begin(), merged.end());
+
+        FederationStats stats = federation.getStats();
+
+        std::cout << std::setw(8) << federation.getRegionCount() << std::setw(10) << federation.getBoundaryCount()
+                  << std::setw(10) << federation.getOverlayRoadCount()
+                  << std::setw(10) << std::fixed << std::setprecision(2) << buildTime.count() * 1000.0
+                  << std::setw(13) << (stats.exchanges > 0 ? stats.exchangeSeconds * 1000.0 / stats.exchanges : 0)
+                  << std::setw(12) << std::setprecision(0) << merged.size() / elapsed.count()
+                  << std::setw(10) << std::setprecision(3) << merged[merged.size() / 2] * 1000.0
+                  << std::setw(10) << merged[merged.size() * 99 / 100] * 1000.0
+                  << std::setw(10) << stats.stitchedRoutes
+                  << std::setw(10) << std::setprecision(4) << (checked > 0 ? stretch / checked : 0) << std::endl;
+        std::cout.unsetf(std::ios_base::floatfield);
+    }
+}
+
+
+/**
+ * @brief       Free flow cost of a route
+ *
+ * @param[in]   route   route to add up
+ */
+double RouteCost(const Route & route)
+{
+    std::list<std::pair<std::string, double> >::const_iterator step;
+    double cost = 0;
+
+    for (step = route.route.begin(); step != route.route.end(); ++step)
+    {
+        cost += step->second;
+    }
+
+    return cost;
+}
+
+
+/**
+ * @brief       Traffic assignment benchmark
+ * @details     Draws about the square root of pairCount zones among the grid
+ *              intersections and demand between pairCount pairs of them, as a
+ *              planning model joins its trips at zone centroids. The volumes
+ *              are scaled so the average subnet is loaded close to its
+ *              capacity. Reports the time of each Frank-Wolfe iteration and the
+ *              relative gap reached.
+ *
+ * @param[in]   ccn             compute node holding the grid
+ * @param[in]   width           width of the grid
+ * @param[in]   pairCount       origin and destination pairs of the demand
+ * @param[in]   seed            seed of the zones and the volumes
+ * @param[in]   threadCount     threads running the searches
+ */
+void BenchAssignment(CentralComputeNode & ccn, int width, long long pairCount, unsigned int seed, int threadCount)
+{
+    const int nodeCount = width * width;
+
+    TrafficAssignment assignment;
+    std::vector<std::string> names;
+    std::vector<int> capacities, zones;
+    std::mt19937 generator(seed);
+    std::uniform_int_distribution<int> pickNode(0, nodeCount - 1);
+    std::uniform_real_distribution<double> spread(0.5, 1.5);
+    double volume;
+    long long pair;
+    int zoneCount, index, overCapacity = 0;
+
+    zoneCount = std::min(nodeCount, std::max(2, (int)std::ceil(std::sqrt((double)pairCount)) + 1));
+
+    //distinct zones, so that every pair fits in the matrix
+    for (index = 0; index < nodeCount; index++)
+    {
+        zones.push_back(index);
+    }
+
+    std::shuffle(zones.begin(), zones.end(), generator);
+    zones.resize(zoneCount);
+
+    //a trip crosses about two thirds of the width of the grid
+    volume = (double)ASSIGN_BENCH_CAPACITY * nodeCount / (pairCount * (2.0 * width / 3.0));
+
+    std::chrono::time_point<std::chrono::steady_clock> setupStart = std::chrono::steady_clock::now();
+
+    ccn.getSubnets(names, capacities);
+    assignment.setNetwork(ccn.getRoadGraph(), capacities);
+
+    for (pair = 0; pair < pairCount; pair++)
+    {
+        //every zone sends to the next ones in turn
+        int origin = (int)(pair % zoneCount);
+        int destination = (int)((origin + 1 + pair / zoneCount) % zoneCount);
+
+        if (destination == origin)
+        {
+            destination = (destination + 1) % zoneCount;
+        }
+
+        assignment.addDemand(zones[origin], zones[destination], volume * spread(generator));
+    }
+
+    std::chrono::duration<double> setupTime = std::chrono::steady_clock::now() - setupStart;
+
+    std::cout << "Grid: " << width << "x" << width << " (" << nodeCount << " subnets)" << std::endl;
+    std::cout << "Assignment: " << assignment.getPairCount() << " pairs between " << zoneCount << " zones, "
+              << assignment.getOriginCount() << " origins, " << threadCount << " threads" << std::endl;
+    std::cout << "Setup: " << setupTime.count() << " s" << std::endl;
+
+    assignment.setProgressListener([](const AssignmentIteration & iteration)
+    {
+        std::cout << "  iteration " << iteration.iteration << ": relative gap " << std::scientific
+                  << std::setprecision(3) << iteration.relativeGap << std::fixed << ", step "
+                  << iteration.step << ", " << iteration.seconds << " s" << std::endl;
+    });
+
+    std::chrono::time_point<std::chrono::steady_clock> begin = std::chrono::steady_clock::now();
+
+    assignment.solve(ASSIGN_BENCH_ITERATIONS, ASSIGN_BENCH_GAP, threadCount);
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+
+    for (index = 0; index < nodeCount; index++)
+    {
+        if (assignment.getVolumeRatio(index) > 1)
+        {
+            overCapacity++;
+        }
+    }
+
+    std::cout << std::defaultfloat;
+    std::cout << "Iterations: " << assignment.getIterations().size() << ", relative gap "
+              << assignment.getRelativeGap() << std::endl;
+    std::cout << "Time: " << elapsed.count() << " s, "
+              << elapsed.count() / std::max<size_t>(1, assignment.getIterations().size()) << " s per iteration"
+              << std::endl;
+    std::cout << "Subnets over capacity: " << overCapacity << std::endl;
+}
@@ -0,0 +1,394 @@
+/**
+ * @file    RouteSearch.h
+ * @brief   Definition file for the shortest path searches of the Compute Node
+ *
+ * @author  Andrew Frost, Richard Millar
+ * @version 1.00
+ */
+
+// Precompiler Directives =====================================================
+#ifndef ROUTESEARCH_H
+#define ROUTESEARCH_H
+
+// Header Files ===============================================================
+#include <vector>
+#include "CostModel.h"
+#include "Landmarks.h"
+#include "SearchContext.h"
+
+/*
+ * The searches are templates over the graph and the cost model. The graph has
+ * compressed adjacency lists like RoadGraph: getNodeCount(), and the roads
+ * leaving node i are targets[offsets[i]] to targets[offsets[i + 1] - 1] with
+ * their travel times in costs. The cost model is one of the policies of
+ * CostModel.h. Each instantiation is compiled with its cost inlined into the
+ * relaxation loop, the Compute Node picks the instantiation once per query.
+ */
+
+// Function Prototypes ========================================================
+template<typename Graph, typename Cost>
+bool AStarSearch(const Graph & graph, const Cost & cost, const LandmarkTable & landmarks,
+                 SearchContext & context, int start, int dest);
+
+template<typename Graph, typename Cost>
+int BidirectionalSearch(const Graph & graph, const Graph & reverse, const Cost & cost,
+                        const LandmarkTable & landmarks, SearchContext & forward, SearchContext & backward,
+                        int start, int dest);
+
+template<typename Graph, typename Cost>
+void ExpandBidirectional(const Graph & graph, const Cost & cost, const LandmarkTable & landmarks,
+                         SearchContext & context, const SearchContext & other, bool backward,
+                         int start, int dest, double & best, int & meet);
+
+template<typename Graph, typename Cost>
+void DijkstraSearch(const Graph & graph, const Cost & cost, SearchContext & context, int start,
+                    std::vector<double> & distances);
+
+template<typename Graph, typename Cost>
+void FillRoadCosts(const Graph & graph, const Cost & cost, std::vector<double> & costs);
+
+inline double AveragePotential(const LandmarkTable & landmarks, int node, int start, int dest);
+
+
+// Template Implementation ====================================================
+/**
+ * @brief       A* search
+ * @details     Searches from start until dest is settled. The heuristic is the
+ *              landmark lower bound on the free flow travel time, which no cost
+ *              model goes below, so it stays admissible.
+ *
+ * @param[in]   graph       road graph
+ * @param[in]   cost        cost model of the roads
+ * @param[in]   landmarks   lower bounds for the heuristic, may be empty
+ * @param[out]  context     search context, holds the parents on success
+ * @param[in]   start       index of the start node
+ * @param[in]   dest        index of the destination node
+ *
+ * @note        Returns false if dest can't be reached
+ */
+template<typename Graph, typename Cost>
+bool AStarSearch(const Graph & graph, const Cost & cost, const LandmarkTable & landmarks,
+                 SearchContext & context, int start, int dest)
+{
+    const bool informed = !landmarks.isEmpty();
+
+    int current, neighbor, edge;
+
+    double key, heuristic, tentativeGScore;
+
+    //initialize tables
+    context.prepare(graph.getNodeCount());
+
+    context.relax(start, 0, -1);
+    context.push(start, 0);
+
+    while (context.pop(current, key))
+    {
+        //stale entry of a node that was already evaluated
+        if (context.isSettled(current))
+        {
+            continue;
+        }
+
+        if (current == dest)
+        {
+            return true;
+        }
+
+        context.settle(current);
+
+        for (edge = graph.offsets[current]; edge < graph.offsets[current + 1]; edge++)
+        {
+            neighbor = graph.targets[edge];
+
+            //if already evaluated
+            if (context.isSettled(neighbor))
+            {
+                continue;
+            }
+
+            tentativeGScore = context.getGScore(current) + cost(current, neighbor, graph.costs[edge]);
+
+            if (tentativeGScore >= context.getGScore(neighbor))
+            {
+                continue;
+            }
+
+            heuristic = informed ? landmarks.lowerBound(neighbor, dest) : 0;
+
+            //the landmarks prove dest can't be reached from here
+            if (heuristic >= SEARCH_INFINITY)
+            {
+                continue;
+            }
+
+            context.relax(neighbor, tentativeGScore, current);
+
+            context.push(neighbor, tentativeGScore + heuristic);
+        }
+    }
+
+    return false;
+}
+
+
+/**
+ * @brief       Bidirectional search
+ * @details     Searches forward from the start and backward from the
+ *              destination, always expanding the side with the smaller key.
+ *              Every road that connects the two searches is a candidate route,
+ *              and the search stops once the two smallest keys together can't
+ *              beat the best candidate. With landmarks both sides use the
+ *              average of the forward and backward lower bounds as potential,
+ *              which keeps the same stopping rule valid.
+ *
+ * @param[in]   graph       road graph
+ * @param[in]   reverse     graph with every road reversed
+ * @param[in]   cost        cost model of the roads of graph
+ * @param[in]   landmarks   lower bounds for the potentials, may be empty
+ * @param[out]  forward     context of the side from start
+ * @param[out]  backward    context of the side from dest
+ * @param[in]   start       index of the start node
+ * @param[in]   dest        index of the destination node
+ *
+ * @note        Returns the node where the two sides meet, the parents of
+ *              forward lead from it to start and those of backward to dest,
+ *              or -1 if dest can't be reached
+ */
+template<typename Graph, typename Cost>
+int BidirectionalSearch(const Graph & graph, const Graph & reverse, const Cost & cost,
+                        const LandmarkTable & landmarks, SearchContext & forward, SearchContext & backward,
+                        int start, int dest)
+{
+    const ReversedCost<Cost> reversedCost(cost);
+
+    int meet = -1;
+
+    double best = SEARCH_INFINITY;
+
+    //initialize tables
+    forward.prepare(graph.getNodeCount());
+    backward.prepare(graph.getNodeCount());
+
+    forward.relax(start, 0, -1);
+    forward.push(start, AveragePotential(landmarks, start, start, dest));
+
+    backward.relax(dest, 0, -1);
+    backward.push(dest, -AveragePotential(landmarks, dest, start, dest));
+
+    if (start == dest)
+    {
+        best = 0;
+        meet = start;
+    }
+
+    while (!forward.isOpenEmpty() && !backward.isOpenEmpty()
+        && forward.getTopKey() + backward.getTopKey() < best)
+    {
+        if (forward.getTopKey() <= backward.getTopKey())
+        {
+            ExpandBidirectional(graph, cost, landmarks, forward, backward, false, start, dest, best, meet);
+        }
+        else
+        {
+            ExpandBidirectional(reverse, reversedCost, landmarks, backward, forward, true, start, dest, best, meet);
+        }
+    }
+
+    return meet;
+}
+
+
+/**
+ * @brief       Expands one side of a bidirectional search
+ * @details     Settles the cheapest node of the given side and relaxes its
+ *              roads, checking each reached node against the other side for a
+ *              shorter connection.
+ *
+ * @param[in]   graph       graph of the side, reversed for the backward side
+ * @param[in]   cost        cost model of the roads of that graph
+ * @param[in]   landmarks   lower bounds for the potentials, may be empty
+ * @param[in]   context     search context of the side to expand
+ * @param[in]   other       search context of the opposite side
+ * @param[in]   backward    true when expanding the side that started at dest
+ * @param[in]   start       index of the start node
+ * @param[in]   dest        index of the destination node
+ * @param[out]  best        cost of the best connection found so far
+ * @param[out]  meet        node where the best connection joins the two sides
+ *
+ * @note        None
+ */
+template<typename Graph, typename Cost>
+void ExpandBidirectional(const Graph & graph, const Cost & cost, const LandmarkTable & landmarks,
+                         SearchContext & context, const SearchContext & other, bool backward,
+                         int start, int dest, double & best, int & meet)
+{
+    int current, neighbor, edge;
+
+    double key, potential, tentativeGScore;
+
+    if (!context.pop(current, key) || context.isSettled(current))
+    {
+        return;
+    }
+
+    context.settle(current);
+
+    for (edge = graph.offsets[current]; edge < graph.offsets[current + 1]; edge++)
+    {
+        neighbor = graph.targets[edge];
+
+        if (context.isSettled(neighbor))
+        {
+            continue;
+        }
+
+        tentativeGScore = context.getGScore(current) + cost(current, neighbor, graph.costs[edge]);
+
+        if (tentativeGScore >= context.getGScore(neighbor))
+        {
+            continue;
+        }
+
+        potential = AveragePotential(landmarks, neighbor, start, dest);
+
+        //the landmarks prove neighbor is not on any route from start to dest
+        if (potential >= SEARCH_INFINITY)
+        {
+            continue;
+        }
+
+        context.relax(neighbor, tentativeGScore, current);
+
+        context.push(neighbor, tentativeGScore + (backward ? -potential : potential));
+
+        if (other.isReached(neighbor) && tentativeGScore + other.getGScore(neighbor) < best)
+        {
+            best = tentativeGScore + other.getGScore(neighbor);
+            meet = neighbor;
+        }
+    }
+}
+
+
+/**
+ * @brief       Dijkstra search of the whole graph
+ * @details     Settles every node that can be reached from start
+ *
+ * @param[in]   graph       road graph
+ * @param[in]   cost        cost model of the roads
+ * @param[out]  context     search context, holds the parents
+ * @param[in]   start       index of the start node
+ * @param[out]  distances   cost by node index, SEARCH_INFINITY if unreachable
+ *
+ * @note        None
+ */
+template<typename Graph, typename Cost>
+void DijkstraSearch(const Graph & graph, const Cost & cost, SearchContext & context, int start,
+                    std::vector<double> & distances)
+{
+    int current, neighbor, edge;
+
+    double key, tentativeGScore;
+
+    distances.assign(graph.getNodeCount(), SEARCH_INFINITY);
+
+    context.prepare(graph.getNodeCount());
+
+    context.relax(start, 0, -1);
+    context.push(start, 0);
+
+    while (context.pop(current, key))
+    {
+        if (context.isSettled(current))
+        {
+            continue;
+        }
+
+        context.settle(current);
+        distances[current] = key;
+
+        for (edge = graph.offsets[current]; edge < graph.offsets[current + 1]; edge++)
+        {
+            neighbor = graph.targets[edge];
+
+            if (context.isSettled(neighbor))
+            {
+                continue;
+            }
+
+            tentativeGScore = key + cost(current, neighbor, graph.costs[edge]);
+
+            if (tentativeGScore < context.getGScore(neighbor))
+            {
+                context.relax(neighbor, tentativeGScore, current);
+                context.push(neighbor, tentativeGScore);
+            }
+        }
+    }
+}
+
+
+/**
+ * @brief       Cost of every road
+ * @details     Fills costs with the cost model of each road of the graph, in
+ *              the order of graph.targets
+ *
+ * @param[in]   graph   road graph
+ * @param[in]   cost    cost model of the roads
+ * @param[out]  costs   cost of every road
+ *
+ * @note        None
+ */
+template<typename Graph, typename Cost>
+void FillRoadCosts(const Graph & graph, const Cost & cost, std::vector<double> & costs)
+{
+    int node, edge;
+
+    costs.resize(graph.getEdgeCount());
+
+    for (node = 0; node < graph.getNodeCount(); node++)
+    {
+        for (edge = graph.offsets[node]; edge < graph.offsets[node + 1]; edge++)
+        {
+            costs[edge] = cost(node, graph.targets[edge], graph.costs[edge]);
+        }
+    }
+}
+
+
+/**
+ * @brief       Average potential of a node
+ * @details     Half the difference of the landmark bound to dest and the bound
+ *              from start. The forward side adds it to its keys and the backward
+ *              side subtracts it, so both sides stay consistent.
+ *
+ * @param[in]   landmarks   lower bounds, may be empty
+ * @param[in]   node        index of the node
+ * @param[in]   start       index of the start node
+ * @param[in]   dest        index of the destination node
+ *
+ * @note        Returns 0 without landmarks and SEARCH_INFINITY when the node
+ *              can't be on a route from start to dest.
+ */
+inline double AveragePotential(const LandmarkTable & landmarks, int node, int start, int dest)
+{
+    double toDest, fromStart;
+
+    if (landmarks.isEmpty())
+    {
+        return 0;
+    }
+
+    toDest = landmarks.lowerBound(node, dest);
+    fromStart = landmarks.lowerBound(start, node);
+
+    if (toDest >= SEARCH_INFINITY || fromStart >= SEARCH_INFINITY)
+    {
+        return SEARCH_INFINITY;
+    }
+
+    return (toDest - fromStart) / 2;
+}
+
+#endif
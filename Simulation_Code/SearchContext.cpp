@@ -0,0 +1,454 @@
+/**
+ * @file    SearchContext.cpp
+ *
+ * @brief   Implementation file for the MonotonicArena and SearchContext classes
+ *
+ * @author  Andrew Frost, Richard Millar
+ * @version 1.00
+ */
+
+// Header Files ===============================================================
+#include "SearchContext.h"
+#include <algorithm>
+#include <cstring>
+
+#define ARENA_MIN_BLOCK 4096
+#define HEAP_MIN_CAPACITY 64
+
+
+// MonotonicArena Implementation ==============================================
+/**
+ * @brief   Default constructor.
+ * @details Constructs an empty arena, no memory is reserved until needed
+ * @note    None
+ */
+MonotonicArena::MonotonicArena() : blocks(), blockSizes(), offset(0), capacity(0)
+{
+
+}
+
+/**
+ * @brief   Default destructor.
+ * @details Releases every block owned by the arena
+ * @note    None
+ */
+MonotonicArena::~MonotonicArena()
+{
+    releaseBlocks();
+}
+
+
+/**
+ * @brief       Allocates memory from the arena
+ * @details     Bumps the offset of the active block, adding a new block when
+ *              the request does not fit.
+ *
+ * @param[in]   bytes       size of the request
+ * @param[in]   alignment   required alignment, must be a power of two
+ *
+ * @note        None
+ */
+void* MonotonicArena::allocate(std::size_t bytes, std::size_t alignment)
+{
+    std::size_t aligned;
+
+    if (!blocks.empty())
+    {
+        aligned = (offset + alignment - 1) & ~(alignment - 1);
+
+        if (aligned + bytes <= blockSizes.back())
+        {
+            offset = aligned + bytes;
+            return blocks.back() + aligned;
+        }
+    }
+
+    addBlock(std::max(bytes + alignment, std::max((std::size_t)ARENA_MIN_BLOCK, capacity)));
+
+    aligned = (offset + alignment - 1) & ~(alignment - 1);
+    offset = aligned + bytes;
+
+    return blocks.back() + aligned;
+}
+
+
+/**
+ * @brief   Releases every allocation at once
+ * @details If the last use spilled over into several blocks they are merged
+ *          into one block large enough for all of them.
+ * @note    Pointers handed out before the reset become invalid.
+ */
+void MonotonicArena::reset()
+{
+    std::size_t total = capacity;
+
+    if (blocks.size() > 1)
+    {
+        releaseBlocks();
+        addBlock(total);
+    }
+
+    offset = 0;
+}
+
+
+/**
+ * @brief   Get the arena capacity
+ * @details Returns the number of bytes owned by the arena
+ * @note    None
+ */
+std::size_t MonotonicArena::getCapacity() const
+{
+    return capacity;
+}
+
+
+/**
+ * @brief       Adds a block to the arena
+ * @details     The new block becomes the active block.
+ *
+ * @param[in]   bytes   size of the block
+ *
+ * @note        None
+ */
+void MonotonicArena::addBlock(std::size_t bytes)
+{
+    blocks.push_back(new char[bytes]);
+    blockSizes.push_back(bytes);
+    capacity += bytes;
+    offset = 0;
+}
+
+
+/**
+ * @brief   Frees every block
+ * @details Returns all memory owned by the arena to the heap
+ * @note    None
+ */
+void MonotonicArena::releaseBlocks()
+{
+    unsigned int index;
+
+    for (index = 0; index < blocks.size(); index++)
+    {
+        delete [] blocks[index];
+    }
+
+    blocks.clear();
+    blockSizes.clear();
+    capacity = 0;
+    offset = 0;
+}
+
+
+// SearchContext Implementation ===============================================
+/**
+ * @brief   Default constructor.
+ * @details Constructs an empty search context
+ * @note    None
+ */
+SearchContext::SearchContext()
+    : reachedGeneration(),
+    settledGeneration(),
+    gScores(),
+    parents(),
+    generation(0),
+    heap(NULL),
+    heapSize(0),
+    heapCapacity(0),
+    settledCount(0),
+    arena()
+{
+
+}
+
+/**
+ * @brief   Default destructor.
+ * @details Destroys a SearchContext object
+ * @note    None
+ */
+SearchContext::~SearchContext()
+{
+
+}
+
+
+/**
+ * @brief       Starts a new query
+ * @details     Invalidates all labels of the previous query by advancing the
+ *              generation and empties the open list. The label arrays only
+ *              grow when the graph has grown since the last query.
+ *
+ * @param[in]   nodeCount   number of subnets in the graph
+ *
+ * @note        None
+ */
+void SearchContext::prepare(int nodeCount)
+{
+    if (reachedGeneration.size() < (unsigned)nodeCount)
+    {
+        reachedGeneration.resize(nodeCount, 0);
+        settledGeneration.resize(nodeCount, 0);
+        gScores.resize(nodeCount, SEARCH_INFINITY);
+        parents.resize(nodeCount, -1);
+    }
+
+    generation++;
+
+    //on wrap around old labels could look current again
+    if (generation == 0)
+    {
+        std::fill(reachedGeneration.begin(), reachedGeneration.end(), 0);
+        std::fill(settledGeneration.begin(), settledGeneration.end(), 0);
+        generation = 1;
+    }
+
+    arena.reset();
+
+    heapCapacity = std::max((std::size_t)HEAP_MIN_CAPACITY, heapCapacity);
+    heap = arena.allocateArray<OpenEntry>(heapCapacity);
+    heapSize = 0;
+
+    settledCount = 0;
+}
+
+
+/**
+ * @brief       Shows whether a node has a label
+ * @details     Returns whether the node was reached during the current query
+ *
+ * @param[in]   node    subnet index
+ *
+ * @note        None
+ */
+bool SearchContext::isReached(int node) const
+{
+    return reachedGeneration[node] == generation;
+}
+
+
+/**
+ * @brief       Shows whether a node is settled
+ * @details     Returns whether the node was removed from the open list
+ *
+ * @param[in]   node    subnet index
+ *
+ * @note        None
+ */
+bool SearchContext::isSettled(int node) const
+{
+    return settledGeneration[node] == generation;
+}
+
+
+/**
+ * @brief       Get the g-score of a node
+ * @details     Returns the best known cost to the node, or SEARCH_INFINITY
+ *
+ * @param[in]   node    subnet index
+ *
+ * @note        None
+ */
+double SearchContext::getGScore(int node) const
+{
+    if (!isReached(node))
+    {
+        return SEARCH_INFINITY;
+    }
+
+    return gScores[node];
+}
+
+
+/**
+ * @brief       Get the parent of a node
+ * @details     Returns the node the best known path came from, or -1
+ *
+ * @param[in]   node    subnet index
+ *
+ * @note        None
+ */
+int SearchContext::getParent(int node) const
+{
+    if (!isReached(node))
+    {
+        return -1;
+    }
+
+    return parents[node];
+}
+
+
+/**
+ * @brief       Updates the label of a node
+ * @details     Stores the new g-score and parent of the node
+ *
+ * @param[in]   node    subnet index
+ * @param[in]   gScore  cost of the path to the node
+ * @param[in]   parent  previous node on the path, -1 for the start
+ *
+ * @note        None
+ */
+void SearchContext::relax(int node, double gScore, int parent)
+{
+    reachedGeneration[node] = generation;
+    gScores[node] = gScore;
+    parents[node] = parent;
+}
+
+
+/**
+ * @brief       Marks a node as settled
+ * @details     The node will be skipped if it shows up in the open list again
+ *
+ * @param[in]   node    subnet index
+ *
+ * @note        None
+ */
+void SearchContext::settle(int node)
+{
+    settledGeneration[node] = generation;
+    settledCount++;
+}
+
+
+/**
+ * @brief       Adds a node to the open list
+ * @details     Sifts the entry up the heap, growing the heap inside the arena
+ *              when full.
+ *
+ * @param[in]   node    subnet index
+ * @param[in]   key     priority of the node
+ *
+ * @note        None
+ */
+void SearchContext::push(int node, double key)
+{
+    OpenEntry* grown;
+    std::size_t index, parent;
+
+    if (heapSize == heapCapacity)
+    {
+        grown = arena.allocateArray<OpenEntry>(heapCapacity * 2);
+        std::memcpy(grown, heap, sizeof(OpenEntry) * heapSize);
+        heap = grown;
+        heapCapacity *= 2;
+    }
+
+    index = heapSize++;
+
+    while (index > 0)
+    {
+        parent = (index - 1) / 2;
+
+        if (heap[parent].key <= key)
+        {
+            break;
+        }
+
+        heap[index] = heap[parent];
+        index = parent;
+    }
+
+    heap[index].key = key;
+    heap[index].node = node;
+}
+
+
+/**
+ * @brief       Removes the cheapest entry of the open list
+ * @details     Returns false when the open list is empty
+ *
+ * @param[out]  node    subnet index of the entry
+ * @param[out]  key     priority of the entry
+ *
+ * @note        The entry may be stale, callers check isSettled()
+ */
+bool SearchContext::pop(int & node, double & key)
+{
+    OpenEntry last;
+    std::size_t index, child;
+
+    if (heapSize == 0)
+    {
+        return false;
+    }
+
+    node = heap[0].node;
+    key = heap[0].key;
+
+    last = heap[--heapSize];
+    index = 0;
+
+    while ((child = 2 * index + 1) < heapSize)
+    {
+        if (child + 1 < heapSize && heap[child + 1].key < heap[child].key)
+        {
+            child++;
+        }
+
+        if (last.key <= heap[child].key)
+        {
+            break;
+        }
+
+        heap[index] = heap[child];
+        index = child;
+    }
+
+    if (heapSize > 0)
+    {
+        heap[index] = last;
+    }
+
+    return true;
+}
+
+
+/**
+ * @brief   Shows whether the open list is empty
+ * @details Returns whether no entries are left to pop
+ * @note    None
+ */
+bool SearchContext::isOpenEmpty() const
+{
+    return heapSize == 0;
+}
+
+
+/**
+ * @brief   Get the smallest key in the open list
+ * @details Returns SEARCH_INFINITY when the open list is empty
+ * @note    None
+ */
+double SearchContext::getTopKey() const
+{
+    if (heapSize == 0)
+    {
+        return SEARCH_INFINITY;
+    }
+
+    return heap[0].key;
+}
+
+
+/**
+ * @brief   Get the settled node count
+ * @details Returns how many nodes were settled during the current query
+ * @note    None
+ */
+int SearchContext::getSettledCount() const
+{
+    return settledCount;
+}
+
+
+/**
+ * @brief   Get the arena
+ * @details Returns the arena that is reset at the start of every query
+ * @note    None
+ */
+MonotonicArena & SearchContext::getArena()
+{
+    return arena;
+}
@@ -0,0 +1,143 @@
+/**
+ * @file    SearchContext.h
+ * @brief   Definition file for the MonotonicArena and SearchContext classes
+ *
+ * @author  Andrew Frost, Richard Millar
+ * @version 1.00
+ */
+
+// Precompiler Directives =====================================================
+#ifndef SEARCHCONTEXT_H
+#define SEARCHCONTEXT_H
+
+// Header Files ===============================================================
+#include <cstddef>
+#include <vector>
+
+#define SEARCH_INFINITY 1e300
+
+// Class Definition ===========================================================
+/**
+ * @brief   Bump allocator for the temporary structures of a single query.
+ * @details Memory is handed out from large blocks and released all at once by
+ *          reset(). When a query needed more than one block, reset() replaces
+ *          them with a single block of the combined size, so after a few
+ *          queries the arena stops touching the heap entirely.
+ *
+ * @class   MonotonicArena SearchContext.h "SearchContext.h"
+ */
+class MonotonicArena
+{
+public:
+    MonotonicArena();
+    ~MonotonicArena();
+
+    void* allocate(std::size_t bytes, std::size_t alignment);
+
+    template<typename Type>
+    Type* allocateArray(std::size_t count);
+
+    void reset();
+
+    std::size_t getCapacity() const;
+
+private:
+    MonotonicArena(const MonotonicArena & other);
+    MonotonicArena & operator=(const MonotonicArena & other);
+
+    void addBlock(std::size_t bytes);
+    void releaseBlocks();
+
+    std::vector<char*> blocks; //every block owned by the arena, the last one is active
+    std::vector<std::size_t> blockSizes;
+    std::size_t offset; //first free byte in the active block
+    std::size_t capacity; //total bytes owned by the arena
+};
+
+
+/**
+ * @brief   One entry of the open list.
+ * @details Holds the priority the node was pushed with. Entries are never
+ *          updated in place, stale ones are skipped when popped.
+ */
+struct OpenEntry
+{
+    double key;
+    int node;
+};
+
+
+/**
+ * @brief   Reusable per-thread state of a shortest path search.
+ * @details All labels live in flat arrays indexed by subnet index. A label is
+ *          only valid when its generation matches the generation of the
+ *          current query, so starting a new query is a single increment no
+ *          matter how large the graph is. The open list is a binary heap kept
+ *          in the arena.
+ *
+ * @class   SearchContext SearchContext.h "SearchContext.h"
+ */
+class SearchContext
+{
+public:
+    SearchContext();
+    ~SearchContext();
+
+    void prepare(int nodeCount);
+
+    bool isReached(int node) const;
+    bool isSettled(int node) const;
+
+    double getGScore(int node) const;
+    int getParent(int node) const;
+
+    void relax(int node, double gScore, int parent);
+    void settle(int node);
+
+    void push(int node, double key);
+    bool pop(int & node, double & key);
+    bool isOpenEmpty() const;
+    double getTopKey() const;
+
+    int getSettledCount() const;
+
+    MonotonicArena & getArena();
+
+private:
+    SearchContext(const SearchContext & other);
+    SearchContext & operator=(const SearchContext & other);
+
+    std::vector<unsigned int> reachedGeneration;
+    std::vector<unsigned int> settledGeneration;
+    std::vector<double> gScores;
+    std::vector<int> parents;
+
+    unsigned int generation;
+
+    OpenEntry* heap;
+    std::size_t heapSize;
+    std::size_t heapCapacity;
+
+    int settledCount;
+
+    MonotonicArena arena;
+};
+
+
+// Template Implementation ====================================================
+/**
+ * @brief       Allocates an array from the arena
+ * @details     The array is not constructed, so only trivial types should be
+ *              requested.
+ *
+ * @param[in]   count   number of elements to allocate
+ *
+ * @note        None
+ */
+template<typename Type>
+Type* MonotonicArena::allocateArray(std::size_t count)
+{
+    return static_cast<Type*>(allocate(sizeof(Type) * count, alignof(Type)));
+}
+
+#endif
@@ -0,0 +1,365 @@
+/**
+ * @file    ShmClient.cpp
+ *
+ * @brief   Implementation file for the ShmClient class
+ *
+ * @author  Andrew Frost, Richard Millar
+ * @version 1.00
+ */
+
+// Header Files ===============================================================
+#include "ShmClient.h"
+#include <algorithm>
+#include <chrono>
+#include <fcntl.h>
+#include <iostream>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Class Implementation =======================================================
+/**
+ * @brief   Default constructor
+ * @details Constructs a client that is not connected yet
+ * @note    None
+ */
+ShmClient::ShmClient()
+    : segment(NULL), segmentSize(0), header(NULL), requests(NULL), slot(NULL), names(NULL), client(0),
+      generation(0), nextSequence(1)
+{
+
+}
+
+
+/**
+ * @brief   Destructor
+ * @note    None
+ */
+ShmClient::~ShmClient()
+{
+    close();
+}
+
+
+/**
+ * @brief       Map a server's segment and claim a client slot
+ *
+ * @param[in]   address     shm:name
+ *
+ * @note        Returns false if there is no server or every slot is taken
+ */
+bool ShmClient::open(const std::string & address)
+{
+    std::string name;
+    struct stat status;
+    uint32_t expected;
+    void* mapped;
+    int fd, index;
+
+    if(!ParseShmAddress(address, name))
+    {
+        std::cout << "ERROR: Invalid server address " << address << ", expected shm:name." << std::endl;
+        return false;
+    }
+
+    fd = shm_open(name.c_str(), O_RDWR, 0);
+
+    if(fd < 0 || fstat(fd, &status) != 0 || (size_t)status.st_size < sizeof(ShmHeader))
+    {
+        std::cout << "ERROR: Could not connect to " << address << "." << std::endl;
+
+        if(fd >= 0)
+        {
+            ::close(fd);
+        }
+        return false;
+    }
+
+    segmentSize = (size_t)status.st_size;
+    mapped = mmap(NULL, segmentSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+
+    if(mapped == MAP_FAILED)
+    {
+        std::cout << "ERROR: Could not map " << address << "." << std::endl;
+        return false;
+    }
+
+    segment = (unsigned char*)mapped;
+    header = (ShmHeader*)segment;
+
+    if(header->serverReady.load(std::memory_order_acquire) == 0 || header->magic != SHM_MAGIC ||
+       header->size != segmentSize)
+    {
+        std::cout << "ERROR: No server is ready on " << address << "." << std::endl;
+        close();
+        return false;
+    }
+
+    requests = (ShmRequestCell*)(segment + header->requestsOffset);
+    names = (const char*)(segment + header->namesOffset);
+
+    for(index = 0; index < SHM_MAX_CLIENTS; index++)
+    {
+        ShmClientSlot & candidate = ((ShmClientSlot*)(segment + header->clientsOffset))[index];
+
+        expected = SHM_SLOT_FREE;
+
+        if(candidate.state.compare_exchange_strong(expected, SHM_SLOT_USED, std::memory_order_acq_rel))
+        {
+            slot = &candidate;
+            client = (uint32_t)index;
+            generation = slot->generation.load(std::memory_order_relaxed);
+            slot->pid.store((int32_t)getpid(), std::memory_order_relaxed);
+
+            return true;
+        }
+    }
+
+    std::cout << "ERROR: Every client slot of " << address << " is taken." << std::endl;
+    close();
+
+    return false;
+}
+
+
+/**
+ * @brief   Give up the slot and unmap the segment
+ * @details The server takes the client's vehicles off the network
+ * @note    None
+ */
+void ShmClient::close()
+{
+    if(slot != NULL)
+    {
+        slot->state.store(SHM_SLOT_CLOSING, std::memory_order_release);
+        FutexWake(header->requestSignal, header->serverSleeping);
+        slot = NULL;
+    }
+
+    if(segment != NULL)
+    {
+        munmap(segment, segmentSize);
+        segment = NULL;
+        header = NULL;
+        requests = NULL;
+        names = NULL;
+    }
+}
+
+
+/**
+ * @brief       Ask for a route, joining the network if the vehicle is new
+ *
+ * @param[in]   id          vehicle ID, unique across all clients
+ * @param[in]   source      road the vehicle is on
+ * @param[in]   dest        road the vehicle is going to
+ * @param[in]   priority    JobPriority of the request
+ * @param[in]   deadline    seconds the request may wait, 0 for none
+ *
+ * @note        Returns the sequence number of the request, 0 if it was not sent
+ */
+unsigned int ShmClient::requestRoute(const std::string & id, const std::string & source, const std::string & dest,
+                                     int priority, double deadline)
+{
+    return send(NET_ROUTE_REQUEST, id, source, dest, priority, deadline);
+}
+
+
+/**
+ * @brief       Ask to turn onto the next road
+ *
+ * @param[in]   id          vehicle ID
+ * @param[in]   currentRoad road the vehicle is on
+ * @param[in]   newRoad     road the vehicle wants to turn onto
+ *
+ * @note        Returns the sequence number of the request, 0 if it was not sent
+ */
+unsigned int ShmClient::changeRoad(const std::string & id, const std::string & currentRoad,
+                                   const std::string & newRoad)
+{
+    return send(NET_ROAD_CHANGE, id, currentRoad, newRoad, 0, 0);
+}
+
+
+/**
+ * @brief       Leave the network
+ *
+ * @param[in]   id          vehicle ID
+ * @param[in]   lastRoad    road the vehicle leaves from
+ *
+ * @note        Returns the sequence number of the request, 0 if it was not sent
+ */
+unsigned int ShmClient::leave(const std::string & id, const std::string & lastRoad)
+{
+    return send(NET_LEAVE, id, lastRoad, "", 0, 0);
+}
+
+
+/**
+ * @brief       Wait for the next reply
+ *
+ * @param[out]  reply       reply in the ring, valid until release()
+ * @param[in]   timeoutMS   longest to wait, -1 for no limit
+ *
+ * @note        Returns 1 for a reply, 0 on timeout, -1 if the server has gone
+ */
+int ShmClient::receive(const ShmResponse* & reply, int timeoutMS)
+{
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now() +
+        std::chrono::milliseconds(std::max(timeoutMS, 0));
+    uint32_t tail, signal;
+    long long remaining;
+
+    if(slot == NULL)
+    {
+        return -1;
+    }
+
+    tail = slot->tail.load(std::memory_order_relaxed);
+
+    while(true)
+    {
+        if(slot->head.load(std::memory_order_acquire) != tail)
+        {
+            reply = &slot->responses[tail & (SHM_RESPONSE_SLOTS - 1)];
+            return 1;
+        }
+
+        if(header->serverReady.load(std::memory_order_acquire) == 0 ||
+           slot->state.load(std::memory_order_relaxed) != SHM_SLOT_USED)
+        {
+            return -1;
+        }
+
+        remaining = timeoutMS < 0 ? SHM_POLL_MS : std::chrono::duration_cast<std::chrono::milliseconds>(
+            end - std::chrono::steady_clock::now()).count();
+
+        if(remaining <= 0)
+        {
+            return 0;
+        }
+
+        //the fence pairs with the one the server takes after publishing
+        slot->clientSleeping.store(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        signal = slot->responseSignal.load(std::memory_order_acquire);
+
+        if(slot->head.load(std::memory_order_acquire) == tail)
+        {
+            FutexWait(slot->responseSignal, signal, (int)std::min(remaining, (long long)SHM_POLL_MS));
+        }
+
+        slot->clientSleeping.store(0, std::memory_order_relaxed);
+    }
+}
+
+
+/**
+ * @brief   Give the reply last received back to the ring
+ * @note    None
+ */
+void ShmClient::release()
+{
+    if(slot != NULL)
+    {
+        slot->tail.store(slot->tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+}
+
+
+/**
+ * @brief       Get the name of a subnet in a route
+ *
+ * @param[in]   index   subnet index from a ShmRouteNode
+ *
+ * @note        The name is read in place, it lives as long as the mapping
+ */
+const char* ShmClient::subnetName(uint32_t index) const
+{
+    if(names == NULL || index >= header->subnetCount)
+    {
+        return "";
+    }
+
+    return names + (size_t)index * SHM_NAME_SIZE;
+}
+
+
+/**
+ * @brief       Put a request on the ring and wake the server
+ * @details     Claims the next position of the ring, writes the request into
+ *              its cell, then marks the cell as holding it. While the ring is
+ *              full the client yields to the server.
+ *
+ * @param[in]   type        kind of request
+ * @param[in]   id          vehicle ID
+ * @param[in]   from        source, current road, or last road
+ * @param[in]   to          dest or new road
+ * @param[in]   priority    JobPriority of a route request
+ * @param[in]   deadline    deadline of a route request
+ *
+ * @note        Returns the sequence number, 0 if a name is too long or the
+ *              server has gone
+ */
+unsigned int ShmClient::send(NetMessageType type, const std::string & id, const std::string & from,
+                             const std::string & to, int priority, double deadline)
+{
+    ShmRequestCell* cell;
+    uint64_t position, turn;
+    int64_t lead;
+
+    if(slot == NULL || id.size() >= SHM_NAME_SIZE || from.size() >= SHM_NAME_SIZE || to.size() >= SHM_NAME_SIZE)
+    {
+        return 0;
+    }
+
+    position = header->enqueuePosition.load(std::memory_order_relaxed);
+
+    while(true)
+    {
+        cell = &requests[position & (SHM_REQUEST_SLOTS - 1)];
+        turn = cell->turn.load(std::memory_order_acquire);
+        lead = (int64_t)(turn - position);
+
+        if(lead == 0)
+        {
+            if(header->enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+            {
+                break;
+            }
+        }
+        else if(lead < 0)
+        {
+            //full, the server has not taken the request a lap ago
+            if(header->serverReady.load(std::memory_order_acquire) == 0)
+            {
+                return 0;
+            }
+
+            FutexWake(header->requestSignal, header->serverSleeping);
+            sched_yield();
+            position = header->enqueuePosition.load(std::memory_order_relaxed);
+        }
+        else
+        {
+            position = header->enqueuePosition.load(std::memory_order_relaxed);
+        }
+    }
+
+    cell->request.type = type;
+    cell->request.priority = priority;
+    cell->request.client = client;
+    cell->request.generation = generation;
+    cell->request.sequence = nextSequence;
+    cell->request.deadline = deadline;
+    CopyShmName(cell->request.id, id);
+    CopyShmName(cell->request.from, from);
+    CopyShmName(cell->request.to, to);
+
+    cell->turn.store(position + 1, std::memory_order_release);
+    FutexWake(header->requestSignal, header->serverSleeping);
+
+    return nextSequence++;
+}
@@ -0,0 +1,64 @@
+/**
+ * @file    ShmClient.h
+ * @brief   Definition file for the ShmClient class
+ *
+ * @author  Andrew Frost, Richard Millar
+ * @version 1.00
+ */
+
+// Precompiler Directives =====================================================
+#ifndef SHMCLIENT_H
+#define SHMCLIENT_H
+
+// Header Files ===============================================================
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "NetProtocol.h"
+#include "ShmTransport.h"
+
+// Class Definition ===========================================================
+/**
+ * @brief   Connection of a vehicle simulator to a ShmServer.
+ * @details Requests go on the shared ring at once and return their sequence
+ *          number, so many can be in flight. A reply is read in place: the
+ *          pointer receive() gives stays valid until release(). Used by one
+ *          thread only.
+ *
+ * @class   ShmClient ShmClient.h "ShmClient.h"
+ */
+class ShmClient
+{
+public:
+    ShmClient();
+    ~ShmClient();
+
+    bool open(const std::string & address);
+    void close();
+
+    unsigned int requestRoute(const std::string & id, const std::string & source, const std::string & dest,
+                              int priority, double deadline);
+    unsigned int changeRoad(const std::string & id, const std::string & currentRoad, const std::string & newRoad);
+    unsigned int leave(const std::string & id, const std::string & lastRoad);
+
+    int receive(const ShmResponse* & reply, int timeoutMS);
+    void release();
+
+    const char* subnetName(uint32_t index) const;
+
+private:
+    unsigned int send(NetMessageType type, const std::string & id, const std::string & from,
+                      const std::string & to, int priority, double deadline);
+
+    unsigned char* segment;
+    size_t segmentSize;
+    ShmHeader* header;
+    ShmRequestCell* requests;
+    ShmClientSlot* slot;
+    const char* names;
+    uint32_t client;
+    uint32_t generation;
+    unsigned int nextSequence;
+};
+
+#endif
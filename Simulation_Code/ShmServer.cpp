@@ -0,0 +1,595 @@
+/**
+ * @file    ShmServer.cpp
+ *
+ * @brief   Implementation file for the ShmServer class
+ *
+ * @author  Andrew Frost, Richard Millar
+ * @version 1.00
+ */
+
+// Header Files ===============================================================
+#include "ShmServer.h"
+#include "CentralComputeNode.h"
+#include "Trace.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <fcntl.h>
+#include <iostream>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Local Functions ============================================================
+/**
+ * @brief   Round an offset up to a cache line
+ * @note    None
+ */
+static uint64_t AlignOffset(uint64_t offset)
+{
+    return (offset + SHM_CACHE_LINE - 1) / SHM_CACHE_LINE * SHM_CACHE_LINE;
+}
+
+
+// Class Implementation =======================================================
+/**
+ * @brief       ShmServer constructor
+ *
+ * @param[in]   newCcn  Compute Node to serve
+ *
+ * @note        None
+ */
+ShmServer::ShmServer(CentralComputeNode & newCcn)
+    : ccn(newCcn), fleet(newCcn), name(), segment(NULL), segmentSize(0), header(NULL), requests(NULL),
+      slots(NULL), dequeuePosition(0), subnetIndex(), backlogs(SHM_MAX_CLIENTS), claimed(0), requestCount(0),
+      batches(0), largestBatch(0), routesSent(0), wakeups(0)
+{
+    fleet.setWakeup([this]()
+    {
+        if(header != NULL)
+        {
+            FutexWake(header->requestSignal, header->serverSleeping);
+        }
+    });
+}
+
+
+/**
+ * @brief   ShmServer destructor
+ * @note    None
+ */
+ShmServer::~ShmServer()
+{
+    close();
+}
+
+
+/**
+ * @brief       Make the segment and start taking clients
+ * @details     A segment left by an earlier run is replaced
+ *
+ * @param[in]   address     shm:name
+ *
+ * @note        Returns false if the address is not valid or the segment
+ *              cannot be made
+ */
+bool ShmServer::open(const std::string & address)
+{
+    std::vector<std::string> names;
+    std::vector<int> capacities;
+    uint64_t namesOffset, requestsOffset, clientsOffset;
+    void* mapped;
+    int fd, index;
+
+    if(!ParseShmAddress(address, name))
+    {
+        std::cout << "ERROR: Invalid server address " << address << ", expected shm:name." << std::endl;
+        name.clear();
+        return false;
+    }
+
+    ccn.getLock();
+    {
+        ccn.getSubnets(names, capacities);
+    }
+    ccn.releaseLock();
+
+    namesOffset = AlignOffset(sizeof(ShmHeader));
+    requestsOffset = AlignOffset(namesOffset + names.size() * SHM_NAME_SIZE);
+    clientsOffset = AlignOffset(requestsOffset + SHM_REQUEST_SLOTS * sizeof(ShmRequestCell));
+    segmentSize = clientsOffset + SHM_MAX_CLIENTS * sizeof(ShmClientSlot);
+
+    shm_unlink(name.c_str());
+    fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+
+    if(fd < 0 || ftruncate(fd, (off_t)segmentSize) != 0)
+    {
+        std::cout << "ERROR: Could not make the shared memory segment " << name << "." << std::endl;
+
+        if(fd >= 0)
+        {
+            ::close(fd);
+            shm_unlink(name.c_str());
+        }
+        name.clear();
+        return false;
+    }
+
+    mapped = mmap(NULL, segmentSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+
+    if(mapped == MAP_FAILED)
+    {
+        std::cout << "ERROR: Could not map the shared memory segment " << name << "." << std::endl;
+        shm_unlink(name.c_str());
+        name.clear();
+        return false;
+    }
+
+    //a new segment is zeroed, which is every slot free and every ring empty
+    segment = (unsigned char*)mapped;
+    header = (ShmHeader*)segment;
+    requests = (ShmRequestCell*)(segment + requestsOffset);
+    slots = (ShmClientSlot*)(segment + clientsOffset);
+
+    for(index = 0; index < (int)names.size(); index++)
+    {
+        if(!CopyShmName((char*)(segment + namesOffset + (uint64_t)index * SHM_NAME_SIZE), names[index]))
+        {
+            std::cout << "ERROR: Subnet name " << names[index] << " is too long for shared memory." << std::endl;
+            close();
+            return false;
+        }
+
+        subnetIndex[names[index]] = (uint32_t)index;
+    }
+
+    for(index = 0; index < SHM_REQUEST_SLOTS; index++)
+    {
+        requests[index].turn.store((uint64_t)index, std::memory_order_relaxed);
+    }
+
+    header->subnetCount = (uint32_t)names.size();
+    header->namesOffset = namesOffset;
+    header->requestsOffset = requestsOffset;
+    header->clientsOffset = clientsOffset;
+    header->size = segmentSize;
+    header->magic = SHM_MAGIC;
+    header->serverReady.store(1, std::memory_order_release);
+
+    return true;
+}
+
+
+/**
+ * @brief       Serve clients
+ * @details     Each pass of the loop drains the request ring, handles what it
+ *              took as one batch under one lock of the Compute Node, then puts
+ *              the replies and the routes that are ready on the clients'
+ *              rings. With nothing to do it sleeps until a client or the
+ *              Compute Node wakes it.
+ *
+ * @param[in]   running     flag to show that the simulator is running
+ * @param[in]   seconds     time to serve for
+ *
+ * @note        Runs on its own thread
+ */
+void ShmServer::run(std::atomic_bool & running, double seconds)
+{
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now(), lastCheck = now,
+        end = now + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<double>(seconds));
+    std::vector<ShmRequest> batch;
+    std::vector<std::pair<int, NetMessage> > replies;
+    std::vector<int> gone;
+    ShmRequest request;
+    NetMessage message, reply;
+    ShmClientSlot* slot;
+    uint32_t signal;
+    int index, client;
+    bool checkAlive;
+
+    TRACE_THREAD_NAME("server");
+
+    batch.reserve(SHM_MAX_BATCH);
+
+    while(running && now < end && header != NULL)
+    {
+        batch.clear();
+        replies.clear();
+
+        while(batch.size() < SHM_MAX_BATCH && takeRequest(request))
+        {
+            batch.push_back(request);
+        }
+
+        checkAlive = now - lastCheck >= std::chrono::milliseconds(SHM_CHECK_MS);
+        lastCheck = checkAlive ? now : lastCheck;
+        findGoneClients(gone, checkAlive);
+
+        if(!batch.empty() || !gone.empty())
+        {
+            TRACE_SCOPE("server", "batch");
+
+            ccn.getLock();
+            {
+                for(index = 0; index < (int)batch.size(); index++)
+                {
+                    slot = &slots[batch[index].client];
+
+                    //a request left over from a client that has gone
+                    if(slot->state.load(std::memory_order_acquire) == SHM_SLOT_FREE ||
+                       slot->generation.load(std::memory_order_relaxed) != batch[index].generation)
+                    {
+                        continue;
+                    }
+
+                    client = (int)(batch[index].generation * SHM_MAX_CLIENTS + batch[index].client);
+
+                    message.type = (NetMessageType)batch[index].type;
+                    message.sequence = batch[index].sequence;
+                    message.id = batch[index].id;
+                    message.from = batch[index].from;
+                    message.to = batch[index].to;
+                    message.priority = batch[index].priority;
+                    message.deadline = batch[index].deadline;
+
+                    if(fleet.handle(client, message, reply))
+                    {
+                        replies.push_back(std::make_pair(client, reply));
+                    }
+                }
+
+                for(index = 0; index < (int)gone.size(); index++)
+                {
+                    fleet.dropClient(gone[index]);
+                }
+            }
+            ccn.releaseLock();
+
+            for(index = 0; index < (int)gone.size(); index++)
+            {
+                freeSlot(gone[index]);
+            }
+
+            requestCount += (long long)batch.size();
+            batches += batch.empty() ? 0 : 1;
+            largestBatch = std::max(largestBatch, (long long)batch.size());
+        }
+
+        for(index = 0; index < (int)replies.size(); index++)
+        {
+            deliver(replies[index].first, replies[index].second);
+        }
+
+        flushBacklogs();
+
+        if(sendRoutes() == 0 && batch.empty())
+        {
+            //the fence pairs with the one a waker takes after publishing
+            header->serverSleeping.store(1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            signal = header->requestSignal.load(std::memory_order_acquire);
+
+            if(!requestWaiting() && sendRoutes() == 0)
+            {
+                //a full client ring is not signalled when it drains, so look again soon
+                FutexWait(header->requestSignal, signal, std::all_of(backlogs.begin(), backlogs.end(),
+                          [](const std::deque<NetMessage> & backlog) { return backlog.empty(); }) ? SHM_POLL_MS : 1);
+                wakeups++;
+            }
+
+            header->serverSleeping.store(0, std::memory_order_relaxed);
+        }
+
+        now = std::chrono::steady_clock::now();
+    }
+}
+
+
+/**
+ * @brief   Stop serving
+ * @details Takes the remote vehicles off the network, tells the clients the
+ *          server has gone, and removes the segment
+ * @note    Call once run() has returned
+ */
+void ShmServer::close()
+{
+    int index;
+
+    if(header == NULL)
+    {
+        return;
+    }
+
+    header->serverReady.store(0, std::memory_order_release);
+
+    for(index = 0; index < SHM_MAX_CLIENTS; index++)
+    {
+        claimed += slots[index].state.load(std::memory_order_acquire) != SHM_SLOT_FREE ? 1 : 0;
+        FutexWake(slots[index].responseSignal, slots[index].clientSleeping);
+    }
+
+    ccn.getLock();
+    {
+        fleet.dropAll();
+    }
+    ccn.releaseLock();
+
+    //clients keep their mapping until they close, the name goes now
+    munmap(segment, segmentSize);
+    shm_unlink(name.c_str());
+
+    segment = NULL;
+    header = NULL;
+    requests = NULL;
+    slots = NULL;
+    name.clear();
+}
+
+
+/**
+ * @brief   Print how much the server handled
+ * @note    Call once run() has returned
+ */
+void ShmServer::printStatistics() const
+{
+    std::cout << "Server: " << claimed << " clients, " << requestCount << " requests in " << batches
+              << " batches, largest " << largestBatch << ", " << routesSent << " routes sent, "
+              << wakeups << " sleeps." << std::endl;
+}
+
+
+/**
+ * @brief       Take the next request off the ring
+ *
+ * @param[out]  request     request taken
+ *
+ * @note        Returns false if the ring is empty
+ */
+bool ShmServer::takeRequest(ShmRequest & request)
+{
+    ShmRequestCell & cell = requests[dequeuePosition & (SHM_REQUEST_SLOTS - 1)];
+
+    if(cell.turn.load(std::memory_order_acquire) != dequeuePosition + 1)
+    {
+        return false;
+    }
+
+    request = cell.request;
+
+    //free for the request a whole lap later
+    cell.turn.store(dequeuePosition + SHM_REQUEST_SLOTS, std::memory_order_release);
+    dequeuePosition++;
+
+    return true;
+}
+
+
+/**
+ * @brief   Check whether a request is waiting on the ring
+ * @note    None
+ */
+bool ShmServer::requestWaiting() const
+{
+    return requests[dequeuePosition & (SHM_REQUEST_SLOTS - 1)].turn.load(std::memory_order_acquire) ==
+        dequeuePosition + 1;
+}
+
+
+/**
+ * @brief       Find the clients that closed, or died without closing
+ *
+ * @param[out]  gone        client numbers of the slots to free
+ * @param[in]   checkAlive  also look for client processes that no longer exist
+ *
+ * @note        None
+ */
+void ShmServer::findGoneClients(std::vector<int> & gone, bool checkAlive) const
+{
+    uint32_t state;
+    pid_t pid;
+    int index;
+
+    gone.clear();
+
+    for(index = 0; index < SHM_MAX_CLIENTS; index++)
+    {
+        state = slots[index].state.load(std::memory_order_acquire);
+        pid = slots[index].pid.load(std::memory_order_relaxed);
+
+        if(state == SHM_SLOT_CLOSING ||
+           (state == SHM_SLOT_USED && checkAlive && pid > 0 && kill(pid, 0) != 0 && errno == ESRCH))
+        {
+            gone.push_back((int)(slots[index].generation.load(std::memory_order_relaxed) * SHM_MAX_CLIENTS) +
+                           index);
+        }
+    }
+}
+
+
+/**
+ * @brief       Free the slot of a client whose vehicles have been taken off
+ *
+ * @param[in]   client  client number of the slot
+ *
+ * @note        None
+ */
+void ShmServer::freeSlot(int client)
+{
+    ShmClientSlot & slot = slots[client % SHM_MAX_CLIENTS];
+
+    backlogs[client % SHM_MAX_CLIENTS].clear();
+    claimed++;
+
+    slot.head.store(0, std::memory_order_relaxed);
+    slot.tail.store(0, std::memory_order_relaxed);
+    slot.pid.store(0, std::memory_order_relaxed);
+    slot.generation.fetch_add(1, std::memory_order_relaxed);
+    slot.state.store(SHM_SLOT_FREE, std::memory_order_release);
+}
+
+
+/**
+ * @brief   Put the routes set by the Compute Node on the clients' rings
+ * @note    Returns how many routes there were
+ */
+int ShmServer::sendRoutes()
+{
+    std::vector<RemoteFleet::RouteReady> routes;
+    NetMessage reply;
+    int index;
+
+    fleet.takeRoutes(routes);
+
+    reply.type = NET_ROUTE_RESPONSE;
+    reply.status = NET_OK;
+
+    for(index = 0; index < (int)routes.size(); index++)
+    {
+        reply.sequence = routes[index].sequence;
+        reply.route.swap(routes[index].route);
+        deliver(routes[index].client, reply);
+    }
+
+    return (int)routes.size();
+}
+
+
+/**
+ * @brief       Send a reply to a client, keeping it back if the ring is full
+ *
+ * @param[in]   client  client number the reply is for
+ * @param[in]   reply   reply to send
+ *
+ * @note        A reply for a client that has gone is dropped
+ */
+void ShmServer::deliver(int client, const NetMessage & reply)
+{
+    ShmClientSlot & slot = slots[client % SHM_MAX_CLIENTS];
+    std::deque<NetMessage> & backlog = backlogs[client % SHM_MAX_CLIENTS];
+
+    if(slot.state.load(std::memory_order_acquire) != SHM_SLOT_USED ||
+       (int)(slot.generation.load(std::memory_order_relaxed) * SHM_MAX_CLIENTS) + client % SHM_MAX_CLIENTS != client)
+    {
+        return;
+    }
+
+    //replies keep their order behind any already kept back
+    if(backlog.empty() && push(client, reply))
+    {
+        return;
+    }
+
+    backlog.push_back(reply);
+}
+
+
+/**
+ * @brief       Write a reply on a client's ring
+ * @details     A route is written as subnet indices, each looked up once here
+ *              so the client does not have to. A route longer than
+ *              SHM_MAX_ROUTE takes several replies, which are published
+ *              together once they are all written.
+ *
+ * @param[in]   client  client number the reply is for
+ * @param[in]   reply   reply to write
+ *
+ * @note        Returns false if the ring has no room for the whole reply
+ */
+bool ShmServer::push(int client, const NetMessage & reply)
+{
+    ShmClientSlot & slot = slots[client % SHM_MAX_CLIENTS];
+    std::list<std::pair<std::string, double> >::const_iterator step;
+    std::unordered_map<std::string, uint32_t>::const_iterator subnet;
+    uint32_t head = slot.head.load(std::memory_order_relaxed);
+    uint32_t parts = std::max<uint32_t>(1, (uint32_t)((reply.route.size() + SHM_MAX_ROUTE - 1) / SHM_MAX_ROUTE));
+    uint32_t part = 0;
+    bool refused = parts > SHM_RESPONSE_SLOTS;
+    ShmResponse* response;
+
+    //a route longer than the whole ring could never be sent
+    if(refused)
+    {
+        parts = 1;
+    }
+
+    if(head - slot.tail.load(std::memory_order_acquire) > SHM_RESPONSE_SLOTS - parts)
+    {
+        return false;
+    }
+
+    response = &slot.responses[head & (SHM_RESPONSE_SLOTS - 1)];
+    response->count = 0;
+
+    for(step = reply.route.begin(); step != reply.route.end() && !refused; ++step)
+    {
+        subnet = subnetIndex.find(step->first);
+
+        if(subnet == subnetIndex.end())
+        {
+            refused = true;
+            break;
+        }
+
+        if(response->count == SHM_MAX_ROUTE)
+        {
+            response->type = reply.type;
+            response->status = reply.status;
+            response->sequence = reply.sequence;
+            response->more = 1;
+
+            part++;
+            response = &slot.responses[(head + part) & (SHM_RESPONSE_SLOTS - 1)];
+            response->count = 0;
+        }
+
+        response->route[response->count].subnet = subnet->second;
+        response->route[response->count].cost = step->second;
+        response->count++;
+    }
+
+    if(refused)
+    {
+        //a route that cannot be sent is refused, the vehicle asks again or leaves
+        part = 0;
+        response = &slot.responses[head & (SHM_RESPONSE_SLOTS - 1)];
+        response->count = 0;
+    }
+
+    response->type = reply.type;
+    response->status = refused ? NET_REFUSED : reply.status;
+    response->sequence = reply.sequence;
+    response->more = 0;
+
+    slot.head.store(head + part + 1, std::memory_order_release);
+    FutexWake(slot.responseSignal, slot.clientSleeping);
+
+    if(reply.type == NET_ROUTE_RESPONSE && !refused && !reply.route.empty())
+    {
+        routesSent++;
+    }
+
+    return true;
+}
+
+
+/**
+ * @brief   Write the replies kept back while clients' rings were full
+ * @note    None
+ */
+void ShmServer::flushBacklogs()
+{
+    int index;
+
+    for(index = 0; index < SHM_MAX_CLIENTS; index++)
+    {
+        while(!backlogs[index].empty() &&
+              push((int)(slots[index].generation.load(std::memory_order_relaxed) * SHM_MAX_CLIENTS) + index,
+                   backlogs[index].front()))
+        {
+            backlogs[index].pop_front();
+        }
+    }
+}
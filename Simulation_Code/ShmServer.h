@@ -0,0 +1,91 @@
+/**
+ * @file    ShmServer.h
+ * @brief   Definition file for the ShmServer class
+ *
+ * @author  Andrew Frost, Richard Millar
+ * @version 1.00
+ */
+
+// Precompiler Directives =====================================================
+#ifndef SHMSERVER_H
+#define SHMSERVER_H
+
+// Header Files ===============================================================
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "NetProtocol.h"
+#include "RemoteFleet.h"
+#include "ShmTransport.h"
+#include "VehicleServer.h"
+
+#define SHM_CHECK_MS 500 //how often the server looks for clients that died
+#define SHM_MAX_BATCH 1024 //most requests handled under one lock
+
+class CentralComputeNode;
+
+// Class Definition ===========================================================
+/**
+ * @brief   Serves the Compute Node to vehicle simulators on the same machine
+ *          through a shared memory segment.
+ * @details Clients put requests on one ring the server drains; each client has
+ *          a ring of its own for the replies. Requests are the messages of
+ *          NetProtocol.h laid out flat, and a route is sent as subnet indices
+ *          into a table of names written once when the segment is made, so a
+ *          client reads it in place without copying or parsing it. A side
+ *          that finds its ring empty sleeps on a futex the other side wakes.
+ *          The vehicles are kept by a RemoteFleet; the client number given it
+ *          is the slot and the generation of its claim, so a route or request
+ *          left over from a client that has gone never reaches the next one.
+ *
+ * @class   ShmServer ShmServer.h "ShmServer.h"
+ */
+class ShmServer : public VehicleServer
+{
+public:
+    ShmServer(CentralComputeNode & newCcn);
+    ~ShmServer();
+
+    bool open(const std::string & address);
+    void run(std::atomic_bool & running, double seconds);
+    void close();
+
+    void printStatistics() const;
+
+private:
+    bool takeRequest(ShmRequest & request);
+    bool requestWaiting() const;
+    void findGoneClients(std::vector<int> & gone, bool checkAlive) const;
+    void freeSlot(int client);
+    int sendRoutes();
+    void deliver(int client, const NetMessage & reply);
+    bool push(int client, const NetMessage & reply);
+    void flushBacklogs();
+
+    CentralComputeNode & ccn;
+    RemoteFleet fleet;
+
+    std::string name; //of the segment, to unlink on close
+    unsigned char* segment;
+    size_t segmentSize;
+    ShmHeader* header;
+    ShmRequestCell* requests;
+    ShmClientSlot* slots;
+    uint64_t dequeuePosition;
+
+    std::unordered_map<std::string, uint32_t> subnetIndex;
+    std::vector<std::deque<NetMessage> > backlogs; //replies that did not fit a client's ring, by slot
+
+    long long claimed; //slots claimed by clients, counted as they are given up
+    long long requestCount;
+    long long batches;
+    long long largestBatch;
+    long long routesSent;
+    long long wakeups;
+};
+
+#endif
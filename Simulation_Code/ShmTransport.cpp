@@ -0,0 +1,111 @@
+/**
+ * @file    ShmTransport.cpp
+ *
+ * @brief   Implementation file for the shared memory segment helpers
+ *
+ * @author  Andrew Frost, Richard Millar
+ * @version 1.00
+ */
+
+// Header Files ===============================================================
+#include "ShmTransport.h"
+#include <climits>
+#include <cstring>
+#include <ctime>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+//the futex words are waited on as plain 32 bit integers by the kernel
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t) && ATOMIC_INT_LOCK_FREE == 2,
+              "Futex words must be lock free 32 bit atomics.");
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "Ring positions must be lock free across processes.");
+static_assert((SHM_REQUEST_SLOTS & (SHM_REQUEST_SLOTS - 1)) == 0, "SHM_REQUEST_SLOTS must be a power of two.");
+static_assert((SHM_RESPONSE_SLOTS & (SHM_RESPONSE_SLOTS - 1)) == 0, "SHM_RESPONSE_SLOTS must be a power of two.");
+
+/**
+ * @brief       Sleep until a futex word is woken or no longer holds a value
+ *
+ * @param[in]   word        futex word in the shared segment
+ * @param[in]   value       value the caller last saw
+ * @param[in]   timeoutMS   longest to sleep
+ *
+ * @note        Not private, the word is shared between processes
+ */
+void FutexWait(std::atomic<uint32_t> & word, uint32_t value, int timeoutMS)
+{
+    timespec timeout;
+
+    timeout.tv_sec = timeoutMS / 1000;
+    timeout.tv_nsec = (long)(timeoutMS % 1000) * 1000000L;
+
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAIT, value, &timeout, NULL, 0);
+}
+
+
+/**
+ * @brief       Change a futex word and wake whoever sleeps on it
+ *
+ * @param[in]   word        futex word in the shared segment
+ * @param[in]   sleeping    flag the other side sets before it sleeps
+ *
+ * @note        The caller has published what it is waking for, the fence
+ *              pairs with the one the other side takes after setting its flag
+ */
+void FutexWake(std::atomic<uint32_t> & word, const std::atomic<uint32_t> & sleeping)
+{
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    if(sleeping.load(std::memory_order_relaxed) != 0)
+    {
+        word.fetch_add(1, std::memory_order_release);
+        syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+    }
+}
+
+
+/**
+ * @brief       Get the segment name of a shm:name address
+ *
+ * @param[in]   address     address to parse
+ * @param[out]  name        name for shm_open, starting with a slash
+ *
+ * @note        Returns false if the address is not a shared memory one
+ */
+bool ParseShmAddress(const std::string & address, std::string & name)
+{
+    if(address.compare(0, 4, "shm:") != 0 || address.size() <= 4)
+    {
+        return false;
+    }
+
+    name = address.substr(4);
+
+    if(name[0] != '/')
+    {
+        name.insert(0, "/");
+    }
+
+    return name.size() > 1 && name.find('/', 1) == std::string::npos && name.size() < NAME_MAX;
+}
+
+
+/**
+ * @brief       Copy a name into a fixed size field
+ *
+ * @param[out]  field   field of SHM_NAME_SIZE characters
+ * @param[in]   text    name to copy
+ *
+ * @note        Returns false if the name does not fit
+ */
+bool CopyShmName(char* field, const std::string & text)
+{
+    if(text.size() >= SHM_NAME_SIZE)
+    {
+        return false;
+    }
+
+    std::memcpy(field, text.c_str(), text.size() + 1);
+
+    return true;
+}
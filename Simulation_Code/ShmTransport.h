@@ -0,0 +1,143 @@
+/**
+ * @file    ShmTransport.h
+ * @brief   Definition file for the shared memory segment between a vehicle
+ *          simulator and the Compute Node server
+ *
+ * @author  Andrew Frost, Richard Millar
+ * @version 1.00
+ */
+
+// Precompiler Directives =====================================================
+#ifndef SHMTRANSPORT_H
+#define SHMTRANSPORT_H
+
+// Header Files ===============================================================
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#define SHM_MAGIC 0x53444e32u
+#define SHM_CACHE_LINE 64
+#define SHM_NAME_SIZE 64 //longest vehicle or subnet name, with its terminator
+#define SHM_MAX_CLIENTS 16
+#define SHM_REQUEST_SLOTS 4096 //a power of two
+#define SHM_RESPONSE_SLOTS 128 //a power of two
+#define SHM_MAX_ROUTE 512 //most subnets in one reply, longer routes take several
+#define SHM_POLL_MS 100
+
+/**
+ * @brief   State of a client slot.
+ */
+enum ShmSlotState
+{
+    SHM_SLOT_FREE,
+    SHM_SLOT_USED,
+    SHM_SLOT_CLOSING    //the client has gone, the server takes its vehicles off
+};
+
+
+/**
+ * @brief   A request in the shared ring, one NetMessage of a request kind.
+ */
+struct ShmRequest
+{
+    int32_t type;
+    int32_t priority;
+    uint32_t client; //slot of the client
+    uint32_t generation; //of the slot when the request was sent
+    uint32_t sequence;
+    double deadline;
+    char id[SHM_NAME_SIZE];
+    char from[SHM_NAME_SIZE];
+    char to[SHM_NAME_SIZE];
+};
+
+
+/**
+ * @brief   A cell of the request ring.
+ * @details turn is the position the cell may next be written at, plus one
+ *          once it holds that position's request.
+ */
+struct ShmRequestCell
+{
+    std::atomic<uint64_t> turn;
+    ShmRequest request;
+};
+
+
+/**
+ * @brief   A step of a route, the subnet as an index into the names table.
+ */
+struct ShmRouteNode
+{
+    uint32_t subnet;
+    double cost; //to the next subnet, 0 for the destination
+};
+
+
+/**
+ * @brief   A reply in a client's ring.
+ * @details The route is read in place from the ring. A route of more than
+ *          SHM_MAX_ROUTE steps is split over consecutive replies with the same
+ *          sequence, all published at once, each but the last marked more.
+ */
+struct ShmResponse
+{
+    int32_t type;
+    int32_t status;
+    uint32_t sequence;
+    uint32_t count; //steps of the route in this reply
+    uint32_t more; //nonzero when the route goes on in the next reply
+    ShmRouteNode route[SHM_MAX_ROUTE];
+};
+
+
+/**
+ * @brief   A client's place in the segment and the ring of its replies.
+ * @details Only the server writes head and only the client writes tail, each
+ *          on a line of its own.
+ */
+struct ShmClientSlot
+{
+    std::atomic<uint32_t> state;
+    std::atomic<uint32_t> generation; //bumped each time the slot is freed
+    std::atomic<int32_t> pid;
+
+    alignas(SHM_CACHE_LINE) std::atomic<uint32_t> responseSignal; //futex word
+    std::atomic<uint32_t> clientSleeping;
+
+    alignas(SHM_CACHE_LINE) std::atomic<uint32_t> head;
+    alignas(SHM_CACHE_LINE) std::atomic<uint32_t> tail;
+
+    alignas(SHM_CACHE_LINE) ShmResponse responses[SHM_RESPONSE_SLOTS];
+};
+
+
+/**
+ * @brief   Start of the segment.
+ * @details The subnet names, the request ring and the client slots follow at
+ *          the offsets given.
+ */
+struct ShmHeader
+{
+    uint32_t magic;
+    uint32_t subnetCount;
+    uint64_t namesOffset;
+    uint64_t requestsOffset;
+    uint64_t clientsOffset;
+    uint64_t size;
+    std::atomic<uint32_t> serverReady;
+
+    alignas(SHM_CACHE_LINE) std::atomic<uint64_t> enqueuePosition;
+    alignas(SHM_CACHE_LINE) std::atomic<uint32_t> requestSignal; //futex word
+    std::atomic<uint32_t> serverSleeping;
+};
+
+
+void FutexWait(std::atomic<uint32_t> & word, uint32_t value, int timeoutMS);
+void FutexWake(std::atomic<uint32_t> & word, const std::atomic<uint32_t> & sleeping);
+
+bool ParseShmAddress(const std::string & address, std::string & name);
+bool CopyShmName(char* field, const std::string & text);
+
+#endif
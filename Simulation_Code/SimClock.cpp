@@ -0,0 +1,261 @@
+/**
+ * @file    SimClock.cpp
+ *
+ * @brief   Implementation file for the SimClock and StartupBarrier classes
+ *
+ * @author  Andrew Frost, Richard Millar
+ * @version 1.00
+ */
+
+// Header Files ===============================================================
+#include "SimClock.h"
+#include <thread>
+
+std::chrono::steady_clock::time_point SimClock::origin = std::chrono::steady_clock::now();
+double SimClock::speedup = 1.0;
+std::atomic_bool SimClock::stepped(false);
+std::atomic<SimClock::rep> SimClock::steppedTime(0);
+std::mutex SimClock::steppedMutex;
+std::condition_variable SimClock::steppedMoved;
+
+/**
+ * @brief   Get the current simulated time
+ * @details Scales the wall time since the origin by the speedup, or gives the
+ *          time a stepped clock was last advanced to
+ * @note    None
+ */
+SimClock::time_point SimClock::now()
+{
+    if(stepped.load(std::memory_order_relaxed))
+    {
+        return time_point(duration(steppedTime.load(std::memory_order_acquire)));
+    }
+
+    std::chrono::duration<double> wall = std::chrono::steady_clock::now() - origin;
+
+    return time_point(std::chrono::duration_cast<duration>(wall * speedup));
+}
+
+
+/**
+ * @brief       Set how much faster simulated time runs than the wall clock
+ * @details     Moves the origin so simulated time carries on from where it is
+ *              rather than jumping
+ *
+ * @param[in]   factor  simulated seconds per wall second, above zero
+ *
+ * @note        Not thread safe, set it before the simulator's threads start.
+ *              Returns false and keeps the old speedup for a factor of zero or
+ *              less.
+ */
+bool SimClock::setSpeedup(double factor)
+{
+    std::chrono::steady_clock::time_point wall = std::chrono::steady_clock::now();
+    std::chrono::duration<double> simulated;
+
+    if(!(factor > 0))
+    {
+        return false;
+    }
+
+    simulated = std::chrono::duration<double>(wall - origin) * speedup;
+    origin = wall - std::chrono::duration_cast<std::chrono::steady_clock::duration>(simulated / factor);
+    speedup = factor;
+
+    return true;
+}
+
+
+/**
+ * @brief   Get how much faster simulated time runs than the wall clock
+ * @note    None
+ */
+double SimClock::getSpeedup()
+{
+    return speedup;
+}
+
+
+/**
+ * @brief       Stop or start following the wall clock
+ * @details     A stepped clock starts from the current simulated time and only
+ *              moves with advanceTo. A clock that is no longer stepped carries
+ *              on from where it was stepped to.
+ *
+ * @param[in]   newStepped  whether the clock is stepped
+ *
+ * @note        Not thread safe, set it before the simulator's threads start
+ */
+void SimClock::setStepped(bool newStepped)
+{
+    std::chrono::steady_clock::time_point wall = std::chrono::steady_clock::now();
+    time_point current = now();
+
+    if(newStepped == stepped)
+    {
+        return;
+    }
+
+    if(newStepped)
+    {
+        steppedTime = current.time_since_epoch().count();
+    }
+    else
+    {
+        origin = wall - std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                            std::chrono::duration<double>(current.time_since_epoch()) / speedup);
+    }
+
+    stepped = newStepped;
+}
+
+
+/**
+ * @brief   Shows whether the clock only moves with advanceTo
+ * @note    None
+ */
+bool SimClock::isStepped()
+{
+    return stepped;
+}
+
+
+/**
+ * @brief       Move a stepped clock on
+ * @details     Wakes the threads sleeping on the clock
+ *
+ * @param[in]   time    simulated time to move to
+ *
+ * @note        A time before the current one is ignored, the clock never goes
+ *              back. Does nothing unless the clock is stepped.
+ */
+void SimClock::advanceTo(time_point time)
+{
+    if(!stepped || time <= now())
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(steppedMutex);
+
+        steppedTime.store(time.time_since_epoch().count(), std::memory_order_release);
+    }
+
+    steppedMoved.notify_all();
+}
+
+
+/**
+ * @brief       Get the wall time a simulated time falls at
+ *
+ * @param[in]   time    simulated time
+ *
+ * @note        For waiting on condition variables until a simulated time. A
+ *              stepped clock has no wall time, the time is that of the next
+ *              look at the clock.
+ */
+std::chrono::steady_clock::time_point SimClock::toWall(time_point time)
+{
+    if(stepped)
+    {
+        return std::chrono::steady_clock::now() + std::chrono::milliseconds(SIM_STEPPED_POLL_MS);
+    }
+
+    std::chrono::duration<double> simulated = time.time_since_epoch();
+
+    return origin + std::chrono::duration_cast<std::chrono::steady_clock::duration>(simulated / speedup);
+}
+
+
+/**
+ * @brief       Sleep for a simulated time
+ *
+ * @param[in]   time    simulated time to sleep
+ *
+ * @note        None
+ */
+void SimClock::sleepFor(std::chrono::duration<double> time)
+{
+    if(stepped)
+    {
+        sleepUntil(now() + std::chrono::duration_cast<duration>(time));
+        return;
+    }
+
+    std::this_thread::sleep_for(std::chrono::duration_cast<std::chrono::steady_clock::duration>(time / speedup));
+}
+
+
+/**
+ * @brief       Sleep until a simulated time
+ *
+ * @param[in]   time    simulated time to wake at
+ *
+ * @note        Returns at once if the time has passed. On a stepped clock may
+ *              return early, after SIM_STEPPED_POLL_MS of wall time.
+ */
+void SimClock::sleepUntil(time_point time)
+{
+    if(stepped)
+    {
+        std::unique_lock<std::mutex> lock(steppedMutex);
+
+        steppedMoved.wait_for(lock, std::chrono::milliseconds(SIM_STEPPED_POLL_MS),
+                              [time]() { return now() >= time; });
+        return;
+    }
+
+    std::this_thread::sleep_until(toWall(time));
+}
+
+
+/**
+ * @brief       StartupBarrier constructor
+ *
+ * @param[in]   newCount    vehicles to wait for
+ *
+ * @note        None
+ */
+StartupBarrier::StartupBarrier(int newCount) : mutex(), arrived(), count(newCount)
+{
+
+}
+
+
+/**
+ * @brief   StartupBarrier destructor
+ * @note    None
+ */
+StartupBarrier::~StartupBarrier()
+{
+
+}
+
+
+/**
+ * @brief   Count a vehicle as joined
+ * @details Wakes the waiter when the last vehicle has joined
+ * @note    Each vehicle arrives once
+ */
+void StartupBarrier::arrive()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if(count > 0 && --count == 0)
+    {
+        arrived.notify_all();
+    }
+}
+
+
+/**
+ * @brief   Wait until every vehicle has joined
+ * @note    Returns at once if there were none to wait for
+ */
+void StartupBarrier::wait()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+
+    arrived.wait(lock, [this]() { return count <= 0; });
+}
@@ -0,0 +1,102 @@
+/**
+ * @file    SimClock.h
+ * @brief   Definition file for the SimClock and StartupBarrier classes
+ *
+ * @author  Andrew Frost, Richard Millar
+ * @version 1.00
+ */
+
+// Precompiler Directives =====================================================
+#ifndef SIMCLOCK_H
+#define SIMCLOCK_H
+
+// Header Files ===============================================================
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+#define SIM_STEPPED_POLL_MS 10 //longest a sleeper waits for a stepped clock to move
+
+// Class Definition ===========================================================
+/**
+ * @brief   Clock of the simulated city.
+ * @details Simulated time runs speedup times faster than the wall clock, so a
+ *          road of 15 seconds takes 150 ms at a speedup of 100 and every
+ *          vehicle keeps the same timing relative to the others. Travel times,
+ *          time steps, trip departures, checkpoints and samples are all in
+ *          simulated time; the compute time of the Compute Node is not, so a
+ *          large speedup makes routing relatively slower. Simulated time
+ *          starts at zero when the program starts and never jumps.
+ *
+ *          A stepped clock does not follow the wall clock at all, it only
+ *          moves when a deterministic run advances it to the next event, so
+ *          the same seed always gives the same run. Sleepers on a stepped
+ *          clock wake when it has passed their time, or after
+ *          SIM_STEPPED_POLL_MS of wall time so they can look whether the run
+ *          has ended.
+ *
+ *          Meets the requirements of a std::chrono clock, but its time points
+ *          must be slept on with sleepUntil, std::this_thread::sleep_until
+ *          would sleep in simulated rather than wall time.
+ *
+ * @class   SimClock SimClock.h "SimClock.h"
+ */
+class SimClock
+{
+public:
+    typedef std::chrono::system_clock::duration duration;
+    typedef duration::rep rep;
+    typedef duration::period period;
+    typedef std::chrono::time_point<SimClock> time_point;
+
+    static const bool is_steady = true;
+
+    static time_point now();
+
+    static bool setSpeedup(double factor);
+    static double getSpeedup();
+
+    static void setStepped(bool newStepped);
+    static bool isStepped();
+    static void advanceTo(time_point time);
+
+    static std::chrono::steady_clock::time_point toWall(time_point time);
+    static void sleepFor(std::chrono::duration<double> time);
+    static void sleepUntil(time_point time);
+
+private:
+    static std::chrono::steady_clock::time_point origin; //wall time of simulated time zero
+    static double speedup;
+
+    static std::atomic_bool stepped;
+    static std::atomic<rep> steppedTime; //simulated time of a stepped clock
+    static std::mutex steppedMutex;
+    static std::condition_variable steppedMoved;
+};
+
+
+/**
+ * @brief   Holds the Compute Node back until every vehicle has joined.
+ * @details Each vehicle started with the run arrives once it has joined the
+ *          network, and the Compute Node waits for the last of them, so it
+ *          never sees an empty network and ends before the vehicles are on it.
+ *
+ * @class   StartupBarrier SimClock.h "SimClock.h"
+ */
+class StartupBarrier
+{
+public:
+    StartupBarrier(int newCount);
+    ~StartupBarrier();
+
+    void arrive();
+    void wait();
+
+private:
+    std::mutex mutex;
+    std::condition_variable arrived;
+    int count; //vehicles still to join
+};
+
+#endif
@@ -8,6 +8,7 @@
  */
 
 #include "ThreadSafeObject.h"
+#include "Trace.h"
 
 ThreadSafeObject::ThreadSafeObject() : mutex()
 {
@@ -21,10 +22,25 @@ ThreadSafeObject::~ThreadSafeObject()
 
 void ThreadSafeObject::getLock() 
 {
+#ifdef SDN_TRACE
+    //only waits are traced, an uncontended lock records nothing
+    if (mutex.try_lock())
+    {
+        return;
+    }
+
+    TRACE_SCOPE("lock", "lock wait");
+#endif
     mutex.lock();
 }
 
 
+bool ThreadSafeObject::tryLock()
+{
+    return mutex.try_lock();
+}
+
+
 void ThreadSafeObject::releaseLock()
 {
     mutex.unlock();
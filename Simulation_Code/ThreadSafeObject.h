@@ -28,6 +28,7 @@ public:
     ~ThreadSafeObject();
 
     void getLock();
+    bool tryLock();
     void releaseLock();
 
 private:
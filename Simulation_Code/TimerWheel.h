@@ -0,0 +1,375 @@
+/**
+ * @file    TimerWheel.h
+ * @brief   Definition and implementation of the TimerWheel class template
+ * @details A template, so the implementation lives in the header.
+ *
+ * @author  Andrew Frost, Richard Millar
+ * @version 1.00
+ */
+
+// Precompiler Directives =====================================================
+#ifndef TIMERWHEEL_H
+#define TIMERWHEEL_H
+
+// Header Files ===============================================================
+#include <utility>
+#include <vector>
+
+#define TIMER_WHEEL_LEVELS 4
+#define TIMER_WHEEL_INNER_BITS 8  //ticks covered by the innermost level, 256
+#define TIMER_WHEEL_OUTER_BITS 6  //slots of each outer level, 64
+
+
+// Class Definition ===========================================================
+/**
+ * @brief   Hierarchical timer wheel.
+ * @details Times are whole ticks. The innermost level has a slot for each of
+ *          the next 256 ticks, each outer level has 64 slots each as long as
+ *          the whole level inside it, so four levels reach 2^26 ticks ahead
+ *          (about 18 hours of milliseconds) and later timers wait in an
+ *          overflow list. Scheduling a timer is constant time. When the
+ *          current tick crosses into a new slot of an outer level, the timers
+ *          of that slot are spread over the levels inside it, so each timer is
+ *          moved at most once per level before it is due.
+ *
+ * @class   TimerWheel TimerWheel.h "TimerWheel.h"
+ */
+template <typename T>
+class TimerWheel
+{
+public:
+    TimerWheel(long long startTick);
+    ~TimerWheel();
+
+    void schedule(long long tick, const T & item);
+    void advance(long long tick, std::vector<T> & due);
+
+    long long nextTick() const;
+    long long getCurrentTick() const;
+    long long size() const;
+
+private:
+    typedef std::vector<std::pair<long long, T> > Slot;
+
+    void place(long long tick, const T & item);
+    void cascade(int level);
+    void hand(Slot & slot, std::vector<T> & due);
+
+    static int levelShift(int level);
+    static int slotIndex(long long tick, int level);
+
+    long long current; //every timer up to this tick has been handed out
+    long long count;
+
+    std::vector<Slot> levels[TIMER_WHEEL_LEVELS];
+    Slot overflow; //timers past the outermost level
+    Slot expired; //timers scheduled at or before the current tick
+};
+
+
+// Class Implementation =======================================================
+/**
+ * @brief       TimerWheel constructor
+ *
+ * @param[in]   startTick   tick the wheel starts at
+ *
+ * @note        None
+ */
+template <typename T>
+TimerWheel<T>::TimerWheel(long long startTick)
+    : current(startTick), count(0), overflow(), expired()
+{
+    int level;
+
+    levels[0].resize(1 << TIMER_WHEEL_INNER_BITS);
+
+    for(level = 1; level < TIMER_WHEEL_LEVELS; level++)
+    {
+        levels[level].resize(1 << TIMER_WHEEL_OUTER_BITS);
+    }
+}
+
+
+/**
+ * @brief   TimerWheel destructor
+ * @note    None
+ */
+template <typename T>
+TimerWheel<T>::~TimerWheel()
+{
+
+}
+
+
+/**
+ * @brief       Add a timer
+ *
+ * @param[in]   tick    tick the timer is due at, a past tick is due right away
+ * @param[in]   item    item handed out when the timer is due
+ *
+ * @note        None
+ */
+template <typename T>
+void TimerWheel<T>::schedule(long long tick, const T & item)
+{
+    place(tick, item);
+    count++;
+}
+
+
+/**
+ * @brief       Move the wheel on
+ * @details     Hands out every timer due up to and including tick. An empty
+ *              wheel jumps straight to tick.
+ *
+ * @param[in]   tick    tick to move to
+ * @param[out]  due     timers that became due are appended to it
+ *
+ * @note        None
+ */
+template <typename T>
+void TimerWheel<T>::advance(long long tick, std::vector<T> & due)
+{
+    typename Slot::iterator timer;
+    int level;
+
+    hand(expired, due);
+
+    while(current < tick)
+    {
+        if(count == 0)
+        {
+            current = tick;
+            break;
+        }
+
+        current++;
+
+        //entering a new slot of a level, spread its timers over the levels inside
+        for(level = 1; level < TIMER_WHEEL_LEVELS && (current & ((1LL << levelShift(level)) - 1)) == 0; level++)
+        {
+        }
+
+        for(level = level - 1; level >= 1; level--)
+        {
+            cascade(level);
+        }
+
+        if((current & ((1LL << levelShift(TIMER_WHEEL_LEVELS)) - 1)) == 0 && !overflow.empty())
+        {
+            Slot waiting;
+
+            waiting.swap(overflow);
+
+            for(timer = waiting.begin(); timer != waiting.end(); ++timer)
+            {
+                place(timer->first, timer->second);
+            }
+        }
+
+        hand(levels[0][slotIndex(current, 0)], due);
+
+        //timers of an outer slot that fall on this very tick
+        hand(expired, due);
+    }
+}
+
+
+/**
+ * @brief   Get the tick to call advance at next
+ * @details Returns the first tick of the innermost level that holds a timer,
+ *          or the next tick an outer level is spread out at if that comes
+ *          sooner, so no timer is handed out late. Returns -1 if the wheel is
+ *          empty.
+ * @note    None
+ */
+template <typename T>
+long long TimerWheel<T>::nextTick() const
+{
+    long long tick, boundary;
+    int level;
+
+    if(count == 0)
+    {
+        return -1;
+    }
+
+    if(!expired.empty())
+    {
+        return current;
+    }
+
+    boundary = -1;
+
+    for(level = TIMER_WHEEL_LEVELS; level >= 1; level--)
+    {
+        bool waiting = false;
+        int slot;
+
+        if(level == TIMER_WHEEL_LEVELS)
+        {
+            waiting = !overflow.empty();
+        }
+        else
+        {
+            for(slot = 0; slot < (int)levels[level].size() && !waiting; slot++)
+            {
+                waiting = !levels[level][slot].empty();
+            }
+        }
+
+        if(waiting)
+        {
+            //the next time a slot of this level starts
+            boundary = ((current >> levelShift(level)) + 1) << levelShift(level);
+        }
+    }
+
+    for(tick = current + 1; tick <= current + (1 << TIMER_WHEEL_INNER_BITS); tick++)
+    {
+        if(boundary >= 0 && tick >= boundary)
+        {
+            break;
+        }
+
+        if(!levels[0][slotIndex(tick, 0)].empty())
+        {
+            return tick;
+        }
+    }
+
+    return boundary >= 0 ? boundary : tick;
+}
+
+
+/**
+ * @brief   Get the tick the wheel has been moved to
+ * @note    None
+ */
+template <typename T>
+long long TimerWheel<T>::getCurrentTick() const
+{
+    return current;
+}
+
+
+/**
+ * @brief   Get the number of timers waiting
+ * @note    None
+ */
+template <typename T>
+long long TimerWheel<T>::size() const
+{
+    return count;
+}
+
+
+/**
+ * @brief       Put a timer in the slot for its distance from the current tick
+ *
+ * @param[in]   tick    tick the timer is due at
+ * @param[in]   item    item of the timer
+ *
+ * @note        Does not count the timer
+ */
+template <typename T>
+void TimerWheel<T>::place(long long tick, const T & item)
+{
+    long long distance = tick - current;
+    int level;
+
+    if(distance <= 0)
+    {
+        expired.push_back(std::make_pair(tick, item));
+        return;
+    }
+
+    for(level = 0; level < TIMER_WHEEL_LEVELS; level++)
+    {
+        if(distance < (1LL << levelShift(level + 1)))
+        {
+            levels[level][slotIndex(tick, level)].push_back(std::make_pair(tick, item));
+            return;
+        }
+    }
+
+    overflow.push_back(std::make_pair(tick, item));
+}
+
+
+/**
+ * @brief       Spread the timers of the current slot of a level inwards
+ *
+ * @param[in]   level   outer level to spread
+ *
+ * @note        None
+ */
+template <typename T>
+void TimerWheel<T>::cascade(int level)
+{
+    typename Slot::iterator timer;
+    Slot waiting;
+
+    waiting.swap(levels[level][slotIndex(current, level)]);
+
+    for(timer = waiting.begin(); timer != waiting.end(); ++timer)
+    {
+        place(timer->first, timer->second);
+    }
+}
+
+
+/**
+ * @brief       Hand out and remove the timers of a slot
+ *
+ * @param[in]   slot    slot to empty
+ * @param[out]  due     items of the timers are appended to it
+ *
+ * @note        None
+ */
+template <typename T>
+void TimerWheel<T>::hand(Slot & slot, std::vector<T> & due)
+{
+    typename Slot::iterator timer;
+
+    for(timer = slot.begin(); timer != slot.end(); ++timer)
+    {
+        due.push_back(timer->second);
+    }
+
+    count -= (long long)slot.size();
+    slot.clear();
+}
+
+
+/**
+ * @brief       Get the bits of a tick below the slots of a level
+ *
+ * @param[in]   level   level of the wheel, TIMER_WHEEL_LEVELS for the overflow
+ *
+ * @note        None
+ */
+template <typename T>
+int TimerWheel<T>::levelShift(int level)
+{
+    return level == 0 ? 0 : TIMER_WHEEL_INNER_BITS + (level - 1) * TIMER_WHEEL_OUTER_BITS;
+}
+
+
+/**
+ * @brief       Get the slot of a level a tick falls in
+ *
+ * @param[in]   tick    tick to look up
+ * @param[in]   level   level of the wheel
+ *
+ * @note        None
+ */
+template <typename T>
+int TimerWheel<T>::slotIndex(long long tick, int level)
+{
+    int bits = level == 0 ? TIMER_WHEEL_INNER_BITS : TIMER_WHEEL_OUTER_BITS;
+
+    return (int)((tick >> levelShift(level)) & ((1LL << bits) - 1));
+}
+
+#endif
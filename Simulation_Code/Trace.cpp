@@ -0,0 +1,271 @@
+/**
+ * @file    Trace.cpp
+ *
+ * @brief   Implementation file for the Tracer class
+ *
+ * @author  Andrew Frost, Richard Millar
+ * @version 1.00
+ */
+
+// Header Files ===============================================================
+#include "Trace.h"
+
+#ifdef SDN_TRACE
+
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/**
+ * @brief   One recorded event.
+ * @details phase is 'X' for a complete event and 'i' for an instant, times are
+ *          microseconds from the start of tracing.
+ */
+struct TraceEvent
+{
+    const char * category;
+    const char * name;
+    char phase;
+    double start;
+    double duration;
+    std::string detail;
+};
+
+
+/**
+ * @brief   Events of one thread.
+ */
+struct TraceBuffer
+{
+    int threadId;
+    std::string threadName;
+    std::vector<TraceEvent> events;
+    long long dropped;
+};
+
+
+// Static Data ================================================================
+static std::mutex traceMutex; //guards traceBuffers
+static std::vector<std::unique_ptr<TraceBuffer> > traceBuffers;
+static const std::chrono::steady_clock::time_point traceEpoch = std::chrono::steady_clock::now();
+static thread_local TraceBuffer * threadBuffer = NULL;
+
+
+/**
+ * @brief   Get the buffer of the calling thread
+ * @details Creates and registers it on first use
+ * @note    None
+ */
+static TraceBuffer & GetThreadBuffer()
+{
+    if (threadBuffer == NULL)
+    {
+        std::unique_ptr<TraceBuffer> buffer(new TraceBuffer());
+        std::lock_guard<std::mutex> guard(traceMutex);
+
+        buffer->threadId = (int)traceBuffers.size() + 1;
+        buffer->dropped = 0;
+        buffer->events.reserve(1024);
+
+        threadBuffer = buffer.get();
+        traceBuffers.push_back(std::move(buffer));
+    }
+
+    return *threadBuffer;
+}
+
+
+/**
+ * @brief   Microseconds from the start of tracing
+ */
+static double TraceMicroseconds(std::chrono::steady_clock::time_point time)
+{
+    return std::chrono::duration<double, std::micro>(time - traceEpoch).count();
+}
+
+
+/**
+ * @brief       Writes a JSON string
+ * @details     Escapes quotes, backslashes and control characters
+ *
+ * @param[in]   file    file to write to
+ * @param[in]   text    text to write
+ */
+static void WriteJsonString(std::ofstream & file, const std::string & text)
+{
+    const char * hex = "0123456789abcdef";
+    std::string::const_iterator character;
+
+    file << '"';
+
+    for (character = text.begin(); character != text.end(); ++character)
+    {
+        if (*character == '"' || *character == '\\')
+        {
+            file << '\\' << *character;
+        }
+        else if ((unsigned char)*character < 0x20)
+        {
+            file << "\\u00" << hex[(*character >> 4) & 0xf] << hex[*character & 0xf];
+        }
+        else
+        {
+            file << *character;
+        }
+    }
+
+    file << '"';
+}
+
+
+/**
+ * @brief       Records a complete event
+ * @details     The event runs from start until now
+ *
+ * @param[in]   category    category of the event
+ * @param[in]   name        name of the event
+ * @param[in]   start       time the event began
+ *
+ * @note        None
+ */
+void Tracer::complete(const char * category, const char * name, std::chrono::steady_clock::time_point start)
+{
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+    TraceBuffer & buffer = GetThreadBuffer();
+
+    if (buffer.events.size() >= TRACE_EVENTS_PER_THREAD)
+    {
+        buffer.dropped++;
+        return;
+    }
+
+    buffer.events.push_back(TraceEvent());
+
+    TraceEvent & event = buffer.events.back();
+
+    event.category = category;
+    event.name = name;
+    event.phase = 'X';
+    event.start = TraceMicroseconds(start);
+    event.duration = TraceMicroseconds(end) - event.start;
+}
+
+
+/**
+ * @brief       Records an instant event
+ *
+ * @param[in]   category    category of the event
+ * @param[in]   name        name of the event
+ * @param[in]   detail      argument shown with the event
+ *
+ * @note        None
+ */
+void Tracer::instant(const char * category, const char * name, const std::string & detail)
+{
+    double now = TraceMicroseconds(std::chrono::steady_clock::now());
+    TraceBuffer & buffer = GetThreadBuffer();
+
+    if (buffer.events.size() >= TRACE_EVENTS_PER_THREAD)
+    {
+        buffer.dropped++;
+        return;
+    }
+
+    buffer.events.push_back(TraceEvent());
+
+    TraceEvent & event = buffer.events.back();
+
+    event.category = category;
+    event.name = name;
+    event.phase = 'i';
+    event.start = now;
+    event.duration = 0;
+    event.detail = detail;
+}
+
+
+/**
+ * @brief       Labels the calling thread
+ *
+ * @param[in]   name    name shown for the thread
+ *
+ * @note        None
+ */
+void Tracer::setThreadName(const std::string & name)
+{
+    GetThreadBuffer().threadName = name;
+}
+
+
+/**
+ * @brief       Writes the trace
+ * @details     Writes every recorded event as Chrome trace event JSON, which
+ *              chrome://tracing and Perfetto open directly
+ *
+ * @param[in]   fileName    file to write
+ *
+ * @note        Call once the traced threads have stopped. Returns false if the
+ *              file could not be written.
+ */
+bool Tracer::exportJson(const std::string & fileName)
+{
+    std::lock_guard<std::mutex> guard(traceMutex);
+    std::ofstream file(fileName.c_str());
+    std::vector<TraceEvent>::const_iterator event;
+    long long dropped = 0;
+    bool first = true;
+    size_t index;
+
+    if (!file.is_open())
+    {
+        return false;
+    }
+
+    file << std::fixed << std::setprecision(3);
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+    for (index = 0; index < traceBuffers.size(); index++)
+    {
+        const TraceBuffer & buffer = *traceBuffers[index];
+
+        dropped += buffer.dropped;
+
+        if (!buffer.threadName.empty())
+        {
+            file << (first ? "" : ",\n") << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":"
+                 << buffer.threadId << ",\"args\":{\"name\":";
+            WriteJsonString(file, buffer.threadName);
+            file << "}}";
+            first = false;
+        }
+
+        for (event = buffer.events.begin(); event != buffer.events.end(); ++event)
+        {
+            file << (first ? "" : ",\n") << "{\"ph\":\"" << event->phase << "\",\"cat\":\"" << event->category
+                 << "\",\"name\":\"" << event->name << "\",\"pid\":1,\"tid\":" << buffer.threadId
+                 << ",\"ts\":" << event->start;
+
+            if (event->phase == 'X')
+            {
+                file << ",\"dur\":" << event->duration;
+            }
+            else
+            {
+                file << ",\"s\":\"t\",\"args\":{\"detail\":";
+                WriteJsonString(file, event->detail);
+                file << "}";
+            }
+
+            file << "}";
+            first = false;
+        }
+    }
+
+    file << "\n],\"otherData\":{\"droppedEvents\":" << dropped << "}}\n";
+
+    return file.good();
+}
+
+#endif
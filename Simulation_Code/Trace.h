@@ -0,0 +1,92 @@
+/**
+ * @file    Trace.h
+ * @brief   Timeline tracing in the Chrome trace event format
+ * @details Tracing is compiled in with SDN_TRACE (make TRACE=1). Without it the
+ *          macros expand to nothing, their arguments are not evaluated, and
+ *          TRACE_EXPORT is false.
+ *
+ *          TRACE_SCOPE(category, name) records a complete event from the macro
+ *          to the end of the enclosing scope. TRACE_INSTANT(category, name,
+ *          detail) records a point event with a string argument, such as the
+ *          id of a vehicle. TRACE_THREAD_NAME(name) labels the calling thread.
+ *          Names and categories must be string literals.
+ *
+ * @author  Andrew Frost, Richard Millar
+ * @version 1.00
+ */
+
+// Precompiler Directives =====================================================
+#ifndef TRACE_H
+#define TRACE_H
+
+#ifdef SDN_TRACE
+
+// Header Files ===============================================================
+#include <chrono>
+#include <string>
+
+#define TRACE_CONCAT_INNER(first, second) first##second
+#define TRACE_CONCAT(first, second) TRACE_CONCAT_INNER(first, second)
+
+#define TRACE_SCOPE(category, name) TraceScope TRACE_CONCAT(traceScope, __LINE__)(category, name)
+#define TRACE_INSTANT(category, name, detail) Tracer::instant(category, name, detail)
+#define TRACE_THREAD_NAME(name) Tracer::setThreadName(name)
+#define TRACE_EXPORT(fileName) Tracer::exportJson(fileName)
+
+#define TRACE_EVENTS_PER_THREAD (1 << 20)
+
+
+// Class Definition ===========================================================
+/**
+ * @brief   Collects trace events.
+ * @details Each thread records into its own buffer, which is only locked when
+ *          the thread records its first event. Buffers outlive their threads,
+ *          so detached vehicle threads are exported too. A thread that fills
+ *          its buffer drops further events and the export reports how many.
+ *
+ * @class   Tracer Trace.h "Trace.h"
+ */
+class Tracer
+{
+public:
+    static void complete(const char * category, const char * name,
+                         std::chrono::steady_clock::time_point start);
+    static void instant(const char * category, const char * name, const std::string & detail);
+    static void setThreadName(const std::string & name);
+
+    static bool exportJson(const std::string & fileName);
+};
+
+
+/**
+ * @brief   Records a complete event for the scope it lives in.
+ *
+ * @class   TraceScope Trace.h "Trace.h"
+ */
+class TraceScope
+{
+public:
+    TraceScope(const char * newCategory, const char * newName)
+        : category(newCategory), name(newName), start(std::chrono::steady_clock::now()) {}
+
+    ~TraceScope()
+    {
+        Tracer::complete(category, name, start);
+    }
+
+private:
+    const char * category;
+    const char * name;
+    std::chrono::steady_clock::time_point start;
+};
+
+#else
+
+#define TRACE_SCOPE(category, name)
+#define TRACE_INSTANT(category, name, detail)
+#define TRACE_THREAD_NAME(name)
+#define TRACE_EXPORT(fileName) false
+
+#endif
+
+#endif
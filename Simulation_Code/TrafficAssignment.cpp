@@ -0,0 +1,695 @@
+/**
+ * @file    TrafficAssignment.cpp
+ *
+ * @brief   Implementation file for the TrafficAssignment class
+ *
+ * @author  Andrew Frost, Richard Millar
+ * @version 1.00
+ */
+
+// Header Files ===============================================================
+#include "TrafficAssignment.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+
+/**
+ * @brief   Default constructor
+ * @details Constructs an assignment with no network and no demand
+ * @note    None
+ */
+TrafficAssignment::TrafficAssignment()
+    : graph(),
+    capacities(),
+    delayScale(),
+    demands(),
+    originStarts(),
+    demandSorted(true),
+    roadCosts(),
+    roadFlows(),
+    subnetVolumes(),
+    iterations(),
+    unroutedVolume(0),
+    progressListener()
+{
+
+}
+
+/**
+ * @brief   Default destructor
+ * @details Destroys a TrafficAssignment object
+ * @note    None
+ */
+TrafficAssignment::~TrafficAssignment()
+{
+
+}
+
+
+/**
+ * @brief       Sets the city to assign the demand to
+ * @details     Keeps a copy of the graph and works out the delay of each subnet
+ *
+ * @param[in]   newGraph        free flow travel times of the roads
+ * @param[in]   newCapacities   capacity by subnet index
+ *
+ * @note        Clears the flows of an earlier solve
+ */
+void TrafficAssignment::setNetwork(const RoadGraph & newGraph, const std::vector<int> & newCapacities)
+{
+    std::vector<int> roadsIn;
+    double capacity;
+    int node, edge, target;
+
+    graph = newGraph;
+
+    capacities.assign(graph.getNodeCount(), 1);
+    delayScale.assign(graph.getNodeCount(), 0);
+    roadsIn.assign(graph.getNodeCount(), 0);
+
+    //T of each subnet is the mean travel time of the roads into it
+    for (node = 0; node < graph.getNodeCount(); node++)
+    {
+        for (edge = graph.offsets[node]; edge < graph.offsets[node + 1]; edge++)
+        {
+            target = graph.targets[edge];
+
+            //closed roads carry no traffic
+            if (graph.costs[edge] >= SEARCH_INFINITY)
+            {
+                continue;
+            }
+
+            delayScale[target] += graph.costs[edge];
+            roadsIn[target]++;
+        }
+    }
+
+    for (node = 0; node < graph.getNodeCount(); node++)
+    {
+        if (node < (int)newCapacities.size() && newCapacities[node] > 1)
+        {
+            capacities[node] = newCapacities[node];
+        }
+
+        capacity = capacities[node];
+
+        if (roadsIn[node] > 0)
+        {
+            delayScale[node] *= ASSIGNMENT_BPR_ALPHA / (roadsIn[node] * capacity * capacity * capacity * capacity);
+        }
+    }
+
+    roadCosts.clear();
+    roadFlows.clear();
+    subnetVolumes.clear();
+    iterations.clear();
+}
+
+
+/**
+ * @brief       Adds demand between two subnets
+ *
+ * @param[in]   origin      subnet index the trips start at
+ * @param[in]   destination subnet index the trips end at
+ * @param[in]   volume      vehicles per period
+ *
+ * @note        Returns false and ignores the demand if a subnet is not in the
+ *              network or the volume is not positive
+ */
+bool TrafficAssignment::addDemand(int origin, int destination, double volume)
+{
+    Demand demand;
+
+    if (origin < 0 || destination < 0 || origin >= graph.getNodeCount() ||
+        destination >= graph.getNodeCount() || !(volume > 0))
+    {
+        return false;
+    }
+
+    demand.origin = origin;
+    demand.destination = destination;
+    demand.volume = volume;
+
+    demands.push_back(demand);
+    demandSorted = false;
+
+    return true;
+}
+
+
+/**
+ * @brief   Removes all demand
+ * @note    None
+ */
+void TrafficAssignment::clearDemand()
+{
+    demands.clear();
+    originStarts.clear();
+    demandSorted = true;
+}
+
+
+/**
+ * @brief   Get the number of origin and destination pairs added
+ * @note    A pair added twice counts twice
+ */
+long long TrafficAssignment::getPairCount() const
+{
+    return (long long)demands.size();
+}
+
+
+/**
+ * @brief   Get the number of subnets with demand starting at them
+ * @note    None
+ */
+int TrafficAssignment::getOriginCount()
+{
+    prepareDemand();
+
+    return originStarts.empty() ? 0 : (int)originStarts.size() - 1;
+}
+
+
+/**
+ * @brief       Sets a function called after every iteration
+ *
+ * @param[in]   listener    called with the iteration, from the solving thread
+ *
+ * @note        None
+ */
+void TrafficAssignment::setProgressListener(const std::function<void(const AssignmentIteration &)> & listener)
+{
+    progressListener = listener;
+}
+
+
+/**
+ * @brief       Finds the equilibrium flows
+ * @details     Starts from an all or nothing assignment at free flow and runs
+ *              Frank-Wolfe iterations until the relative gap is at most the
+ *              target or the iterations run out
+ *
+ * @param[in]   maxIterations   most iterations to run
+ * @param[in]   targetGap       relative gap to stop at
+ * @param[in]   threadCount     number of worker threads for the searches
+ *
+ * @note        Returns false if there is no network or no demand
+ */
+bool TrafficAssignment::solve(int maxIterations, double targetGap, int threadCount)
+{
+    std::vector<double> targetFlows, targetVolumes;
+    std::chrono::steady_clock::time_point start;
+    std::chrono::duration<double> elapsed;
+    AssignmentIteration iteration;
+    double shortestCost, totalCost;
+    int edge, node;
+
+    iterations.clear();
+
+    if (graph.getNodeCount() == 0 || demands.empty())
+    {
+        return false;
+    }
+
+    prepareDemand();
+
+    threadCount = std::max(1, threadCount);
+
+    //all or nothing at free flow
+    subnetVolumes.assign(graph.getNodeCount(), 0);
+    priceRoads();
+    allOrNothing(roadFlows, threadCount);
+    computeVolumes(roadFlows, subnetVolumes);
+
+    for (iteration.iteration = 1; iteration.iteration <= maxIterations; iteration.iteration++)
+    {
+        start = std::chrono::steady_clock::now();
+
+        priceRoads();
+        shortestCost = allOrNothing(targetFlows, threadCount);
+
+        totalCost = 0;
+
+        for (edge = 0; edge < graph.getEdgeCount(); edge++)
+        {
+            totalCost += roadCosts[edge] * roadFlows[edge];
+        }
+
+        iteration.totalCost = totalCost;
+        iteration.relativeGap = totalCost > 0 ? (totalCost - shortestCost) / totalCost : 0;
+        iteration.step = 0;
+
+        if (iteration.relativeGap > targetGap)
+        {
+            computeVolumes(targetFlows, targetVolumes);
+
+            iteration.step = findStep(targetFlows, targetVolumes);
+
+            for (edge = 0; edge < graph.getEdgeCount(); edge++)
+            {
+                roadFlows[edge] += iteration.step * (targetFlows[edge] - roadFlows[edge]);
+            }
+
+            for (node = 0; node < graph.getNodeCount(); node++)
+            {
+                subnetVolumes[node] += iteration.step * (targetVolumes[node] - subnetVolumes[node]);
+            }
+        }
+
+        elapsed = std::chrono::steady_clock::now() - start;
+        iteration.seconds = elapsed.count();
+
+        iterations.push_back(iteration);
+
+        if (progressListener)
+        {
+            progressListener(iteration);
+        }
+
+        if (iteration.relativeGap <= targetGap)
+        {
+            break;
+        }
+    }
+
+    priceRoads();
+
+    return true;
+}
+
+
+/**
+ * @brief   Get the iterations of the last solve
+ * @note    None
+ */
+const std::vector<AssignmentIteration> & TrafficAssignment::getIterations() const
+{
+    return iterations;
+}
+
+
+/**
+ * @brief   Get the relative gap the last solve reached
+ * @note    Returns 0 before the first iteration
+ */
+double TrafficAssignment::getRelativeGap() const
+{
+    return iterations.empty() ? 0 : iterations.back().relativeGap;
+}
+
+
+/**
+ * @brief   Get the demand whose destination can't be reached from its origin
+ * @note    This demand is left out of the flows
+ */
+double TrafficAssignment::getUnroutedVolume() const
+{
+    return unroutedVolume;
+}
+
+
+/**
+ * @brief   Get the flow on every road, in the order of the graph's targets
+ * @note    None
+ */
+const std::vector<double> & TrafficAssignment::getRoadFlows() const
+{
+    return roadFlows;
+}
+
+
+/**
+ * @brief   Get the volume entering every subnet, by subnet index
+ * @note    None
+ */
+const std::vector<double> & TrafficAssignment::getSubnetVolumes() const
+{
+    return subnetVolumes;
+}
+
+
+/**
+ * @brief       Get the volume to capacity ratio of a subnet
+ *
+ * @param[in]   subnet  subnet index
+ *
+ * @note        Above 1 the subnet is oversubscribed
+ */
+double TrafficAssignment::getVolumeRatio(int subnet) const
+{
+    if (subnet < 0 || subnet >= (int)subnetVolumes.size())
+    {
+        return 0;
+    }
+
+    return subnetVolumes[subnet] / capacities[subnet];
+}
+
+
+/**
+ * @brief   Groups the demand by origin
+ * @details Sorts the demand by origin and destination and records where the
+ *          demand of each origin starts
+ * @note    Only sorts again after demand was added
+ */
+void TrafficAssignment::prepareDemand()
+{
+    unsigned int index;
+
+    if (demandSorted && !originStarts.empty())
+    {
+        return;
+    }
+
+    std::sort(demands.begin(), demands.end(), [](const Demand & left, const Demand & right)
+    {
+        return left.origin < right.origin || (left.origin == right.origin && left.destination < right.destination);
+    });
+
+    originStarts.clear();
+
+    for (index = 0; index < demands.size(); index++)
+    {
+        if (index == 0 || demands[index].origin != demands[index - 1].origin)
+        {
+            originStarts.push_back((int)index);
+        }
+    }
+
+    originStarts.push_back((int)demands.size());
+    demandSorted = true;
+}
+
+
+/**
+ * @brief   Prices every road at the current subnet volumes
+ * @note    None
+ */
+void TrafficAssignment::priceRoads()
+{
+    int edge;
+
+    roadCosts.resize(graph.getEdgeCount());
+
+    for (edge = 0; edge < graph.getEdgeCount(); edge++)
+    {
+        roadCosts[edge] = graph.costs[edge] + getDelay(graph.targets[edge], subnetVolumes[graph.targets[edge]]);
+    }
+}
+
+
+/**
+ * @brief       All or nothing assignment
+ * @details     Loads the demand of every origin onto its shortest path tree at
+ *              the current road costs. Each worker takes the next origin until
+ *              none are left and keeps its own flows, which are added up once
+ *              all have finished.
+ *
+ * @param[out]  flows       flow on every road
+ * @param[in]   threadCount number of worker threads
+ *
+ * @note        Returns the cost of all the routed demand at its shortest paths
+ */
+double TrafficAssignment::allOrNothing(std::vector<double> & flows, int threadCount)
+{
+    const int originCount = (int)originStarts.size() - 1;
+
+    std::atomic_int nextOrigin(0);
+    std::vector<std::vector<double> > workerFlows;
+    std::vector<double> workerCosts, workerUnrouted;
+    std::vector<std::thread> workers;
+    double cost = 0;
+    int worker, edge;
+
+    threadCount = std::max(1, std::min(threadCount, originCount));
+
+    workerFlows.resize(threadCount);
+    workerCosts.assign(threadCount, 0);
+    workerUnrouted.assign(threadCount, 0);
+
+    auto work = [this, &nextOrigin, &workerFlows, &workerCosts, &workerUnrouted, originCount](int index)
+    {
+        SearchContext context;
+        std::vector<double> nodeFlow(graph.getNodeCount(), 0);
+        std::vector<int> order;
+        int origin;
+
+        workerFlows[index].assign(graph.getEdgeCount(), 0);
+
+        while ((origin = nextOrigin++) < originCount)
+        {
+            loadOrigin(origin, workerFlows[index], nodeFlow, order, workerCosts[index], workerUnrouted[index], context);
+        }
+    };
+
+    for (worker = 1; worker < threadCount; worker++)
+    {
+        workers.push_back(std::thread(work, worker));
+    }
+
+    work(0);
+
+    for (worker = 0; worker < (int)workers.size(); worker++)
+    {
+        workers[worker].join();
+    }
+
+    flows.swap(workerFlows[0]);
+    unroutedVolume = workerUnrouted[0];
+    cost = workerCosts[0];
+
+    for (worker = 1; worker < threadCount; worker++)
+    {
+        for (edge = 0; edge < graph.getEdgeCount(); edge++)
+        {
+            flows[edge] += workerFlows[worker][edge];
+        }
+
+        unroutedVolume += workerUnrouted[worker];
+        cost += workerCosts[worker];
+    }
+
+    return cost;
+}
+
+
+/**
+ * @brief       Loads the demand of one origin
+ * @details     Runs Dijkstra from the origin until all its destinations are
+ *              settled, then walks the settled subnets from the last to the
+ *              first, passing the demand ending at or beyond each subnet on to
+ *              the road from its parent
+ *
+ * @param[in]   origin      position of the origin in originStarts
+ * @param[out]  flows       flows of the worker, the demand is added to them
+ * @param[out]  nodeFlow    demand still to pass on by subnet, all zero before
+ *                          and after
+ * @param[out]  order       scratch list of the settled subnets
+ * @param[out]  cost        the cost of the demand at its shortest paths is
+ *                          added to it
+ * @param[out]  unrouted    the demand that can't be routed is added to it
+ * @param[out]  context     search labels of the worker
+ *
+ * @note        None
+ */
+void TrafficAssignment::loadOrigin
+(
+    int origin,
+    std::vector<double> & flows,
+    std::vector<double> & nodeFlow,
+    std::vector<int> & order,
+    double & cost,
+    double & unrouted,
+    SearchContext & context
+) const
+{
+    const int first = originStarts[origin], last = originStarts[origin + 1];
+    const int source = demands[first].origin;
+
+    int index, current, neighbor, edge, parent, road, remaining = 0;
+    double key, tentativeGScore;
+
+    for (index = first; index < last; index++)
+    {
+        //demand is sorted by destination, so repeats are next to each other
+        if (index == first || demands[index].destination != demands[index - 1].destination)
+        {
+            remaining++;
+        }
+
+        nodeFlow[demands[index].destination] += demands[index].volume;
+    }
+
+    context.prepare(graph.getNodeCount());
+    context.relax(source, 0, -1);
+    context.push(source, 0);
+
+    order.clear();
+
+    while (remaining > 0 && context.pop(current, key))
+    {
+        if (context.isSettled(current))
+        {
+            continue;
+        }
+
+        context.settle(current);
+        order.push_back(current);
+
+        if (nodeFlow[current] > 0)
+        {
+            cost += nodeFlow[current] * key;
+            remaining--;
+        }
+
+        for (edge = graph.offsets[current]; edge < graph.offsets[current + 1]; edge++)
+        {
+            neighbor = graph.targets[edge];
+
+            if (context.isSettled(neighbor))
+            {
+                continue;
+            }
+
+            tentativeGScore = key + roadCosts[edge];
+
+            if (tentativeGScore < context.getGScore(neighbor))
+            {
+                context.relax(neighbor, tentativeGScore, current);
+                context.push(neighbor, tentativeGScore);
+            }
+        }
+    }
+
+    //destinations the search never reached have no route
+    for (index = first; index < last; index++)
+    {
+        if (!context.isSettled(demands[index].destination))
+        {
+            unrouted += demands[index].volume;
+            nodeFlow[demands[index].destination] = 0;
+        }
+    }
+
+    //children are settled after their parents, so walking backwards passes
+    //each subnet all of the demand of its subtree
+    for (index = (int)order.size() - 1; index > 0; index--)
+    {
+        current = order[index];
+
+        if (nodeFlow[current] > 0)
+        {
+            parent = context.getParent(current);
+            road = -1;
+
+            //the cheapest road from the parent is the one the search took
+            for (edge = graph.offsets[parent]; edge < graph.offsets[parent + 1]; edge++)
+            {
+                if (graph.targets[edge] == current && (road < 0 || roadCosts[edge] < roadCosts[road]))
+                {
+                    road = edge;
+                }
+            }
+
+            flows[road] += nodeFlow[current];
+            nodeFlow[parent] += nodeFlow[current];
+            nodeFlow[current] = 0;
+        }
+    }
+
+    nodeFlow[source] = 0;
+}
+
+
+/**
+ * @brief       Volume entering every subnet
+ *
+ * @param[in]   flows   flow on every road
+ * @param[out]  volumes volume by subnet index
+ *
+ * @note        None
+ */
+void TrafficAssignment::computeVolumes(const std::vector<double> & flows, std::vector<double> & volumes) const
+{
+    int edge;
+
+    volumes.assign(graph.getNodeCount(), 0);
+
+    for (edge = 0; edge < graph.getEdgeCount(); edge++)
+    {
+        volumes[graph.targets[edge]] += flows[edge];
+    }
+}
+
+
+/**
+ * @brief       Frank-Wolfe step size
+ * @details     Bisects the derivative of the Beckmann objective along the
+ *              line from the current flows to the all or nothing flows. The
+ *              derivative is the free flow cost of the change in flows plus
+ *              the delay of each subnet times the change in its volume.
+ *
+ * @param[in]   target          all or nothing flow on every road
+ * @param[in]   targetVolumes   all or nothing volume of every subnet
+ *
+ * @note        Returns a step between 0 and 1
+ */
+double TrafficAssignment::findStep(const std::vector<double> & target, const std::vector<double> & targetVolumes) const
+{
+    double freeFlow = 0, low = 0, high = 1, step, slope;
+    int edge, node, bisection;
+
+    for (edge = 0; edge < graph.getEdgeCount(); edge++)
+    {
+        freeFlow += graph.costs[edge] * (target[edge] - roadFlows[edge]);
+    }
+
+    for (bisection = 0; bisection <= ASSIGNMENT_STEP_BISECTIONS; bisection++)
+    {
+        //the first pass tries the whole step
+        step = bisection == 0 ? 1 : (low + high) / 2;
+        slope = freeFlow;
+
+        for (node = 0; node < graph.getNodeCount(); node++)
+        {
+            slope += getDelay(node, subnetVolumes[node] + step * (targetVolumes[node] - subnetVolumes[node]))
+                   * (targetVolumes[node] - subnetVolumes[node]);
+        }
+
+        if (bisection == 0 && slope <= 0)
+        {
+            return 1;
+        }
+
+        if (slope > 0)
+        {
+            high = step;
+        }
+        else
+        {
+            low = step;
+        }
+    }
+
+    return (low + high) / 2;
+}
+
+
+/**
+ * @brief       BPR delay of entering a subnet
+ *
+ * @param[in]   subnet  subnet index
+ * @param[in]   volume  volume entering the subnet
+ *
+ * @note        None
+ */
+double TrafficAssignment::getDelay(int subnet, double volume) const
+{
+    double squared = volume * volume;
+
+    return delayScale[subnet] * squared * squared;
+}
@@ -0,0 +1,123 @@
+/**
+ * @file    TrafficAssignment.h
+ * @brief   Definition file for the TrafficAssignment class
+ *
+ * @author  Andrew Frost, Richard Millar
+ * @version 1.00
+ */
+
+// Precompiler Directives =====================================================
+#ifndef TRAFFICASSIGNMENT_H
+#define TRAFFICASSIGNMENT_H
+
+// Header Files ===============================================================
+#include <functional>
+#include <vector>
+#include "RoadGraph.h"
+#include "SearchContext.h"
+
+#define ASSIGNMENT_BPR_ALPHA 0.15 //delay of a subnet at capacity, as a share of its travel time
+#define ASSIGNMENT_STEP_BISECTIONS 30
+
+/**
+ * @brief   One Frank-Wolfe iteration of a traffic assignment.
+ */
+struct AssignmentIteration
+{
+    int iteration;
+    double relativeGap; //(total cost - shortest path cost) / total cost, 0 at equilibrium
+    double totalCost; //of all the demand at the flows of the iteration
+    double step; //share of the all or nothing flows moved in
+    double seconds; //wall time of the iteration
+};
+
+
+// Class Definition ===========================================================
+/**
+ * @brief   Equilibrium flows of a whole OD demand matrix over the city.
+ * @details Finds the user equilibrium, where no trip can get cheaper by
+ *          changing route, with the Frank-Wolfe algorithm. Each iteration
+ *          prices the roads at the current flows, loads all of the demand of
+ *          each origin onto its shortest path tree in one Dijkstra search (all
+ *          or nothing), and moves the flows towards that assignment by the
+ *          step that minimizes the Beckmann objective.
+ *
+ *          A road costs its free flow travel time plus the BPR delay of the
+ *          subnet it enters, T * 0.15 * (v / c)^4, where v is the volume
+ *          entering the subnet, c its capacity and T the mean travel time of
+ *          the roads into it. Putting the delay on the subnet keeps it in the
+ *          units of subnetCapacity, and the objective stays convex, so the
+ *          relative gap goes to zero. Volumes are vehicles per period of the
+ *          demand, in the same units as the capacities.
+ *
+ *          The origins are shared between worker threads, each with its own
+ *          search labels and flows, which are added up after the searches.
+ *
+ * @class   TrafficAssignment TrafficAssignment.h "TrafficAssignment.h"
+ */
+class TrafficAssignment
+{
+public:
+    TrafficAssignment();
+    ~TrafficAssignment();
+
+    void setNetwork(const RoadGraph & newGraph, const std::vector<int> & newCapacities);
+
+    bool addDemand(int origin, int destination, double volume);
+    void clearDemand();
+
+    long long getPairCount() const;
+    int getOriginCount();
+
+    void setProgressListener(const std::function<void(const AssignmentIteration &)> & listener);
+
+    bool solve(int maxIterations, double targetGap, int threadCount);
+
+    const std::vector<AssignmentIteration> & getIterations() const;
+    double getRelativeGap() const;
+    double getUnroutedVolume() const;
+
+    const std::vector<double> & getRoadFlows() const;
+    const std::vector<double> & getSubnetVolumes() const;
+    double getVolumeRatio(int subnet) const;
+
+private:
+    /**
+     * @brief   Demand from one origin to one destination.
+     */
+    struct Demand
+    {
+        int origin;
+        int destination;
+        double volume;
+    };
+
+    void prepareDemand();
+    void priceRoads();
+    double allOrNothing(std::vector<double> & flows, int threadCount);
+    void loadOrigin(int origin, std::vector<double> & flows, std::vector<double> & nodeFlow,
+                    std::vector<int> & order, double & cost, double & unrouted, SearchContext & context) const;
+    void computeVolumes(const std::vector<double> & flows, std::vector<double> & volumes) const;
+    double findStep(const std::vector<double> & target, const std::vector<double> & targetVolumes) const;
+
+    double getDelay(int subnet, double volume) const;
+
+    RoadGraph graph;
+    std::vector<double> capacities; //by subnet, at least 1
+    std::vector<double> delayScale; //T * alpha / c^4 by subnet
+
+    std::vector<Demand> demands; //sorted by origin once solving starts
+    std::vector<int> originStarts; //first demand of each origin, by origin position
+    bool demandSorted;
+
+    std::vector<double> roadCosts; //at the current flows
+    std::vector<double> roadFlows;
+    std::vector<double> subnetVolumes; //volume entering each subnet
+
+    std::vector<AssignmentIteration> iterations;
+    double unroutedVolume; //demand with no route to its destination
+
+    std::function<void(const AssignmentIteration &)> progressListener;
+};
+
+#endif
@@ -0,0 +1,580 @@
+/**
+ * @file    TripSource.cpp
+ *
+ * @brief   Implementation file for the TripSource, TripFile and TripGenerator classes
+ *
+ * @author  Andrew Frost, Richard Millar
+ * @version 1.00
+ */
+
+// Header Files ===============================================================
+#include "TripSource.h"
+#include <iostream>
+#include <sstream>
+
+
+/**
+ * @brief   Default constructor
+ * @details Constructs an empty trip that departs at once
+ * @note    None
+ */
+Trip::Trip()
+    : departure(0), id(""), source(""), dest(""), priority(PRIORITY_PRIVATE), deadline(0)
+{
+
+}
+
+/**
+ * @brief   Default destructor
+ * @details Destroys a Trip object
+ * @note    None
+ */
+Trip::~Trip()
+{
+
+}
+
+
+/**
+ * @brief       Writes the trip
+ *
+ * @param[in]   writer  checkpoint to write to
+ *
+ * @note        None
+ */
+void Trip::save(CheckpointWriter & writer) const
+{
+    writer.writeDouble(departure);
+    writer.writeString(id);
+    writer.writeString(source);
+    writer.writeString(dest);
+    writer.writeInt(priority);
+    writer.writeDouble(deadline);
+}
+
+
+/**
+ * @brief       Reads the trip
+ *
+ * @param[in]   reader  checkpoint to read from
+ *
+ * @note        None
+ */
+void Trip::load(CheckpointReader & reader)
+{
+    long long readPriority;
+
+    departure = reader.readDouble();
+    id = reader.readString();
+    source = reader.readString();
+    dest = reader.readString();
+    readPriority = reader.readInt();
+    deadline = reader.readDouble();
+
+    priority = (readPriority >= 0 && readPriority < PRIORITY_COUNT) ? (JobPriority)readPriority : PRIORITY_PRIVATE;
+}
+
+
+/**
+ * @brief   Default constructor
+ * @details Constructs a TripSource object
+ * @note    None
+ */
+TripSource::TripSource()
+{
+
+}
+
+/**
+ * @brief   Default destructor
+ * @details Destroys a TripSource object
+ * @note    None
+ */
+TripSource::~TripSource()
+{
+
+}
+
+
+/**
+ * @brief   Default constructor
+ * @details Constructs a trip file that is not open yet
+ * @note    None
+ */
+TripFile::TripFile() : TripSource(), file(), lastDeparture(0), lineNumber(0)
+{
+
+}
+
+/**
+ * @brief   Default destructor
+ * @details Closes the file
+ * @note    None
+ */
+TripFile::~TripFile()
+{
+
+}
+
+
+/**
+ * @brief       Opens a trip file
+ * @details     Trips are read from the file as they are needed
+ *
+ * @param[in]   fileName    file to read trips from
+ *
+ * @note        Returns false if the file could not be opened
+ */
+bool TripFile::open(const std::string & fileName)
+{
+    file.open(fileName.c_str());
+
+    lastDeparture = 0;
+    lineNumber = 0;
+
+    return file.is_open();
+}
+
+
+/**
+ * @brief       Reads the next trip
+ * @details     Skips blank and comment lines and returns the next trip of the
+ *              file. Lines that can not be read are reported and skipped.
+ *
+ * @param[out]  trip    next trip
+ *
+ * @note        Returns false once the file is exhausted
+ */
+bool TripFile::next(Trip & trip)
+{
+    std::stringstream arguments;
+    std::string line, priority;
+
+    while (std::getline(file, line))
+    {
+        lineNumber++;
+
+        if (line.empty() || line[0] == '#')
+        {
+            continue;
+        }
+
+        arguments.clear();
+        arguments.str(line);
+
+        trip = Trip();
+
+        if (!(arguments >> trip.departure >> trip.id >> trip.source >> trip.dest))
+        {
+            std::cout << "Warning: skipping trip on line " << lineNumber << "." << std::endl;
+            continue;
+        }
+
+        if (arguments >> priority)
+        {
+            arguments >> trip.deadline;
+
+            if (!ParseJobPriority(priority, trip.priority))
+            {
+                std::cout << "Warning: invalid priority on trip line " << lineNumber << "." << std::endl;
+                trip.priority = PRIORITY_PRIVATE;
+            }
+        }
+
+        //trips are expected in order, a late entry leaves with the previous one
+        if (trip.departure < lastDeparture)
+        {
+            trip.departure = lastDeparture;
+        }
+
+        lastDeparture = trip.departure;
+
+        return true;
+    }
+
+    return false;
+}
+
+
+/**
+ * @brief       Writes the read position
+ * @details     Writes the offset of the next line, or -1 once the file is
+ *              exhausted
+ *
+ * @param[in]   writer  checkpoint to write to
+ *
+ * @note        None
+ */
+void TripFile::save(CheckpointWriter & writer)
+{
+    writer.writeInt(file.good() ? (long long)file.tellg() : -1);
+    writer.writeDouble(lastDeparture);
+    writer.writeInt(lineNumber);
+}
+
+
+/**
+ * @brief       Reads the read position
+ * @details     Moves the open file to where the checkpoint left it
+ *
+ * @param[in]   reader  checkpoint to read from
+ *
+ * @note        The trip file must already be open
+ */
+bool TripFile::restore(CheckpointReader & reader)
+{
+    long long offset = reader.readInt();
+
+    lastDeparture = reader.readDouble();
+    lineNumber = reader.readInt();
+
+    file.clear();
+
+    if (offset < 0)
+    {
+        file.seekg(0, std::ios::end);
+        file.get();
+    }
+    else
+    {
+        file.seekg(offset);
+    }
+
+    return reader.isGood() && (offset < 0 || file.good());
+}
+
+
+/**
+ * @brief   Default constructor
+ * @details Constructs a generator that produces no trips until configured
+ * @note    None
+ */
+TripGenerator::TripGenerator()
+    : TripSource(), rate(0), count(0), generated(0), clock(0), generator(),
+    subnets(), pairs(), weights(), pickPair()
+{
+
+}
+
+/**
+ * @brief   Default destructor
+ * @details Destroys a TripGenerator object
+ * @note    None
+ */
+TripGenerator::~TripGenerator()
+{
+
+}
+
+
+/**
+ * @brief       Sets up the arrival process
+ *
+ * @param[in]   newRate     average trips per second
+ * @param[in]   newCount    number of trips to generate
+ * @param[in]   seed        seed of the random number generator
+ *
+ * @note        None
+ */
+void TripGenerator::configure(double newRate, long long newCount, unsigned int seed)
+{
+    rate = newRate;
+    count = newCount;
+    generated = 0;
+    clock = 0;
+    generator.seed(seed);
+}
+
+
+/**
+ * @brief       Sets the subnets for uniform demand
+ * @details     Used to pick starts and destinations when no OD pair was added
+ *
+ * @param[in]   names   every subnet of the city
+ *
+ * @note        None
+ */
+void TripGenerator::setSubnets(const std::vector<std::string> & names)
+{
+    subnets = names;
+}
+
+
+/**
+ * @brief       Adds an OD pair
+ * @details     Trips pick a pair with probability proportional to its weight
+ *
+ * @param[in]   source  subnet the trips start at
+ * @param[in]   dest    subnet the trips end at
+ * @param[in]   weight  relative demand of the pair
+ *
+ * @note        None
+ */
+void TripGenerator::addPair(const std::string & source, const std::string & dest, double weight)
+{
+    pairs.push_back(std::make_pair(source, dest));
+    weights.push_back(weight);
+
+    pickPair = std::discrete_distribution<int>(weights.begin(), weights.end());
+}
+
+
+/**
+ * @brief   Shows whether the generator will produce trips
+ * @details Returns true once a positive rate and count were configured
+ * @note    None
+ */
+bool TripGenerator::isConfigured() const
+{
+    return rate > 0 && count > 0;
+}
+
+
+/**
+ * @brief       Writes the generator state
+ * @details     Writes the arrival process and the state of the random number
+ *              generator, so the restored generator draws the same trips
+ *
+ * @param[in]   writer  checkpoint to write to
+ *
+ * @note        None
+ */
+void TripGenerator::save(CheckpointWriter & writer)
+{
+    std::stringstream state;
+
+    state << generator;
+
+    writer.writeDouble(rate);
+    writer.writeInt(count);
+    writer.writeInt(generated);
+    writer.writeDouble(clock);
+    writer.writeString(state.str());
+}
+
+
+/**
+ * @brief       Reads the generator state
+ *
+ * @param[in]   reader  checkpoint to read from
+ *
+ * @note        The OD pairs and subnets come from the input file as before
+ */
+bool TripGenerator::restore(CheckpointReader & reader)
+{
+    std::stringstream state;
+
+    rate = reader.readDouble();
+    count = reader.readInt();
+    generated = reader.readInt();
+    clock = reader.readDouble();
+    state.str(reader.readString());
+
+    state >> generator;
+
+    return reader.isGood() && !state.fail();
+}
+
+
+/**
+ * @brief       Draws the next trip
+ * @details     Advances the clock by an exponential gap and picks an OD pair.
+ *              Uniform picks never start and end at the same subnet.
+ *
+ * @param[out]  trip    next trip
+ *
+ * @note        Returns false once count trips were generated
+ */
+bool TripGenerator::next(Trip & trip)
+{
+    std::exponential_distribution<double> gap(rate);
+    int source, dest, pair;
+
+    if (generated >= count || rate <= 0 || (pairs.empty() && subnets.size() < 2))
+    {
+        return false;
+    }
+
+    clock += gap(generator);
+
+    trip = Trip();
+    trip.departure = clock;
+
+    std::stringstream name;
+    name << "gen" << generated;
+    trip.id = name.str();
+
+    if (!pairs.empty())
+    {
+        pair = pickPair(generator);
+        trip.source = pairs[pair].first;
+        trip.dest = pairs[pair].second;
+    }
+    else
+    {
+        std::uniform_int_distribution<int> pickSubnet(0, (int)subnets.size() - 1);
+
+        source = pickSubnet(generator);
+
+        do
+        {
+            dest = pickSubnet(generator);
+        } while (dest == source);
+
+        trip.source = subnets[source];
+        trip.dest = subnets[dest];
+    }
+
+    generated++;
+
+    return true;
+}
+
+
+/**
+ * @brief       Constructor
+ * @details     Constructs a stream over a trip source
+ *
+ * @param[in]   newSource   trips to stream
+ *
+ * @note        None
+ */
+TripStream::TripStream(TripSource & newSource)
+    : ThreadSafeObject(), source(newSource), waiting(), hasWaiting(false), released(0)
+{
+
+}
+
+/**
+ * @brief   Default destructor
+ * @details Destroys a TripStream object
+ * @note    None
+ */
+TripStream::~TripStream()
+{
+
+}
+
+
+/**
+ * @brief       Look at the next trip
+ * @details     Reads the next trip from the source if none is waiting, and
+ *              returns it without taking it
+ *
+ * @param[out]  trip    next trip
+ *
+ * @note        Returns false once the source is exhausted
+ */
+bool TripStream::peek(Trip & trip)
+{
+    bool found;
+
+    getLock();
+    {
+        if (!hasWaiting)
+        {
+            hasWaiting = source.next(waiting);
+        }
+
+        trip = waiting;
+        found = hasWaiting;
+    }
+    releaseLock();
+
+    return found;
+}
+
+
+/**
+ * @brief   Take the next trip
+ * @details Marks the waiting trip as released
+ * @note    None
+ */
+void TripStream::pop()
+{
+    getLock();
+    {
+        if (hasWaiting)
+        {
+            hasWaiting = false;
+            released++;
+        }
+    }
+    releaseLock();
+}
+
+
+/**
+ * @brief   Get the released count
+ * @details Returns the number of trips taken from the stream
+ * @note    None
+ */
+long long TripStream::getReleasedCount()
+{
+    long long count;
+
+    getLock();
+    {
+        count = released;
+    }
+    releaseLock();
+
+    return count;
+}
+
+
+/**
+ * @brief       Writes the stream
+ * @details     Writes the source state followed by the waiting trip, if any
+ *
+ * @param[in]   writer  checkpoint to write to
+ *
+ * @note        None
+ */
+void TripStream::save(CheckpointWriter & writer)
+{
+    getLock();
+    {
+        source.save(writer);
+
+        writer.writeInt(released);
+        writer.writeInt(hasWaiting ? 1 : 0);
+
+        if (hasWaiting)
+        {
+            waiting.save(writer);
+        }
+    }
+    releaseLock();
+}
+
+
+/**
+ * @brief       Reads the stream
+ *
+ * @param[in]   reader  checkpoint to read from
+ *
+ * @note        Returns false if the source could not be restored
+ */
+bool TripStream::restore(CheckpointReader & reader)
+{
+    bool good;
+
+    getLock();
+    {
+        good = source.restore(reader);
+
+        released = reader.readInt();
+        hasWaiting = reader.readInt() != 0;
+
+        if (hasWaiting)
+        {
+            waiting.load(reader);
+        }
+
+        good = good && reader.isGood();
+    }
+    releaseLock();
+
+    return good;
+}
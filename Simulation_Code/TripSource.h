@@ -0,0 +1,164 @@
+/**
+ * @file    TripSource.h
+ * @brief   Definition file for the TripSource, TripFile and TripGenerator classes
+ *
+ * @author  Andrew Frost, Richard Millar
+ * @version 1.00
+ */
+
+// Precompiler Directives =====================================================
+#ifndef TRIPSOURCE_H
+#define TRIPSOURCE_H
+
+// Header Files ===============================================================
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+#include "JobQueue.h"
+#include "Checkpoint.h"
+#include "ThreadSafeObject.h"
+
+/**
+ * @brief   One vehicle to be released into the city.
+ * @details departure is in seconds from the start of the simulation.
+ */
+struct Trip
+{
+public:
+    Trip();
+    ~Trip();
+
+    void save(CheckpointWriter & writer) const;
+    void load(CheckpointReader & reader);
+
+    double departure;
+    std::string id;
+    std::string source;
+    std::string dest;
+    JobPriority priority;
+    double deadline;
+};
+
+
+// Class Definition ===========================================================
+/**
+ * @brief   Stream of trips in departure order.
+ * @details Trips are produced one at a time, so only the next trip is held in
+ *          memory however long the demand is.
+ *
+ * @class   TripSource TripSource.h "TripSource.h"
+ */
+class TripSource
+{
+public:
+    TripSource();
+    virtual ~TripSource();
+
+    virtual bool next(Trip & trip) = 0;
+
+    virtual void save(CheckpointWriter & writer) = 0;
+    virtual bool restore(CheckpointReader & reader) = 0;
+};
+
+
+/**
+ * @brief   Trips read from a file.
+ * @details Each line holds "departure car-name source destination" followed by
+ *          an optional priority class and deadline, like the car lines of the
+ *          input file. Lines must be sorted by departure; a trip that departs
+ *          before the one read ahead of it is released right away.
+ *
+ * @class   TripFile TripSource.h "TripSource.h"
+ */
+class TripFile : public TripSource
+{
+public:
+    TripFile();
+    ~TripFile();
+
+    bool open(const std::string & fileName);
+
+    bool next(Trip & trip);
+
+    void save(CheckpointWriter & writer);
+    bool restore(CheckpointReader & reader);
+
+private:
+    std::ifstream file;
+    double lastDeparture;
+    long long lineNumber;
+};
+
+
+/**
+ * @brief   Trips drawn from a seeded Poisson process.
+ * @details Departures are spaced by exponential gaps for the given rate, and
+ *          each trip picks a start and destination from the weighted OD pairs,
+ *          or uniformly among the subnets when no pair was added. The same
+ *          seed always produces the same trips.
+ *
+ * @class   TripGenerator TripSource.h "TripSource.h"
+ */
+class TripGenerator : public TripSource
+{
+public:
+    TripGenerator();
+    ~TripGenerator();
+
+    void configure(double newRate, long long newCount, unsigned int seed);
+
+    void setSubnets(const std::vector<std::string> & names);
+    void addPair(const std::string & source, const std::string & dest, double weight);
+
+    bool isConfigured() const;
+
+    bool next(Trip & trip);
+
+    void save(CheckpointWriter & writer);
+    bool restore(CheckpointReader & reader);
+
+private:
+    double rate; //trips per second
+    long long count; //trips left to generate
+    long long generated;
+    double clock; //departure of the last trip
+
+    std::mt19937 generator;
+    std::vector<std::string> subnets;
+    std::vector<std::pair<std::string, std::string> > pairs;
+    std::vector<double> weights;
+    std::discrete_distribution<int> pickPair;
+};
+
+
+/**
+ * @brief   Shared view of a trip source.
+ * @details The injector looks at the next trip until it is due and only then
+ *          takes it, so a checkpoint written in between still holds the trip
+ *          that is waiting. All access goes through the stream's lock.
+ *
+ * @class   TripStream TripSource.h "TripSource.h"
+ */
+class TripStream : public ThreadSafeObject
+{
+public:
+    TripStream(TripSource & newSource);
+    ~TripStream();
+
+    bool peek(Trip & trip);
+    void pop();
+
+    long long getReleasedCount();
+
+    void save(CheckpointWriter & writer);
+    bool restore(CheckpointReader & reader);
+
+private:
+    TripSource & source;
+    Trip waiting; //next trip, read ahead of its departure
+    bool hasWaiting;
+    long long released;
+};
+
+#endif
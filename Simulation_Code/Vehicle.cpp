@@ -14,6 +14,7 @@
 // Header Files ===============================================================
 #include "Vehicle.h"
 #include "CentralComputeNode.h"
+#include "Trace.h"
 
 // Class Implementation =======================================================
 /**
@@ -23,7 +24,8 @@
  */
 Vehicle::Vehicle() 
     : id(""), sourceAddress(""), destAddress(""), travelTime(), totalTime(), 
-    travelTimeLeft(0), route(NULL), routeRequested(false)
+    travelTimeLeft(0), route(NULL), routeRequested(false), priority(PRIORITY_PRIVATE), deadline(0), resumed(false),
+    routeListener()
 {
 
 }
@@ -40,7 +42,8 @@ Vehicle::Vehicle()
  */
 Vehicle::Vehicle(std::string newID, std::string newSource, std::string newDest)
             : id(newID), sourceAddress(newSource), destAddress(newDest), 
-            travelTime(), totalTime(), travelTimeLeft(0), route(NULL), routeRequested(false)
+            travelTime(), totalTime(), travelTimeLeft(0), route(NULL), routeRequested(false),
+            priority(PRIORITY_PRIVATE), deadline(0), resumed(false), routeListener()
 {
     // Constructor Initialized
 }
@@ -57,7 +60,8 @@ Vehicle::Vehicle(std::string newID, std::string newSource, std::string newDest)
 Vehicle::Vehicle(const Vehicle & other)
     : id(other.id), sourceAddress(other.sourceAddress), destAddress(other.destAddress),
     travelTime(other.travelTime), totalTime(other.totalTime),
-    travelTimeLeft(other.travelTimeLeft), route(NULL), routeRequested(other.routeRequested)
+    travelTimeLeft(other.travelTimeLeft), route(NULL), routeRequested(other.routeRequested),
+    priority(other.priority), deadline(other.deadline), resumed(other.resumed), routeListener()
 {
     if (other.route != NULL) 
     {
@@ -83,45 +87,45 @@ Vehicle::~Vehicle()
 
 /**
  * @brief   Sets the time the vehicle begins its journey
- * @details Sets the total time to the current time
+ * @details Sets the total time to the current simulated time
  * @note    None
  */
 void Vehicle::setStartTime() 
 {
-    totalTime = std::chrono::system_clock::now();
+    totalTime = SimClock::now();
 }
 
 
 /**
  * @brief   Set the depart time of the vehicle
- * @details Sets the travel time to the current time
+ * @details Sets the travel time to the current simulated time
  * @note    None
  */
 void Vehicle::setDepartTime() 
 {
-    travelTime = std::chrono::system_clock::now();
+    travelTime = SimClock::now();
 }
 
 
 /**
  * @brief   Get the current travel time between nodes
- * @details Returns the difference between now and the travelTime
+ * @details Returns the simulated time between now and the travelTime
  * @note    None
  */
 std::chrono::duration<double> Vehicle::getTravelTime() const
 {
-    return (std::chrono::system_clock::now() - travelTime);
+    return (SimClock::now() - travelTime);
 }
 
 
 /**
  * @brief   Get the total travel time
- * @details Returns the totalTime
+ * @details Returns the simulated time since the totalTime
  * @note    None
  */
 std::chrono::duration<double> Vehicle::getTotalTime() const
 {
-    return (std::chrono::system_clock::now() - totalTime);
+    return (SimClock::now() - totalTime);
 }
 
 
@@ -157,6 +161,18 @@ bool Vehicle::timeRemainingToNextDestination() const
 }
 
 
+/**
+ * @brief   Get the time the vehicle reaches its next node
+ * @details Returns the depart time plus the travel time of the current road
+ * @note    None
+ */
+SimClock::time_point Vehicle::getArrivalTime() const
+{
+    return travelTime + std::chrono::duration_cast<SimClock::duration>(
+        std::chrono::duration<double>(travelTimeLeft));
+}
+
+
 /**
  * @brief   Clears the vehicle route
  * @details Deletes the current vehicle route
@@ -184,6 +200,17 @@ bool Vehicle::hasRoute() const
 }
 
 
+/**
+ * @brief   Get a copy of the route
+ * @details Returns an empty route if the vehicle has none
+ * @note    None
+ */
+std::list<std::pair<std::string, double> > Vehicle::getRoute() const
+{
+    return route != NULL ? *route : std::list<std::pair<std::string, double> >();
+}
+
+
 /**
  * @brief   Get Vehicle ID
  * @details Returns the vehicle ID
@@ -217,6 +244,34 @@ std::string Vehicle::getDest()
 }
 
 
+/**
+ * @brief       Set the priority class
+ * @details     Route requests of the vehicle are queued in this class, with the
+ *              given deadline
+ * 
+ * @param[in]   newPriority     priority class of the vehicle
+ * @param[in]   newDeadline     seconds a route request may wait, 0 for none
+ * 
+ * @note        None
+ */
+void Vehicle::setPriority(JobPriority newPriority, double newDeadline)
+{
+    priority = newPriority;
+    deadline = newDeadline;
+}
+
+
+/**
+ * @brief   Get the priority class
+ * @details Returns the class route requests of the vehicle are queued in
+ * @note    None
+ */
+JobPriority Vehicle::getPriority() const
+{
+    return priority;
+}
+
+
 /**
  * @brief       Determine whether vehicle is traveling to node
  * @details     Returns whether the node is within the vehicle route
@@ -244,19 +299,25 @@ bool Vehicle::hasNode(const std::string &node) const
 
 /**
  * @brief       Request a new route from ccn
- * @details     Send a job request to ccn to set a new route
+ * @details     Send a job request to ccn to set a new route. If the ccn is
+ *              overloaded it may answer at once with a cached route, or turn the
+ *              request away.
  * 
  * @param[in]   ccn     Central compute node
  * 
- * @note        None
+ * @note        Returns false if the request was rejected and has to be sent again
  */
-void Vehicle::requestRoute(CentralComputeNode & ccn)
+bool Vehicle::requestRoute(CentralComputeNode & ccn)
 {
+    TRACE_SCOPE("vehicle", "requestRoute");
+
     Job job;
+    Route staleRoute;
+    AdmissionResult result;
 
     if(routeRequested)
     {
-        return;
+        return true;
     }
 
     job.start = sourceAddress;
@@ -265,9 +326,25 @@ void Vehicle::requestRoute(CentralComputeNode & ccn)
 
     job.id = id;
 
-    ccn.queueJob(job);
+    job.priority = priority;
+
+    job.deadline = deadline;
+
+    result = ccn.queueJob(job, staleRoute);
+
+    if(result == JOB_REJECTED)
+    {
+        return false;
+    }
 
     routeRequested = true;
+
+    if(result == JOB_STALE)
+    {
+        setRoute(staleRoute.route);
+    }
+
+    return true;
 }
 
 
@@ -291,6 +368,27 @@ void Vehicle::setRoute(std::list<std::pair<std::string, double>> newRoute)
     }
 
     routeRequested = false;
+
+    if(routeListener)
+    {
+        routeListener();
+    }
+}
+
+
+/**
+ * @brief       Sets the function called when a route is set
+ * @details     Lets a vehicle that is not polling find out its route has come.
+ *              The listener runs under the vehicle's lock, and under the CCN's
+ *              when the CCN delivers the route, so it must not take either.
+ *
+ * @param[in]   listener    function to call, or an empty function for none
+ *
+ * @note        None
+ */
+void Vehicle::setRouteListener(const std::function<void()> & listener)
+{
+    routeListener = listener;
 }
 
 
@@ -298,10 +396,10 @@ void Vehicle::setRoute(std::list<std::pair<std::string, double>> newRoute)
  * @brief       Try to do a road change
  * @details     If the object can change its current road do so, else wait
  * 
- * @param[in]   ccn     Central compute node to send requests to
+ * @param[in]   authority   decides the road change, the Compute Node or a region
  * @note        None
  */
-bool Vehicle::tryRoadChange(CentralComputeNode & ccn)
+bool Vehicle::tryRoadChange(RoadAuthority & authority)
 {
     Job job;
     std::pair<std::string, double> node;
@@ -313,7 +411,7 @@ bool Vehicle::tryRoadChange(CentralComputeNode & ccn)
 
     if(!route->empty())
     {
-        success = ccn.changeRoad(id, sourceAddress, node.first);
+        success = authority.changeRoad(id, sourceAddress, node.first);
     }
     else 
     {        
@@ -335,4 +433,110 @@ bool Vehicle::tryRoadChange(CentralComputeNode & ccn)
     return success;
 }
 
+
+/**
+ * @brief       Writes the vehicle to a checkpoint
+ * @details     Writes where the vehicle is, where it is going, the rest of its
+ *              route and how far along its clocks are
+ * 
+ * @param[in]   writer  checkpoint to write to
+ * 
+ * @note        The caller holds the lock of the vehicle
+ */
+void Vehicle::save(CheckpointWriter & writer) const
+{
+    std::list<std::pair<std::string, double> >::const_iterator node;
+
+    writer.writeString(id);
+    writer.writeString(sourceAddress);
+    writer.writeString(destAddress);
+    writer.writeInt(priority);
+    writer.writeDouble(deadline);
+
+    writer.writeDouble(getTotalTime().count());
+    writer.writeDouble(getTravelTime().count());
+    writer.writeDouble(travelTimeLeft);
+
+    writer.writeInt(route != NULL ? (long long)route->size() : -1);
+
+    if (route != NULL)
+    {
+        for (node = route->begin(); node != route->end(); ++node)
+        {
+            writer.writeString(node->first);
+            writer.writeDouble(node->second);
+        }
+    }
+}
+
+
+/**
+ * @brief       Reads the vehicle from a checkpoint
+ * @details     Restores the vehicle as it was written and winds its clocks back
+ *              by the time that had passed, so it carries on along the road it
+ *              was on. A pending route request is not restored, the vehicle
+ *              asks again and joins its restored job.
+ * 
+ * @param[in]   reader  checkpoint to read from
+ * 
+ * @note        Returns false if the checkpoint ended early
+ */
+bool Vehicle::restore(CheckpointReader & reader)
+{
+    SimClock::time_point now = SimClock::now();
+    double totalSeconds, travelSeconds, cost;
+    long long readPriority, nodeCount, index;
+    std::string node;
+
+    id = reader.readString();
+    sourceAddress = reader.readString();
+    destAddress = reader.readString();
+    readPriority = reader.readInt();
+    deadline = reader.readDouble();
+
+    totalSeconds = reader.readDouble();
+    travelSeconds = reader.readDouble();
+    travelTimeLeft = reader.readDouble();
+
+    nodeCount = reader.readInt();
+
+    priority = (readPriority >= 0 && readPriority < PRIORITY_COUNT) ? (JobPriority)readPriority : PRIORITY_PRIVATE;
+
+    clearRoute();
+
+    if (nodeCount >= 0)
+    {
+        route = new std::list<std::pair<std::string, double> >();
+
+        for (index = 0; index < nodeCount && reader.isGood(); index++)
+        {
+            node = reader.readString();
+            cost = reader.readDouble();
+            route->push_back(std::make_pair(node, cost));
+        }
+    }
+
+    totalTime = now - std::chrono::duration_cast<SimClock::duration>(
+                    std::chrono::duration<double>(totalSeconds));
+    travelTime = now - std::chrono::duration_cast<SimClock::duration>(
+                     std::chrono::duration<double>(travelSeconds));
+
+    routeRequested = false;
+    resumed = true;
+
+    return reader.isGood();
+}
+
+
+/**
+ * @brief   Shows whether the vehicle was restored
+ * @details Returns true for vehicles read from a checkpoint, whose start and
+ *          depart times are already set
+ * @note    None
+ */
+bool Vehicle::isResumed() const
+{
+    return resumed;
+}
+
 #endif
\ No newline at end of file
@@ -12,8 +12,13 @@
 #include <list>
 #include <string>
 #include <chrono>
+#include <functional>
 #include "ThreadSafeObject.h"
+#include "JobQueue.h"
+#include "Checkpoint.h"
 #include "CentralComputeNode.h"
+#include "RoadAuthority.h"
+#include "SimClock.h"
 
 class CentralComputeNode;
 
@@ -40,34 +45,51 @@ class Vehicle : public ThreadSafeObject
 		std::string getNextDestination() const;
 
         bool timeRemainingToNextDestination() const;
+        SimClock::time_point getArrivalTime() const;
 
         void clearRoute();
 
         bool hasRoute() const;
         bool hasNode(const std::string &node) const;
+        std::list<std::pair<std::string, double> > getRoute() const;
 
         std::string getID();
         std::string getSource();
         std::string getDest();
+
+        void setPriority(JobPriority newPriority, double newDeadline);
+        JobPriority getPriority() const;
 		
-        void requestRoute(CentralComputeNode & ccn);
+        bool requestRoute(CentralComputeNode & ccn);
 		void setRoute(std::list<std::pair<std::string, double>> newRoute);
+        void setRouteListener(const std::function<void()> & listener);
+
+        bool tryRoadChange(RoadAuthority & authority);
 
-        bool tryRoadChange(CentralComputeNode & ccn);
+        void save(CheckpointWriter & writer) const;
+        bool restore(CheckpointReader & reader);
+        bool isResumed() const;
 
 
 	private:
 		std::string id;
 		std::string sourceAddress;
 	    std::string destAddress;
-        std::chrono::time_point<std::chrono::system_clock> travelTime;
-        std::chrono::time_point<std::chrono::system_clock> totalTime;
+        SimClock::time_point travelTime;
+        SimClock::time_point totalTime;
 
         double travelTimeLeft;
 
 		std::list<std::pair<std::string, double>>* route;
 
         bool routeRequested;
+
+        JobPriority priority;
+        double deadline; //seconds a route request may wait, 0 for none
+
+        bool resumed; //restored from a checkpoint, its clocks are already running
+
+        std::function<void()> routeListener; //called when a route is set, not copied
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,900 @@
+/**
+ * @file    VehicleAgent.cpp
+ *
+ * @brief   Implementation file for the VehicleAgent and AgentScheduler classes
+ *
+ * @author  Andrew Frost, Richard Millar
+ * @version 1.00
+ */
+
+// Header Files ===============================================================
+#include <iostream>
+#include <algorithm>
+#include <string>
+#include "VehicleAgent.h"
+#include "Trace.h"
+
+// Class Implementation =======================================================
+/**
+ * @brief       VehicleAgent constructor
+ *
+ * @param[in]   newCar          vehicle to run, copied into the agent
+ * @param[in]   newRetryMS      wait before asking again when turned away
+ * @param[in]   newStream       stream the car was taken from, or NULL
+ * @param[in]   newActiveCars   counter to count the agent off when it ends, or NULL
+ * @param[in]   newBarrier      barrier to arrive at once joined, or NULL
+ *
+ * @note        None
+ */
+VehicleAgent::VehicleAgent(const Vehicle & newCar, long long newRetryMS, TripStream* newStream,
+                           std::atomic_int* newActiveCars, StartupBarrier* newBarrier)
+    : car(newCar), retryMS(newRetryMS), stream(newStream), activeCars(newActiveCars), barrier(newBarrier),
+      step(AGENT_JOIN),
+      started(newCar.isResumed() && newCar.hasRoute()), routeRequested(false), handoffSubnet(-1),
+      shard(0), waitingForRoute(false), routeArrived(false)
+{
+    //a car restored on the road carries on without departing again
+}
+
+
+/**
+ * @brief   VehicleAgent destructor
+ * @details Counts the agent off, like a streamed car thread that returns
+ * @note    None
+ */
+VehicleAgent::~VehicleAgent()
+{
+    if(activeCars != NULL)
+    {
+        (*activeCars)--;
+    }
+}
+
+
+/**
+ * @brief       Run the vehicle until it has to wait
+ *
+ * @param[in]   ccn             central compute node
+ * @param[in]   consoleLock     lock for the console output
+ * @param[in]   region          region the agent is in, or NULL if the CCN
+ *                              decides road changes
+ * @param[out]  wakeTime        time to resume at, for AGENT_WAIT_TIMER
+ *
+ * @note        Returns what the agent waits for
+ */
+AgentWait VehicleAgent::resume(CentralComputeNode & ccn, ThreadSafeObject & consoleLock, AgentRegion* region,
+                               SimClock::time_point & wakeTime)
+{
+    switch(step)
+    {
+        case AGENT_JOIN:
+            join(ccn, consoleLock, region);
+            step = AGENT_DRIVE;
+            return drive(ccn, consoleLock, region, wakeTime);
+
+        case AGENT_DRIVE:
+            return drive(ccn, consoleLock, region, wakeTime);
+
+        default:
+            return AGENT_DONE;
+    }
+}
+
+
+/**
+ * @brief   Get the vehicle of the agent
+ * @note    Only while the agent is not running
+ */
+const Vehicle & VehicleAgent::getVehicle() const
+{
+    return car;
+}
+
+
+/**
+ * @brief   Get the subnet the agent waits to enter, after AGENT_HANDOFF
+ * @note    None
+ */
+int VehicleAgent::getHandoffSubnet() const
+{
+    return handoffSubnet;
+}
+
+
+/**
+ * @brief       Start the vehicle and join the network
+ *
+ * @param[in]   ccn             central compute node
+ * @param[in]   consoleLock     lock for the console output
+ * @param[in]   region          region the agent is in, or NULL
+ *
+ * @note        None
+ */
+void VehicleAgent::join(CentralComputeNode & ccn, ThreadSafeObject & consoleLock, AgentRegion* region)
+{
+    consoleLock.getLock();
+    {
+        std::cout << "Vehicle " << car.getID() << " started." << std::endl;
+    }
+    consoleLock.releaseLock();
+
+    car.getLock();
+    {
+        if(!car.isResumed())
+        {
+            car.setStartTime();
+        }
+
+        consoleLock.getLock();
+        {
+            std::cout << "Car " + car.getID() << " is joining the network." << std::endl;
+        }
+        consoleLock.releaseLock();
+    }
+    car.releaseLock();
+
+    ccn.getLock();
+    {
+        ccn.joinNetwork(&car);
+        TRACE_INSTANT("vehicle", "join", car.getSource());
+
+        //checkpoints now find the car on the network rather than in the stream
+        if(stream != NULL)
+        {
+            stream->pop();
+        }
+    }
+    ccn.releaseLock();
+
+    if(region != NULL)
+    {
+        region->join(car.getSource());
+    }
+
+    if(barrier != NULL)
+    {
+        barrier->arrive();
+    }
+}
+
+
+/**
+ * @brief       Drive the vehicle until it has to wait
+ * @details     Does what a car thread does in one time step, but straight
+ *              away and as often as it can: departs, changes road on arrival
+ *              and asks for a new route when refused. Stops at the first thing
+ *              it has to wait for. In a region, road changes are decided by the
+ *              region without the lock of the CCN.
+ *
+ * @param[in]   ccn             central compute node
+ * @param[in]   consoleLock     lock for the console output
+ * @param[in]   region          region the agent is in, or NULL
+ * @param[out]  wakeTime        time to resume at, for AGENT_WAIT_TIMER
+ *
+ * @note        Returns what the agent waits for
+ */
+AgentWait VehicleAgent::drive(CentralComputeNode & ccn, ThreadSafeObject & consoleLock, AgentRegion* region,
+                              SimClock::time_point & wakeTime)
+{
+    AgentWait wait = AGENT_WAIT_ROUTE;
+    bool driving = true;
+    bool changed;
+
+    car.getLock();
+
+    while(driving)
+    {
+        if(car.hasRoute())
+        {
+            //start moving to destination
+            if(!started)
+            {
+                started = true;
+                car.setDepartTime();
+                TRACE_INSTANT("vehicle", "depart", car.getSource());
+
+                consoleLock.getLock();
+                {
+                    std::cout << "Car " + car.getID() << " is departing for "
+                        << car.getDest() << " from " << car.getSource() << "." << std::endl;
+                }
+                consoleLock.releaseLock();
+            }
+
+            //if at dest, then complete
+            if(car.getNextDestination() == "")
+            {
+                TRACE_INSTANT("vehicle", "finish", car.getDest());
+
+                consoleLock.getLock();
+                {
+                    std::cout << "Car " + car.getID() << " has reached "
+                        << car.getDest() << "." << std::endl;
+
+                    std::cout << "Car " + car.getID() << " is finished in: "
+                        << std::chrono::duration_cast<std::chrono::seconds>(car.getTotalTime()).count()
+                        << " seconds." << std::endl;
+                }
+                consoleLock.releaseLock();
+
+                ccn.getLock();
+                {
+                    //the CCN hears of the region's road changes before the car leaves
+                    if(region != NULL)
+                    {
+                        region->flush(ccn);
+                    }
+
+                    ccn.leaveNetwork(car.getID(), car.getSource());
+                }
+                ccn.releaseLock();
+
+                if(region != NULL)
+                {
+                    region->leave(car.getSource());
+                }
+
+                step = AGENT_FINISHED;
+                wait = AGENT_DONE;
+                driving = false;
+            }
+            else if(car.timeRemainingToNextDestination())
+            {
+                //sleep until the car reaches the node
+                wakeTime = car.getArrivalTime();
+                wait = AGENT_WAIT_TIMER;
+                driving = false;
+            }
+            else
+            {
+                if(region != NULL)
+                {
+                    changed = car.tryRoadChange(*region); //--- Try road change
+                    handoffSubnet = changed ? -1 : region->takeHandoff();
+                }
+                else
+                {
+                    ccn.getLock();
+                    {
+                        changed = car.tryRoadChange(ccn); //--- Try road change
+                    }
+                    ccn.releaseLock();
+
+                    handoffSubnet = -1;
+                }
+
+                if(handoffSubnet >= 0)
+                {
+                    //the region of the next subnet decides, the agent moves there to wait
+                    TRACE_INSTANT("vehicle", "handoff", car.getNextDestination());
+
+                    wait = AGENT_HANDOFF;
+                    driving = false;
+                }
+                else if(changed)
+                {
+                    TRACE_INSTANT("vehicle", "reach", car.getSource());
+
+                    consoleLock.getLock();
+                    {
+                        std::cout << "Car " + car.getID() << " has reached "
+                            << car.getSource() << "." << std::endl;
+                    }
+                    consoleLock.releaseLock();
+                    car.setDepartTime();
+                }
+                else
+                {
+                    consoleLock.getLock();
+                    {
+                        std::cout << "Car " + car.getID() << " has failed to turn on to "
+                            << car.getNextDestination() << "." << std::endl;
+                    }
+                    consoleLock.releaseLock();
+
+                    TRACE_INSTANT("vehicle", "refused", car.getNextDestination());
+
+                    car.clearRoute();
+
+                    //ask for a new route after a step, as a car thread would
+                    routeRequested = false;
+                    wakeTime = SimClock::now() + std::chrono::milliseconds(retryMS);
+                    wait = AGENT_WAIT_TIMER;
+                    driving = false;
+                }
+            }
+        }
+        else if(!routeRequested)
+        {
+            routeRequested = true;
+
+            //request a route
+            consoleLock.getLock();
+            {
+                std::cout << "Car " + car.getID() << " is requesting a route from " << car.getSource() << " to " << car.getDest() << "." << std::endl;
+            }
+            consoleLock.releaseLock();
+
+            ccn.getLock();
+            {
+                //an overloaded ccn may turn the request away, ask again later
+                if(!car.requestRoute(ccn))
+                {
+                    routeRequested = false;
+                    TRACE_INSTANT("vehicle", "turned away", car.getSource());
+
+                    consoleLock.getLock();
+                    {
+                        std::cout << "Car " + car.getID() << " was turned away by the CCN." << std::endl;
+                    }
+                    consoleLock.releaseLock();
+
+                    wakeTime = SimClock::now() + std::chrono::milliseconds(retryMS);
+                    wait = AGENT_WAIT_TIMER;
+                    driving = false;
+                }
+            }
+            ccn.releaseLock();
+        }
+        else
+        {
+            //the CCN wakes the agent when the route is set
+            wait = AGENT_WAIT_ROUTE;
+            driving = false;
+        }
+    }
+
+    car.releaseLock();
+
+    return wait;
+}
+
+
+/**
+ * @brief       AgentScheduler constructor
+ * @details     With a partition there is one shard and region for each region
+ *              of the partition, and shardCount is not used
+ *
+ * @param[in]   newCcn          central compute node the agents drive on
+ * @param[in]   newConsoleLock  lock for the console output
+ * @param[in]   shardCount      number of scheduler threads, at least one
+ * @param[in]   newPartition    split of the city into regions, or NULL
+ *
+ * @note        Reads the subnets of the CCN, so call before the CCN runs
+ */
+AgentScheduler::AgentScheduler(CentralComputeNode & newCcn, ThreadSafeObject & newConsoleLock, int shardCount,
+                               const RoadPartition* newPartition)
+    : ccn(newCcn), consoleLock(newConsoleLock), partition(newPartition), subnets(), shards(), threads(),
+      epoch(SimClock::now()), stopping(false), spawned(0)
+{
+    std::vector<AgentRegion*> regions;
+    std::vector<std::string> names;
+    std::vector<int> capacities;
+    int index;
+
+    if(partition != NULL && partition->getRegionCount() > 0)
+    {
+        shardCount = partition->getRegionCount();
+
+        ccn.getLock();
+        {
+            ccn.getSubnets(names, capacities);
+        }
+        ccn.releaseLock();
+
+        subnets.build(names, capacities);
+    }
+    else
+    {
+        partition = NULL;
+    }
+
+    for(index = 0; index < std::max(1, shardCount); index++)
+    {
+        shards.push_back(std::unique_ptr<AgentShard>(new AgentShard()));
+
+        if(partition != NULL)
+        {
+            shards.back()->region.reset(new AgentRegion(index, *partition, subnets));
+            regions.push_back(shards.back()->region.get());
+        }
+    }
+
+    for(index = 0; index < (int)regions.size(); index++)
+    {
+        regions[index]->connect(regions, [this](int shard)
+        {
+            notifyShard(shard);
+        });
+    }
+}
+
+
+/**
+ * @brief   AgentScheduler destructor
+ * @details Stops the threads and frees the agents left
+ * @note    None
+ */
+AgentScheduler::~AgentScheduler()
+{
+    stop();
+}
+
+
+/**
+ * @brief       Add a vehicle to the scheduler
+ * @details     The agent is placed on the shard of the region it starts in, or
+ *              on the next shard in turn, and runs as soon as its thread gets
+ *              to it
+ *
+ * @param[in]   car         vehicle to run, copied into the agent
+ * @param[in]   retryMS     wait before asking again when turned away
+ * @param[in]   stream      stream the car was taken from, or NULL
+ * @param[in]   activeCars  counter to count the agent off when it ends, or NULL
+ * @param[in]   barrier     barrier the agent arrives at once joined, or NULL
+ *
+ * @note        None
+ */
+void AgentScheduler::spawn(const Vehicle & car, long long retryMS, TripStream* stream, std::atomic_int* activeCars,
+                           StartupBarrier* barrier)
+{
+    VehicleAgent* agent = new VehicleAgent(car, retryMS, stream, activeCars, barrier);
+    int shard = (int)(spawned++ % (long long)shards.size());
+    int source = partition != NULL ? subnets.find(agent->car.getSource()) : -1;
+
+    if(source >= 0)
+    {
+        shard = partition->getRegion(source);
+    }
+
+    AgentShard & owner = *shards[shard];
+
+    agent->shard = shard;
+    agent->car.setRouteListener([this, agent]()
+    {
+        wake(agent);
+    });
+
+    std::lock_guard<std::mutex> guard(owner.mutex);
+
+    if(stopping)
+    {
+        delete agent;
+        return;
+    }
+
+    owner.agents.insert(agent);
+    owner.ready.push_back(agent);
+    owner.wakeup.notify_one();
+}
+
+
+/**
+ * @brief   Start a thread for each shard
+ * @note    None
+ */
+void AgentScheduler::start()
+{
+    int shard;
+
+    for(shard = 0; shard < (int)shards.size(); shard++)
+    {
+        threads.push_back(std::thread(&AgentScheduler::run, this, shard));
+    }
+}
+
+
+/**
+ * @brief   Stop the threads
+ * @details Agents still on the road are freed, as car threads return when the
+ *          simulator stops, including those on their way between regions
+ * @note    Call once nothing else uses the vehicles, the CCN still points to
+ *          the vehicles of the agents on the network
+ */
+void AgentScheduler::stop()
+{
+    std::unordered_set<VehicleAgent*>::iterator agent;
+    std::vector<VehicleAgent*> moving;
+    int shard;
+
+    for(shard = 0; shard < (int)shards.size(); shard++)
+    {
+        std::lock_guard<std::mutex> guard(shards[shard]->mutex);
+
+        stopping = true;
+        shards[shard]->wakeup.notify_all();
+    }
+
+    for(shard = 0; shard < (int)threads.size(); shard++)
+    {
+        threads[shard].join();
+    }
+
+    threads.clear();
+
+    for(shard = 0; shard < (int)shards.size(); shard++)
+    {
+        AgentShard & owner = *shards[shard];
+
+        for(agent = owner.agents.begin(); agent != owner.agents.end(); ++agent)
+        {
+            delete *agent;
+        }
+
+        owner.agents.clear();
+        owner.ready.clear();
+
+        if(owner.region)
+        {
+            owner.region->takeAgents(moving);
+        }
+    }
+
+    for(shard = 0; shard < (int)moving.size(); shard++)
+    {
+        delete moving[shard];
+    }
+}
+
+
+/**
+ * @brief   Print how often the agents were resumed and why
+ * @details With regions, also how many agents crossed between regions, how
+ *          many were refused at a boundary, on the region's own count or a
+ *          ghost copy, and how often the regions updated the CCN
+ * @note    Call once the scheduler has stopped
+ */
+void AgentScheduler::printStatistics() const
+{
+    long long resumes = 0, timerWakes = 0, routeWakes = 0;
+    long long handoffs = 0, boundaryRefusals = 0, ghostRefusals = 0, syncs = 0;
+    int shard;
+
+    for(shard = 0; shard < (int)shards.size(); shard++)
+    {
+        std::lock_guard<std::mutex> guard(shards[shard]->mutex);
+
+        resumes += shards[shard]->resumes;
+        timerWakes += shards[shard]->timerWakes;
+        routeWakes += shards[shard]->routeWakes;
+
+        if(shards[shard]->region)
+        {
+            handoffs += shards[shard]->region->getHandoffCount();
+            boundaryRefusals += shards[shard]->region->getBoundaryRefusalCount();
+            ghostRefusals += shards[shard]->region->getGhostRefusalCount();
+            syncs += shards[shard]->region->getSyncCount();
+        }
+    }
+
+    std::cout << "Agents: " << spawned << " on " << shards.size() << " threads, " << resumes
+              << " resumes, " << timerWakes << " on timers, " << routeWakes << " on routes." << std::endl;
+
+    if(partition != NULL)
+    {
+        std::cout << "Regions: " << handoffs << " handoffs, " << boundaryRefusals << " refused at a boundary, "
+                  << ghostRefusals << " refused on a ghost copy, " << syncs << " CCN updates." << std::endl;
+    }
+}
+
+
+/**
+ * @brief       Run the agents of one shard
+ * @details     Handles the messages from other regions, moves the due timers
+ *              to the ready queue, resumes the ready agents in turn, and sleeps
+ *              until the next timer or wake up. A region updates the CCN when
+ *              it has REGION_SYNC_CHANGES road changes batched or nothing else
+ *              to do.
+ *
+ * @param[in]   shard   shard to run
+ *
+ * @note        Agents are resumed without the shard's lock, so the CCN can wake
+ *              agents of the shard while one of them runs. Region work is done
+ *              without it too, as regions lock each other's shards to wake them.
+ */
+void AgentScheduler::run(int shard)
+{
+    AgentShard & owner = *shards[shard];
+    AgentRegion* region = owner.region.get();
+    SimClock::time_point wakeTime;
+    std::vector<VehicleAgent*> due, adopted;
+    std::vector<VehicleAgent*>::iterator moved;
+    VehicleAgent* agent;
+    AgentWait wait;
+    bool backlogged = false;
+    long long next;
+
+    TRACE_THREAD_NAME("agents " + std::to_string(shard));
+
+    std::unique_lock<std::mutex> lock(owner.mutex);
+
+    while(!stopping)
+    {
+        if(region != NULL)
+        {
+            lock.unlock();
+            adopted.clear();
+            region->receive(adopted);
+            backlogged = region->deliver();
+            lock.lock();
+
+            for(moved = adopted.begin(); moved != adopted.end(); ++moved)
+            {
+                (*moved)->shard = shard;
+                owner.agents.insert(*moved);
+                owner.ready.push_back(*moved);
+            }
+        }
+
+        due.clear();
+        owner.timers.advance(tickOf(SimClock::now(), false), due);
+        owner.ready.insert(owner.ready.end(), due.begin(), due.end());
+        owner.timerWakes += (long long)due.size();
+
+        if(owner.ready.empty())
+        {
+            if(region != NULL && region->getChangeCount() > 0)
+            {
+                lock.unlock();
+                sync(*region);
+                lock.lock();
+                continue;
+            }
+
+            //a message may have come in since the region looked
+            if(region != NULL && region->checkMail())
+            {
+                continue;
+            }
+
+            next = owner.timers.nextTick();
+
+            if(backlogged)
+            {
+                //a full queue to another region, try again shortly
+                owner.wakeup.wait_for(lock, std::chrono::milliseconds(1));
+            }
+            else if(next < 0)
+            {
+                owner.wakeup.wait(lock);
+            }
+            else
+            {
+                owner.wakeup.wait_until(lock, SimClock::toWall(epoch + std::chrono::milliseconds(next)));
+            }
+
+            continue;
+        }
+
+        agent = owner.ready.front();
+        owner.ready.pop_front();
+        agent->routeArrived = false;
+        owner.resumes++;
+
+        lock.unlock();
+
+        if(region != NULL)
+        {
+            region->setCurrentAgent(agent);
+        }
+
+        wait = agent->resume(ccn, consoleLock, region, wakeTime);
+
+        if(wait == AGENT_HANDOFF)
+        {
+            //the CCN hears of the agent's moves here before any in the next region
+            sync(*region);
+            region->handoff(agent, agent->getHandoffSubnet());
+        }
+
+        if(region != NULL)
+        {
+            backlogged = region->deliver();
+
+            if(region->getChangeCount() >= REGION_SYNC_CHANGES)
+            {
+                sync(*region);
+            }
+        }
+
+        lock.lock();
+
+        settle(owner, agent, wait, wakeTime);
+    }
+}
+
+
+/**
+ * @brief       Run the agents that are due on the calling thread
+ * @details     Moves the timers due by the simulated time to the ready queue
+ *              and resumes the ready agents in turn, including those woken
+ *              while it runs, until none is ready. The agents are resumed in
+ *              the order they became ready, so a run stepped by one thread is
+ *              the same every time.
+ *
+ * @note        Returns the number of agents resumed. Only for a scheduler of
+ *              one shard without regions that was not started.
+ */
+int AgentScheduler::runDue()
+{
+    AgentShard & owner = *shards[0];
+    SimClock::time_point wakeTime;
+    std::vector<VehicleAgent*> due;
+    VehicleAgent* agent;
+    AgentWait wait;
+    int resumed = 0;
+
+    std::unique_lock<std::mutex> lock(owner.mutex);
+
+    owner.timers.advance(tickOf(SimClock::now(), false), due);
+    owner.ready.insert(owner.ready.end(), due.begin(), due.end());
+    owner.timerWakes += (long long)due.size();
+
+    while(!stopping && !owner.ready.empty())
+    {
+        agent = owner.ready.front();
+        owner.ready.pop_front();
+        agent->routeArrived = false;
+        owner.resumes++;
+        resumed++;
+
+        lock.unlock();
+        wait = agent->resume(ccn, consoleLock, NULL, wakeTime);
+        lock.lock();
+
+        settle(owner, agent, wait, wakeTime);
+    }
+
+    return resumed;
+}
+
+
+/**
+ * @brief       Get when the next timer of a stepped run is due
+ *
+ * @param[out]  time    simulated time of the next timer
+ *
+ * @note        Returns false if no timer is set. Only for a scheduler of one
+ *              shard without regions.
+ */
+bool AgentScheduler::getNextTimer(SimClock::time_point & time)
+{
+    AgentShard & owner = *shards[0];
+    std::lock_guard<std::mutex> guard(owner.mutex);
+    long long next = owner.timers.nextTick();
+
+    if(next < 0)
+    {
+        return false;
+    }
+
+    time = epoch + std::chrono::milliseconds(next);
+
+    return true;
+}
+
+
+/**
+ * @brief       Put an agent where it waits after a resume
+ *
+ * @param[in]   owner       shard the agent ran on
+ * @param[in]   agent       agent that ran
+ * @param[in]   wait        what the agent waits for
+ * @param[in]   wakeTime    time to resume at, for AGENT_WAIT_TIMER
+ *
+ * @note        Called under the shard's lock
+ */
+void AgentScheduler::settle(AgentShard & owner, VehicleAgent* agent, AgentWait wait, SimClock::time_point wakeTime)
+{
+    if(wait == AGENT_DONE)
+    {
+        owner.agents.erase(agent);
+        delete agent;
+    }
+    else if(wait == AGENT_HANDOFF)
+    {
+        //the other region's thread runs the agent from now on
+        owner.agents.erase(agent);
+    }
+    else if(wait == AGENT_WAIT_TIMER)
+    {
+        //rounded up, so the agent never wakes before it has arrived
+        owner.timers.schedule(tickOf(wakeTime, true), agent);
+    }
+    else if(agent->routeArrived)
+    {
+        //the route came after the agent looked for it
+        owner.ready.push_back(agent);
+        owner.routeWakes++;
+    }
+    else
+    {
+        agent->waitingForRoute = true;
+    }
+}
+
+
+/**
+ * @brief       Wake an agent whose route has been set
+ * @details     Called from Vehicle::setRoute under the vehicle's lock. An
+ *              agent that is running is marked instead, and queued again as
+ *              soon as it waits for its route.
+ *
+ * @param[in]   agent   agent to wake
+ *
+ * @note        None
+ */
+void AgentScheduler::wake(VehicleAgent* agent)
+{
+    AgentShard & owner = *shards[agent->shard];
+    std::lock_guard<std::mutex> guard(owner.mutex);
+
+    if(agent->waitingForRoute)
+    {
+        agent->waitingForRoute = false;
+        owner.ready.push_back(agent);
+        owner.routeWakes++;
+        owner.wakeup.notify_one();
+    }
+    else
+    {
+        agent->routeArrived = true;
+    }
+}
+
+
+/**
+ * @brief       Wake the thread of a shard
+ * @details     Called by a region that has sent messages to the shard's region
+ *
+ * @param[in]   shard   shard to wake
+ *
+ * @note        None
+ */
+void AgentScheduler::notifyShard(int shard)
+{
+    std::lock_guard<std::mutex> guard(shards[shard]->mutex);
+
+    shards[shard]->wakeup.notify_one();
+}
+
+
+/**
+ * @brief       Apply a region's batched road changes to the CCN
+ *
+ * @param[in]   region  region to flush
+ *
+ * @note        Called by the region's thread without its shard's lock
+ */
+void AgentScheduler::sync(AgentRegion & region)
+{
+    TRACE_SCOPE("region", "sync");
+
+    ccn.getLock();
+    {
+        region.flush(ccn);
+    }
+    ccn.releaseLock();
+}
+
+
+/**
+ * @brief       Convert a time to a tick of the timer wheels
+ *
+ * @param[in]   time        time to convert
+ * @param[in]   roundUp     round a time between ticks up rather than down
+ *
+ * @note        Ticks are simulated milliseconds from the scheduler's epoch
+ */
+long long AgentScheduler::tickOf(SimClock::time_point time, bool roundUp) const
+{
+    SimClock::duration offset = time - epoch;
+    std::chrono::milliseconds tick = std::chrono::duration_cast<std::chrono::milliseconds>(offset);
+
+    if(roundUp && tick < offset)
+    {
+        tick += std::chrono::milliseconds(1);
+    }
+
+    return tick.count();
+}
@@ -0,0 +1,172 @@
+/**
+ * @file    VehicleAgent.h
+ * @brief   Definition file for the VehicleAgent and AgentScheduler classes
+ *
+ * @author  Andrew Frost, Richard Millar
+ * @version 1.00
+ */
+
+// Precompiler Directives =====================================================
+#ifndef VEHICLEAGENT_H
+#define VEHICLEAGENT_H
+
+// Header Files ===============================================================
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+#include "ThreadSafeObject.h"
+#include "Vehicle.h"
+#include "CentralComputeNode.h"
+#include "TripSource.h"
+#include "TimerWheel.h"
+#include "Partition.h"
+#include "Region.h"
+#include "SimClock.h"
+
+#define REGION_SYNC_CHANGES 256 //road changes a region batches before telling the CCN
+
+/**
+ * @brief   What a suspended agent is waiting for.
+ */
+enum AgentWait
+{
+    AGENT_WAIT_ROUTE,   //the CCN to deliver a route
+    AGENT_WAIT_TIMER,   //a point in time, the next arrival or a retry
+    AGENT_HANDOFF,      //another region to decide its road change
+    AGENT_DONE          //the vehicle has left the network
+};
+
+
+// Class Definition ===========================================================
+/**
+ * @brief   A vehicle run as a resumable task rather than a thread.
+ * @details Does the same steps as a car thread, but instead of waking every
+ *          time step to poll its state, resume() runs the vehicle until it has
+ *          to wait and returns what it waits for: a route from the CCN, or the
+ *          time it reaches its next node. The step it got to is kept in the
+ *          agent, so the next resume() carries on from there.
+ *
+ * @class   VehicleAgent VehicleAgent.h "VehicleAgent.h"
+ */
+class VehicleAgent
+{
+public:
+    VehicleAgent(const Vehicle & newCar, long long newRetryMS, TripStream* newStream,
+                 std::atomic_int* newActiveCars, StartupBarrier* newBarrier);
+    ~VehicleAgent();
+
+    AgentWait resume(CentralComputeNode & ccn, ThreadSafeObject & consoleLock, AgentRegion* region,
+                     SimClock::time_point & wakeTime);
+
+    const Vehicle & getVehicle() const;
+    int getHandoffSubnet() const;
+
+private:
+    enum AgentStep
+    {
+        AGENT_JOIN,
+        AGENT_DRIVE,
+        AGENT_FINISHED
+    };
+
+    void join(CentralComputeNode & ccn, ThreadSafeObject & consoleLock, AgentRegion* region);
+    AgentWait drive(CentralComputeNode & ccn, ThreadSafeObject & consoleLock, AgentRegion* region,
+                    SimClock::time_point & wakeTime);
+
+    Vehicle car;
+    long long retryMS; //wait before asking again when turned away
+    TripStream* stream; //stream the car was taken from, or NULL
+    std::atomic_int* activeCars; //counted off when the agent ends, or NULL
+    StartupBarrier* barrier; //told once the car has joined, or NULL
+
+    AgentStep step;
+    bool started;
+    bool routeRequested;
+    int handoffSubnet; //subnet of another region the agent waits to enter
+
+    //kept by the scheduler under the lock of the agent's shard
+    std::atomic_int shard; //moves with the agent between regions
+    bool waitingForRoute;
+    bool routeArrived; //a route came while the agent was running
+
+    friend class AgentScheduler;
+};
+
+
+/**
+ * @brief   Runs vehicle agents on a few threads.
+ * @details Agents are spread over shards, each run by one thread with its own
+ *          ready queue and timer wheel. Given a partition of the city, there is
+ *          a shard for each region and an agent runs on the shard of the region
+ *          it is in, moving shard when it crosses into another region. A thread sleeps until an agent's timer
+ *          is due or the CCN delivers a route to one of its agents, so an agent
+ *          costs no CPU while it drives along a road or waits in the job queue.
+ *          An agent's timer is set to the exact time it reaches its next node.
+ *
+ * @class   AgentScheduler VehicleAgent.h "VehicleAgent.h"
+ */
+class AgentScheduler
+{
+public:
+    AgentScheduler(CentralComputeNode & newCcn, ThreadSafeObject & newConsoleLock, int shardCount,
+                   const RoadPartition* newPartition);
+    ~AgentScheduler();
+
+    void spawn(const Vehicle & car, long long retryMS, TripStream* stream, std::atomic_int* activeCars,
+               StartupBarrier* barrier);
+
+    void start();
+    void stop();
+
+    int runDue();
+    bool getNextTimer(SimClock::time_point & time);
+
+    void printStatistics() const;
+
+private:
+    /**
+     * @brief   Agents of one scheduler thread.
+     */
+    struct AgentShard
+    {
+        AgentShard() : ready(), timers(0), agents(), region(), resumes(0), timerWakes(0), routeWakes(0) {}
+
+        std::mutex mutex;
+        std::condition_variable wakeup;
+        std::deque<VehicleAgent*> ready;
+        TimerWheel<VehicleAgent*> timers; //in simulated milliseconds from the scheduler's epoch
+        std::unordered_set<VehicleAgent*> agents; //every live agent of the shard
+        std::unique_ptr<AgentRegion> region; //NULL unless the city is partitioned
+
+        long long resumes;
+        long long timerWakes;
+        long long routeWakes;
+    };
+
+    void run(int shard);
+    void settle(AgentShard & owner, VehicleAgent* agent, AgentWait wait, SimClock::time_point wakeTime);
+    void wake(VehicleAgent* agent);
+    void notifyShard(int shard);
+    void sync(AgentRegion & region);
+
+    long long tickOf(SimClock::time_point time, bool roundUp) const;
+
+    CentralComputeNode & ccn;
+    ThreadSafeObject & consoleLock;
+    const RoadPartition* partition; //NULL for shards taken in turn
+    SubnetTable subnets;
+
+    std::vector<std::unique_ptr<AgentShard> > shards;
+    std::vector<std::thread> threads;
+    SimClock::time_point epoch; //tick 0 of the timer wheels
+    std::atomic_bool stopping;
+    std::atomic<long long> spawned;
+};
+
+#endif
@@ -0,0 +1,37 @@
+/**
+ * @file    VehicleServer.h
+ * @brief   Definition file for the VehicleServer interface
+ *
+ * @author  Andrew Frost, Richard Millar
+ * @version 1.00
+ */
+
+// Precompiler Directives =====================================================
+#ifndef VEHICLESERVER_H
+#define VEHICLESERVER_H
+
+// Header Files ===============================================================
+#include <atomic>
+#include <string>
+
+// Class Definition ===========================================================
+/**
+ * @brief   Serves the Compute Node to vehicles in other processes.
+ * @details Implemented by CcnServer over sockets and by ShmServer over shared
+ *          memory, so the simulator runs either the same way.
+ *
+ * @class   VehicleServer VehicleServer.h "VehicleServer.h"
+ */
+class VehicleServer
+{
+public:
+    virtual ~VehicleServer() {}
+
+    virtual bool open(const std::string & address) = 0;
+    virtual void run(std::atomic_bool & running, double seconds) = 0;
+    virtual void close() = 0;
+
+    virtual void printStatistics() const = 0;
+};
+
+#endif
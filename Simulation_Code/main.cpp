@@ -20,210 +20,1824 @@
 #include <functional>
 #include <vector>
 #include <string>
+#include <iomanip>
+#include <algorithm>
+#include <memory>
+#include <unordered_set>
+#include <random>
+#include <ctime>
+#include <sys/resource.h>
 #include "ThreadSafeObject.h"
 #include "Vehicle.h"
 #include "CentralComputeNode.h"
+#include "TripSource.h"
+#include "Checkpoint.h"
+#include "OccupancyLog.h"
+#include "VehicleAgent.h"
+#include "CcnServer.h"
+#include "ShmServer.h"
+#include "SimClock.h"
+#include "TrafficAssignment.h"
+#include "Trace.h"
+
+#define LANDMARK_COUNT 8
+#define TABLE_REFRESH_MS 5000
+#define STEP_MIN_MS 250 //shortest time step of a vehicle
+#define STEP_SPREAD_MS 1500 //time steps are drawn from STEP_MIN_MS up to this much longer
+#define ASSIGN_ITERATIONS 50 //default Frank-Wolfe iterations of an assignment
+#define ASSIGN_GAP 0.0001 //default relative gap an assignment stops at
+#define ASSIGN_REPORT 10 //most congested subnets printed after an assignment
+
+/**
+ * @brief   Settings of a run read from the input file.
+ * @details File names are empty when the feature is not used.
+ */
+struct RunSettings
+{
+    RunSettings() : tripFileName(), checkpointFileName(), checkpointSeconds(0), restoreFileName(),
+                    sampleFileName(), sampleMS(0), traceFileName(), agentThreads(0),
+                    regionCount(0), serveAddress(), serveSeconds(0), speedup(1.0), deterministic(false),
+                    seed(0), metricsFileName(), assignFileName(), assignOutputName(),
+                    assignIterations(ASSIGN_ITERATIONS), assignGap(ASSIGN_GAP) {}
+
+    std::string tripFileName; //trip file to stream vehicles from
+    std::string checkpointFileName;
+    double checkpointSeconds; //time between checkpoints
+    std::string restoreFileName; //checkpoint to carry on from
+    std::string sampleFileName; //occupancy time series
+    long long sampleMS; //time between occupancy samples
+    std::string traceFileName; //timeline written at the end of the run
+    int agentThreads; //threads running the vehicles as agents, 0 for a thread per vehicle
+    int regionCount; //regions the city is split into, one agent thread each, 0 for none
+    std::string serveAddress; //address the CCN is served on to remote vehicles
+    double serveSeconds; //time to serve for
+    double speedup; //simulated seconds per wall second
+    bool deterministic; //stepped on one thread from an explicit seed
+    unsigned int seed; //of the vehicle time steps
+    std::string metricsFileName; //performance of the run, as JSON
+    std::string assignFileName; //demand matrix to assign instead of simulating
+    std::string assignOutputName; //volume to capacity ratio of every subnet, as CSV
+    int assignIterations; //most Frank-Wolfe iterations
+    double assignGap; //relative gap the assignment stops at
+};
 
 // Function Prototypes ========================================================
-bool FetchInput(const char* fileName, CentralComputeNode & ccn, std::vector<Vehicle> & cars);
+bool FetchInput(const char* fileName, CentralComputeNode & ccn, std::vector<Vehicle> & cars,
+                TripGenerator & tripGenerator, RunSettings & settings);
+void PrepareLandmarks(const char* fileName, CentralComputeNode & ccn);
+bool ParseAdmission(const std::string & capacity, const std::string & name, CentralComputeNode & ccn);
+bool AssignDemand(CentralComputeNode & ccn, const RunSettings & settings);
+void PrintLatencies(const CentralComputeNode & ccn);
+bool WriteMetrics(const std::string & fileName, const CentralComputeNode & ccn, double wallSeconds,
+                  double simulatedSeconds);
 
-void RunSimulator(CentralComputeNode &ccn, std::vector<Vehicle> &vehicles);
+bool WriteCheckpoint(const std::string & fileName, CentralComputeNode & ccn, std::atomic_bool & running,
+                     TripStream* stream, SimClock::time_point start);
+bool ReadCheckpoint(const std::string & fileName, CentralComputeNode & ccn, std::vector<Vehicle> & vehicles,
+                    TripStream* stream, double & elapsed);
+void TakeCheckpoint(const std::string & fileName, CentralComputeNode & ccn, std::atomic_bool & running,
+                    ThreadSafeObject & consoleLock, TripStream* stream, SimClock::time_point start);
+void PeriodicCheckpoint(const std::string & fileName, double periodSeconds, CentralComputeNode & ccn,
+                        std::atomic_bool & running, ThreadSafeObject & consoleLock, TripStream* stream,
+                        SimClock::time_point start);
+bool OpenOccupancy(OccupancyWriter & writer, const std::string & fileName, CentralComputeNode & ccn,
+                   ThreadSafeObject & consoleLock);
+void TakeOccupancySample(OccupancyWriter & writer, CentralComputeNode & ccn, SimClock::time_point start,
+                         std::chrono::duration<double> & sampling, std::chrono::duration<double> & locked);
+void PrintOccupancy(const OccupancyWriter & writer, const std::string & fileName,
+                    std::chrono::duration<double> sampling, std::chrono::duration<double> locked,
+                    std::chrono::duration<double> elapsed, ThreadSafeObject & consoleLock);
+void SampleOccupancy(const std::string & fileName, long long periodMS, CentralComputeNode & ccn,
+                     std::atomic_bool & running, ThreadSafeObject & consoleLock,
+                     SimClock::time_point start);
+
+void RunSimulator(CentralComputeNode &ccn, std::vector<Vehicle> &vehicles, TripStream* stream,
+                  const RunSettings & settings, double startOffset);
+void InjectVehicles(CentralComputeNode & ccn, std::atomic_bool & running, ThreadSafeObject & consoleLock,
+                    TripStream & stream, std::atomic_int & activeCars, SimClock::time_point start,
+                    AgentScheduler* scheduler, std::mt19937 & steps);
+void ServeVehicles(VehicleServer & server, double seconds, CentralComputeNode & ccn, std::atomic_bool & running,
+                   ThreadSafeObject & consoleLock);
+void StreamedCar(CentralComputeNode & ccn, std::atomic_bool & running, ThreadSafeObject & consoleLock,
+                 Vehicle car, long long timeStep, std::atomic_int & activeCars, TripStream* stream);
+void RunLockstep(CentralComputeNode & ccn, AgentScheduler & scheduler, std::atomic_bool & running,
+                 ThreadSafeObject & consoleLock, TripStream* stream, std::mt19937 & steps,
+                 std::atomic_int & activeCars, SimClock::time_point start, const RunSettings & settings);
 void EndSimulator(std::vector<std::thread> & simulatorThreads);
+long long DrawTimeStep(std::mt19937 & steps);
 void WaitFor(long long timeMS); 
 void ComputeNode(CentralComputeNode& ccn, std::atomic_bool & running, ThreadSafeObject & consoleLock);
 void Car(CentralComputeNode & ccn, std::atomic_bool & running, 
-         ThreadSafeObject & consoleLock, Vehicle car, long long timeStep);
+         ThreadSafeObject & consoleLock, Vehicle car, long long timeStep, TripStream* stream,
+         StartupBarrier* barrier);
+
+
+// Main Function ==============================================================
+int main(int argc, char * argv[])
+{
+    CentralComputeNode ccn;
+    std::vector<Vehicle> vehicles;
+    RunSettings settings;
+    TripGenerator tripGenerator;
+    TripFile tripFile;
+    TripSource* demand = NULL;
+    std::unique_ptr<TripStream> stream;
+    double startOffset = 0;
+
+    //take input
+    if(argc < 2)
+    {
+        std::cout << "Error: no file name specified. Terminating early." << std::endl;
+        return -1;
+    }
+
+    if(argc > 2)
+    {
+        if(std::string(argv[2]) == "hierarchy")
+        {
+            ccn.setRoutingAlgorithm(ROUTE_HIERARCHY);
+        }
+        else if(std::string(argv[2]) == "bidirectional")
+        {
+            ccn.setRoutingAlgorithm(ROUTE_BIDIRECTIONAL);
+        }
+        else if(std::string(argv[2]) == "allpairs")
+        {
+            ccn.setRoutingAlgorithm(ROUTE_ALL_PAIRS);
+        }
+        else if(std::string(argv[2]) != "astar")
+        {
+            std::cout << "Error: unknown router " << argv[2] << ", expected astar, bidirectional, hierarchy or allpairs. Terminating early." << std::endl;
+            return -1;
+        }
+    }
+
+    if(argc > 3 && !ParseAdmission(argv[3], argc > 4 ? argv[4] : "reject", ccn))
+    {
+        std::cout << "Error: expected a queue capacity followed by reject, delay or stale. Terminating early." << std::endl;
+        return -1;
+    }
+
+    std::cout << "Reading in simulation data." << std::endl;
+    if(!FetchInput(argv[1], ccn, vehicles, tripGenerator, settings))
+    {
+        std::cout << "Error: invalid file name or contents. Terminating early." << std::endl;
+        return -1;
+    }
+
+    if(settings.deterministic && (settings.regionCount > 0 || !settings.serveAddress.empty()))
+    {
+        std::cout << "Error: a seeded run cannot use regions or serve. Terminating early." << std::endl;
+        return -1;
+    }
+
+    //planning runs assign the demand matrix and never start the simulator
+    if(!settings.assignFileName.empty())
+    {
+        return AssignDemand(ccn, settings) ? 0 : -1;
+    }
+
+    //travel times, steps and departures all follow the simulated clock, which
+    //a seeded run steps itself
+    SimClock::setSpeedup(settings.speedup);
+    SimClock::setStepped(settings.deterministic);
+
+    if(!settings.tripFileName.empty())
+    {
+        if(!tripFile.open(settings.tripFileName))
+        {
+            std::cout << "Error: could not open trip file " << settings.tripFileName << ". Terminating early." << std::endl;
+            return -1;
+        }
+
+        demand = &tripFile;
+    }
+    else if(tripGenerator.isConfigured())
+    {
+        demand = &tripGenerator;
+    }
+
+    if(demand != NULL)
+    {
+        stream.reset(new TripStream(*demand));
+    }
+
+    PrepareLandmarks(argv[1], ccn);
+
+    //a restored run carries on with the vehicles of the checkpoint
+    if(!settings.restoreFileName.empty())
+    {
+        vehicles.clear();
+
+        if(!ReadCheckpoint(settings.restoreFileName, ccn, vehicles, stream.get(), startOffset))
+        {
+            std::cout << "Error: could not restore from " << settings.restoreFileName << ". Terminating early." << std::endl;
+            return -1;
+        }
+    }
+
+    if(argc > 2 && std::string(argv[2]) == "allpairs")
+    {
+        ccn.startTableRefresh(TABLE_REFRESH_MS);
+    }
+
+    std::chrono::steady_clock::time_point wallStart = std::chrono::steady_clock::now();
+    SimClock::time_point simulatedStart = SimClock::now();
+
+    RunSimulator(ccn, vehicles, stream.get(), settings, startOffset);
+
+    std::chrono::duration<double> wallTime = std::chrono::steady_clock::now() - wallStart;
+    std::chrono::duration<double> simulatedTime = SimClock::now() - simulatedStart;
+
+    ccn.stopTableRefresh();
+
+    if(!settings.traceFileName.empty())
+    {
+        if(TRACE_EXPORT(settings.traceFileName))
+        {
+            std::cout << "Trace written to " << settings.traceFileName << "." << std::endl;
+        }
+        else
+        {
+            std::cout << "Warning: no trace written, tracing needs a build with make TRACE=1." << std::endl;
+        }
+    }
+
+    PrintLatencies(ccn);
+
+    if(!settings.metricsFileName.empty())
+    {
+        if(WriteMetrics(settings.metricsFileName, ccn, wallTime.count(), simulatedTime.count()))
+        {
+            std::cout << "Metrics written to " << settings.metricsFileName << "." << std::endl;
+        }
+        else
+        {
+            std::cout << "Warning: could not write metrics to " << settings.metricsFileName << "." << std::endl;
+        }
+    }
+
+    return 0;
+}
+
+// Functions ==================================================================
+/**
+ * @brief       Process input file
+ * @details     Parses out input file and places the data into the compute node
+ * 
+ * @param[in]   fileName        file to parse
+ * @param[in]   ccn             Central node
+ * @param[in]   cars            List of vehicles
+ * @param[out]  tripGenerator   generated demand, if any
+ * @param[out]  settings        trip file, checkpoint and sampling settings
+ */
+bool FetchInput(const char* fileName, CentralComputeNode &ccn, std::vector<Vehicle> &cars,
+                TripGenerator & tripGenerator, RunSettings & settings)
+{
+    std::ifstream inputFile(fileName);
+    std::stringstream arguments;
+
+    std::vector<std::string> roadIDs;
+    std::vector<int> roadProp;
+    std::vector<std::vector<double> > map;
+    std::map<std::string, std::map<std::string, int> > cityMap;
+
+    std::map<std::string, std::map<std::string, int> >::iterator cityIter;
+    std::map<std::string, int>::iterator neighborIter;
+
+    std::string command, currentKey, value1, value2, value3, value4;
+    int intValue, rowIndex, colIndex;
+    double deadline, rate, weight;
+    long long tripCount;
+    unsigned int seed;
+    JobPriority priority;
+
+    if(!inputFile.is_open())    //----- If the input file was not opened end
+    {
+        std::cout << "ERROR: File is invalid, Terminating program..." << std::endl;
+        return false;
+    }
+
+    std::cout << "Reading File..." << std::endl;
+
+    // Begin processing the file
+    while(!inputFile.eof())
+    {
+        inputFile >> command;   // Read the first block of text into command
+        std::getline(inputFile, value1);    // read in the rest of the line
+
+        arguments.clear();  // reset the stream state left by the previous line
+
+        if(command == "car")    //---- If the command is for a car
+        {
+            arguments.str(value1);
+            arguments >> value1 >> value2 >> value3;
+            cars.push_back(Vehicle(value1, value2, value3));
+
+            // optional priority class and route deadline in seconds
+            if(arguments >> value4)
+            {
+                deadline = 0;
+                arguments >> deadline;
+
+                if(!ParseJobPriority(value4, priority))
+                {
+                    std::cout << "ERROR: Invalid priority " + value4 << "." << std::endl;
+                    inputFile.close();
+                    return false;
+                }
+
+                cars.back().setPriority(priority, deadline);
+            }
+
+            std::cout << "Car " << value1 << " found." << std::endl;
+        }
+        else if(command == "intersect") //--- If the command is for an intersection
+        {
+            arguments.str(value1);
+            arguments >> currentKey >> intValue;
+            roadIDs.push_back(currentKey);
+            roadProp.push_back(intValue);
+            cityMap[currentKey];
+            std::cout << "Intersection " << currentKey << " found." << std::endl;
+        }
+        else if(command == "neighbor")  //---- If the command is for a neighbor
+        {   
+            arguments.str(value1);
+            arguments >> value1 >> intValue;
+            cityMap[currentKey].insert(std::pair<std::string, int>(value1, intValue));
+        }
+        else if(command == "trips")  //---- If the command streams vehicles from a trip file
+        {
+            arguments.str(value1);
+            arguments >> settings.tripFileName;
+            std::cout << "Trip file " << settings.tripFileName << " found." << std::endl;
+        }
+        else if(command == "generate")  //---- If the command generates vehicles
+        {
+            arguments.str(value1);
+            arguments >> rate >> tripCount >> seed;
+            tripGenerator.configure(rate, tripCount, seed);
+            std::cout << "Generating " << tripCount << " trips at " << rate << " per second." << std::endl;
+        }
+        else if(command == "od")    //---- If the command weights generated trips
+        {
+            arguments.str(value1);
+            arguments >> value1 >> value2 >> weight;
+            tripGenerator.addPair(value1, value2, weight);
+        }
+        else if(command == "checkpoint")    //---- If the command saves the run periodically
+        {
+            arguments.str(value1);
+            arguments >> settings.checkpointFileName >> settings.checkpointSeconds;
+            std::cout << "Checkpointing to " << settings.checkpointFileName << " every "
+                      << settings.checkpointSeconds << " seconds." << std::endl;
+        }
+        else if(command == "restore")   //---- If the command carries on from a checkpoint
+        {
+            arguments.str(value1);
+            arguments >> settings.restoreFileName;
+            std::cout << "Restoring from " << settings.restoreFileName << "." << std::endl;
+        }
+        else if(command == "sample")    //---- If the command records the occupancy over time
+        {
+            arguments.str(value1);
+            arguments >> settings.sampleFileName >> settings.sampleMS;
+            std::cout << "Sampling occupancy to " << settings.sampleFileName << " every "
+                      << settings.sampleMS << " ms." << std::endl;
+        }
+        else if(command == "trace")    //---- If the command writes a timeline of the run
+        {
+            arguments.str(value1);
+            arguments >> settings.traceFileName;
+            std::cout << "Tracing to " << settings.traceFileName << "." << std::endl;
+        }
+        else if(command == "agents")    //---- If the command runs the vehicles as agents
+        {
+            arguments.str(value1);
+            arguments >> settings.agentThreads;
+            std::cout << "Running vehicles as agents on " << settings.agentThreads << " threads." << std::endl;
+        }
+        else if(command == "regions")    //---- If the command splits the city into regions
+        {
+            arguments.str(value1);
+            arguments >> settings.regionCount;
+            std::cout << "Splitting the city into " << settings.regionCount << " regions." << std::endl;
+        }
+        else if(command == "serve")    //---- If the command serves the CCN to remote vehicles
+        {
+            arguments.str(value1);
+            arguments >> settings.serveAddress >> settings.serveSeconds;
+            std::cout << "Serving the CCN on " << settings.serveAddress << " for "
+                      << settings.serveSeconds << " seconds." << std::endl;
+        }
+        else if(command == "speedup")    //---- If the command runs simulated time faster
+        {
+            arguments.str(value1);
+            arguments >> settings.speedup;
+
+            if(!(settings.speedup > 0))
+            {
+                std::cout << "ERROR: Invalid speedup " << value1 << "." << std::endl;
+                inputFile.close();
+                return false;
+            }
+
+            std::cout << "Running simulated time " << settings.speedup << " times faster." << std::endl;
+        }
+        else if(command == "cost")    //---- If the command picks how roads are costed
+        {
+            arguments.str(value1);
+            arguments >> value1;
+
+            if(value1 == "free")
+            {
+                ccn.setCostModel(COST_FREE_FLOW);
+            }
+            else if(value1 == "linear")
+            {
+                ccn.setCostModel(COST_LINEAR);
+            }
+            else if(value1 == "bpr")
+            {
+                ccn.setCostModel(COST_BPR);
+            }
+            else if(value1 == "capacity")
+            {
+                ccn.setCostModel(COST_CAPACITY);
+            }
+            else
+            {
+                std::cout << "ERROR: Invalid cost model " << value1 << ", expected free, linear, bpr or capacity." << std::endl;
+                inputFile.close();
+                return false;
+            }
+
+            std::cout << "Costing roads with the " << value1 << " model." << std::endl;
+        }
+        else if(command == "order")    //---- If the command picks how the subnets are numbered
+        {
+            arguments.str(value1);
+            arguments >> value1;
+
+            if(value1 == "input")
+            {
+                ccn.setNodeOrder(ORDER_INPUT);
+            }
+            else if(value1 == "bfs")
+            {
+                ccn.setNodeOrder(ORDER_BFS);
+            }
+            else if(value1 == "rcm")
+            {
+                ccn.setNodeOrder(ORDER_RCM);
+            }
+            else
+            {
+                std::cout << "ERROR: Invalid node order " << value1 << ", expected input, bfs or rcm." << std::endl;
+                inputFile.close();
+                return false;
+            }
+
+            std::cout << "Numbering subnets in " << value1 << " order." << std::endl;
+        }
+        else if(command == "customize")    //---- If the command sets how often the hierarchy is re-customized
+        {
+            arguments.str(value1);
+            arguments >> value1;
+
+            if(value1 == "auto")
+            {
+                ccn.setCustomizationInterval(0);
+                std::cout << "Re-customizing the hierarchy at an interval scaled with the map." << std::endl;
+            }
+            else if(!(std::istringstream(value1) >> intValue) || intValue < 1)
+            {
+                std::cout << "ERROR: Invalid customization interval " << value1 << ", expected a move count or auto." << std::endl;
+                inputFile.close();
+                return false;
+            }
+            else
+            {
+                ccn.setCustomizationInterval(intValue);
+                std::cout << "Re-customizing the hierarchy every " << intValue << " vehicle moves." << std::endl;
+            }
+        }
+        else if(command == "alternatives")    //---- If the command spreads vehicles over several routes
+        {
+            arguments.str(value1);
+
+            if(!(arguments >> intValue) || intValue < 1)
+            {
+                std::cout << "ERROR: Invalid alternative route count " << value1 << "." << std::endl;
+                inputFile.close();
+                return false;
+            }
+
+            ccn.setAlternativeRoutes(intValue);
+            std::cout << "Spreading vehicles over up to " << intValue << " routes." << std::endl;
+        }
+        else if(command == "seed")    //---- If the command makes the run deterministic
+        {
+            arguments.str(value1);
+
+            if(!(arguments >> settings.seed))
+            {
+                std::cout << "ERROR: Invalid seed " << value1 << "." << std::endl;
+                inputFile.close();
+                return false;
+            }
+
+            settings.deterministic = true;
+            std::cout << "Stepping a deterministic run with seed " << settings.seed << "." << std::endl;
+        }
+        else if(command == "metrics")    //---- If the command writes the performance of the run
+        {
+            arguments.str(value1);
+            arguments >> settings.metricsFileName;
+            std::cout << "Writing metrics to " << settings.metricsFileName << "." << std::endl;
+        }
+        else if(command == "assign")    //---- If the command assigns a demand matrix instead of simulating
+        {
+            arguments.str(value1);
+
+            if(!(arguments >> settings.assignFileName >> settings.assignOutputName))
+            {
+                std::cout << "ERROR: assign needs a demand file and an output file." << std::endl;
+                inputFile.close();
+                return false;
+            }
+
+            // optional iteration limit and relative gap
+            if(arguments >> settings.assignIterations)
+            {
+                arguments >> settings.assignGap;
+            }
+
+            if(settings.assignIterations < 1 || !(settings.assignGap >= 0))
+            {
+                std::cout << "ERROR: Invalid assignment limits " << value1 << "." << std::endl;
+                inputFile.close();
+                return false;
+            }
+
+            std::cout << "Assigning the demand of " << settings.assignFileName << " for up to "
+                      << settings.assignIterations << " iterations." << std::endl;
+        }
+        else if(command[0] == '#')  //---- If the command is a comment
+        {
+            continue;
+        }
+        else    //---- If the command is not recognized
+        {
+            std::cout << "ERROR: Invalid Command " + command << "." << std::endl;
+            inputFile.close();
+            return false;
+        }
+    }
+    ccn.buildSubnetToIndexTable(roadIDs);
+    tripGenerator.setSubnets(roadIDs);
+    map.resize(roadIDs.size());
+
+    // Resize the map to the number of subnets
+    for(int index = 0 ; index < map.size(); index++)
+    {
+        map[index].resize(roadIDs.size());
+    }
+
+    // initialize the map values
+    for(int row = 0; row < map.size(); row++)
+    {
+        for(int col = 0; col < map[row].size(); col++)
+        {
+            if(row == col)
+            {
+                map[row][col] = 0;
+            }
+            else
+            {
+                map[row][col] = -1;
+            }
+        }
+    }
+    
+    // for each subnet found
+    for(cityIter = cityMap.begin(); cityIter != cityMap.end(); cityIter++)
+    {
+        rowIndex = ccn.getMapIndex(cityIter->first);    //---- set the row to the subnet index
+
+        // Iterate through the neighbors
+        for(neighborIter = cityIter->second.begin(); neighborIter != cityIter->second.end(); neighborIter++)
+        {
+            if(neighborIter->first[0] == '[')   //---- If the neighbor is referenced by index
+            {
+                std::string neighbor = neighborIter->first;
+                neighbor = roadIDs[std::stoi(neighbor.substr(1, neighbor.size()-2)) - 1];
+                colIndex = ccn.getMapIndex(neighbor);
+            }
+            else
+            {
+                colIndex = ccn.getMapIndex(neighborIter->first);
+            }
+            map[rowIndex][colIndex] = neighborIter->second;
+        }
+    }
+
+    // Set each subnet capacity
+    for(int index = 0; index < roadIDs.size(); index++)
+    {
+        ccn.setSubnetProperties(roadIDs[index], roadProp[index]);
+    }
+    ccn.setMap(map);
+    
+    std::cout << "Closing the file." << std::endl;
+    inputFile.close();
+    return true;
+}
+
+
+/**
+ * @brief       Load or build the landmark tables
+ * @details     Landmark tables are kept next to the input file. They are loaded
+ *              if they were built for the same map, otherwise they are rebuilt
+ *              in parallel and saved for the next run.
+ *
+ * @param[in]   fileName    input file the city was read from
+ * @param[in]   ccn         Central node
+ */
+void PrepareLandmarks(const char* fileName, CentralComputeNode & ccn)
+{
+    std::string landmarkFile = std::string(fileName) + ".alt";
+    int threadCount = (int)std::thread::hardware_concurrency();
+
+    if (ccn.loadLandmarks(landmarkFile))
+    {
+        std::cout << "Loaded landmarks from " << landmarkFile << "." << std::endl;
+        return;
+    }
+
+    std::cout << "Building landmarks..." << std::endl;
+    ccn.buildLandmarks(LANDMARK_COUNT, LANDMARKS_AVOID, threadCount);
+
+    if (!ccn.saveLandmarks(landmarkFile))
+    {
+        std::cout << "Warning: could not save landmarks to " << landmarkFile << "." << std::endl;
+    }
+}
+
+
+/**
+ * @brief       Reads the admission control settings
+ * @details     Sets the job queue capacity and the policy for jobs that do not
+ *              fit from the command line
+ *
+ * @param[in]   capacity    most queued jobs, 0 for no limit
+ * @param[in]   name        reject, delay or stale
+ * @param[in]   ccn         Central node
+ */
+bool ParseAdmission(const std::string & capacity, const std::string & name, CentralComputeNode & ccn)
+{
+    AdmissionPolicy policy;
+    int limit = std::atoi(capacity.c_str());
+
+    if(limit < 0 || (limit == 0 && capacity != "0"))
+    {
+        return false;
+    }
+
+    if(name == "reject")
+    {
+        policy = ADMIT_REJECT;
+    }
+    else if(name == "delay")
+    {
+        policy = ADMIT_DELAY;
+    }
+    else if(name == "stale")
+    {
+        policy = ADMIT_STALE_ROUTE;
+    }
+    else
+    {
+        return false;
+    }
+
+    ccn.setAdmissionControl(limit, policy);
+
+    return true;
+}
+
+
+/**
+ * @brief       Print route latencies
+ * @details     Prints the route delivery latency of each priority class that
+ *              was served during the run, and how the job queue coped
+ *
+ * @param[in]   ccn     Compute Node of the simulator
+ */
+void PrintLatencies(const CentralComputeNode & ccn)
+{
+    const char* names[PRIORITY_COUNT] = {"emergency", "transit", "private"};
+
+    std::cout << "Route latency by class:" << std::endl;
+
+    for(int priority = 0; priority < PRIORITY_COUNT; priority++)
+    {
+        const LatencyStats & stats = ccn.getLatencyStats((JobPriority)priority);
+
+        if(stats.count == 0)
+        {
+            continue;
+        }
+
+        std::cout << std::fixed << std::setprecision(3)
+                  << "  " << names[priority] << ": " << stats.count << " routes, mean "
+                  << stats.getMean() * 1000.0 << " ms, p99 " << stats.getPercentile(0.99) * 1000.0
+                  << " ms, max " << stats.maximum * 1000.0 << " ms, " << stats.missed
+                  << " past deadline" << std::endl;
+    }
+
+    const AdmissionStats & admission = ccn.getAdmissionStats();
+
+    std::cout << "Job queue: max depth " << admission.maxDepth << ", " << admission.queued << " queued, "
+              << admission.coalesced << " coalesced, " << admission.delayed << " delayed, "
+              << admission.rejected << " rejected, " << admission.staleServed << " answered stale, "
+              << admission.stranded << " stranded without a route" << std::endl;
+
+    std::cout << "Roads: " << ccn.getRoadChangeFailureCount() << " road changes refused, "
+              << ccn.getAlternativeRouteCount() << " vehicles sent on an alternative route" << std::endl;
+}
+
+
+/**
+ * @brief       Assign a demand matrix to the city
+ * @details     Reads the demand file, one "origin destination volume" line per
+ *              pair of subnets, finds the equilibrium flows with a traffic
+ *              assignment on every hardware thread, prints the convergence and
+ *              the most congested subnets and writes the volume to capacity
+ *              ratio of every subnet as CSV
+ *
+ * @param[in]   ccn         Compute Node holding the city
+ * @param[in]   settings    names of the demand and output files and the limits
+ *
+ * @note        Returns false if a file could not be read or written or holds
+ *              no usable demand
+ */
+bool AssignDemand(CentralComputeNode & ccn, const RunSettings & settings)
+{
+    std::ifstream demandFile(settings.assignFileName.c_str());
+    std::ofstream output;
+    std::vector<std::string> names;
+    std::vector<int> capacities, order;
+    std::string line, origin, destination;
+    std::stringstream arguments;
+    TrafficAssignment assignment;
+    double volume;
+    int lineNumber = 0, skipped = 0, overCapacity = 0, index;
+    int threadCount = std::max(1, (int)std::thread::hardware_concurrency());
+
+    if(!demandFile.is_open())
+    {
+        std::cout << "Error: could not open demand file " << settings.assignFileName << "." << std::endl;
+        return false;
+    }
+
+    ccn.getSubnets(names, capacities);
+    assignment.setNetwork(ccn.getRoadGraph(), capacities);
+
+    while(std::getline(demandFile, line))
+    {
+        lineNumber++;
+
+        if(line.empty() || line[0] == '#')
+        {
+            continue;
+        }
+
+        arguments.clear();
+        arguments.str(line);
+
+        if(!(arguments >> origin >> destination >> volume)
+            || !assignment.addDemand(ccn.getMapIndex(origin), ccn.getMapIndex(destination), volume))
+        {
+            skipped++;
+        }
+    }
+
+    if(skipped > 0)
+    {
+        std::cout << "Warning: skipped " << skipped << " of " << lineNumber
+                  << " demand lines with an unknown subnet or no volume." << std::endl;
+    }
+
+    std::cout << "Assigning " << assignment.getPairCount() << " pairs from " << assignment.getOriginCount()
+              << " origins on " << threadCount << " threads." << std::endl;
+
+    assignment.setProgressListener([](const AssignmentIteration & iteration)
+    {
+        std::cout << std::scientific << std::setprecision(3)
+                  << "  iteration " << iteration.iteration << ": relative gap " << iteration.relativeGap
+                  << std::fixed << ", step " << iteration.step << ", " << iteration.seconds << " s" << std::endl;
+    });
+
+    if(!assignment.solve(settings.assignIterations, settings.assignGap, threadCount))
+    {
+        std::cout << "Error: no demand to assign." << std::endl;
+        return false;
+    }
+
+    if(assignment.getUnroutedVolume() > 0)
+    {
+        std::cout << "Warning: " << assignment.getUnroutedVolume()
+                  << " vehicles have no route to their destination." << std::endl;
+    }
+
+    //most congested first
+    order.resize(names.size());
+
+    for(index = 0; index < (int)names.size(); index++)
+    {
+        order[index] = index;
+
+        if(assignment.getVolumeRatio(index) > 1)
+        {
+            overCapacity++;
+        }
+    }
+
+    std::sort(order.begin(), order.end(), [&assignment](int left, int right)
+    {
+        return assignment.getVolumeRatio(left) > assignment.getVolumeRatio(right);
+    });
+
+    std::cout << std::scientific << std::setprecision(3) << "Assignment reached a relative gap of "
+              << assignment.getRelativeGap() << " after " << assignment.getIterations().size()
+              << " iterations, " << overCapacity << " subnets over capacity." << std::endl;
+
+    for(index = 0; index < (int)order.size() && index < ASSIGN_REPORT; index++)
+    {
+        std::cout << "  " << names[order[index]] << ": volume " << assignment.getSubnetVolumes()[order[index]]
+                  << ", capacity " << capacities[order[index]] << ", ratio "
+                  << assignment.getVolumeRatio(order[index]) << std::endl;
+    }
+
+    output.open(settings.assignOutputName.c_str());
+
+    if(!output.is_open())
+    {
+        std::cout << "Error: could not write " << settings.assignOutputName << "." << std::endl;
+        return false;
+    }
+
+    output << "subnet,volume,capacity,ratio" << std::endl;
+
+    for(index = 0; index < (int)names.size(); index++)
+    {
+        output << names[index] << "," << assignment.getSubnetVolumes()[index] << ","
+               << capacities[index] << "," << assignment.getVolumeRatio(index) << std::endl;
+    }
+
+    std::cout << "Subnet volumes written to " << settings.assignOutputName << "." << std::endl;
+
+    return true;
+}
+
+
+/**
+ * @brief       Write the performance of the run
+ * @details     Writes a flat JSON object with the wall and simulated length of
+ *              the run, the routes delivered and their rate, the route latency
+ *              percentiles over all classes and the peak resident set size,
+ *              for PerfCheck to compare against a baseline
+ *
+ * @param[in]   fileName            file to write
+ * @param[in]   ccn                 Compute Node of the simulator
+ * @param[in]   wallSeconds         wall time the run took
+ * @param[in]   simulatedSeconds    simulated time the run took
+ *
+ * @note        Returns false if the file could not be written
+ */
+bool WriteMetrics(const std::string & fileName, const CentralComputeNode & ccn, double wallSeconds,
+                  double simulatedSeconds)
+{
+    std::ofstream file(fileName.c_str());
+    LatencyStats all;
+    rusage usage;
+    int priority, bucket;
+
+    if(!file.is_open())
+    {
+        return false;
+    }
+
+    //the classes share their buckets, so the percentiles of the whole run add up
+    for(priority = 0; priority < PRIORITY_COUNT; priority++)
+    {
+        const LatencyStats & stats = ccn.getLatencyStats((JobPriority)priority);
+
+        all.count += stats.count;
+        all.total += stats.total;
+        all.maximum = std::max(all.maximum, stats.maximum);
+
+        for(bucket = 0; bucket < LATENCY_BUCKETS; bucket++)
+        {
+            all.buckets[bucket] += stats.buckets[bucket];
+        }
+    }
+
+    getrusage(RUSAGE_SELF, &usage);
+
+    file << std::fixed << std::setprecision(6)
+         << "{\n"
+         << "    \"wallSeconds\": " << wallSeconds << ",\n"
+         << "    \"simulatedSeconds\": " << simulatedSeconds << ",\n"
+         << "    \"routes\": " << all.count << ",\n"
+         << "    \"routesPerSecond\": " << (wallSeconds > 0 ? all.count / wallSeconds : 0) << ",\n"
+         << "    \"latencyP50Ms\": " << all.getPercentile(0.5) * 1000.0 << ",\n"
+         << "    \"latencyP99Ms\": " << all.getPercentile(0.99) * 1000.0 << ",\n"
+         << "    \"roadChangesRefused\": " << ccn.getRoadChangeFailureCount() << ",\n"
+         << "    \"peakRssKB\": " << usage.ru_maxrss << "\n"
+         << "}\n";
+
+    return file.good();
+}
+
+
+/**
+ * @brief       Write a checkpoint
+ * @details     Writes the run to fileName one piece at a time rather than
+ *              stopping it. The vehicle list is taken together with the trip
+ *              stream, so a streamed vehicle is either on the network or still
+ *              in the stream. Each vehicle is then written under its own lock,
+ *              and the waiting jobs last.
+ *
+ * @param[in]   fileName    checkpoint file to write
+ * @param[in]   ccn         Compute Node of the simulator
+ * @param[in]   running     flag to show that the simulator is running
+ * @param[in]   stream      vehicles still to stream in, or NULL
+ * @param[in]   start       time the run started
+ */
+bool WriteCheckpoint(const std::string & fileName, CentralComputeNode & ccn, std::atomic_bool & running,
+                     TripStream* stream, SimClock::time_point start)
+{
+    CheckpointWriter writer;
+    std::vector<std::string> vehicleIds;
+    std::chrono::duration<double> elapsed = SimClock::now() - start;
+    int result;
+
+    if(!writer.open(fileName))
+    {
+        return false;
+    }
+
+    writer.writeDouble(elapsed.count());
+    writer.writeInt(stream != NULL ? 1 : 0);
+
+    ccn.getLock();
+    {
+        ccn.saveState(writer, vehicleIds);
+
+        if(stream != NULL)
+        {
+            stream->save(writer);
+        }
+    }
+    ccn.releaseLock();
+
+    for(int index = 0; index < vehicleIds.size(); index++)
+    {
+        //a busy vehicle may be waiting on the ccn, let go and try again
+        do
+        {
+            ccn.getLock();
+            {
+                result = ccn.saveVehicle(writer, vehicleIds[index]);
+            }
+            ccn.releaseLock();
+
+            if(result < 0)
+            {
+                WaitFor(1);
+            }
+        } while(result < 0 && running);
+
+        if(result < 0)
+        {
+            return false;
+        }
+    }
+
+    writer.writeInt(0);
+
+    ccn.getLock();
+    {
+        ccn.saveJobs(writer);
+    }
+    ccn.releaseLock();
+
+    return writer.close();
+}
+
+
+/**
+ * @brief       Read a checkpoint
+ * @details     Restores the vehicles, the trip stream and the waiting jobs
+ *              written by WriteCheckpoint
+ *
+ * @param[in]   fileName    checkpoint file to read
+ * @param[in]   ccn         Compute Node of the simulator
+ * @param[out]  vehicles    vehicles that were on the network
+ * @param[in]   stream      vehicles still to stream in, or NULL
+ * @param[out]  elapsed     seconds the run had been going
+ */
+bool ReadCheckpoint(const std::string & fileName, CentralComputeNode & ccn, std::vector<Vehicle> & vehicles,
+                    TripStream* stream, double & elapsed)
+{
+    CheckpointReader reader;
+    std::unordered_set<std::string> waiting;
+    bool hadStream;
+    int jobCount;
+
+    if(!reader.open(fileName))
+    {
+        std::cout << "Error: " << fileName << " is not a checkpoint." << std::endl;
+        return false;
+    }
+
+    elapsed = reader.readDouble();
+    hadStream = reader.readInt() != 0;
+
+    if(!ccn.restoreState(reader))
+    {
+        std::cout << "Error: " << fileName << " was written for another city." << std::endl;
+        return false;
+    }
+
+    if(hadStream != (stream != NULL))
+    {
+        std::cout << "Error: the trips of " << fileName << " do not match the input file." << std::endl;
+        return false;
+    }
+
+    if(stream != NULL && !stream->restore(reader))
+    {
+        return false;
+    }
+
+    while(reader.readInt() == 1)
+    {
+        vehicles.push_back(Vehicle());
+
+        if(!vehicles.back().restore(reader))
+        {
+            return false;
+        }
+
+        if(!vehicles.back().hasRoute())
+        {
+            waiting.insert(vehicles.back().getID());
+        }
+    }
+
+    jobCount = ccn.restoreJobs(reader, waiting);
+
+    if(jobCount < 0)
+    {
+        return false;
+    }
+
+    std::cout << "Restored " << vehicles.size() << " vehicles and " << jobCount << " jobs at "
+              << elapsed << " seconds." << std::endl;
+
+    return true;
+}
+
+
+/**
+ * @brief       Write a checkpoint and report it
+ *
+ * @param[in]   fileName    checkpoint file to write
+ * @param[in]   ccn         Compute Node of the simulator
+ * @param[in]   running     flag to show that the simulator is running
+ * @param[in]   consoleLock Lock assigned to the console for output
+ * @param[in]   stream      vehicles still to stream in, or NULL
+ * @param[in]   start       time the run started
+ */
+void TakeCheckpoint(const std::string & fileName, CentralComputeNode & ccn, std::atomic_bool & running,
+                    ThreadSafeObject & consoleLock, TripStream* stream, SimClock::time_point start)
+{
+    std::chrono::duration<double> elapsed;
+    bool written;
+
+    {
+        TRACE_SCOPE("run", "checkpoint");
+
+        written = WriteCheckpoint(fileName, ccn, running, stream, start);
+    }
+    elapsed = SimClock::now() - start;
+
+    consoleLock.getLock();
+    {
+        if(written)
+        {
+            std::cout << "Checkpoint written to " << fileName << " at "
+                      << (long long)elapsed.count() << " seconds." << std::endl;
+        }
+        else
+        {
+            std::cout << "Warning: could not write checkpoint " << fileName << "." << std::endl;
+        }
+    }
+    consoleLock.releaseLock();
+}
+
+
+/**
+ * @brief       Checkpoint the run periodically
+ * @details     Writes a checkpoint every periodSeconds until the run ends
+ *
+ * @param[in]   fileName        checkpoint file to write
+ * @param[in]   periodSeconds   time between checkpoints
+ * @param[in]   ccn             Compute Node of the simulator
+ * @param[in]   running         flag to show that the simulator is running
+ * @param[in]   consoleLock     Lock assigned to the console for output
+ * @param[in]   stream          vehicles still to stream in, or NULL
+ * @param[in]   start           time the run started
+ */
+void PeriodicCheckpoint(const std::string & fileName, double periodSeconds, CentralComputeNode & ccn,
+                        std::atomic_bool & running, ThreadSafeObject & consoleLock, TripStream* stream,
+                        SimClock::time_point start)
+{
+    SimClock::time_point due = SimClock::now();
+
+    TRACE_THREAD_NAME("checkpoint");
+
+    while(running)
+    {
+        due += std::chrono::duration_cast<SimClock::duration>(std::chrono::duration<double>(periodSeconds));
+
+        //sleep in short slices so the run can still end early
+        while(running && SimClock::now() < due)
+        {
+            WaitFor(100);
+        }
+
+        if(!running)
+        {
+            break;
+        }
+
+        TakeCheckpoint(fileName, ccn, running, consoleLock, stream, start);
+    }
+}
+
+
+/**
+ * @brief       Open the occupancy file
+ * @details     Writes the header naming every subnet and its capacity
+ *
+ * @param[out]  writer      writer to open
+ * @param[in]   fileName    occupancy file to write
+ * @param[in]   ccn         Compute Node of the simulator
+ * @param[in]   consoleLock Lock assigned to the console for output
+ *
+ * @return      true if the file is open, otherwise a warning has been printed
+ */
+bool OpenOccupancy(OccupancyWriter & writer, const std::string & fileName, CentralComputeNode & ccn,
+                   ThreadSafeObject & consoleLock)
+{
+    std::vector<std::string> names;
+    std::vector<int> capacities;
+
+    ccn.getLock();
+    {
+        ccn.getSubnets(names, capacities);
+    }
+    ccn.releaseLock();
+
+    if(!writer.open(fileName, names, capacities))
+    {
+        consoleLock.getLock();
+        {
+            std::cout << "Warning: could not write occupancy samples to " << fileName << "." << std::endl;
+        }
+        consoleLock.releaseLock();
+        return false;
+    }
+
+    return true;
+}
+
+
+/**
+ * @brief       Take one occupancy sample
+ * @details     Only the copy is taken under the Compute Node lock, the
+ *              encoding is done outside it
+ *
+ * @param[in]   writer      open occupancy writer
+ * @param[in]   ccn         Compute Node of the simulator
+ * @param[in]   start       time the run started
+ * @param[out]  sampling    time spent sampling, added to
+ * @param[out]  locked      time spent under the Compute Node lock, added to
+ */
+void TakeOccupancySample(OccupancyWriter & writer, CentralComputeNode & ccn, SimClock::time_point start,
+                         std::chrono::duration<double> & sampling, std::chrono::duration<double> & locked)
+{
+    OccupancySample sample;
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+    TRACE_SCOPE("run", "sampleOccupancy");
+
+    sample.timeMS = std::chrono::duration_cast<std::chrono::milliseconds>(SimClock::now() - start).count();
+
+    ccn.getLock();
+    {
+        ccn.sampleOccupancy(sample);
+    }
+    ccn.releaseLock();
+
+    locked += std::chrono::steady_clock::now() - now;
+
+    writer.append(sample);
+
+    sampling += std::chrono::steady_clock::now() - now;
+}
+
+
+/**
+ * @brief       Report the occupancy samples written
+ *
+ * @param[in]   writer      closed occupancy writer
+ * @param[in]   fileName    occupancy file written
+ * @param[in]   sampling    time spent sampling
+ * @param[in]   locked      time spent under the Compute Node lock
+ * @param[in]   elapsed     wall time the samples were taken over
+ * @param[in]   consoleLock Lock assigned to the console for output
+ */
+void PrintOccupancy(const OccupancyWriter & writer, const std::string & fileName,
+                    std::chrono::duration<double> sampling, std::chrono::duration<double> locked,
+                    std::chrono::duration<double> elapsed, ThreadSafeObject & consoleLock)
+{
+    consoleLock.getLock();
+    {
+        std::cout << std::fixed << std::setprecision(3) << "Wrote " << writer.getSampleCount()
+                  << " occupancy samples (" << writer.getByteCount() << " bytes) to " << fileName
+                  << ", sampling took " << sampling.count() * 100.0 / elapsed.count() << "% of the run, "
+                  << locked.count() * 100.0 / elapsed.count() << "% under the CCN lock." << std::endl;
+    }
+    consoleLock.releaseLock();
+}
+
+
+/**
+ * @brief       Record the occupancy over time
+ * @details     Samples the occupancy, queue length and road change failures of
+ *              every subnet every periodMS until the run ends. Only the copy is
+ *              taken under the Compute Node lock, the encoding is done outside
+ *              it. The time spent sampling is reported against the length of
+ *              the run.
+ *
+ * @param[in]   fileName    occupancy file to write
+ * @param[in]   periodMS    time between samples
+ * @param[in]   ccn         Compute Node of the simulator
+ * @param[in]   running     flag to show that the simulator is running
+ * @param[in]   consoleLock Lock assigned to the console for output
+ * @param[in]   start       time the run started
+ */
+void SampleOccupancy(const std::string & fileName, long long periodMS, CentralComputeNode & ccn,
+                     std::atomic_bool & running, ThreadSafeObject & consoleLock,
+                     SimClock::time_point start)
+{
+    OccupancyWriter writer;
+    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+    SimClock::time_point due = SimClock::now();
+    std::chrono::duration<double> sampling(0), locked(0);
+
+    TRACE_THREAD_NAME("sampler");
+
+    if(!OpenOccupancy(writer, fileName, ccn, consoleLock))
+    {
+        return;
+    }
+
+    while(running)
+    {
+        due += std::chrono::milliseconds(periodMS);
+
+        //sleep in short slices so the run can still end early
+        while(running && SimClock::now() < due)
+        {
+            WaitFor(std::min(100LL, periodMS));
+        }
+
+        if(!running)
+        {
+            break;
+        }
+
+        TakeOccupancySample(writer, ccn, start, sampling, locked);
+    }
+
+    writer.close();
+    PrintOccupancy(writer, fileName, sampling, locked, std::chrono::steady_clock::now() - begin, consoleLock);
+}
+
+
+/**
+ * @brief       Run the simulator until end
+ * @details     Initializes the simulator by launching the vehicle threads and starting
+ *              the compute node.
+ *
+ * @param[in]   ccn                 Compute Node of the simulator
+ * @param[in]   vehicles            List of vehicles in the simulator
+ * @param[in]   stream              vehicles to stream in while running, or NULL
+ * @param[in]   settings            checkpoint and sampling settings
+ * @param[in]   startOffset         seconds the run had been going when it was restored
+ */
+void RunSimulator(CentralComputeNode &ccn, std::vector<Vehicle> &vehicles, TripStream* stream,
+                  const RunSettings & settings, double startOffset)
+{
+    ThreadSafeObject consoleLock;
+    std::atomic_bool running(true);
+    std::atomic_int activeCars(0);
+    std::vector<std::thread> vehicleThreads(vehicles.size());
+    std::thread injector, checkpointer, sampler;
+    SimClock::time_point start = SimClock::now() -
+        std::chrono::duration_cast<SimClock::duration>(std::chrono::duration<double>(startOffset));
+    StartupBarrier startup((int)vehicles.size()); //the vehicles started with the run
+
+    RoadPartition partition; //outlives the scheduler, whose regions refer to it
+    std::unique_ptr<AgentScheduler> scheduler;
+    std::unique_ptr<VehicleServer> server; //a CcnServer or a ShmServer, by the address served on
+    std::thread serving;
+
+    //a seeded run draws the same time steps every time
+    std::mt19937 steps(settings.deterministic ? settings.seed : (unsigned)time(0));
+    long long tStep;
+
+    std::cout << "Starting the simulator..." << std::endl;
+
+    if(settings.regionCount > 0)
+    {
+        //one agent thread per region, each deciding the road changes inside it
+        partition.build(ccn.getRoadGraph(), settings.regionCount);
+        std::cout << "Partitioned " << ccn.getRoadGraph().getNodeCount() << " subnets into "
+                  << partition.getRegionCount() << " regions, " << partition.getCutEdgeCount()
+                  << " roads between regions." << std::endl;
+    }
+
+    if(settings.deterministic)
+    {
+        //every agent and the ccn are stepped in turn on this thread
+        scheduler.reset(new AgentScheduler(ccn, consoleLock, 1, NULL));
+        vehicleThreads.clear();
+
+        for(int index = 0; index < vehicles.size(); index++)
+        {
+            scheduler->spawn(vehicles[index], DrawTimeStep(steps), NULL, NULL, NULL);
+        }
+    }
+    else if(settings.agentThreads > 0 || settings.regionCount > 0)
+    {
+        //vehicles run as agents on a few threads instead of one thread each
+        scheduler.reset(new AgentScheduler(ccn, consoleLock, settings.agentThreads,
+                                           settings.regionCount > 0 ? &partition : NULL));
+        vehicleThreads.clear();
+
+        for(int index = 0; index < vehicles.size(); index++)
+        {
+            scheduler->spawn(vehicles[index], DrawTimeStep(steps), NULL, NULL, &startup);
+        }
+
+        scheduler->start();
+    }
+
+    for(int index = 0; index < vehicleThreads.size(); index++)
+    {
+        tStep = DrawTimeStep(steps);
+        vehicleThreads[index] = std::thread(Car, std::ref(ccn), std::ref(running), std::ref(consoleLock),
+                                            std::ref(vehicles[index]), tStep, (TripStream*)NULL, &startup);
+    }
+
+    if(stream != NULL)
+    {
+        //keep the ccn up until the last streamed vehicle has left
+        ccn.setDemandPending(true);
+    }
+
+    if(stream != NULL && !settings.deterministic)
+    {
+        injector = std::thread(InjectVehicles, std::ref(ccn), std::ref(running), std::ref(consoleLock),
+                               std::ref(*stream), std::ref(activeCars), start, scheduler.get(), std::ref(steps));
+    }
+
+    if(!settings.serveAddress.empty())
+    {
+        //vehicle simulators on the same machine can skip the socket
+        if(settings.serveAddress.compare(0, 4, "shm:") == 0)
+        {
+            server.reset(new ShmServer(ccn));
+        }
+        else
+        {
+            server.reset(new CcnServer(ccn));
+        }
+    }
+
+    if(server && server->open(settings.serveAddress))
+    {
+        //keep the ccn up while remote vehicles may still join
+        ccn.setDemandPending(true);
+        serving = std::thread(ServeVehicles, std::ref(*server), settings.serveSeconds, std::ref(ccn),
+                              std::ref(running), std::ref(consoleLock));
+    }
+
+    //a seeded run checkpoints and samples from the lockstep loop instead
+    if(!settings.checkpointFileName.empty() && settings.checkpointSeconds > 0 && !settings.deterministic)
+    {
+        checkpointer = std::thread(PeriodicCheckpoint, settings.checkpointFileName, settings.checkpointSeconds,
+                                   std::ref(ccn), std::ref(running), std::ref(consoleLock), stream, start);
+    }
+
+    if(!settings.sampleFileName.empty() && settings.sampleMS > 0 && !settings.deterministic)
+    {
+        sampler = std::thread(SampleOccupancy, settings.sampleFileName, settings.sampleMS, std::ref(ccn),
+                              std::ref(running), std::ref(consoleLock), start);
+    }
+
+    if(settings.deterministic)
+    {
+        RunLockstep(ccn, *scheduler, running, consoleLock, stream, steps, activeCars, start, settings);
+    }
+    else
+    {
+        //the ccn ends once the network is empty, so it waits for the vehicles to join
+        startup.wait();
+        ComputeNode(ccn, std::ref(running), std::ref(consoleLock));
+    }
+
+    std::cout << "Ending the simulator..." << std::endl;
+    EndSimulator(vehicleThreads);
+
+    if(injector.joinable())
+    {
+        injector.join();
+    }
 
+    if(serving.joinable())
+    {
+        serving.join();
+        server->printStatistics();
+    }
 
-// Main Function ==============================================================
-int main(int argc, char * argv[])
-{
-    CentralComputeNode ccn;
-    std::vector<Vehicle> vehicles;
+    if(checkpointer.joinable())
+    {
+        checkpointer.join();
+    }
 
-    //take input
-    if(argc < 2)
+    if(sampler.joinable())
     {
-        std::cout << "Error: no file name specified. Terminating early." << std::endl;
-        return -1;
+        sampler.join();
     }
 
-    std::cout << "Reading in simulation data." << std::endl;
-    if(!FetchInput(argv[1], ccn, vehicles))
+    //nothing else looks at the vehicles now, the agents left can be freed
+    if(scheduler)
     {
-        std::cout << "Error: invalid file name or contents. Terminating early." << std::endl;
-        return -1;
+        scheduler->stop();
+        scheduler->printStatistics();
     }
 
-    RunSimulator(ccn, vehicles);
-    return 0;
+    //streamed vehicles are detached, wait for the last ones to stop
+    while(activeCars > 0)
+    {
+        WaitFor(10);
+    }
+    std::cout << "Simulator Terminated." << std::endl;
 }
 
-// Functions ==================================================================
 /**
- * @brief       Process input file
- * @details     Parses out input file and places the data into the compute node
- * 
- * @param[in]   fileName    file to parse
- * @param[in]   ccn         Central node
- * @param[in]   cars        List of vehicles
+ * @brief       Serve the CCN to remote vehicles
+ * @details     Runs the server for the given time, then takes the remote
+ *              vehicles left off the network and lets the CCN end once the
+ *              network is empty
+ *
+ * @param[in]   server      server listening for remote vehicles
+ * @param[in]   seconds     time to serve for
+ * @param[in]   ccn         Compute Node of the simulator
+ * @param[in]   running     flag to show that the simulator is running
+ * @param[in]   consoleLock Lock assigned to the console for output
  */
-bool FetchInput(const char* fileName, CentralComputeNode &ccn, std::vector<Vehicle> &cars)
+void ServeVehicles(VehicleServer & server, double seconds, CentralComputeNode & ccn, std::atomic_bool & running,
+                   ThreadSafeObject & consoleLock)
 {
-    std::ifstream inputFile(fileName);
-    std::stringstream arguments;
+    server.run(running, seconds);
+    server.close();
 
-    std::vector<std::string> roadIDs;
-    std::vector<int> roadProp;
-    std::vector<std::vector<double> > map;
-    std::map<std::string, std::map<std::string, int> > cityMap;
-
-    std::map<std::string, std::map<std::string, int> >::iterator cityIter;
-    std::map<std::string, int>::iterator neighborIter;
-
-    std::string command, currentKey, value1, value2, value3;
-    int intValue, rowIndex, colIndex;
+    consoleLock.getLock();
+    {
+        std::cout << "Server stopped." << std::endl;
+    }
+    consoleLock.releaseLock();
 
-    if(!inputFile.is_open())    //----- If the input file was not opened end
+    ccn.getLock();
     {
-        std::cout << "ERROR: File is invalid, Terminating program..." << std::endl;
-        return false;
+        ccn.setDemandPending(false);
     }
+    ccn.releaseLock();
+}
 
-    std::cout << "Reading File..." << std::endl;
 
-    // Begin processing the file
-    while(!inputFile.eof())
+/**
+ * @brief       Stream vehicles into the simulator
+ * @details     Releases each trip of the demand at its departure time, measured
+ *              from the start of the run, as a vehicle on its own detached
+ *              thread, or as an agent when the vehicles run on a scheduler.
+ *              Only the vehicles on the road exist at any time, each is freed
+ *              when it leaves the network.
+ *
+ * @param[in]   ccn         Compute Node of the simulator
+ * @param[in]   running     flag to show that the simulator is running
+ * @param[in]   consoleLock Lock assigned to the console for output
+ * @param[in]   stream      trips to release, in departure order
+ * @param[in]   activeCars  number of streamed vehicles still running
+ * @param[in]   start       time the run started
+ * @param[in]   scheduler   scheduler to run the vehicles on, or NULL for threads
+ * @param[in]   steps       random numbers for the time steps of the vehicles
+ */
+void InjectVehicles(CentralComputeNode & ccn, std::atomic_bool & running, ThreadSafeObject & consoleLock,
+                    TripStream & stream, std::atomic_int & activeCars, SimClock::time_point start,
+                    AgentScheduler* scheduler, std::mt19937 & steps)
+{
+    std::chrono::duration<double> elapsed;
+    long long released;
+    Trip trip;
+
+    TRACE_THREAD_NAME("injector");
+
+    while(running && stream.peek(trip))
     {
-        inputFile >> command;   // Read the first block of text into command
-        std::getline(inputFile, value1);    // read in the rest of the line
+        //sleep in short slices so the run can still end early
+        elapsed = SimClock::now() - start;
 
-        if(command == "car")    //---- If the command is for a car
+        while(running && elapsed.count() < trip.departure)
         {
-            arguments.str(value1);
-            arguments >> value1 >> value2 >> value3;
-            cars.push_back(Vehicle(value1, value2, value3));
-            std::cout << "Car " << value1 << " found." << std::endl;
+            WaitFor(std::min(100LL, (long long)((trip.departure - elapsed.count()) * 1000.0) + 1));
+            elapsed = SimClock::now() - start;
         }
-        else if(command == "intersect") //--- If the command is for an intersection
+
+        if(!running)
         {
-            arguments.str(value1);
-            arguments >> currentKey >> intValue;
-            roadIDs.push_back(currentKey);
-            roadProp.push_back(intValue);
-            cityMap[currentKey];
-            std::cout << "Intersection " << currentKey << " found." << std::endl;
+            break;
         }
-        else if(command == "neighbor")  //---- If the command is for a neighbor
-        {   
-            arguments.str(value1);
-            arguments >> value1 >> intValue;
-            cityMap[currentKey].insert(std::pair<std::string, int>(value1, intValue));
+
+        Vehicle car(trip.id, trip.source, trip.dest);
+        car.setPriority(trip.priority, trip.deadline);
+
+        TRACE_INSTANT("vehicle", "release", trip.id);
+
+        activeCars++;
+        released = stream.getReleasedCount();
+
+        if(scheduler != NULL)
+        {
+            scheduler->spawn(car, DrawTimeStep(steps), &stream, &activeCars, NULL);
         }
-        else if(command[0] == '#')  //---- If the command is a comment
+        else
         {
-            continue;
+            std::thread(StreamedCar, std::ref(ccn), std::ref(running), std::ref(consoleLock),
+                        car, DrawTimeStep(steps), std::ref(activeCars), &stream).detach();
         }
-        else    //---- If the command is not recognized
+
+        //the car takes its trip off the stream once it has joined the network
+        while(running && stream.getReleasedCount() == released)
         {
-            std::cout << "ERROR: Invalid Command " + command << "." << std::endl;
-            inputFile.close();
-            return false;
+            WaitFor(1);
         }
     }
-    ccn.buildSubnetToIndexTable(roadIDs);
-    map.resize(roadIDs.size());
 
-    // Resize the map to the number of subnets
-    for(int index = 0 ; index < map.size(); index++)
+    while(running && activeCars > 0)
     {
-        map[index].resize(roadIDs.size());
+        WaitFor(100);
     }
 
-    // initialize the map values
-    for(int row = 0; row < map.size(); row++)
+    consoleLock.getLock();
     {
-        for(int col = 0; col < map[row].size(); col++)
+        std::cout << "Demand exhausted after " << stream.getReleasedCount() << " streamed vehicles." << std::endl;
+    }
+    consoleLock.releaseLock();
+
+    ccn.getLock();
+    {
+        ccn.setDemandPending(false);
+    }
+    ccn.releaseLock();
+}
+
+
+/**
+ * @brief       Operations done by a streamed Vehicle
+ * @details     Runs the car like any other and then counts it off, so the
+ *              injector knows when all streamed vehicles are gone
+ *
+ * @param[in]   ccn         central compute node
+ * @param[in]   running     flag to show simulator is running
+ * @param[in]   consoleLock lock for the console output
+ * @param[in]   car         vehicle to run, owned by this thread
+ * @param[in]   timeStep    time between steps of the car
+ * @param[in]   activeCars  number of streamed vehicles still running
+ * @param[in]   stream      stream the car was taken from
+ */
+void StreamedCar(CentralComputeNode & ccn, std::atomic_bool & running, ThreadSafeObject & consoleLock,
+                 Vehicle car, long long timeStep, std::atomic_int & activeCars, TripStream* stream)
+{
+    Car(ccn, running, consoleLock, car, timeStep, stream, NULL);
+
+    activeCars--;
+}
+
+
+/**
+ * @brief       Run the simulator on one thread in a fixed order
+ * @details     Steps the simulated clock from event to event instead of
+ *              following the wall clock. The agents that are due run first,
+ *              then the CCN routes one waiting job, and only once neither has
+ *              anything left to do does the clock move on to the next timer
+ *              or trip departure. A streamed vehicle joins before the next
+ *              trip is looked at. Checkpoints and occupancy samples are
+ *              taken here too, each as the clock reaches its due time, and
+ *              the clock stops at every due time on the way. Nothing here
+ *              depends on how the threads are scheduled, so the same seed
+ *              always gives the same run.
+ *
+ * @param[in]   ccn         Compute Node of the simulator
+ * @param[in]   scheduler   scheduler of one shard holding the vehicles, not started
+ * @param[in]   running     flag to show that the simulator is running
+ * @param[in]   consoleLock Lock assigned to the console for output
+ * @param[in]   stream      trips to release, in departure order, or NULL
+ * @param[in]   steps       random numbers for the time steps of the vehicles
+ * @param[in]   activeCars  number of streamed vehicles still running
+ * @param[in]   start       time the run started
+ * @param[in]   settings    checkpoint and occupancy files and their periods
+ */
+void RunLockstep(CentralComputeNode & ccn, AgentScheduler & scheduler, std::atomic_bool & running,
+                 ThreadSafeObject & consoleLock, TripStream* stream, std::mt19937 & steps,
+                 std::atomic_int & activeCars, SimClock::time_point start, const RunSettings & settings)
+{
+    SimClock::time_point next, departure;
+    bool pending = stream != NULL, hasNext;
+    int resumed, waiting, routed;
+    Trip trip;
+
+    OccupancyWriter writer;
+    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+    std::chrono::duration<double> sampling(0), locked(0);
+    SimClock::duration checkpointPeriod = std::chrono::duration_cast<SimClock::duration>(
+                                              std::chrono::duration<double>(settings.checkpointSeconds));
+    SimClock::duration samplePeriod = std::chrono::milliseconds(settings.sampleMS);
+    SimClock::time_point checkpointDue = SimClock::now() + checkpointPeriod;
+    SimClock::time_point sampleDue = SimClock::now() + samplePeriod;
+    bool checkpointing = !settings.checkpointFileName.empty() && settings.checkpointSeconds > 0;
+    bool recording = false;
+
+    TRACE_THREAD_NAME("lockstep");
+
+    if(!settings.sampleFileName.empty() && settings.sampleMS > 0)
+    {
+        recording = OpenOccupancy(writer, settings.sampleFileName, ccn, consoleLock);
+    }
+
+    consoleLock.getLock();
+    {
+        std::cout << "CCN started, stepping the run on one thread." << std::endl;
+    }
+    consoleLock.releaseLock();
+
+    while(running)
+    {
+        //checkpoint and sample at the same simulated times in every run
+        if(checkpointing && SimClock::now() >= checkpointDue)
         {
-            if(row == col)
+            TakeCheckpoint(settings.checkpointFileName, ccn, running, consoleLock, stream, start);
+            checkpointDue += checkpointPeriod;
+        }
+
+        if(recording && SimClock::now() >= sampleDue)
+        {
+            TakeOccupancySample(writer, ccn, start, sampling, locked);
+            sampleDue += samplePeriod;
+        }
+
+        //release the trips due by now
+        while(pending && stream->peek(trip) && SimClock::now() - start >= std::chrono::duration<double>(trip.departure))
+        {
+            Vehicle car(trip.id, trip.source, trip.dest);
+            car.setPriority(trip.priority, trip.deadline);
+
+            TRACE_INSTANT("vehicle", "release", trip.id);
+
+            activeCars++;
+            scheduler.spawn(car, DrawTimeStep(steps), stream, &activeCars, NULL);
+            scheduler.runDue();
+        }
+
+        if(pending && !stream->peek(trip))
+        {
+            pending = false;
+
+            consoleLock.getLock();
             {
-                map[row][col] = 0;
+                std::cout << "Demand exhausted after " << stream->getReleasedCount() << " streamed vehicles." << std::endl;
             }
-            else
+            consoleLock.releaseLock();
+
+            ccn.getLock();
             {
-                map[row][col] = -1;
+                ccn.setDemandPending(false);
             }
+            ccn.releaseLock();
         }
-    }
-    
-    // for each subnet found
-    for(cityIter = cityMap.begin(); cityIter != cityMap.end(); cityIter++)
-    {
-        rowIndex = ccn.getMapIndex(cityIter->first);    //---- set the row to the subnet index
 
-        // Iterate through the neighbors
-        for(neighborIter = cityIter->second.begin(); neighborIter != cityIter->second.end(); neighborIter++)
+        resumed = scheduler.runDue();
+
+        //a job whose route is full stays queued until vehicles move on
+        ccn.getLock();
         {
-            if(neighborIter->first[0] == '[')   //---- If the neighbor is referenced by index
+            waiting = ccn.getQueueDepth() + ccn.getDelayedJobCount();
+            ccn.directTraffic(std::ref(running));
+            routed = waiting - (ccn.getQueueDepth() + ccn.getDelayedJobCount());
+        }
+        ccn.releaseLock();
+
+        if(!running || resumed > 0 || routed > 0)
+        {
+            continue;
+        }
+
+        //nothing happens until the next timer or departure
+        hasNext = scheduler.getNextTimer(next);
+
+        if(pending)
+        {
+            //a tick past the departure, which is rounded down
+            departure = start + std::chrono::duration_cast<SimClock::duration>(
+                                    std::chrono::duration<double>(trip.departure)) + SimClock::duration(1);
+
+            if(!hasNext || departure < next)
             {
-                std::string neighbor = neighborIter->first;
-                neighbor = roadIDs[std::stoi(neighbor.substr(1, neighbor.size()-2)) - 1];
-                colIndex = ccn.getMapIndex(neighbor);
+                next = departure;
+                hasNext = true;
             }
-            else
+        }
+
+        if(!hasNext)
+        {
+            consoleLock.getLock();
             {
-                colIndex = ccn.getMapIndex(neighborIter->first);
+                std::cout << "Warning: the run has stalled, no vehicle can move." << std::endl;
             }
-            map[rowIndex][colIndex] = neighborIter->second;
+            consoleLock.releaseLock();
+
+            running = false;
+            break;
+        }
+
+        //stop the clock at a due checkpoint or sample on the way
+        if(checkpointing && checkpointDue < next)
+        {
+            next = checkpointDue;
         }
+
+        if(recording && sampleDue < next)
+        {
+            next = sampleDue;
+        }
+
+        SimClock::advanceTo(next);
     }
 
-    // Set each subnet capacity
-    for(int index = 0; index < roadIDs.size(); index++)
+    if(recording)
     {
-        ccn.setSubnetProperties(roadIDs[index], roadProp[index]);
+        writer.close();
+        PrintOccupancy(writer, settings.sampleFileName, sampling, locked,
+                       std::chrono::steady_clock::now() - begin, consoleLock);
     }
-    ccn.setMap(map);
-    
-    std::cout << "Closing the file." << std::endl;
-    inputFile.close();
-    return true;
 }
 
 
 /**
- * @brief       Run the simulator until end
- * @details     Initializes the simulator by launching the vehicle threads and starting
- *              the compute node.
+ * @brief       Draw the time step of a vehicle
+ * @details     Between STEP_MIN_MS and STEP_MIN_MS + STEP_SPREAD_MS
  *
- * @param[in]   ccn         Compute Node of the simulator
- * @param[in]   vehicles    List of vehicles in the simulator
+ * @param[in]   steps   random numbers to draw from
+ *
+ * @note        Spreads the vehicles' steps so they do not all wake together
  */
-void RunSimulator(CentralComputeNode &ccn, std::vector<Vehicle> &vehicles)
+long long DrawTimeStep(std::mt19937 & steps)
 {
-    ThreadSafeObject consoleLock;
-    std::atomic_bool running(true);
-    std::vector<std::thread> vehicleThreads(vehicles.size());
-
-    long long tStep;
-
-    std::cout << "Starting the simulator..." << std::endl;
-    srand((unsigned)time(0));
-    for(int index = 0; index < vehicleThreads.size(); index++)
-    {
-        tStep = (rand() % 1500) + 250;
-        vehicleThreads[index] = std::thread(Car, std::ref(ccn), std::ref(running), std::ref(consoleLock),
-                                            std::ref(vehicles[index]), tStep);
-    }
-
-    WaitFor(2000);
-    ComputeNode(ccn, std::ref(running), std::ref(consoleLock));
-
-    std::cout << "Ending the simulator..." << std::endl;
-    EndSimulator(vehicleThreads);
-    std::cout << "Simulator Terminated." << std::endl;
+    return STEP_MIN_MS + (long long)(steps() % STEP_SPREAD_MS);
 }
 
+
 /**
  * @brief       End the simulator
  * @details     Wait for each thread to join
@@ -240,13 +1854,14 @@ void EndSimulator(std::vector<std::thread> & simulatorThreads)
 
 /**
  * @brief       Wait for a specified time
- * @details     puts the current thread to sleep
+ * @details     puts the current thread to sleep for a simulated time, which
+ *              is shorter on the wall clock when the run is sped up
  * 
- * @param[in]   timeMS  time period to wait in milliseconds
+ * @param[in]   timeMS  time period to wait in simulated milliseconds
  */
 void WaitFor(long long timeMS)
 {
-    std::this_thread::sleep_for(std::chrono::milliseconds(timeMS));
+    SimClock::sleepFor(std::chrono::milliseconds(timeMS));
 }
 
 /**
@@ -259,6 +1874,8 @@ void WaitFor(long long timeMS)
  */
 void ComputeNode(CentralComputeNode & ccn, std::atomic_bool & running, ThreadSafeObject & consoleLock)
 {
+    TRACE_THREAD_NAME("ccn");
+
     consoleLock.getLock();
     {
         std::cout << "CCN started." << std::endl;
@@ -279,19 +1896,28 @@ void ComputeNode(CentralComputeNode & ccn, std::atomic_bool & running, ThreadSaf
 /**
  * @brief       Operations done by each Vehicle object
  * @details     This function runs the car and all its operations. 
- *              
+ *              While on a road the car sleeps until it reaches the next node,
+ *              otherwise it checks its route every time step.
  * 
  * @param[in]   ccn         central compute node
  * @param[in]   running     flag to show simulator is running
  * @param[in]   consoleLock lock for the console output
  * @param[in]   car         main thread object
  * @param[in]   timeStep    time from beginning of sim to start of car
+ * @param[in]   stream      stream the car was taken from, or NULL
+ * @param[in]   barrier     barrier to arrive at once joined, or NULL
  */
-void Car(CentralComputeNode & ccn, std::atomic_bool & running, ThreadSafeObject & consoleLock, Vehicle car, long long timeStep) 
+void Car(CentralComputeNode & ccn, std::atomic_bool & running, ThreadSafeObject & consoleLock, Vehicle car, long long timeStep,
+         TripStream* stream, StartupBarrier* barrier) 
 {
 
-    bool started = false;
+    //a car restored on the road carries on without departing again
+    bool started = car.isResumed() && car.hasRoute();
     bool routeRequested = false;
+    bool driving = false;
+    SimClock::time_point arrival;
+
+    TRACE_THREAD_NAME("car " + car.getID());
 
     consoleLock.getLock();
     {
@@ -301,7 +1927,10 @@ void Car(CentralComputeNode & ccn, std::atomic_bool & running, ThreadSafeObject
 
     car.getLock();
     {
-        car.setStartTime();
+        if(!car.isResumed())
+        {
+            car.setStartTime();
+        }
 
         consoleLock.getLock();
         {
@@ -315,9 +1944,21 @@ void Car(CentralComputeNode & ccn, std::atomic_bool & running, ThreadSafeObject
     ccn.getLock();
     {
         ccn.joinNetwork(&car);
+        TRACE_INSTANT("vehicle", "join", car.getSource());
+
+        //checkpoints now find the car on the network rather than in the stream
+        if(stream != NULL)
+        {
+            stream->pop();
+        }
     }
     ccn.releaseLock();
 
+    if(barrier != NULL)
+    {
+        barrier->arrive();
+    }
+
     // While the simulator is running
     while (running) 
     {
@@ -330,6 +1971,7 @@ void Car(CentralComputeNode & ccn, std::atomic_bool & running, ThreadSafeObject
                 {
                     started = true;
                     car.setDepartTime();
+                    TRACE_INSTANT("vehicle", "depart", car.getSource());
 
                     consoleLock.getLock();
                     {
@@ -343,6 +1985,8 @@ void Car(CentralComputeNode & ccn, std::atomic_bool & running, ThreadSafeObject
                 //if at dest, then complete
                 if (car.getNextDestination() == "")
                 {
+                    TRACE_INSTANT("vehicle", "finish", car.getDest());
+
                     consoleLock.getLock();
                     {
                         std::cout << "Car " + car.getID() << " has reached "
@@ -372,6 +2016,8 @@ void Car(CentralComputeNode & ccn, std::atomic_bool & running, ThreadSafeObject
                     {
                         if (car.tryRoadChange(ccn)) //--- Try road change
                         {
+                            TRACE_INSTANT("vehicle", "reach", car.getSource());
+
                             consoleLock.getLock();
                             {
                                 std::cout << "Car " + car.getID() << " has reached " 
@@ -389,6 +2035,8 @@ void Car(CentralComputeNode & ccn, std::atomic_bool & running, ThreadSafeObject
                             }
                             consoleLock.releaseLock();
 
+                            TRACE_INSTANT("vehicle", "refused", car.getNextDestination());
+
                             car.clearRoute();
 
                             routeRequested = false;
@@ -410,15 +2058,41 @@ void Car(CentralComputeNode & ccn, std::atomic_bool & running, ThreadSafeObject
 
                 ccn.getLock();
                 {
-                    car.requestRoute(ccn);
+                    //an overloaded ccn may turn the request away, ask again next step
+                    if(!car.requestRoute(ccn))
+                    {
+                        routeRequested = false;
+                        TRACE_INSTANT("vehicle", "turned away", car.getSource());
+
+                        consoleLock.getLock();
+                        {
+                            std::cout << "Car " + car.getID() << " was turned away by the CCN." << std::endl;
+                        }
+                        consoleLock.releaseLock();
+                    }
                 }
                 ccn.releaseLock();
             }
+
+            //a car on a road has nothing to do until it reaches the next node
+            driving = car.hasRoute() && car.timeRemainingToNextDestination();
+
+            if(driving)
+            {
+                arrival = car.getArrivalTime();
+            }
         }
         car.releaseLock();
 
-        //might want to use a random time for the sake of collisions
-        WaitFor(timeStep);
+        if(driving)
+        {
+            SimClock::sleepUntil(arrival);
+        }
+        else
+        {
+            //might want to use a random time for the sake of collisions
+            WaitFor(timeStep);
+        }
     }
 }
 